@@ -0,0 +1,741 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   adaptive_point_multiset.hpp
+ *  Contains the definition of \ref spatial::adaptive_point_multiset, an idle
+ *  k-d tree whose nodes split along the dimension of largest spread, and the
+ *  specializations of \ref spatial::region_iterator and \ref
+ *  spatial::neighbor_iterator that search it.
+ */
+
+#ifndef SPATIAL_ADAPTIVE_POINT_MULTISET_HPP
+#define SPATIAL_ADAPTIVE_POINT_MULTISET_HPP
+
+#include <memory>  // std::allocator
+#include <vector>
+#include <utility> // std::pair
+#include <iterator> // std::forward_iterator_tag
+#include <algorithm> // std::push_heap, std::pop_heap
+#include "function.hpp"
+#include "region_iterator.hpp"
+#include "neighbor_iterator.hpp"
+#include "bits/spatial_except.hpp"
+#include "bits/spatial_adaptive_kdtree.hpp"
+
+namespace spatial
+{
+  /**
+   *  An idle multiset of points in which each node of the tree splits its
+   *  subtree along the dimension where its values have the largest spread,
+   *  rather than along the next dimension in turn.
+   *
+   *  On anisotropic data, such as points along roads or in thin corridors,
+   *  cycling through the dimensions cuts long and thin cells, whose planes
+   *  prune few nodes. Choosing the dimension of largest spread keeps the
+   *  cells close to square, at the cost of one dimension stored per node.
+   *
+   *  The container is searched with \ref region_iterator and \ref
+   *  neighbor_iterator, through the same functions as the other containers
+   *  of the library: region_begin(), region_range(), neighbor_begin(),
+   *  neighbor_range(), etc. Both iterators are forward iterators, that read
+   *  the dimension of each node from the tree. Values inserted after the
+   *  tree was built are visited by every search, and erased values are
+   *  skipped, until they amount to a quarter of the tree, which is then
+   *  rebuilt; rebalance() rebuilds it at once.
+   *
+   *  \tparam Rank The rank of the keys, or 0 to set it at run time.
+   *  \tparam Key The type of the keys.
+   *  \tparam Compare The comparator that reads the coordinates of the keys;
+   *  one of \ref bracket_less, \ref paren_less, \ref iterator_less or \ref
+   *  accessor_less.
+   *  \tparam Split Either \ref max_spread_split or \ref
+   *  sliding_midpoint_split.
+   *  \tparam Alloc The allocator of the values.
+   */
+  template<dimension_type Rank, typename Key,
+           typename Compare = bracket_less<Key>,
+           typename Split = max_spread_split,
+           typename Alloc = std::allocator<Key> >
+  struct adaptive_point_multiset
+    : details::Adaptive_kdtree<details::Static_rank<Rank>, Key, Compare,
+                               Split, Alloc>
+  {
+  private:
+    typedef details::Adaptive_kdtree<details::Static_rank<Rank>, Key,
+                                     Compare, Split, Alloc> base_type;
+
+  public:
+    adaptive_point_multiset()
+      : base_type(details::Static_rank<Rank>(), Compare(), Alloc())
+    { }
+
+    explicit adaptive_point_multiset(const Compare& compare)
+      : base_type(details::Static_rank<Rank>(), compare, Alloc())
+    { }
+
+    adaptive_point_multiset(const Compare& compare, const Alloc& alloc)
+      : base_type(details::Static_rank<Rank>(), compare, alloc)
+    { }
+  };
+
+  /**
+   *  Specialization for \ref adaptive_point_multiset with runtime rank
+   *  support.
+   */
+  template<typename Key, typename Compare, typename Split, typename Alloc>
+  struct adaptive_point_multiset<0, Key, Compare, Split, Alloc>
+    : details::Adaptive_kdtree<details::Dynamic_rank, Key, Compare, Split,
+                               Alloc>
+  {
+  private:
+    typedef details::Adaptive_kdtree<details::Dynamic_rank, Key, Compare,
+                                     Split, Alloc> base_type;
+
+  public:
+    adaptive_point_multiset()
+      : base_type(details::Dynamic_rank(), Compare(), Alloc())
+    { }
+
+    explicit adaptive_point_multiset(dimension_type dim)
+      : base_type(details::Dynamic_rank(dim), Compare(), Alloc())
+    { except::check_rank(dim); }
+
+    adaptive_point_multiset(dimension_type dim, const Compare& compare)
+      : base_type(details::Dynamic_rank(dim), compare, Alloc())
+    { except::check_rank(dim); }
+
+    adaptive_point_multiset(dimension_type dim, const Compare& compare,
+                            const Alloc& alloc)
+      : base_type(details::Dynamic_rank(dim), compare, alloc)
+    { except::check_rank(dim); }
+
+    explicit adaptive_point_multiset(const Compare& compare)
+      : base_type(details::Dynamic_rank(), compare, Alloc())
+    { }
+  };
+
+  namespace details
+  {
+    /**
+     *  The walk of an \ref adaptive_point_multiset through the values that
+     *  match a region predicate. The subtrees that remain to be visited are
+     *  kept on a stack, below which the values outside of the tree are
+     *  visited last.
+     */
+    template <typename Container, typename Predicate>
+    struct Adaptive_region
+    {
+      typedef std::pair<std::size_t, std::size_t> range_type;
+
+      Adaptive_region() : container(0), pos(0) { }
+
+      Adaptive_region(const Container& container_, const Predicate& pred_)
+        : container(&container_), pred(pred_), pos(container_.slot_count())
+      {
+        std::size_t indexed = container_.indexed_size();
+        stack.push_back(range_type(indexed, container_.slot_count()));
+        if (indexed != 0) stack.push_back(range_type(0, indexed));
+        increment();
+      }
+
+      //! Moves to the next matching value, or past-the-end.
+      void increment()
+      {
+        const std::size_t indexed = container->indexed_size();
+        const dimension_type rank = container->dimension();
+        while (!stack.empty())
+          {
+            range_type range = stack.back();
+            stack.pop_back();
+            if (range.first >= indexed)
+              {
+                for (std::size_t i = range.first; i < range.second; ++i)
+                  {
+                    if (!container->is_erased(i) && match(value(i)))
+                      {
+                        stack.push_back(range_type(i + 1, range.second));
+                        pos = i;
+                        return;
+                      }
+                  }
+                continue;
+              }
+            std::size_t node = range.first;
+            std::size_t split = container->node_right(node);
+            relative_order rel
+              = pred(container->node_dimension(node), rank, value(node));
+            if (split < range.second && rel != above)
+              { stack.push_back(range_type(split, range.second)); }
+            if (node + 1 < split && rel != below)
+              { stack.push_back(range_type(node + 1, split)); }
+            if (rel == matching && !container->is_erased(node)
+                && match(value(node)))
+              { pos = node; return; }
+          }
+        pos = container->slot_count();
+      }
+
+      const typename Container::key_type& value(std::size_t i) const
+      { return container->slot(i); }
+
+      bool match(const typename Container::key_type& key) const
+      {
+        const dimension_type rank = container->dimension();
+        for (dimension_type d = 0; d < rank; ++d)
+          { if (pred(d, rank, key) != matching) return false; }
+        return true;
+      }
+
+      const Container* container;
+      Predicate pred;
+      std::vector<range_type> stack;
+      std::size_t pos;
+    };
+
+    /**
+     *  An entry of the search queue of an \ref adaptive_point_multiset:
+     *  either a single value at \c pos, whose distance to the target is \c
+     *  bound, or the subtree stored in [\c pos, \c end), whose values are no
+     *  closer to the target than \c bound.
+     */
+    template <typename Distance>
+    struct Adaptive_entry
+    {
+      Adaptive_entry(Distance bound_, std::size_t pos_, std::size_t end_,
+                     bool value_)
+        : bound(bound_), pos(pos_), end(end_), value(value_) { }
+      Distance bound;
+      std::size_t pos;
+      std::size_t end;
+      bool value;
+    };
+
+    //! Orders the entries of the search queue so that the closest comes out
+    //! first, and values come out before subtrees with the same bound.
+    struct Adaptive_entry_greater
+    {
+      template <typename Entry>
+      bool operator()(const Entry& x, const Entry& y) const
+      {
+        return y.bound < x.bound
+          || (!(x.bound < y.bound) && y.value && !x.value);
+      }
+    };
+
+    /**
+     *  The incremental nearest neighbor search of an \ref
+     *  adaptive_point_multiset: a best-first traversal that keeps the values
+     *  and the subtrees that remain to be visited in a priority queue,
+     *  ordered by their distance, or the lower bound of their distance, to
+     *  the target. The bound of a subtree on the far side of a node is the
+     *  distance from the target to the plane of the node, on the dimension
+     *  stored in the node.
+     */
+    template <typename Container, typename Metric>
+    struct Adaptive_search
+    {
+      typedef typename Metric::distance_type distance_type;
+      typedef typename Container::key_type key_type;
+      typedef Adaptive_entry<distance_type> entry_type;
+
+      Adaptive_search() : container(0), pos(0), distance() { }
+
+      Adaptive_search(const Container& container_, const Metric& metric_,
+                      const key_type& target_)
+        : container(&container_), metric(metric_), target(target_),
+          pos(container_.slot_count()), distance()
+      {
+        std::size_t indexed = container_.indexed_size();
+        if (indexed != 0)
+          { push(entry_type(distance_type(), 0, indexed, false)); }
+        for (std::size_t i = container_.next_slot(indexed);
+             i < container_.slot_count(); i = container_.next_slot(i + 1))
+          {
+            push(entry_type(metric.distance_to_key
+                            (container_.dimension(), target, value(i)),
+                            i, i + 1, true));
+          }
+        increment();
+      }
+
+      //! Moves to the next closest value, or past-the-end.
+      void increment()
+      {
+        const dimension_type rank = container->dimension();
+        while (!heap.empty())
+          {
+            std::pop_heap(heap.begin(), heap.end(), Adaptive_entry_greater());
+            entry_type entry = heap.back();
+            heap.pop_back();
+            if (entry.value)
+              { pos = entry.pos; distance = entry.bound; return; }
+            // Descend to the cell of the target, leaving the far sides.
+            std::size_t node = entry.pos, end = entry.end;
+            for (;;)
+              {
+                const key_type& key = value(node);
+                if (!container->is_erased(node))
+                  {
+                    push(entry_type(metric.distance_to_key(rank, target, key),
+                                    node, node + 1, true));
+                  }
+                std::size_t split = container->node_right(node);
+                dimension_type dim = container->node_dimension(node);
+                range_type lower(node + 1, split), upper(split, end);
+                bool left = container->key_comp()(dim, target, key);
+                range_type near = left ? lower : upper;
+                range_type far = left ? upper : lower;
+                if (far.first < far.second)
+                  {
+                    distance_type plane = metric.distance_to_plane
+                      (rank, dim, target, key);
+                    push(entry_type(entry.bound < plane ? plane : entry.bound,
+                                    far.first, far.second, false));
+                  }
+                if (!(near.first < near.second)) break;
+                node = near.first;
+                end = near.second;
+              }
+          }
+        pos = container->slot_count();
+      }
+
+      const key_type& value(std::size_t i) const
+      { return container->slot(i); }
+
+      void push(const entry_type& entry)
+      {
+        heap.push_back(entry);
+        std::push_heap(heap.begin(), heap.end(), Adaptive_entry_greater());
+      }
+
+      typedef std::pair<std::size_t, std::size_t> range_type;
+
+      const Container* container;
+      Metric metric;
+      key_type target;
+      std::vector<entry_type> heap;
+      std::size_t pos;
+      distance_type distance;
+    };
+  } // namespace details
+
+  /**
+   *  Specialization of \ref region_iterator for \ref adaptive_point_multiset.
+   *  It may only be incremented.
+   */
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Split, typename Alloc, typename Predicate>
+  class region_iterator<adaptive_point_multiset<Rank, Key, Compare, Split,
+                                                Alloc>, Predicate>
+  {
+  private:
+    typedef adaptive_point_multiset<Rank, Key, Compare, Split, Alloc>
+    container_type;
+
+  public:
+    typedef std::forward_iterator_tag                   iterator_category;
+    typedef Key                                         value_type;
+    typedef typename container_type::difference_type    difference_type;
+    typedef const Key*                                  pointer;
+    typedef const Key&                                  reference;
+
+    //! Uninitialized iterator.
+    region_iterator() { }
+
+    //! Builds an iterator to the first value of \c container that matches
+    //! \c pred.
+    region_iterator(const container_type& container, const Predicate& pred)
+      : _walk(container, pred) { }
+
+    //! Builds a past-the-end iterator of \c container.
+    explicit region_iterator(const container_type& container)
+    {
+      _walk.container = &container;
+      _walk.pos = container.slot_count();
+    }
+
+    reference operator*() const { return _walk.value(_walk.pos); }
+
+    pointer operator->() const { return &**this; }
+
+    region_iterator& operator++() { _walk.increment(); return *this; }
+
+    region_iterator operator++(int)
+    {
+      region_iterator x(*this);
+      _walk.increment();
+      return x;
+    }
+
+    bool operator==(const region_iterator& other) const
+    { return _walk.pos == other._walk.pos; }
+
+    bool operator!=(const region_iterator& other) const
+    { return _walk.pos != other._walk.pos; }
+
+    //! Returns the region predicate of the iterator.
+    const Predicate& predicate() const { return _walk.pred; }
+
+  private:
+    details::Adaptive_region<container_type, Predicate> _walk;
+  };
+
+  /**
+   *  Specialization of \ref region_iterator for constant \ref
+   *  adaptive_point_multiset, which is the same iterator since the values of
+   *  the container are always constant.
+   */
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Split, typename Alloc, typename Predicate>
+  class region_iterator<const adaptive_point_multiset<Rank, Key, Compare,
+                                                      Split, Alloc>, Predicate>
+    : public region_iterator<adaptive_point_multiset<Rank, Key, Compare,
+                                                     Split, Alloc>, Predicate>
+  {
+  private:
+    typedef adaptive_point_multiset<Rank, Key, Compare, Split, Alloc>
+    container_type;
+    typedef region_iterator<container_type, Predicate> Base;
+
+  public:
+    region_iterator() { }
+
+    region_iterator(const container_type& container, const Predicate& pred)
+      : Base(container, pred) { }
+
+    explicit region_iterator(const container_type& container)
+      : Base(container) { }
+
+    region_iterator(const Base& other) : Base(other) { }
+
+    region_iterator& operator++() { Base::operator++(); return *this; }
+
+    region_iterator operator++(int)
+    {
+      region_iterator x(*this);
+      Base::operator++();
+      return x;
+    }
+  };
+
+  /**
+   *  Specialization of \ref neighbor_iterator for \ref
+   *  adaptive_point_multiset. The iterator visits the values of the
+   *  container by increasing distance to the target. It may only be
+   *  incremented.
+   */
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Split, typename Alloc, typename Metric>
+  class neighbor_iterator<adaptive_point_multiset<Rank, Key, Compare, Split,
+                                                  Alloc>, Metric>
+  {
+  private:
+    typedef adaptive_point_multiset<Rank, Key, Compare, Split, Alloc>
+    container_type;
+
+  public:
+    typedef std::forward_iterator_tag                   iterator_category;
+    typedef Key                                         value_type;
+    typedef typename container_type::difference_type    difference_type;
+    typedef const Key*                                  pointer;
+    typedef const Key&                                  reference;
+    typedef Compare                                     key_compare;
+    typedef Metric                                      metric_type;
+    typedef typename Metric::distance_type              distance_type;
+    typedef Key                                         key_type;
+
+    //! Uninitialized iterator.
+    neighbor_iterator() { }
+
+    //! Builds an iterator to the value of \c container that is the closest
+    //! to \c target.
+    neighbor_iterator(const container_type& container, const Metric& metric,
+                      const key_type& target)
+      : _search(container, metric, target) { }
+
+    //! Builds a past-the-end iterator of \c container.
+    explicit neighbor_iterator(const container_type& container)
+    {
+      _search.container = &container;
+      _search.pos = container.slot_count();
+    }
+
+    reference operator*() const { return _search.value(_search.pos); }
+
+    pointer operator->() const { return &**this; }
+
+    neighbor_iterator& operator++()
+    { _search.increment(); return *this; }
+
+    neighbor_iterator operator++(int)
+    {
+      neighbor_iterator x(*this);
+      _search.increment();
+      return x;
+    }
+
+    bool operator==(const neighbor_iterator& other) const
+    { return _search.pos == other._search.pos; }
+
+    bool operator!=(const neighbor_iterator& other) const
+    { return _search.pos != other._search.pos; }
+
+    //! Returns the distance between the current value and the target.
+    distance_type distance() const { return _search.distance; }
+
+    //! Returns the metric used by the iterator.
+    const metric_type& metric() const { return _search.metric; }
+
+    //! Returns the target of the search.
+    const key_type& target_key() const { return _search.target; }
+
+  private:
+    details::Adaptive_search<container_type, Metric> _search;
+  };
+
+  /**
+   *  Specialization of \ref neighbor_iterator for constant \ref
+   *  adaptive_point_multiset, which is the same iterator since the values of
+   *  the container are always constant.
+   */
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Split, typename Alloc, typename Metric>
+  class neighbor_iterator<const adaptive_point_multiset<Rank, Key, Compare,
+                                                        Split, Alloc>, Metric>
+    : public neighbor_iterator<adaptive_point_multiset<Rank, Key, Compare,
+                                                       Split, Alloc>, Metric>
+  {
+  private:
+    typedef adaptive_point_multiset<Rank, Key, Compare, Split, Alloc>
+    container_type;
+    typedef neighbor_iterator<container_type, Metric> Base;
+
+  public:
+    neighbor_iterator() { }
+
+    neighbor_iterator(const container_type& container, const Metric& metric,
+                      const Key& target)
+      : Base(container, metric, target) { }
+
+    explicit neighbor_iterator(const container_type& container)
+      : Base(container) { }
+
+    neighbor_iterator(const Base& other) : Base(other) { }
+
+    neighbor_iterator& operator++()
+    { Base::operator++(); return *this; }
+
+    neighbor_iterator operator++(int)
+    {
+      neighbor_iterator x(*this);
+      Base::operator++();
+      return x;
+    }
+  };
+
+  /**
+   *  Overloads of region_begin() and region_end() for \ref
+   *  adaptive_point_multiset. The other region functions, such as
+   *  region_cbegin() or region_range(), call them.
+   */
+  ///@{
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Split, typename Alloc, typename Predicate>
+  inline region_iterator<adaptive_point_multiset<Rank, Key, Compare, Split,
+                                                 Alloc>, Predicate>
+  region_begin(adaptive_point_multiset<Rank, Key, Compare, Split, Alloc>&
+               container, const Predicate& pred)
+  {
+    return region_iterator<adaptive_point_multiset
+                           <Rank, Key, Compare, Split, Alloc>, Predicate>
+      (container, pred);
+  }
+
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Split, typename Alloc, typename Predicate>
+  inline region_iterator<const adaptive_point_multiset<Rank, Key, Compare,
+                                                       Split, Alloc>,
+                         Predicate>
+  region_begin(const adaptive_point_multiset<Rank, Key, Compare, Split,
+                                             Alloc>& container,
+               const Predicate& pred)
+  {
+    return region_iterator<const adaptive_point_multiset
+                           <Rank, Key, Compare, Split, Alloc>, Predicate>
+      (container, pred);
+  }
+
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Split, typename Alloc, typename Predicate>
+  inline region_iterator<adaptive_point_multiset<Rank, Key, Compare, Split,
+                                                 Alloc>, Predicate>
+  region_end(adaptive_point_multiset<Rank, Key, Compare, Split, Alloc>&
+             container, const Predicate&)
+  {
+    return region_iterator<adaptive_point_multiset
+                           <Rank, Key, Compare, Split, Alloc>, Predicate>
+      (container);
+  }
+
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Split, typename Alloc, typename Predicate>
+  inline region_iterator<const adaptive_point_multiset<Rank, Key, Compare,
+                                                       Split, Alloc>,
+                         Predicate>
+  region_end(const adaptive_point_multiset<Rank, Key, Compare, Split, Alloc>&
+             container, const Predicate&)
+  {
+    return region_iterator<const adaptive_point_multiset
+                           <Rank, Key, Compare, Split, Alloc>, Predicate>
+      (container);
+  }
+  ///@}
+
+  /**
+   *  Overloads of neighbor_begin(), neighbor_end(), neighbor_lower_bound()
+   *  and neighbor_upper_bound() for \ref adaptive_point_multiset. The other
+   *  neighbor functions, such as neighbor_cbegin(), neighbor_range(), or the
+   *  overloads that assume an euclidian metric, call them.
+   */
+  ///@{
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Split, typename Alloc, typename Metric>
+  inline neighbor_iterator<adaptive_point_multiset<Rank, Key, Compare, Split,
+                                                   Alloc>, Metric>
+  neighbor_begin(adaptive_point_multiset<Rank, Key, Compare, Split, Alloc>&
+                 container, const Metric& metric, const Key& target)
+  {
+    return neighbor_iterator<adaptive_point_multiset
+                             <Rank, Key, Compare, Split, Alloc>, Metric>
+      (container, metric, target);
+  }
+
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Split, typename Alloc, typename Metric>
+  inline neighbor_iterator<const adaptive_point_multiset<Rank, Key, Compare,
+                                                         Split, Alloc>,
+                           Metric>
+  neighbor_begin(const adaptive_point_multiset<Rank, Key, Compare, Split,
+                                               Alloc>& container,
+                 const Metric& metric, const Key& target)
+  {
+    return neighbor_iterator<const adaptive_point_multiset
+                             <Rank, Key, Compare, Split, Alloc>, Metric>
+      (container, metric, target);
+  }
+
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Split, typename Alloc, typename Metric>
+  inline neighbor_iterator<adaptive_point_multiset<Rank, Key, Compare, Split,
+                                                   Alloc>, Metric>
+  neighbor_end(adaptive_point_multiset<Rank, Key, Compare, Split, Alloc>&
+               container, const Metric&, const Key&)
+  {
+    return neighbor_iterator<adaptive_point_multiset
+                             <Rank, Key, Compare, Split, Alloc>, Metric>
+      (container);
+  }
+
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Split, typename Alloc, typename Metric>
+  inline neighbor_iterator<const adaptive_point_multiset<Rank, Key, Compare,
+                                                         Split, Alloc>,
+                           Metric>
+  neighbor_end(const adaptive_point_multiset<Rank, Key, Compare, Split,
+                                             Alloc>& container,
+               const Metric&, const Key&)
+  {
+    return neighbor_iterator<const adaptive_point_multiset
+                             <Rank, Key, Compare, Split, Alloc>, Metric>
+      (container);
+  }
+
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Split, typename Alloc, typename Metric>
+  inline neighbor_iterator<const adaptive_point_multiset<Rank, Key, Compare,
+                                                         Split, Alloc>,
+                           Metric>
+  neighbor_cend(const adaptive_point_multiset<Rank, Key, Compare, Split,
+                                              Alloc>& container,
+                const Metric& metric, const Key& target)
+  { return neighbor_end(container, metric, target); }
+
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Split, typename Alloc, typename Metric>
+  inline neighbor_iterator<adaptive_point_multiset<Rank, Key, Compare, Split,
+                                                   Alloc>, Metric>
+  neighbor_lower_bound(adaptive_point_multiset<Rank, Key, Compare, Split,
+                                               Alloc>& container,
+                       const Metric& metric, const Key& target,
+                       typename Metric::distance_type bound)
+  {
+    except::check_positive_distance(bound);
+    neighbor_iterator<adaptive_point_multiset
+                      <Rank, Key, Compare, Split, Alloc>, Metric>
+      i(container, metric, target), end(container);
+    while (i != end && i.distance() < bound) { ++i; }
+    return i;
+  }
+
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Split, typename Alloc, typename Metric>
+  inline neighbor_iterator<const adaptive_point_multiset<Rank, Key, Compare,
+                                                         Split, Alloc>,
+                           Metric>
+  neighbor_lower_bound(const adaptive_point_multiset<Rank, Key, Compare,
+                                                     Split, Alloc>& container,
+                       const Metric& metric, const Key& target,
+                       typename Metric::distance_type bound)
+  {
+    except::check_positive_distance(bound);
+    neighbor_iterator<const adaptive_point_multiset
+                      <Rank, Key, Compare, Split, Alloc>, Metric>
+      i(container, metric, target), end(container);
+    while (i != end && i.distance() < bound) { ++i; }
+    return i;
+  }
+
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Split, typename Alloc, typename Metric>
+  inline neighbor_iterator<adaptive_point_multiset<Rank, Key, Compare, Split,
+                                                   Alloc>, Metric>
+  neighbor_upper_bound(adaptive_point_multiset<Rank, Key, Compare, Split,
+                                               Alloc>& container,
+                       const Metric& metric, const Key& target,
+                       typename Metric::distance_type bound)
+  {
+    except::check_positive_distance(bound);
+    neighbor_iterator<adaptive_point_multiset
+                      <Rank, Key, Compare, Split, Alloc>, Metric>
+      i(container, metric, target), end(container);
+    while (i != end && !(bound < i.distance())) { ++i; }
+    return i;
+  }
+
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Split, typename Alloc, typename Metric>
+  inline neighbor_iterator<const adaptive_point_multiset<Rank, Key, Compare,
+                                                         Split, Alloc>,
+                           Metric>
+  neighbor_upper_bound(const adaptive_point_multiset<Rank, Key, Compare,
+                                                     Split, Alloc>& container,
+                       const Metric& metric, const Key& target,
+                       typename Metric::distance_type bound)
+  {
+    except::check_positive_distance(bound);
+    neighbor_iterator<const adaptive_point_multiset
+                      <Rank, Key, Compare, Split, Alloc>, Metric>
+      i(container, metric, target), end(container);
+    while (i != end && !(bound < i.distance())) { ++i; }
+    return i;
+  }
+  ///@}
+}
+
+#endif // SPATIAL_ADAPTIVE_POINT_MULTISET_HPP
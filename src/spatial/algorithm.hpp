@@ -16,8 +16,9 @@
 #define SPATIAL_ALGORITHM_HPP
 
 #include <utility> // std::pair
-#include <bits/spatial_node.hpp>
-#include <bits/spatial_assert.hpp>
+#include <limits> // std::numeric_limits
+#include "bits/spatial_node.hpp"
+#include "bits/spatial_assert.hpp"
 #include "spatial.hpp"
 
 namespace spatial
@@ -32,45 +33,48 @@ namespace spatial
    *  path from the root node of the tree to any leaf node. If the tree is
    *  empty, the minimum and the maximum depth are equal to 0, therefore.
    *
+   *  \see diagnose() for a complete report on the shape of the tree.
+   *
    *  \param container Min and max depth are inspected in this container.
    */
   template <typename Container>
-  inline std::pair<std::size_t>
+  inline std::pair<std::size_t, std::size_t>
   minmax_depth(const Container& container)
   {
-    typename Container::const_iterator::node_ptr node
-      = Container.end().node->parent;
-    SPATIAL_ASSERT(node != 0);
-    SPATIAL_ASSERT(node == node->parent->parent);
-    if (header(node)) return pair<std::size_t>(0, 0);
+    typedef typename Container::const_iterator::node_ptr node_ptr;
+    node_ptr node = container.end().node->parent;
+    SPATIAL_ASSERT_CHECK(node != 0);
+    SPATIAL_ASSERT_CHECK(node == node->parent->parent);
+    if (header(node)) return std::pair<std::size_t, std::size_t>(0, 0);
     std::size_t current = 1;
     while (node->left != 0)
       { ++current; node = node->left; }
-    // Set to leftmost then iterate...
-    std::size_t min = current, max = curent;
+    // Set to leftmost then iterate, in order, over all nodes...
+    std::size_t min = std::numeric_limits<std::size_t>::max(), max = 0;
     while (!header(node))
       {
+        if (node->left == 0 && node->right == 0)
+          {
+            if (current > max) max = current;
+            if (current < min) min = current;
+          }
         if (node->right != 0)
           {
             node = node->right; ++current;
             while (node->left != 0) { node = node->left; ++current; }
-            if (current > max) max = current;
-            if (current < min) min = current;
           }
         else
           {
-            if (current > max) max = current;
-            if (current < min) min = current;
-            Node<Mode>* p = node->parent;
+            node_ptr p = node->parent;
             while (!header(p) && node == p->right)
               { node = p; p = node->parent; --current; }
-            node = p;
-            SPATIAL_ASSERT(max >= min);
-            SPATIAL_ASSERT(max >= 1);
-            SPATIAL_ASSERT(min >= 1);
+            node = p; --current;
           }
       }
-    return std::pair<std::size_t>(min, max);
+    SPATIAL_ASSERT_CHECK(current == 0);
+    SPATIAL_ASSERT_CHECK(max >= min);
+    SPATIAL_ASSERT_CHECK(min >= 1);
+    return std::pair<std::size_t, std::size_t>(min, max);
   }
 
   /**
@@ -0,0 +1,352 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   spatial_adaptive_kdtree.hpp
+ *  Contains the definition of \ref spatial::details::Adaptive_kdtree, the
+ *  tree behind \ref spatial::adaptive_point_multiset, whose nodes store the
+ *  dimension along which they split their subtree.
+ */
+
+#ifndef SPATIAL_ADAPTIVE_KDTREE_HPP
+#define SPATIAL_ADAPTIVE_KDTREE_HPP
+
+#include <memory>  // std::allocator
+#include <vector>
+#include <utility> // std::pair
+#include <algorithm> // std::nth_element, std::partition, std::swap
+#include "spatial_rank.hpp"
+#include "spatial_coordinate.hpp"
+#include "spatial_hash_index.hpp" // equal_key
+#include "spatial_indexed_array.hpp"
+
+namespace spatial
+{
+  /**
+   *  A split policy for \ref adaptive_point_multiset: each node splits its
+   *  subtree at the median of the dimension along which the values of the
+   *  subtree have the largest spread. The tree is balanced.
+   */
+  struct max_spread_split { };
+
+  /**
+   *  A split policy for \ref adaptive_point_multiset: each node splits its
+   *  subtree at the middle of the dimension along which the values of the
+   *  subtree have the largest spread. The cells keep a bounded aspect ratio
+   *  at the expense of balance, which suits clustered values.
+   *
+   *  Since the spread is measured on the values, each side of the middle
+   *  holds at least one value; the node is the value of the lower side that
+   *  is the closest to the middle, as if the split slid to it. A spread too
+   *  narrow to be cut in its middle is split at its median instead.
+   */
+  struct sliding_midpoint_split { };
+
+  namespace details
+  {
+    /**
+     *  An idle k-d tree stored in a single array in pre-order, in which each
+     *  node stores the dimension that it splits, chosen when the tree is
+     *  built by the \c Split policy, instead of cycling through the
+     *  dimensions with the depth of the node.
+     *
+     *  The values of the left subtree of a node are lower or equal to the
+     *  node on its dimension, and those of its right subtree are greater or
+     *  equal. The left subtree of the node at position \c p starts at \c p +
+     *  1 and its right subtree at \c right(p).
+     *
+     *  Values inserted after the last build are kept at the end of the
+     *  array, and visited by every search, and erased values are skipped by
+     *  the searches, until they amount to a quarter of the tree, which is
+     *  then rebuilt.
+     *
+     *  \tparam Rank Either \static_rank or \dynamic_rank.
+     *  \tparam Key The type of the keys.
+     *  \tparam Compare The comparator that reads the coordinates of the keys.
+     *  \tparam Split Either \ref max_spread_split or \ref
+     *  sliding_midpoint_split.
+     *  \tparam Alloc The allocator of the values.
+     */
+    template <typename Rank, typename Key, typename Compare, typename Split,
+              typename Alloc>
+    class Adaptive_kdtree
+      : private Rank,
+        public Indexed_array<Adaptive_kdtree<Rank, Key, Compare, Split,
+                                             Alloc>, Key, Alloc>
+    {
+    private:
+      typedef Indexed_array<Adaptive_kdtree<Rank, Key, Compare, Split, Alloc>,
+                            Key, Alloc> Base;
+
+      friend class Indexed_array<Adaptive_kdtree<Rank, Key, Compare, Split,
+                                                 Alloc>, Key, Alloc>;
+
+    public:
+      typedef Rank                                          rank_type;
+      typedef Key                                           key_type;
+      typedef Key                                           value_type;
+      typedef Compare                                       key_compare;
+      typedef Split                                         split_policy;
+      typedef Alloc                                         allocator_type;
+      typedef typename Base::size_type                      size_type;
+      typedef typename Base::difference_type                difference_type;
+      typedef const Key*                                    pointer;
+      typedef const Key*                                    const_pointer;
+      typedef const Key&                                    reference;
+      typedef const Key&                                    const_reference;
+      typedef typename Base::iterator                       iterator;
+      typedef typename Base::const_iterator                 const_iterator;
+
+      Adaptive_kdtree(const Rank& rank_, const Compare& compare,
+                      const Alloc& alloc)
+        : Rank(rank_), Base(alloc), _compare(compare) { }
+
+      //! Returns the rank of the container.
+      const rank_type& rank() const { return *this; }
+
+      //! Returns the dimension of the container.
+      dimension_type dimension() const { return rank()(); }
+
+      key_compare key_comp() const { return _compare; }
+
+      //! Returns a value equal to \c key, or \ref end() if there are none.
+      const_iterator find(const key_type& key) const
+      {
+        std::vector<std::pair<std::size_t, std::size_t> > stack;
+        return const_iterator(*this, next_equal(key, stack, true));
+      }
+
+      //! Returns the number of values equal to \c key.
+      size_type count(const key_type& key) const
+      {
+        std::vector<std::pair<std::size_t, std::size_t> > stack;
+        size_type found = 0;
+        for (std::size_t i = next_equal(key, stack, true);
+             i != this->slot_count();
+             i = next_equal(key, stack, false))
+          { ++found; }
+        return found;
+      }
+
+      //! Returns the dimension split by the node at \c pos.
+      dimension_type node_dimension(std::size_t pos) const
+      { return _dims[pos]; }
+
+      //! Returns the position of the right subtree of the node at \c pos.
+      std::size_t node_right(std::size_t pos) const { return _right[pos]; }
+
+      void swap(Adaptive_kdtree& other)
+      {
+        std::swap(static_cast<Rank&>(*this), static_cast<Rank&>(other));
+        Base::swap(other);
+        _dims.swap(other._dims);
+        _right.swap(other._right);
+        std::swap(_compare, other._compare);
+      }
+
+    private:
+      /**
+       *  Returns the position of the next value equal to \c key, or \ref
+       *  slot_count(). The subtrees that remain to be searched are kept in \c
+       *  stack, along with the position where the values outside of the tree
+       *  are searched.
+       */
+      std::size_t
+      next_equal(const key_type& key,
+                 std::vector<std::pair<std::size_t, std::size_t> >& stack,
+                 bool start) const
+      {
+        const std::size_t indexed = this->indexed_size();
+        if (start)
+          {
+            stack.push_back(std::make_pair(indexed, this->slot_count()));
+            if (indexed != 0) stack.push_back(std::make_pair(0, indexed));
+          }
+        while (!stack.empty())
+          {
+            std::pair<std::size_t, std::size_t> range = stack.back();
+            stack.pop_back();
+            if (range.first >= indexed)
+              {
+                for (std::size_t i = range.first; i < range.second; ++i)
+                  {
+                    if (!this->is_erased(i)
+                        && equal_key(rank(), _compare, this->slot(i), key))
+                      {
+                        stack.push_back(std::make_pair(i + 1, range.second));
+                        return i;
+                      }
+                  }
+                continue;
+              }
+            std::size_t node = range.first, split = _right[node];
+            const Key& value = this->slot(node);
+            if (split < range.second && !_compare(_dims[node], key, value))
+              { stack.push_back(std::make_pair(split, range.second)); }
+            if (node + 1 < split && !_compare(_dims[node], value, key))
+              { stack.push_back(std::make_pair(node + 1, split)); }
+            if (!this->is_erased(node)
+                && equal_key(rank(), _compare, value, key)) return node;
+          }
+        return this->slot_count();
+      }
+
+      //! Builds the tree over all the values of the array, whose positions
+      //! are reordered in \c order so that the tree is stored in pre-order.
+      void build_index(std::vector<std::size_t>& order)
+      {
+        std::vector<dimension_type> dims(order.size());
+        std::vector<std::size_t> right(order.size());
+        build(order, 0, order.size(), dims, right);
+        _dims.swap(dims);
+        _right.swap(right);
+      }
+
+      //! Returns true if \c value is equal to \c key.
+      bool equal_value(const Key& value, const key_type& key) const
+      { return equal_key(rank(), _compare, value, key); }
+
+      double coordinate(dimension_type d, std::size_t i) const
+      { return compare_coordinate(_compare, d, this->slot(i)); }
+
+      /**
+       *  Builds the subtree of the values whose positions are stored in [\c
+       *  first, \c last) of \c work. The smaller side of each split is built
+       *  recursively, which bounds the depth of the recursion even when the
+       *  tree is not balanced.
+       */
+      void build(std::vector<std::size_t>& work, std::size_t first,
+                 std::size_t last, std::vector<dimension_type>& dims,
+                 std::vector<std::size_t>& right) const
+      {
+        while (first < last)
+          {
+            dimension_type dim = 0;
+            double low = 0.0, high = 0.0;
+            widest_dimension(work, first, last, dim, low, high);
+            std::size_t split = partition(work, first, last, dim, low, high,
+                                          Split());
+            dims[first] = dim;
+            right[first] = split;
+            if (split - first - 1 < last - split)
+              {
+                build(work, first + 1, split, dims, right);
+                first = split;
+              }
+            else
+              {
+                build(work, split, last, dims, right);
+                last = split;
+                ++first;
+              }
+          }
+      }
+
+      //! Finds the dimension with the largest spread of values in [\c
+      //! first, \c last) of \c work, and the bounds of the spread.
+      void widest_dimension(const std::vector<std::size_t>& work,
+                            std::size_t first, std::size_t last,
+                            dimension_type& dim, double& low,
+                            double& high) const
+      {
+        double spread = -1.0;
+        for (dimension_type d = 0; d < dimension(); ++d)
+          {
+            double l = coordinate(d, work[first]), h = l;
+            for (std::size_t i = first + 1; i < last; ++i)
+              {
+                double x = coordinate(d, work[i]);
+                if (x < l) l = x; else if (h < x) h = x;
+              }
+            if (spread < h - l) { spread = h - l; dim = d; low = l; high = h; }
+          }
+      }
+
+      /**
+       *  Moves the node of the values in [\c first, \c last) of \c work to \c
+       *  first, and its left subtree right after it, then returns the
+       *  position of its right subtree.
+       */
+      ///@{
+      std::size_t partition(std::vector<std::size_t>& work, std::size_t first,
+                            std::size_t last, dimension_type dim, double,
+                            double, max_spread_split) const
+      {
+        std::vector<std::size_t>::iterator
+          begin_ = work.begin() + static_cast<difference_type>(first),
+          mid = begin_ + static_cast<difference_type>((last - first) / 2);
+        std::nth_element(begin_, mid,
+                         work.begin() + static_cast<difference_type>(last),
+                         Coordinate_less(*this, dim));
+        std::iter_swap(begin_, mid);
+        return first + (last - first) / 2 + 1;
+      }
+
+      std::size_t partition(std::vector<std::size_t>& work, std::size_t first,
+                            std::size_t last, dimension_type dim, double low,
+                            double high, sliding_midpoint_split) const
+      {
+        // When the spread is a few ulps wide, the middle may round to one of
+        // its bounds and leave a side empty: split at the median instead.
+        double cut = low + (high - low) / 2.0;
+        if (!(low < cut))
+          {
+            return partition(work, first, last, dim, low, high,
+                             max_spread_split());
+          }
+        std::vector<std::size_t>::iterator
+          begin_ = work.begin() + static_cast<difference_type>(first),
+          end_ = work.begin() + static_cast<difference_type>(last),
+          split = std::partition(begin_, end_,
+                                 Coordinate_below(*this, dim, cut));
+        if (split == begin_ || split == end_)
+          {
+            return partition(work, first, last, dim, low, high,
+                             max_spread_split());
+          }
+        std::vector<std::size_t>::iterator closest = begin_;
+        for (std::vector<std::size_t>::iterator i = begin_ + 1; i != split;
+             ++i)
+          {
+            if (coordinate(dim, *closest) < coordinate(dim, *i))
+              closest = i;
+          }
+        std::iter_swap(begin_, closest);
+        return first + static_cast<std::size_t>(split - begin_);
+      }
+      ///@}
+
+      struct Coordinate_less
+      {
+        Coordinate_less(const Adaptive_kdtree& tree_, dimension_type dim_)
+          : tree(tree_), dim(dim_) { }
+        bool operator()(std::size_t i, std::size_t j) const
+        { return tree.coordinate(dim, i) < tree.coordinate(dim, j); }
+        const Adaptive_kdtree& tree;
+        dimension_type dim;
+      };
+
+      struct Coordinate_below
+      {
+        Coordinate_below(const Adaptive_kdtree& tree_, dimension_type dim_,
+                         double cut_)
+          : tree(tree_), dim(dim_), cut(cut_) { }
+        bool operator()(std::size_t i) const
+        { return tree.coordinate(dim, i) < cut; }
+        const Adaptive_kdtree& tree;
+        dimension_type dim;
+        double cut;
+      };
+
+      std::vector<dimension_type> _dims;
+      std::vector<std::size_t> _right;
+      Compare _compare;
+    };
+  } // namespace details
+} // namespace spatial
+
+#endif // SPATIAL_ADAPTIVE_KDTREE_HPP
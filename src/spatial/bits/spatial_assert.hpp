@@ -66,12 +66,14 @@ namespace spatial
     // Prototype declaration for the assertions.
     template <typename Key, typename Value> struct Kdtree_link;
     template <typename Key, typename Value> struct Relaxed_kdtree_link;
+    template <typename Key, typename Value> struct Relaxed_kdtree_cold_link;
+    template <typename Key, typename Value> struct Relaxed_kdtree_cached_link;
     template <typename Link> struct Node;
     template <typename Rank, typename Key, typename Value, typename Compare,
               typename Alloc>
     class Kdtree;
     template <typename Rank, typename Key, typename Value, typename Compare,
-              typename Balancing, typename Alloc>
+              typename Balancing, typename Alloc, typename Storage>
     class Relaxed_kdtree;
 
     template <typename Value>
@@ -93,6 +95,20 @@ namespace spatial
     template <typename Key, typename Value>
     inline const Relaxed_kdtree_link<Key, Value>*
     const_link(const Node<Relaxed_kdtree_link<Key, Value> >* node);
+
+    template <typename Key, typename Value>
+    inline const typename Relaxed_kdtree_cold_link<Key, Value>::key_type&
+    const_key(const Node<Relaxed_kdtree_cold_link<Key, Value> >* node);
+    template <typename Key, typename Value>
+    inline const Relaxed_kdtree_cold_link<Key, Value>*
+    const_link(const Node<Relaxed_kdtree_cold_link<Key, Value> >* node);
+
+    template <typename Key, typename Value>
+    inline const typename Relaxed_kdtree_cached_link<Key, Value>::key_type&
+    const_key(const Node<Relaxed_kdtree_cached_link<Key, Value> >* node);
+    template <typename Key, typename Value>
+    inline const Relaxed_kdtree_cached_link<Key, Value>*
+    const_link(const Node<Relaxed_kdtree_cached_link<Key, Value> >* node);
   }
 
   namespace assert
@@ -137,14 +153,14 @@ namespace spatial
          && (!right || assert_invariant_node(cmp, rank, next_depth, right)));
     }
 
-    template <typename Compare, typename Key, typename Value>
+    template <typename Compare, typename Link>
     inline bool
     assert_invariant_node
     (const Compare& cmp, dimension_type rank, dimension_type depth,
-     const details::Node<details::Relaxed_kdtree_link<Key, Value> >* node)
+     const details::Node<Link>* node)
     {
       dimension_type next_depth = depth + 1;
-      const details::Node<details::Relaxed_kdtree_link<Key, Value> >
+      const details::Node<Link>
         *left = node->left, *right = node->right;
       while (!header(node->parent))
         {
@@ -241,11 +257,11 @@ namespace spatial
       return o;
     }
 
-    template <typename Compare, typename Key, typename Value>
+    template <typename Compare, typename Link>
     inline std::ostream&
     assert_inspect_node
     (const Compare& cmp, dimension_type rank, std::ostream& o,
-     const details::Node<details::Relaxed_kdtree_link<Key, Value> >* node,
+     const details::Node<Link>* node,
      dimension_type depth)
     {
       if (node->left)
@@ -255,7 +271,7 @@ namespace spatial
       else if (node->parent->left == node) o << "L";
       else if (node->parent->right == node) o << "R";
       else o << "E";
-      const details::Node<details::Relaxed_kdtree_link<Key, Value> >
+      const details::Node<Link>
         *test = node;
       dimension_type test_depth = depth;
       while (!header(test->parent))
@@ -340,11 +356,11 @@ namespace spatial
     }
 
     template <typename Rank, typename Key, typename Value, typename Compare,
-              typename Balancing, typename Alloc>
+              typename Balancing, typename Alloc, typename Storage>
     inline void assert_inspect
     (const char* msg, const char* filename, unsigned int line,
-     const details::Relaxed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc>&
-     tree) throw()
+     const details::Relaxed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc,
+                                   Storage>& tree) throw()
     {
       try
         {
@@ -0,0 +1,470 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   spatial_batch.hpp
+ *  Contains the executor of the batch queries of \ref query.hpp, which
+ *  advances several independent queries in turn so that the loads of their
+ *  nodes from memory overlap.
+ *
+ *  A descent in the tree is a chain of loads, each of which depends on the
+ *  previous one: a single query leaves the processor waiting on one cache
+ *  miss at a time. Here, each query is a cursor that examines one node per
+ *  step, then requests the next node it will examine to be loaded and lets
+ *  the executor move on to the next query. By the time the executor comes
+ *  back to a query, its node has had the time to arrive in cache.
+ */
+
+#ifndef SPATIAL_BATCH_HPP
+#define SPATIAL_BATCH_HPP
+
+#include <vector>
+#include <iterator> // std::iterator_traits
+#include <algorithm> // std::swap
+#include <limits> // std::numeric_limits
+#include "spatial_traversal.hpp"
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#  include <xmmintrin.h> // _mm_prefetch
+#endif
+
+/**
+ *  \def SPATIAL_BATCH_WIDTH
+ *  The number of queries that the batch queries advance in turn, unless
+ *  another width is given to them. The best width depends on the number of
+ *  cache misses that the processor can have in flight; widths beyond that
+ *  number only add to the cache footprint of the queries.
+ */
+#ifndef SPATIAL_BATCH_WIDTH
+#  define SPATIAL_BATCH_WIDTH 8
+#endif
+
+namespace spatial
+{
+  namespace details
+  {
+    /**
+     *  Requests the memory pointed to by \c ptr to be loaded in cache, if the
+     *  compiler provides a way to do so. \c ptr may be null.
+     *
+     *  Unlike \ref prefetch(), it does not depend on SPATIAL_ENABLE_PREFETCH:
+     *  the executor relies on it to overlap the loads of its queries, and
+     *  issues it once per step rather than once per child of each node.
+     */
+    inline void
+    batch_prefetch(const void* ptr)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+      __builtin_prefetch(ptr);
+#elif defined(_MSC_VER)
+      _mm_prefetch(static_cast<const char*>(ptr), _MM_HINT_T0);
+#else
+      static_cast<void>(ptr);
+#endif
+    }
+
+    /**
+     *  Advances the queries read from [\c first, \c last) in turn, at most \c
+     *  width at a time, until all of them are completed.
+     *
+     *  A cursor models a resumable query. It provides the types \c
+     *  query_type and \c result_type and the functions:
+     *  \li \c start(root, query), which starts a new query from \c root;
+     *  \li \c step(), which examines the current node, and returns \c true
+     *  after it requested the next node to be loaded, or \c false once the
+     *  query is completed;
+     *  \li \c result(), which returns the result of a completed query.
+     *
+     *  \param root The root of the tree, which must not be the header.
+     *  \param prototype The cursor copied for each of the concurrent queries.
+     *  \param width The number of queries advanced in turn.
+     *  \param first The first of the queries.
+     *  \param last The end of the queries.
+     *  \param store A functor called with the position of each query in
+     *  [\c first, \c last) and its result, as the queries complete.
+     *  \return The number of queries read.
+     */
+    template <typename NodePtr, typename Cursor, typename InputIterator,
+              typename Store>
+    inline std::size_t
+    interleave(NodePtr root, const Cursor& prototype, std::size_t width,
+               InputIterator first, InputIterator last, Store store)
+    {
+      SPATIAL_ASSERT_CHECK(root != 0);
+      SPATIAL_ASSERT_CHECK(!header(root));
+      SPATIAL_ASSERT_CHECK(width != 0);
+      std::vector<Cursor> cursors(width, prototype);
+      std::vector<std::size_t> index(width);
+      std::size_t active = 0;
+      std::size_t next = 0;
+      for (; active < width && first != last; ++active, ++first, ++next)
+        {
+          cursors[active].start(root, *first);
+          index[active] = next;
+        }
+      while (active != 0)
+        {
+          for (std::size_t i = 0; i < active;)
+            {
+              if (cursors[i].step()) { ++i; continue; }
+              store(index[i], cursors[i].result());
+              if (first != last)
+                {
+                  cursors[i].start(root, *first);
+                  index[i] = next++;
+                  ++first; ++i;
+                }
+              else if (i != --active)
+                {
+                  // The last active query takes the place of this one
+                  std::swap(cursors[i], cursors[active]);
+                  std::swap(index[i], index[active]);
+                }
+            }
+        }
+      return next;
+    }
+
+    /**
+     *  A resumable search of the first node, in pre-order, whose key is
+     *  equal to the query. The result is the header if no such node exists.
+     */
+    template <typename NodePtr, typename Rank, typename KeyCompare,
+              typename Key>
+    class Find_cursor
+    {
+    public:
+      typedef Key     query_type;
+      typedef NodePtr result_type;
+
+      Find_cursor(const Rank& rank, const KeyCompare& key_comp,
+                  std::size_t depth_bound)
+        : _rank(rank), _key_comp(key_comp), _stack(depth_bound),
+          _node(0), _dim(0), _result(0), _key() { }
+
+      void start(NodePtr root, const Key& key)
+      {
+        _stack.clear();
+        _node = root; _dim = 0; _result = root->parent; _key = key;
+        batch_prefetch(root);
+      }
+
+      bool step()
+      {
+        NodePtr node = _node;
+        bool walk_left = !_key_comp(_dim, const_key(node), _key);
+        bool walk_right = !_key_comp(_dim, _key, const_key(node));
+        if (walk_left && walk_right)
+          {
+            dimension_type test = 0;
+            for (; test < _rank()
+                   && (test == _dim
+                       || !(_key_comp(test, _key, const_key(node))
+                            || _key_comp(test, const_key(node), _key)));
+                 ++test);
+            if (test == _rank()) { _result = node; return false; }
+          }
+        NodePtr left = walk_left ? node->left : 0;
+        NodePtr right = walk_right ? node->right : 0;
+        dimension_type child_dim = incr_dim(_rank, _dim);
+        if (left != 0)
+          {
+            if (right != 0)
+              { _stack.push(Traversal_entry<NodePtr>(right, child_dim)); }
+            _node = left; _dim = child_dim;
+          }
+        else if (right != 0)
+          { _node = right; _dim = child_dim; }
+        else if (!_stack.empty())
+          {
+            Traversal_entry<NodePtr> entry = _stack.pop();
+            _node = entry.node; _dim = entry.dim;
+          }
+        else return false;
+        batch_prefetch(_node);
+        return true;
+      }
+
+      result_type result() const { return _result; }
+
+    private:
+      Rank _rank;
+      KeyCompare _key_comp;
+      Traversal_stack<Traversal_entry<NodePtr> > _stack;
+      NodePtr _node;
+      dimension_type _dim;
+      NodePtr _result;
+      Key _key;
+    };
+
+    /**
+     *  A resumable search of the node closest to the query according to a
+     *  metric. Among nodes at equal distance, the first one found is kept.
+     */
+    template <typename NodePtr, typename Rank, typename KeyCompare,
+              typename Metric, typename Key>
+    class Nearest_cursor
+    {
+      typedef typename Metric::distance_type distance_type;
+      typedef Neighbor_entry<NodePtr, distance_type> entry_type;
+
+    public:
+      typedef Key     query_type;
+      typedef NodePtr result_type;
+
+      Nearest_cursor(const Rank& rank, const KeyCompare& key_comp,
+                     const Metric& met, std::size_t depth_bound)
+        : _rank(rank), _key_comp(key_comp), _met(met), _stack(depth_bound),
+          _node(0), _dim(0), _best(0), _best_dist(), _target() { }
+
+      void start(NodePtr root, const Key& target)
+      {
+        _stack.clear();
+        _node = root; _dim = 0; _best = root->parent; _target = target;
+        _best_dist = (std::numeric_limits<distance_type>::max)();
+        batch_prefetch(root);
+      }
+
+      bool step()
+      {
+        NodePtr node = _node;
+        distance_type dist
+          = distance_to_key(_met, _rank(), _target, const_key(node));
+        if (dist < _best_dist) { _best = node; _best_dist = dist; }
+        NodePtr near, far;
+        if (_key_comp(_dim, const_key(node), _target))
+          { near = node->right; far = node->left; }
+        else
+          { near = node->left; far = node->right; }
+        dimension_type child_dim = incr_dim(_rank, _dim);
+        if (far != 0)
+          {
+            distance_type bound = distance_to_plane
+              (_met, _rank(), _dim, _target, const_key(node));
+            if (bound < _best_dist)
+              { _stack.push(entry_type(far, child_dim, bound)); }
+          }
+        if (near != 0)
+          { _node = near; _dim = child_dim; }
+        else
+          {
+            _node = 0;
+            while (!_stack.empty())
+              {
+                entry_type entry = _stack.pop();
+                if (entry.bound < _best_dist)
+                  { _node = entry.node; _dim = entry.dim; break; }
+              }
+            if (_node == 0) return false;
+          }
+        batch_prefetch(_node);
+        return true;
+      }
+
+      result_type result() const { return _best; }
+
+    private:
+      Rank _rank;
+      KeyCompare _key_comp;
+      Metric _met;
+      Traversal_stack<entry_type> _stack;
+      NodePtr _node;
+      dimension_type _dim;
+      NodePtr _best;
+      distance_type _best_dist;
+      Key _target;
+    };
+
+    /**
+     *  A resumable count of the nodes matching a \region_predicate, which is
+     *  the query.
+     */
+    template <typename NodePtr, typename Rank, typename Predicate>
+    class Region_count_cursor
+    {
+    public:
+      typedef Predicate   query_type;
+      typedef std::size_t result_type;
+
+      Region_count_cursor(const Rank& rank, std::size_t depth_bound)
+        : _rank(rank), _stack(depth_bound), _node(0), _dim(0), _count(0),
+          _pred() { }
+
+      void start(NodePtr root, const Predicate& pred)
+      {
+        _stack.clear();
+        _node = root; _dim = 0; _count = 0; _pred = pred;
+        batch_prefetch(root);
+      }
+
+      bool step()
+      {
+        NodePtr node = _node;
+        relative_order rel = _pred(_dim, _rank(), const_key(node));
+        if (rel == matching)
+          {
+            dimension_type test = 0;
+            for (; test < _rank()
+                   && (test == _dim
+                       || _pred(test, _rank(), const_key(node)) == matching);
+                 ++test);
+            if (test == _rank()) { ++_count; }
+          }
+        NodePtr left = (rel != below) ? node->left : 0;
+        NodePtr right = (rel != above) ? node->right : 0;
+        dimension_type child_dim = incr_dim(_rank, _dim);
+        if (left != 0)
+          {
+            if (right != 0)
+              { _stack.push(Traversal_entry<NodePtr>(right, child_dim)); }
+            _node = left; _dim = child_dim;
+          }
+        else if (right != 0)
+          { _node = right; _dim = child_dim; }
+        else if (!_stack.empty())
+          {
+            Traversal_entry<NodePtr> entry = _stack.pop();
+            _node = entry.node; _dim = entry.dim;
+          }
+        else return false;
+        batch_prefetch(_node);
+        return true;
+      }
+
+      result_type result() const { return _count; }
+
+    private:
+      Rank _rank;
+      Traversal_stack<Traversal_entry<NodePtr> > _stack;
+      NodePtr _node;
+      dimension_type _dim;
+      std::size_t _count;
+      Predicate _pred;
+    };
+
+    /**
+     *  Runs the searches of the keys in [\c first, \c last) with \ref
+     *  Find_cursor, \c width at a time, and passes their results to \c store.
+     *  \return The number of keys read.
+     */
+    template <typename NodePtr, typename Rank, typename KeyCompare,
+              typename InputIterator, typename Store>
+    inline std::size_t
+    batch_find(NodePtr root, Rank rank, const KeyCompare& key_comp,
+               std::size_t depth_bound, std::size_t width,
+               InputIterator first, InputIterator last, Store store)
+    {
+      typedef Find_cursor
+        <NodePtr, Rank, KeyCompare,
+         typename std::iterator_traits<InputIterator>::value_type> cursor;
+      return interleave(root, cursor(rank, key_comp, depth_bound), width,
+                        first, last, store);
+    }
+
+    /**
+     *  Runs the nearest neighbor searches of the targets in [\c first, \c
+     *  last) with \ref Nearest_cursor, \c width at a time, and passes their
+     *  results to \c store.
+     *  \return The number of targets read.
+     */
+    template <typename NodePtr, typename Rank, typename KeyCompare,
+              typename Metric, typename InputIterator, typename Store>
+    inline std::size_t
+    batch_nearest(NodePtr root, Rank rank, const KeyCompare& key_comp,
+                  const Metric& met, std::size_t depth_bound,
+                  std::size_t width, InputIterator first, InputIterator last,
+                  Store store)
+    {
+      typedef Nearest_cursor
+        <NodePtr, Rank, KeyCompare, Metric,
+         typename std::iterator_traits<InputIterator>::value_type> cursor;
+      return interleave(root, cursor(rank, key_comp, met, depth_bound),
+                        width, first, last, store);
+    }
+
+    /**
+     *  Runs the counts of the predicates in [\c first, \c last) with \ref
+     *  Region_count_cursor, \c width at a time, and passes their results to
+     *  \c store.
+     *  \return The number of predicates read.
+     */
+    template <typename NodePtr, typename Rank, typename InputIterator,
+              typename Store>
+    inline std::size_t
+    batch_region_count(NodePtr root, Rank rank, std::size_t depth_bound,
+                       std::size_t width, InputIterator first,
+                       InputIterator last, Store store)
+    {
+      typedef Region_count_cursor
+        <NodePtr, Rank,
+         typename std::iterator_traits<InputIterator>::value_type> cursor;
+      return interleave(root, cursor(rank, depth_bound), width,
+                        first, last, store);
+    }
+
+    /**
+     *  \name Dispatch of \dynamic_rank
+     *
+     *  Overloads of the batch queries for \dynamic_rank. If the rank of the
+     *  container is listed in \ref SPATIAL_DISPATCH_RANKS, the cursors are
+     *  instantiated with the equivalent \static_rank.
+     */
+    ///@{
+    template <typename NodePtr, typename KeyCompare, typename InputIterator,
+              typename Store>
+    inline std::size_t
+    batch_find(NodePtr root, Dynamic_rank rank, const KeyCompare& key_comp,
+               std::size_t depth_bound, std::size_t width,
+               InputIterator first, InputIterator last, Store store)
+    {
+#     define SPATIAL_RANK_DISPATCH_CALL(r)                             \
+        batch_find(root, r, key_comp, depth_bound, width, first, last, store)
+      SPATIAL_RANK_DISPATCH(rank)
+#     undef SPATIAL_RANK_DISPATCH_CALL
+      return batch_find
+        <NodePtr, Dynamic_rank, KeyCompare, InputIterator, Store>
+        (root, rank, key_comp, depth_bound, width, first, last, store);
+    }
+
+    template <typename NodePtr, typename KeyCompare, typename Metric,
+              typename InputIterator, typename Store>
+    inline std::size_t
+    batch_nearest(NodePtr root, Dynamic_rank rank, const KeyCompare& key_comp,
+                  const Metric& met, std::size_t depth_bound,
+                  std::size_t width, InputIterator first, InputIterator last,
+                  Store store)
+    {
+#     define SPATIAL_RANK_DISPATCH_CALL(r)                             \
+        batch_nearest(root, r, key_comp, met, depth_bound, width,     \
+                      first, last, store)
+      SPATIAL_RANK_DISPATCH(rank)
+#     undef SPATIAL_RANK_DISPATCH_CALL
+      return batch_nearest
+        <NodePtr, Dynamic_rank, KeyCompare, Metric, InputIterator, Store>
+        (root, rank, key_comp, met, depth_bound, width, first, last, store);
+    }
+
+    template <typename NodePtr, typename InputIterator, typename Store>
+    inline std::size_t
+    batch_region_count(NodePtr root, Dynamic_rank rank,
+                       std::size_t depth_bound, std::size_t width,
+                       InputIterator first, InputIterator last, Store store)
+    {
+#     define SPATIAL_RANK_DISPATCH_CALL(r)                             \
+        batch_region_count(root, r, depth_bound, width, first, last, store)
+      SPATIAL_RANK_DISPATCH(rank)
+#     undef SPATIAL_RANK_DISPATCH_CALL
+      return batch_region_count
+        <NodePtr, Dynamic_rank, InputIterator, Store>
+        (root, rank, depth_bound, width, first, last, store);
+    }
+    ///@}
+
+  } // namespace details
+} // namespace spatial
+
+#endif // SPATIAL_BATCH_HPP
@@ -14,6 +14,7 @@
 #define SPATIAL_BIDIRECTIONAL_HPP
 
 #include "spatial_node.hpp"
+#include "spatial_stats.hpp"
 
 namespace spatial
 {
@@ -30,7 +31,7 @@ namespace spatial
      *  \tparam Rank      The rank of the iterator.
      */
     template <typename Link, typename Rank>
-    class Bidirectional_iterator : private Rank
+    class Bidirectional_iterator : private Rank, public Iterator_stats
     {
     public:
       //! The \c value_type can receive a copy of the reference pointed to be
@@ -142,7 +143,8 @@ namespace spatial
      *  \tparam Rank      The rank of the iterator.
      */
     template <typename Link, typename Rank>
-    class Const_bidirectional_iterator : private Rank
+    class Const_bidirectional_iterator
+      : private Rank, public Iterator_stats
     {
     public:
       //! The \c value_type can receive a copy of the reference pointed to be
@@ -171,6 +173,14 @@ namespace spatial
                                    dimension_type node_dim_)
         : Rank(rank_), node(node_), node_dim(node_dim_) { }
 
+      //! Initialize the node at construction time and copy the counts of
+      //! the iterator it is converted from.
+      Const_bidirectional_iterator(const Rank& rank_, node_ptr node_,
+                                   dimension_type node_dim_,
+                                   const Iterator_stats& stats_)
+        : Rank(rank_), Iterator_stats(stats_), node(node_),
+          node_dim(node_dim_) { }
+
       //! Returns the reference to the value pointed to by the iterator.
       reference operator*()
       { return const_value(node); }
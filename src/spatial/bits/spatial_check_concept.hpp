@@ -43,6 +43,39 @@ namespace spatial
   struct enable_if : public enable_if_c<Cond::value, Tp> { };
   ///@}
 
+  namespace details
+  {
+    /**
+     *  Statically resolves whether the functor \c Tp declares the nested type
+     *  \c is_transparent, i.e. whether it accepts arguments of any type
+     *  rather than only the key type of a container, like \ref
+     *  bracket_less<void>. Designed to be used with \ref enable_if.
+     */
+    template <typename Tp>
+    struct is_transparent
+    {
+    private:
+      template <typename Up> static char test(typename Up::is_transparent*);
+      template <typename Up> static long test(...);
+
+    public:
+      static const bool value = (sizeof(test<Tp>(0)) == sizeof(char));
+    };
+
+    /**
+     *  Statically resolves whether an overload taking a \c Query instead of a
+     *  \c Key should be enabled: only if \c Functor is transparent and \c
+     *  Query differs from \c Key, for which the regular overload is used.
+     */
+    template <typename Functor, typename Query, typename Key>
+    struct is_transparent_query
+    { static const bool value = is_transparent<Functor>::value; };
+
+    template <typename Functor, typename Key>
+    struct is_transparent_query<Functor, Key, Key>
+    { static const bool value = false; };
+  } // namespace details
+
 } // namespace spatial
 
 #endif // SPATIAL_CHECK_CONCEPT_HPP
@@ -0,0 +1,419 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   spatial_collapsed_kdtree.hpp
+ *  Contains the definition of \ref spatial::details::Collapsed_kdtree, the
+ *  tree used by the collapsed containers, which store all the values sharing
+ *  the same key in a single node.
+ */
+
+#ifndef SPATIAL_COLLAPSED_KDTREE_HPP
+#define SPATIAL_COLLAPSED_KDTREE_HPP
+
+#include <new> // placement new
+#include <vector>
+#include <utility> // std::pair
+#include <memory> // std::allocator_traits
+#include <type_traits> // std::aligned_storage, std::alignment_of
+#include "spatial_relaxed_kdtree.hpp"
+#include "../collapsed_iterator.hpp"
+
+namespace spatial
+{
+  namespace details
+  {
+    /**
+     *  Extracts the key of a value stored in a collapsed container. In a
+     *  mapped container, the key is the first member of the value.
+     */
+    template <typename Key, typename Value>
+    struct Collapsed_key
+    {
+      static const Key& get(const Value& value) { return value.first; }
+    };
+
+    /**
+     *  In a collapsed container that is not mapped, the value is the key.
+     */
+    template <typename Key>
+    struct Collapsed_key<Key, Key>
+    {
+      static const Key& get(const Key& value) { return value; }
+    };
+
+    /**
+     *  The values held by a node of a collapsed map. The first value is
+     *  stored in the node itself; a list is only allocated for the values
+     *  that follow it, when a key is inserted more than once.
+     *
+     *  The values of a map cannot be assigned, since their key is constant.
+     *  So when the first value is erased, its place is left empty rather
+     *  than filled with the next value, and the list is built again when a
+     *  value is erased from its middle.
+     */
+    template <typename Key, typename Value, typename Alloc>
+    class Collapsed_bucket
+    {
+      typedef std::vector<Value, typename std::allocator_traits<Alloc>
+                          ::template rebind_alloc<Value> > list_type;
+
+    public:
+      Collapsed_bucket(const Value& value, const Alloc& alloc)
+        : _rest(alloc), _has_first(false)
+      { ::new (first_address()) Value(value); _has_first = true; }
+
+      Collapsed_bucket(const Collapsed_bucket& other)
+        : _rest(other._rest), _has_first(false)
+      {
+        if (other._has_first)
+          { ::new (first_address()) Value(other.first()); _has_first = true; }
+      }
+
+      ~Collapsed_bucket() { if (_has_first) first().~Value(); }
+
+      //! The number of values in the bucket.
+      std::size_t size() const { return _rest.size() + (_has_first ? 1 : 0); }
+
+      ///@{
+      //! The value at position \c pos in the bucket.
+      Value& value(const Key&, std::size_t pos)
+      {
+        if (!_has_first) return _rest[pos];
+        return pos == 0 ? first() : _rest[pos - 1];
+      }
+
+      const Value& value(const Key&, std::size_t pos) const
+      {
+        if (!_has_first) return _rest[pos];
+        return pos == 0 ? first() : _rest[pos - 1];
+      }
+      ///@}
+
+      //! Appends \c value after the other values of the bucket.
+      void push_back(const Value& value) { _rest.push_back(value); }
+
+      //! Removes the value at position \c pos, which must not be the only
+      //! value of the bucket.
+      void erase(std::size_t pos)
+      {
+        SPATIAL_ASSERT_CHECK(size() > 1);
+        if (_has_first)
+          {
+            if (pos == 0) { _has_first = false; first().~Value(); return; }
+            --pos;
+          }
+        if (pos + 1 == _rest.size()) { _rest.pop_back(); return; }
+        list_type rest(_rest.get_allocator());
+        rest.reserve(_rest.size() - 1);
+        for (std::size_t i = 0; i < _rest.size(); ++i)
+          { if (i != pos) rest.push_back(_rest[i]); }
+        _rest.swap(rest);
+      }
+
+    private:
+      //! The buckets are never assigned: they are built in the nodes.
+      Collapsed_bucket& operator=(const Collapsed_bucket&);
+
+      void* first_address() { return &_first; }
+
+      Value& first() { return *reinterpret_cast<Value*>(&_first); }
+
+      const Value& first() const
+      { return *reinterpret_cast<const Value*>(&_first); }
+
+      //! The storage of the first value, which is empty once it is erased.
+      typename std::aligned_storage
+      <sizeof(Value), std::alignment_of<Value>::value>::type _first;
+
+      //! The values that follow the first one.
+      list_type _rest;
+
+      //! True while the first value is stored in \c _first.
+      bool _has_first;
+    };
+
+    /**
+     *  In a collapsed container that is not mapped, all the values of a node
+     *  are equal to its key, so the bucket only counts them.
+     */
+    template <typename Key, typename Alloc>
+    class Collapsed_bucket<Key, Key, Alloc>
+    {
+    public:
+      Collapsed_bucket(const Key&, const Alloc&) : _count(1) { }
+
+      //! The number of values in the bucket.
+      std::size_t size() const { return _count; }
+
+      //! The value at any position in the bucket is the key of the node.
+      const Key& value(const Key& key, std::size_t) const { return key; }
+
+      //! Counts one more value equal to the key of the node.
+      void push_back(const Key&) { ++_count; }
+
+      //! Counts one less value, which must not be the only value.
+      void erase(std::size_t)
+      { SPATIAL_ASSERT_CHECK(_count > 1); --_count; }
+
+    private:
+      //! The number of values equal to the key of the node.
+      std::size_t _count;
+    };
+
+    /**
+     *  A tree in which each node holds one distinct key along with the
+     *  values that were inserted with a key equal to it, in a \ref
+     *  Collapsed_bucket: the values of a map, or their count in a set.
+     *
+     *  Storing equal keys in a single node keeps the depth of the tree
+     *  proportional to the number of distinct keys, rather than to the number
+     *  of values, and turns the search for all values matching a key into a
+     *  single \ref first_equal descent. The bucket of a node is never
+     *  empty: the node is removed from the tree along with its last value.
+     *
+     *  \tparam Rank Either \static_rank or \dynamic_rank.
+     *  \tparam Key The key type of the values stored in the container.
+     *  \tparam Value Either \c Key, or a pair of a \c const \c Key and a mapped
+     *  type.
+     *  \tparam Compare A model of \generalized_compare.
+     *  \tparam Balancing The balancing policy of the underlying tree.
+     *  \tparam Alloc An allocator for \c Value.
+     */
+    template <typename Rank, typename Key, typename Value, typename Compare,
+              typename Balancing, typename Alloc>
+    class Collapsed_kdtree
+    {
+      typedef Collapsed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc>
+      Self;
+      typedef Collapsed_key<Key, typename mutate<Value>::type> key_of;
+
+    public:
+      typedef Rank                                      rank_type;
+      typedef Key                                       key_type;
+      typedef typename mutate<Value>::type              value_type;
+      typedef Compare                                   key_compare;
+      typedef Balancing                                 balancing_policy;
+      typedef Alloc                                     allocator_type;
+      typedef std::size_t                               size_type;
+      typedef std::ptrdiff_t                            difference_type;
+
+      //! The values held by a node.
+      typedef Collapsed_bucket<Key, value_type, Alloc>  bucket_type;
+
+      //! The tree holding the nodes, one for each distinct key.
+      typedef Relaxed_kdtree
+      <Rank, const Key, std::pair<const Key, bucket_type>, Compare, Balancing,
+       typename std::allocator_traits<Alloc>::template rebind_alloc
+       <std::pair<const Key, bucket_type> > >           tree_type;
+
+      typedef collapsed_iterator<typename tree_type::iterator, Value>
+      iterator;
+      typedef collapsed_iterator<typename tree_type::const_iterator,
+                                 const value_type>      const_iterator;
+      typedef std::pair<iterator, iterator>             iterator_pair;
+      typedef std::pair<const_iterator, const_iterator> const_iterator_pair;
+
+      Collapsed_kdtree() : _tree(), _count(0) { }
+
+      Collapsed_kdtree(const rank_type& rank_, const key_compare& compare_,
+                       const balancing_policy& balancing_
+                       = balancing_policy(),
+                       const allocator_type& alloc_ = allocator_type())
+        : _tree(rank_, compare_, balancing_,
+                typename tree_type::allocator_type(alloc_)),
+          _count(0) { }
+
+      Collapsed_kdtree(const Self& other)
+        : _tree(other._tree), _count(other._count) { }
+
+      Self& operator=(const Self& other)
+      {
+        if (&other != this) { _tree = other._tree; _count = other._count; }
+        return *this;
+      }
+
+      //! The tree holding one node for each distinct key; its iterators may
+      //! be adapted with \ref collapsed_iterator to enumerate the values.
+      const tree_type& tree() const { return _tree; }
+
+      rank_type rank() const { return _tree.rank(); }
+      dimension_type dimension() const { return _tree.dimension(); }
+      key_compare key_comp() const { return _tree.key_comp(); }
+      balancing_policy balancing() const { return _tree.balancing(); }
+      allocator_type get_allocator() const
+      { return allocator_type(_tree.get_allocator()); }
+
+      //! True if the container holds no value.
+      bool empty() const { return _count == 0; }
+
+      //! The number of values in the container.
+      size_type size() const { return _count; }
+
+      //! The number of values in the container. Same as size().
+      size_type count() const { return _count; }
+
+      //! The number of distinct keys in the container.
+      size_type key_count() const { return _tree.size(); }
+
+      size_type max_size() const { return _tree.max_size(); }
+
+      iterator begin() { return iterator(_tree.begin()); }
+      const_iterator begin() const { return const_iterator(_tree.begin()); }
+      const_iterator cbegin() const { return const_iterator(_tree.begin()); }
+      iterator end() { return iterator(_tree.end()); }
+      const_iterator end() const { return const_iterator(_tree.end()); }
+      const_iterator cend() const { return const_iterator(_tree.end()); }
+
+      /**
+       *  Insert \c value in the node holding its key, or in a new node if the
+       *  key is not yet present in the container.
+       */
+      iterator insert(const value_type& value)
+      {
+        const key_type& key = key_of::get(value);
+        typename tree_type::iterator node = _tree.find(key);
+        if (node == _tree.end())
+          {
+            node = _tree.insert
+              (std::pair<const Key, bucket_type>
+               (key, bucket_type(value, get_allocator())));
+            ++_count;
+            return iterator(node);
+          }
+        (*node).second.push_back(value);
+        ++_count;
+        return iterator(node, (*node).second.size() - 1);
+      }
+
+      /**
+       *  Insert a serie of values in the container.
+       */
+      template <typename InputIterator>
+      void insert(InputIterator first, InputIterator last)
+      { for (; first != last; ++first) { insert(*first); } }
+
+      /**
+       *  Deletes the value pointed to by \c position. The node is removed
+       *  from the tree if it was the last value with this key.
+       */
+      void erase(iterator position)
+      {
+        typename tree_type::iterator node = position.base();
+        bucket_type& bucket = (*node).second;
+        SPATIAL_ASSERT_CHECK(position.position() < bucket.size());
+        if (bucket.size() == 1) { _tree.erase(node); }
+        else { bucket.erase(position.position()); }
+        --_count;
+      }
+
+      /**
+       *  Deletes all values matching \c key, and returns their number.
+       */
+      size_type erase(const key_type& key)
+      {
+        typename tree_type::iterator node = _tree.find(key);
+        if (node == _tree.end()) return 0;
+        size_type erased = (*node).second.size();
+        _tree.erase(node);
+        _count -= erased;
+        return erased;
+      }
+
+      //! Erase all values in the container.
+      void clear() { _tree.clear(); _count = 0; }
+
+      void swap(Self& other)
+      {
+        _tree.swap(other._tree);
+        std::swap(_count, other._count);
+      }
+
+      ///@{
+      /**
+       *  Find the first value inserted with \c key, or returns the element
+       *  past the end of the container.
+       */
+      iterator find(const key_type& key)
+      { return iterator(_tree.find(key)); }
+
+      const_iterator find(const key_type& key) const
+      { return const_iterator(_tree.find(key)); }
+      ///@}
+
+      //! Returns the number of values matching \c key.
+      size_type count(const key_type& key) const
+      {
+        typename tree_type::const_iterator node = _tree.find(key);
+        return node == _tree.end() ? 0 : (*node).second.size();
+      }
+
+      ///@{
+      /**
+       *  Returns the range of values that match \c key. Since these values
+       *  are held in the same node, the range is found with a single descent
+       *  of the tree.
+       */
+      iterator_pair equal_range(const key_type& key)
+      {
+        typename tree_type::iterator node = _tree.find(key);
+        if (node == _tree.end()) return iterator_pair(end(), end());
+        typename tree_type::iterator next = node;
+        return iterator_pair(iterator(node), iterator(++next));
+      }
+
+      const_iterator_pair equal_range(const key_type& key) const
+      {
+        typename tree_type::const_iterator node = _tree.find(key);
+        if (node == _tree.end())
+          return const_iterator_pair(end(), end());
+        typename tree_type::const_iterator next = node;
+        return const_iterator_pair(const_iterator(node),
+                                   const_iterator(++next));
+      }
+      ///@}
+
+    private:
+      //! The tree of distinct keys.
+      tree_type _tree;
+
+      //! The number of values in all nodes of the tree.
+      size_type _count;
+    };
+
+    /**
+     *  Swap the content of the collapsed trees \c left and \c right.
+     */
+    template <typename Rank, typename Key, typename Value, typename Compare,
+              typename Balancing, typename Alloc>
+    inline void swap
+    (Collapsed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc>& left,
+     Collapsed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc>& right)
+    { left.swap(right); }
+
+    /**
+     *  The tree of \c container, through which the mapped values of its
+     *  nodes may be modified by the region and neighbor iterators of \ref
+     *  collapsed_point_multimap. The keys of the tree remain constant, so
+     *  these iterators cannot break its invariants.
+     */
+    template <typename Rank, typename Key, typename Value, typename Compare,
+              typename Balancing, typename Alloc>
+    inline typename Collapsed_kdtree
+    <Rank, Key, Value, Compare, Balancing, Alloc>::tree_type&
+    mutable_tree
+    (Collapsed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc>& container)
+    {
+      return const_cast<typename Collapsed_kdtree
+                        <Rank, Key, Value, Compare, Balancing, Alloc>
+                        ::tree_type&>(container.tree());
+    }
+
+  } // namespace details
+} // namespace spatial
+
+#endif // SPATIAL_COLLAPSED_KDTREE_HPP
@@ -0,0 +1,61 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   spatial_coordinate.hpp
+ *  Reads the coordinates of a key as numbers, for the containers that
+ *  compute on coordinates rather than only compare them.
+ */
+
+#ifndef SPATIAL_COORDINATE_HPP
+#define SPATIAL_COORDINATE_HPP
+
+#include <iterator> // std::advance, std::iterator_traits
+#include "../function.hpp"
+
+namespace spatial
+{
+  namespace details
+  {
+    /**
+     *  Returns the coordinate of \c key on the dimension \c n, read in the
+     *  same way as \c compare reads it.
+     */
+    ///@{
+    template <typename Key>
+    inline double
+    compare_coordinate(const bracket_less<Key>&, dimension_type n,
+                       const Key& key)
+    { return static_cast<double>(key[n]); }
+
+    template <typename Key>
+    inline double
+    compare_coordinate(const paren_less<Key>&, dimension_type n,
+                       const Key& key)
+    { return static_cast<double>(key(n)); }
+
+    template <typename Key>
+    inline double
+    compare_coordinate(const iterator_less<Key>&, dimension_type n,
+                       const Key& key)
+    {
+      typename Key::const_iterator i = key.begin();
+      std::advance(i, static_cast<typename std::iterator_traits
+                   <typename Key::const_iterator>::difference_type>(n));
+      return static_cast<double>(*i);
+    }
+
+    template <typename Accessor, typename Key>
+    inline double
+    compare_coordinate(const accessor_less<Accessor, Key>& compare,
+                       dimension_type n, const Key& key)
+    { return static_cast<double>(compare.accessor()(n, key)); }
+    ///@}
+  } // namespace details
+} // namespace spatial
+
+#endif // SPATIAL_COORDINATE_HPP
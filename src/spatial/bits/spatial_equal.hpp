@@ -17,68 +17,120 @@
 
 #include "spatial_import_tuple.hpp"
 #include "spatial_assert.hpp"
+#include "spatial_rank.hpp"
+#include "spatial_stats.hpp"
 
 namespace spatial
 {
   namespace details
   {
+    /**
+     *  Returns \c true if the left subtree of \c node may hold keys equal to
+     *  \c key, counting the comparison of keys.
+     */
+    template <typename NodePtr, typename KeyCompare, typename Key>
+    inline bool
+    equal_left(NodePtr node, dimension_type dim, const KeyCompare& key_comp,
+               const Key& key)
+    { return !evaluated(key_comp(dim, const_key(node), key)); }
+
+    /**
+     *  Returns \c true if the right subtree of \c node may hold keys equal to
+     *  \c key, counting the comparison of keys.
+     */
+    template <typename NodePtr, typename KeyCompare, typename Key>
+    inline bool
+    equal_right(NodePtr node, dimension_type dim, const KeyCompare& key_comp,
+                const Key& key)
+    { return !evaluated(key_comp(dim, key, const_key(node))); }
+
+    /**
+     *  Returns \c true if the key of \c node is equal to \c key along the
+     *  dimension \c dim, counting the comparisons of keys.
+     */
+    template <typename NodePtr, typename KeyCompare, typename Key>
+    inline bool
+    equal_key(NodePtr node, dimension_type dim, const KeyCompare& key_comp,
+              const Key& key)
+    {
+      return equal_right(node, dim, key_comp, key)
+        && equal_left(node, dim, key_comp, key);
+    }
+
     template <typename NodePtr, typename Rank, typename KeyCompare,
               typename Key>
     inline std::pair<NodePtr, dimension_type>
-    first_equal(NodePtr node, dimension_type depth, const Rank rank,
+    first_equal(NodePtr node, dimension_type dim, const Rank rank,
                 const KeyCompare& key_comp, const Key& key)
     {
       SPATIAL_ASSERT_CHECK(!header(node));
       SPATIAL_ASSERT_CHECK(node != 0);
       // Write in pre-order fashion
       NodePtr end = node->parent;
-      dimension_type end_depth = depth - 1;
+      dimension_type end_dim = decr_dim(rank, dim);
       for (;;)
         {
-          dimension_type dim = depth % rank();
           // Test coordinates of node's key, retain results for dim
-          bool walk_left = !key_comp(dim, const_key(node), key);
-          bool walk_right = !key_comp(dim, key, const_key(node));
+          bool walk_left = equal_left(node, dim, key_comp, key);
+          bool walk_right = equal_right(node, dim, key_comp, key);
           if (walk_left && walk_right)
             {
               dimension_type test = 0;
-              for (; test < dim && !(key_comp(test, key, const_key(node))
-                                     || key_comp(test, const_key(node), key));
+              for (; test < dim && equal_key(node, test, key_comp, key);
                    ++test);
               if (test == dim)
                 {
                   test = dim + 1;
                   for (; test < rank()
-                         && !(key_comp(test, key, const_key(node))
-                              || key_comp(test, const_key(node), key));
+                         && equal_key(node, test, key_comp, key);
                        ++test);
                   if (test == rank())
-                    { return std::make_pair(node, depth); }
+                    { return std::make_pair(node, dim); }
                 }
             }
+          if (node->left != 0) explore(walk_left);
+          if (node->right != 0) explore(walk_right);
           // Walk the tree to find an equal target
           if (walk_right && node->right != 0)
             {
-              ++depth;
+              dim = incr_dim(rank, dim);
               if (walk_left && node->left != 0)
                 {
                   // Go recursively in this case only, left first
                   NodePtr other;
-                  dimension_type other_depth;
-                  import::tie(other, other_depth)
-                    = first_equal(node->left, depth,
+                  dimension_type other_dim;
+                  import::tie(other, other_dim)
+                    = first_equal(descend(node->left), dim,
                                   rank, key_comp, key);
                   if (other != node)
-                    { return std::make_pair(other, other_depth); }
+                    { return std::make_pair(other, other_dim); }
                 }
-              node = node->right;
+              node = descend(node->right);
             }
           else if (walk_left && node->left != 0)
-            { node = node->left; ++depth; }
-          else { return std::make_pair(end, end_depth); }
+            { node = descend(node->left); dim = incr_dim(rank, dim); }
+          else { return std::make_pair(end, end_dim); }
         }
     }
 
+    /**
+     *  Overload of \ref first_equal() for \dynamic_rank. If the rank of the
+     *  container is listed in \ref SPATIAL_DISPATCH_RANKS, the search is
+     *  carried out with the equivalent \static_rank.
+     */
+    template <typename NodePtr, typename KeyCompare, typename Key>
+    inline std::pair<NodePtr, dimension_type>
+    first_equal(NodePtr node, dimension_type dim, Dynamic_rank rank,
+                const KeyCompare& key_comp, const Key& key)
+    {
+#     define SPATIAL_RANK_DISPATCH_CALL(r) \
+        first_equal(node, dim, r, key_comp, key)
+      SPATIAL_RANK_DISPATCH(rank)
+#     undef SPATIAL_RANK_DISPATCH_CALL
+      return first_equal<NodePtr, Dynamic_rank, KeyCompare, Key>
+        (node, dim, rank, key_comp, key);
+    }
+
   } // namespace details
 } // namespace spatial
 
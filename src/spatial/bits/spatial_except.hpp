@@ -115,7 +115,8 @@ namespace spatial
     /**
      *  Checks if all coordinates of \c lower are strictly less than these of
      *  \c higher along the same dimensions. The number of dimensions is limited
-     *  by the rank of \c container.
+     *  by the rank of \c container. \c lower and \c upper are keys of \c
+     *  container, or of another type if its comparator is transparent.
      *  \exception invalid_bounds is thrown if the check fails.
      *  \param container providing type information, comparison and rank.
      *  \param lower the lower bound of the interval considered.
@@ -124,11 +125,9 @@ namespace spatial
      *  This check is performed mainly upon creation of a \ref open_bounds
      *  predicate.
      */
-    template<typename Container>
+    template<typename Container, typename Key>
     inline void check_open_bounds
-    (const Container& container,
-     const typename Container::key_type& lower,
-     const typename Container::key_type& upper)
+    (const Container& container, const Key& lower, const Key& upper)
     {
       for (dimension_type dim = 0; dim < container.dimension(); ++dim)
         if (!container.key_comp()(dim, lower, upper))
@@ -145,11 +144,9 @@ namespace spatial
      *  This check is performed mainly upon creation of a \ref bounds
      *  predicate.
      */
-    template<typename Container>
+    template<typename Container, typename Key>
     inline void check_bounds
-    (const Container& container,
-     const typename Container::key_type& lower,
-     const typename Container::key_type& upper)
+    (const Container& container, const Key& lower, const Key& upper)
     {
         return check_open_bounds(container, lower, upper);
     }
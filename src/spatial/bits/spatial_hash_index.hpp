@@ -0,0 +1,265 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   spatial_hash_index.hpp
+ *  Contains the definition of \ref spatial::details::Hash_index, the open
+ *  addressing table of node pointers used by \ref spatial::hash_indexed to
+ *  answer exact key lookups without descending the tree.
+ */
+
+#ifndef SPATIAL_HASH_INDEX_HPP
+#define SPATIAL_HASH_INDEX_HPP
+
+#include <vector>
+#include <algorithm> // std::swap
+#include <memory> // std::allocator_traits
+#include "spatial_assert.hpp"
+
+namespace spatial
+{
+  namespace details
+  {
+    /**
+     *  Returns true if \c x and \c y are equivalent along all dimensions of \c
+     *  rank with respect to \c key_comp, that is, if neither key is less than
+     *  the other on any dimension.
+     */
+    template <typename Rank, typename KeyCompare, typename Key>
+    inline bool
+    equal_key(const Rank& rank, const KeyCompare& key_comp,
+              const Key& x, const Key& y)
+    {
+      for (dimension_type dim = 0; dim < rank(); ++dim)
+        {
+          if (key_comp(dim, x, y) || key_comp(dim, y, x))
+            { return false; }
+        }
+      return true;
+    }
+
+    /**
+     *  An open addressing hash table with linear probing that stores pointers
+     *  to the nodes of a tree along with the hash of their key.
+     *
+     *  The table does not know how to hash keys: callers provide the hash of
+     *  the key with each operation. Several entries may share the same hash,
+     *  whether their keys are equal or not. It is the responsibility of the
+     *  caller to filter entries by key once they have been retrieved with
+     *  \ref first() and \ref next().
+     *
+     *  Since nodes are never moved in memory by the trees, even when they are
+     *  relinked by rebalancing or by \c swap_node, the pointers stored in the
+     *  table remain valid for as long as the node is not destroyed.
+     *
+     *  Erasure uses backward shift deletion, therefore the table never
+     *  contains tombstones and the load factor is kept below one half.
+     *
+     *  \tparam NodePtr The type of pointer to the nodes being indexed.
+     *  \tparam Alloc The allocator used by the container, rebound to allocate
+     *  the slots of the table.
+     */
+    template <typename NodePtr, typename Alloc>
+    class Hash_index
+    {
+    public:
+      typedef std::size_t                                size_type;
+      typedef NodePtr                                    node_ptr;
+
+    private:
+      //! A slot of the table, empty when \c node is null.
+      struct Slot
+      {
+        Slot() : hash(0), node(0) { }
+        Slot(std::size_t hash_, NodePtr node_) : hash(hash_), node(node_) { }
+        std::size_t hash;
+        NodePtr node;
+      };
+
+      typedef typename std::allocator_traits<Alloc>
+      ::template rebind_alloc<Slot>                      Slot_allocator;
+      typedef std::vector<Slot, Slot_allocator>          Slot_store;
+
+      //! The position, in a table of \c capacity slots, of \c hash.
+      static size_type home(std::size_t hash, size_type capacity)
+      { return static_cast<size_type>(hash) & (capacity - 1); }
+
+      //! The position following \c slot in a table of \c capacity slots.
+      static size_type step(size_type slot, size_type capacity)
+      { return (slot + 1) & (capacity - 1); }
+
+    public:
+      explicit Hash_index(const Alloc& alloc = Alloc())
+        : _slots(Slot_allocator(alloc)), _count(0) { }
+
+      //! The number of nodes held in the table.
+      size_type size() const { return _count; }
+
+      //! True if the table holds no node.
+      bool empty() const { return _count == 0; }
+
+      //! The number of slots in the table; also used as the past-the-end slot.
+      size_type bucket_count() const { return _slots.size(); }
+
+      //! The node held by the slot \c slot.
+      NodePtr node(size_type slot) const
+      {
+        SPATIAL_ASSERT_CHECK(slot < _slots.size());
+        return _slots[slot].node;
+      }
+
+      /**
+       *  Ensures that \c n nodes can be held by the table without growing it.
+       *  Existing entries are re-distributed if the table must grow.
+       */
+      void reserve(size_type n)
+      {
+        size_type capacity = _slots.size() < 16 ? 16 : _slots.size();
+        while (capacity < 2 * n + 1) { capacity <<= 1; }
+        if (capacity == _slots.size()) return;
+        Slot_store store(capacity, Slot(), _slots.get_allocator()); // may throw
+        for (typename Slot_store::const_iterator i = _slots.begin();
+             i != _slots.end(); ++i)
+          {
+            if (i->node == 0) continue;
+            size_type slot = home(i->hash, capacity);
+            while (store[slot].node != 0) { slot = step(slot, capacity); }
+            store[slot] = *i;
+          }
+        _slots.swap(store);
+      }
+
+      /**
+       *  Add \c node to the table, under \c hash.
+       */
+      void insert(std::size_t hash, NodePtr node)
+      {
+        SPATIAL_ASSERT_CHECK(node != 0);
+        reserve(_count + 1); // may throw
+        size_type capacity = _slots.size();
+        size_type slot = home(hash, capacity);
+        while (_slots[slot].node != 0) { slot = step(slot, capacity); }
+        _slots[slot] = Slot(hash, node);
+        ++_count;
+      }
+
+      /**
+       *  Remove \c node from the table. \c hash must be the value that was
+       *  given when \c node was inserted.
+       */
+      void erase(std::size_t hash, NodePtr node)
+      {
+        SPATIAL_ASSERT_CHECK(node != 0);
+        SPATIAL_ASSERT_CHECK(!_slots.empty());
+        size_type capacity = _slots.size();
+        size_type hole = home(hash, capacity);
+        while (_slots[hole].node != node)
+          {
+            SPATIAL_ASSERT_CHECK(_slots[hole].node != 0);
+            hole = step(hole, capacity);
+          }
+        // Shift back the following entries of the cluster that would become
+        // unreachable from their home slot.
+        for (size_type slot = step(hole, capacity); _slots[slot].node != 0;
+             slot = step(slot, capacity))
+          {
+            size_type start = home(_slots[slot].hash, capacity);
+            bool reachable = (hole < slot)
+              ? (start > hole && start <= slot)
+              : (start > hole || start <= slot);
+            if (!reachable) { _slots[hole] = _slots[slot]; hole = slot; }
+          }
+        _slots[hole] = Slot();
+        --_count;
+      }
+
+      /**
+       *  Returns the first slot holding an entry for \c hash, or \ref
+       *  bucket_count() if there is none.
+       */
+      size_type first(std::size_t hash) const
+      {
+        if (_count == 0) return _slots.size();
+        return seek(home(hash, _slots.size()), hash);
+      }
+
+      /**
+       *  Returns the slot following \c slot that holds an entry for \c hash,
+       *  or \ref bucket_count() if there is none.
+       */
+      size_type next(size_type slot, std::size_t hash) const
+      {
+        SPATIAL_ASSERT_CHECK(slot < _slots.size());
+        return seek(step(slot, _slots.size()), hash);
+      }
+
+      //! Removes all entries and releases the memory held by the table.
+      void clear()
+      { Slot_store(_slots.get_allocator()).swap(_slots); _count = 0; }
+
+      //! Swap the content of the table with \c other.
+      void swap(Hash_index& other)
+      {
+        _slots.swap(other._slots);
+        std::swap(_count, other._count);
+      }
+
+    private:
+      //! Walks the cluster from \c slot until an entry for \c hash is found.
+      size_type seek(size_type slot, std::size_t hash) const
+      {
+        size_type capacity = _slots.size();
+        for (; _slots[slot].node != 0; slot = step(slot, capacity))
+          { if (_slots[slot].hash == hash) return slot; }
+        return capacity;
+      }
+
+      //! The slots of the table, its size is always a power of 2.
+      Slot_store _slots;
+
+      //! The number of non-empty slots.
+      size_type _count;
+    };
+
+    /**
+     *  Returns the first slot in \c index that holds a node whose key is equal
+     *  to \c key, or \c index.bucket_count() if there is none.
+     */
+    template <typename Index, typename Rank, typename KeyCompare,
+              typename Key>
+    inline typename Index::size_type
+    first_indexed_equal(const Index& index, std::size_t hash, const Rank& rank,
+                        const KeyCompare& key_comp, const Key& key)
+    {
+      typename Index::size_type slot = index.first(hash);
+      while (slot != index.bucket_count()
+             && !equal_key(rank, key_comp, const_key(index.node(slot)), key))
+        { slot = index.next(slot, hash); }
+      return slot;
+    }
+
+    /**
+     *  Returns the slot in \c index following \c slot that holds a node whose
+     *  key is equal to \c key, or \c index.bucket_count() if there is none.
+     */
+    template <typename Index, typename Rank, typename KeyCompare,
+              typename Key>
+    inline typename Index::size_type
+    next_indexed_equal(const Index& index, typename Index::size_type slot,
+                       std::size_t hash, const Rank& rank,
+                       const KeyCompare& key_comp, const Key& key)
+    {
+      do { slot = index.next(slot, hash); }
+      while (slot != index.bucket_count()
+             && !equal_key(rank, key_comp, const_key(index.node(slot)), key));
+      return slot;
+    }
+
+  } // namespace details
+} // namespace spatial
+
+#endif // SPATIAL_HASH_INDEX_HPP
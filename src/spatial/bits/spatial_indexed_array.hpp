@@ -0,0 +1,313 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   spatial_indexed_array.hpp
+ *  Contains the definition of \ref spatial::details::Indexed_array, the
+ *  storage shared by the containers that index an array of values and
+ *  rebuild their index from time to time, rather than updating it on each
+ *  insertion or erasure.
+ */
+
+#ifndef SPATIAL_INDEXED_ARRAY_HPP
+#define SPATIAL_INDEXED_ARRAY_HPP
+
+#include <vector>
+#include <iterator> // std::bidirectional_iterator_tag
+#include <algorithm> // std::swap
+
+namespace spatial
+{
+  namespace details
+  {
+    /**
+     *  The iterator of an \ref Indexed_array, which visits the values of the
+     *  array in the order in which they are stored, and skips the erased
+     *  ones. The iterators are ordered by the position of their value in
+     *  the array.
+     */
+    template <typename Array>
+    class Indexed_array_iterator
+    {
+    public:
+      typedef std::bidirectional_iterator_tag            iterator_category;
+      typedef typename Array::value_type                 value_type;
+      typedef typename Array::difference_type            difference_type;
+      typedef typename Array::const_pointer              pointer;
+      typedef typename Array::const_reference            reference;
+
+      //! Uninitialized iterator.
+      Indexed_array_iterator() : _array(0), _pos(0) { }
+
+      //! Builds an iterator to the value at \c pos in \c array.
+      Indexed_array_iterator(const Array& array, std::size_t pos)
+        : _array(&array), _pos(pos) { }
+
+      reference operator*() const { return _array->slot(_pos); }
+
+      pointer operator->() const { return &_array->slot(_pos); }
+
+      Indexed_array_iterator& operator++()
+      {
+        _pos = _array->next_slot(_pos + 1);
+        return *this;
+      }
+
+      Indexed_array_iterator operator++(int)
+      {
+        Indexed_array_iterator x(*this);
+        ++*this;
+        return x;
+      }
+
+      Indexed_array_iterator& operator--()
+      {
+        do { --_pos; } while (_array->is_erased(_pos));
+        return *this;
+      }
+
+      Indexed_array_iterator operator--(int)
+      {
+        Indexed_array_iterator x(*this);
+        --*this;
+        return x;
+      }
+
+      bool operator==(const Indexed_array_iterator& other) const
+      { return _pos == other._pos; }
+
+      bool operator!=(const Indexed_array_iterator& other) const
+      { return _pos != other._pos; }
+
+      bool operator<(const Indexed_array_iterator& other) const
+      { return _pos < other._pos; }
+
+      //! Returns the position of the value in the array.
+      std::size_t position() const { return _pos; }
+
+    private:
+      const Array* _array;
+      std::size_t _pos;
+    };
+
+    /**
+     *  An array of values, of which the first \ref indexed_size() belong to
+     *  the index of the \c Derived container, and the others have been
+     *  inserted since the index was last built.
+     *
+     *  Erased values are only marked as such: they keep their slot, so the
+     *  index stays valid, and are skipped by the iterators and searches.
+     *  Once the values inserted or erased since the last build amount to a
+     *  quarter of the index, the erased values are dropped and the index is
+     *  rebuilt.
+     *
+     *  The \c Derived container provides \c build_index(order), which builds
+     *  its index over the values of the array and may reorder the positions
+     *  stored in \c order, in which case the values are moved accordingly,
+     *  and \c equal_value(value, key), which tells the values erased by \ref
+     *  erase(const key_type&).
+     *
+     *  \tparam Derived The container that indexes the array.
+     *  \tparam Key The type of the values.
+     *  \tparam Alloc The allocator of the values.
+     */
+    template <typename Derived, typename Key, typename Alloc>
+    class Indexed_array
+    {
+    private:
+      typedef Indexed_array<Derived, Key, Alloc> Self;
+      typedef std::vector<Key, Alloc> storage_type;
+
+    public:
+      typedef Key                                           key_type;
+      typedef Key                                           value_type;
+      typedef Alloc                                         allocator_type;
+      typedef typename storage_type::size_type              size_type;
+      typedef typename storage_type::difference_type        difference_type;
+      typedef const Key*                                    pointer;
+      typedef const Key*                                    const_pointer;
+      typedef const Key&                                    reference;
+      typedef const Key&                                    const_reference;
+      typedef Indexed_array_iterator<Self>                  iterator;
+      typedef Indexed_array_iterator<Self>                  const_iterator;
+
+      explicit Indexed_array(const Alloc& alloc)
+        : _values(alloc), _indexed(0), _erased_count(0) { }
+
+      allocator_type get_allocator() const { return _values.get_allocator(); }
+
+      ///@{
+      //! Iterates over the values in no particular order.
+      const_iterator begin() const
+      { return const_iterator(*this, next_slot(0)); }
+      const_iterator end() const
+      { return const_iterator(*this, _values.size()); }
+      const_iterator cbegin() const { return begin(); }
+      const_iterator cend() const { return end(); }
+      ///@}
+
+      bool empty() const { return size() == 0; }
+      size_type size() const { return _values.size() - _erased_count; }
+      size_type max_size() const { return _values.max_size(); }
+
+      void clear()
+      {
+        _values.clear();
+        _erased.clear();
+        _erased_count = 0;
+        rebalance();
+      }
+
+      /**
+       *  Inserts \c value at the end of the array, where it is visited by
+       *  every search until the next rebuild of the index. Invalidates all
+       *  iterators.
+       */
+      iterator insert(const value_type& value)
+      {
+        _values.push_back(value);
+        _erased.push_back(false);
+        std::size_t pos = _values.size() - 1;
+        if (rebuild_needed()) { pos = rebuild(pos); }
+        return iterator(*this, pos);
+      }
+
+      //! Inserts the values of [\c first, \c last), then rebuilds the index
+      //! if needed. Invalidates all iterators.
+      template <typename InputIterator>
+      void insert(InputIterator first, InputIterator last)
+      {
+        _values.insert(_values.end(), first, last);
+        _erased.resize(_values.size(), false);
+        if (rebuild_needed()) { rebuild(_values.size()); }
+      }
+
+      //! Drops the erased values and rebuilds the index over all the values
+      //! of the container. Invalidates all iterators.
+      void rebalance() { rebuild(_values.size()); }
+
+      //! Erases the value pointed to by \c pos, then rebuilds the index if
+      //! needed. Invalidates all iterators.
+      void erase(const_iterator pos)
+      {
+        mark_erased(pos.position());
+        if (rebuild_needed()) { rebalance(); }
+      }
+
+      //! Erases all the values equal to \c key, then rebuilds the index if
+      //! needed, and returns the number of values erased. Invalidates all
+      //! iterators.
+      size_type erase(const key_type& key)
+      {
+        const Derived& derived = static_cast<const Derived&>(*this);
+        size_type erased = 0;
+        for (std::size_t i = next_slot(0); i < _values.size();
+             i = next_slot(i + 1))
+          {
+            if (!derived.equal_value(_values[i], key)) continue;
+            mark_erased(i);
+            ++erased;
+          }
+        if (erased != 0 && rebuild_needed()) { rebalance(); }
+        return erased;
+      }
+
+      //! Returns the number of values that belong to the index; the others
+      //! follow them in the array.
+      std::size_t indexed_size() const { return _indexed; }
+
+      //! Returns the number of slots of the array, including the ones of the
+      //! erased values.
+      std::size_t slot_count() const { return _values.size(); }
+
+      //! Returns the value in the slot \c pos, which may be erased.
+      const Key& slot(std::size_t pos) const { return _values[pos]; }
+
+      //! Returns true if the value in the slot \c pos has been erased.
+      bool is_erased(std::size_t pos) const { return _erased[pos]; }
+
+      //! Returns the first slot from \c pos that holds a value that is not
+      //! erased, or \ref slot_count().
+      std::size_t next_slot(std::size_t pos) const
+      {
+        while (pos < _values.size() && _erased[pos]) { ++pos; }
+        return pos;
+      }
+
+    protected:
+      void swap(Indexed_array& other)
+      {
+        _values.swap(other._values);
+        _erased.swap(other._erased);
+        std::swap(_indexed, other._indexed);
+        std::swap(_erased_count, other._erased_count);
+      }
+
+    private:
+      void mark_erased(std::size_t pos)
+      {
+        _erased[pos] = true;
+        ++_erased_count;
+      }
+
+      //! Returns true once the values inserted or erased since the last
+      //! build amount to a quarter of the index.
+      bool rebuild_needed() const
+      {
+        std::size_t pending = _values.size() - _indexed + _erased_count;
+        return pending > 16 && pending > _indexed / 4;
+      }
+
+      /**
+       *  Drops the erased values, then has the \c Derived container build
+       *  its index over the others, and returns the new position of the
+       *  value that was in the slot \c track, or \ref slot_count() if \c
+       *  track is past-the-end.
+       */
+      std::size_t rebuild(std::size_t track)
+      {
+        if (_erased_count != 0)
+          {
+            storage_type live(_values.get_allocator());
+            live.reserve(size());
+            std::size_t moved = size();
+            for (std::size_t i = next_slot(0); i < _values.size();
+                 i = next_slot(i + 1))
+              {
+                if (i == track) moved = live.size();
+                live.push_back(_values[i]);
+              }
+            _values.swap(live);
+            _erased.assign(_values.size(), false);
+            _erased_count = 0;
+            track = moved;
+          }
+        std::vector<std::size_t> order(_values.size());
+        for (std::size_t i = 0; i < order.size(); ++i) { order[i] = i; }
+        static_cast<Derived&>(*this).build_index(order);
+        std::size_t tracked = _values.size();
+        storage_type values(_values.get_allocator());
+        values.reserve(order.size());
+        for (std::size_t i = 0; i < order.size(); ++i)
+          {
+            if (order[i] == track) tracked = i;
+            values.push_back(_values[order[i]]);
+          }
+        _values.swap(values);
+        _indexed = _values.size();
+        return tracked;
+      }
+
+      storage_type _values;
+      std::vector<bool> _erased;
+      std::size_t _indexed;
+      std::size_t _erased_count;
+    };
+  } // namespace details
+} // namespace spatial
+
+#endif // SPATIAL_INDEXED_ARRAY_HPP
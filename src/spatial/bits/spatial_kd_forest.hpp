@@ -0,0 +1,482 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   spatial_kd_forest.hpp
+ *  Contains the definition of \ref spatial::details::Kd_forest, the index of
+ *  randomized k-d trees behind \ref spatial::kd_forest_multiset.
+ */
+
+#ifndef SPATIAL_KD_FOREST_HPP
+#define SPATIAL_KD_FOREST_HPP
+
+#include <memory>  // std::allocator
+#include <vector>
+#include <utility> // std::pair
+#include <algorithm> // std::nth_element, std::partition, heaps
+#include "spatial_rank.hpp"
+#include "spatial_coordinate.hpp"
+#include "spatial_hash_index.hpp" // equal_key
+#include "spatial_indexed_array.hpp"
+
+namespace spatial
+{
+  namespace details
+  {
+    /**
+     *  A linear congruential generator that picks the split dimensions of
+     *  the trees of a \ref Kd_forest. It is seeded with the index of the
+     *  tree, so that the same values always build the same forest.
+     */
+    struct Forest_random
+    {
+      explicit Forest_random(std::size_t seed) : state(seed) { }
+
+      //! Returns a number in [0, \c n).
+      std::size_t operator()(std::size_t n)
+      {
+        state = (state * 1103515245u + 12345u) & 0x7fffffffu;
+        return (state >> 16) % n;
+      }
+
+      std::size_t state;
+    };
+
+    /**
+     *  A node of a tree of a \ref Kd_forest. The children of an inner node
+     *  are the next node and the node at \c right. A leaf refers to the
+     *  values whose positions are in [\c first, \c last) of the permutation
+     *  of its tree.
+     */
+    struct Forest_node
+    {
+      double cut;
+      std::size_t right;
+      std::size_t first;
+      std::size_t last;
+      dimension_type dim;
+      bool leaf;
+    };
+
+    /**
+     *  A branch left aside during the search of a \ref Kd_forest, with the
+     *  approximate distance between the target and the cell of its node.
+     */
+    struct Forest_branch
+    {
+      Forest_branch(double bound_, std::size_t tree_, std::size_t node_)
+        : bound(bound_), tree(tree_), node(node_) { }
+      double bound;
+      std::size_t tree;
+      std::size_t node;
+    };
+
+    //! Orders the branches so that the closest comes out of the heap first.
+    struct Forest_branch_greater
+    {
+      bool operator()(const Forest_branch& x, const Forest_branch& y) const
+      { return y.bound < x.bound; }
+    };
+
+    /**
+     *  An approximate nearest neighbor index made of several randomized k-d
+     *  trees over the same values, as described by Silpa-Anan and Hartley,
+     *  and popularized by FLANN.
+     *
+     *  Each node splits its values at the mean of a dimension chosen at
+     *  random among the 5 dimensions of highest variance, estimated on a
+     *  sample of the values. The trees therefore partition the space
+     *  differently, and a target that lies near a cut in one tree is likely
+     *  to lie well inside a cell in another one.
+     *
+     *  All the trees are searched together: the branches left aside in any
+     *  tree go into a single priority queue, ordered by the sum of the
+     *  squared distances from the target to the cuts crossed to reach them.
+     *  The search stops after comparing the target with a budget of values,
+     *  the \e checks, which trades accuracy for time independently of the
+     *  rank of the keys.
+     *
+     *  Values inserted after the last build are kept at the end of the array
+     *  and always compared with the target, and erased values are skipped by
+     *  the searches, until they amount to a quarter of the forest, which is
+     *  then rebuilt.
+     *
+     *  \tparam Rank Either \static_rank or \dynamic_rank.
+     *  \tparam Key The type of the keys.
+     *  \tparam Compare The comparator that reads the coordinates of the keys.
+     *  \tparam Alloc The allocator of the values.
+     */
+    template <typename Rank, typename Key, typename Compare, typename Alloc>
+    class Kd_forest
+      : private Rank,
+        public Indexed_array<Kd_forest<Rank, Key, Compare, Alloc>, Key, Alloc>
+    {
+    private:
+      typedef Indexed_array<Kd_forest<Rank, Key, Compare, Alloc>, Key, Alloc>
+      Base;
+
+      friend class Indexed_array<Kd_forest<Rank, Key, Compare, Alloc>, Key,
+                                 Alloc>;
+
+    public:
+      typedef Rank                                          rank_type;
+      typedef Key                                           key_type;
+      typedef Key                                           value_type;
+      typedef Compare                                       key_compare;
+      typedef Alloc                                         allocator_type;
+      typedef typename Base::size_type                      size_type;
+      typedef typename Base::difference_type                difference_type;
+      typedef const Key*                                    pointer;
+      typedef const Key*                                    const_pointer;
+      typedef const Key&                                    reference;
+      typedef const Key&                                    const_reference;
+      typedef typename Base::iterator                       iterator;
+      typedef typename Base::const_iterator                 const_iterator;
+
+      //! The number of trees of a forest, unless specified otherwise.
+      static const std::size_t default_trees = 4;
+
+      //! The number of values compared with the target during a search,
+      //! unless specified otherwise.
+      static const std::size_t default_checks = 64;
+
+      Kd_forest(const Rank& rank_, const Compare& compare,
+                std::size_t trees, const Alloc& alloc)
+        : Rank(rank_), Base(alloc),
+          _trees(trees == 0 ? 1 : trees), _checks(default_checks),
+          _compare(compare) { }
+
+      //! Returns the rank of the container.
+      const rank_type& rank() const { return *this; }
+
+      //! Returns the dimension of the container.
+      dimension_type dimension() const { return rank()(); }
+
+      key_compare key_comp() const { return _compare; }
+
+      //! Returns the number of trees of the forest.
+      std::size_t tree_count() const { return _trees.size(); }
+
+      //! Returns the number of values compared with the target by a search.
+      std::size_t max_checks() const { return _checks; }
+
+      //! Sets the number of values compared with the target by a search.
+      //! The more checks, the more accurate the result.
+      void set_max_checks(std::size_t checks) { _checks = checks; }
+
+      /**
+       *  Writes iterators to the \c k values that are approximately the
+       *  closest to \c target, or to all values if there are fewer, by
+       *  increasing euclidian distance between their coordinates.
+       *
+       *  The search descends every tree to the cell of \c target, then
+       *  visits the closest branches left aside in any tree, until it has
+       *  compared \c checks values with \c target, or the remaining branches
+       *  are farther than the \c k closest values found.
+       */
+      ///@{
+      template <typename OutputIterator>
+      OutputIterator
+      nearest_neighbors(const key_type& target, size_type k,
+                        OutputIterator out, std::size_t checks) const
+      {
+        typedef std::pair<double, std::size_t> candidate_type;
+        if (k == 0 || this->empty()) return out;
+        Search search(*this, target, k, checks);
+        for (std::size_t t = 0;
+             t < _trees.size() && this->indexed_size() != 0; ++t)
+          { descend(search, t, 0, 0.0); }
+        while (!search.branches.empty()
+               && (search.checks < checks || !search.full()))
+          {
+            std::pop_heap(search.branches.begin(), search.branches.end(),
+                          Forest_branch_greater());
+            Forest_branch branch = search.branches.back();
+            search.branches.pop_back();
+            if (search.full() && !(branch.bound < search.worst())) break;
+            descend(search, branch.tree, branch.node, branch.bound);
+          }
+        for (std::size_t i = this->indexed_size(); i < this->slot_count(); ++i)
+          { search.check(i); }
+        std::sort_heap(search.results.begin(), search.results.end());
+        for (typename std::vector<candidate_type>::const_iterator
+               i = search.results.begin(); i != search.results.end(); ++i)
+          { *out++ = const_iterator(*this, i->second); }
+        return out;
+      }
+
+      template <typename OutputIterator>
+      OutputIterator
+      nearest_neighbors(const key_type& target, size_type k,
+                        OutputIterator out) const
+      { return nearest_neighbors(target, k, out, _checks); }
+      ///@}
+
+      //! Returns the value that is approximately the closest to \c target,
+      //! or \ref end() if the container is empty.
+      //! \see nearest_neighbors()
+      const_iterator nearest_neighbor(const key_type& target) const
+      {
+        const_iterator result = this->end();
+        nearest_neighbors(target, 1, &result);
+        return result;
+      }
+
+      void swap(Kd_forest& other)
+      {
+        std::swap(static_cast<Rank&>(*this), static_cast<Rank&>(other));
+        Base::swap(other);
+        _trees.swap(other._trees);
+        std::swap(_checks, other._checks);
+        std::swap(_compare, other._compare);
+      }
+
+    private:
+      //! The nodes of a tree, in pre-order, and the permutation of the
+      //! values that its leaves refer to.
+      struct Tree
+      {
+        std::vector<Forest_node> nodes;
+        std::vector<std::size_t> index;
+      };
+
+      //! The state of a search: the branches left aside, and the max-heap of
+      //! the closest values found so far.
+      struct Search
+      {
+        Search(const Kd_forest& forest_, const key_type& target_,
+               size_type k_, std::size_t budget)
+          : forest(forest_), target(target_), k(k_), checks(0)
+        {
+          results.reserve(k_ + 1);
+          branches.reserve(budget < 1024 ? 2 * budget : 2048);
+        }
+
+        bool full() const { return results.size() == k; }
+        double worst() const { return results.front().first; }
+
+        //! Compares the value at position \c i with the target, unless it
+        //! is erased. The trees hold the same values, so a value may be met
+        //! more than once.
+        void check(std::size_t i)
+        {
+          if (forest.is_erased(i)) return;
+          ++checks;
+          double d = forest.distance(target, forest.slot(i));
+          if (full() && !(d < worst())) return;
+          for (std::size_t r = 0; r < results.size(); ++r)
+            { if (results[r].second == i) return; }
+          results.push_back(std::make_pair(d, i));
+          std::push_heap(results.begin(), results.end());
+          if (results.size() > k)
+            {
+              std::pop_heap(results.begin(), results.end());
+              results.pop_back();
+            }
+        }
+
+        const Kd_forest& forest;
+        const key_type& target;
+        size_type k;
+        std::size_t checks;
+        std::vector<std::pair<double, std::size_t> > results;
+        std::vector<Forest_branch> branches;
+      };
+
+      //! Builds all the trees of the forest over the values of the array,
+      //! which keep their positions.
+      void build_index(std::vector<std::size_t>& order)
+      {
+        for (std::size_t t = 0; t < _trees.size(); ++t)
+          {
+            Tree& tree = _trees[t];
+            tree.nodes.clear();
+            tree.index = order;
+            Forest_random random(t + 1);
+            if (!order.empty())
+              { build(tree, 0, tree.index.size(), random); }
+          }
+      }
+
+      //! Returns true if \c value is equal to \c key.
+      bool equal_value(const Key& value, const key_type& key) const
+      { return equal_key(rank(), _compare, value, key); }
+
+      //! Descends the tree \c t from \c node to the leaf of the target,
+      //! leaving the other branches aside in the queue of \c search.
+      void descend(Search& search, std::size_t t, std::size_t node,
+                   double bound) const
+      {
+        const Tree& tree = _trees[t];
+        while (!tree.nodes[node].leaf)
+          {
+            const Forest_node& n = tree.nodes[node];
+            double diff = coordinate(n.dim, search.target) - n.cut;
+            std::size_t closer = node + 1, other = n.right;
+            if (!(diff < 0.0)) { closer = n.right; other = node + 1; }
+            double other_bound = bound + diff * diff;
+            if (!search.full() || other_bound < search.worst())
+              {
+                search.branches.push_back
+                  (Forest_branch(other_bound, t, other));
+                std::push_heap(search.branches.begin(),
+                               search.branches.end(),
+                               Forest_branch_greater());
+              }
+            node = closer;
+          }
+        const Forest_node& leaf = tree.nodes[node];
+        for (std::size_t i = leaf.first; i < leaf.last; ++i)
+          { search.check(tree.index[i]); }
+      }
+
+      /**
+       *  Builds the subtree of the values whose positions are in [\c first,
+       *  \c last) of the permutation of \c tree, and returns the position of
+       *  its root node.
+       */
+      std::size_t build(Tree& tree, std::size_t first, std::size_t last,
+                        Forest_random& random)
+      {
+        std::size_t node = tree.nodes.size();
+        tree.nodes.push_back(Forest_node());
+        if (last - first <= leaf_size)
+          {
+            tree.nodes[node].leaf = true;
+            tree.nodes[node].first = first;
+            tree.nodes[node].last = last;
+            tree.nodes[node].right = 0;
+            tree.nodes[node].dim = 0;
+            tree.nodes[node].cut = 0.0;
+            return node;
+          }
+        double cut = 0.0;
+        dimension_type dim = choose_split(tree, first, last, random, cut);
+        std::vector<std::size_t>::iterator
+          begin_ = tree.index.begin() + static_cast<difference_type>(first),
+          end_ = tree.index.begin() + static_cast<difference_type>(last),
+          mid = std::partition(begin_, end_, Coordinate_below(*this, dim, cut));
+        if (mid == begin_ || mid == end_)
+          {
+            // All values are on one side of the mean: split at the median.
+            mid = begin_ + (end_ - begin_) / 2;
+            std::nth_element(begin_, mid, end_, Coordinate_less(*this, dim));
+            cut = coordinate(dim, this->slot(*mid));
+          }
+        std::size_t split = first + static_cast<std::size_t>(mid - begin_);
+        tree.nodes[node].leaf = false;
+        tree.nodes[node].dim = dim;
+        tree.nodes[node].cut = cut;
+        tree.nodes[node].first = first;
+        tree.nodes[node].last = last;
+        build(tree, first, split, random);
+        std::size_t right = build(tree, split, last, random);
+        tree.nodes[node].right = right;
+        return node;
+      }
+
+      /**
+       *  Returns a dimension chosen at random among the ones of highest
+       *  variance on a sample of the values in [\c first, \c last), and sets
+       *  \c cut to the mean of the sample on this dimension.
+       */
+      dimension_type choose_split(const Tree& tree, std::size_t first,
+                                  std::size_t last, Forest_random& random,
+                                  double& cut) const
+      {
+        const dimension_type rank_ = dimension();
+        std::size_t step = (last - first) / sample_size + 1, count = 0;
+        std::vector<double> sum(rank_, 0.0), square(rank_, 0.0);
+        for (std::size_t i = first; i < last; i += step, ++count)
+          {
+            const Key& key = this->slot(tree.index[i]);
+            for (dimension_type d = 0; d < rank_; ++d)
+              {
+                double x = coordinate(d, key);
+                sum[d] += x;
+                square[d] += x * x;
+              }
+          }
+        std::vector<std::pair<double, dimension_type> > variance(rank_);
+        for (dimension_type d = 0; d < rank_; ++d)
+          {
+            double mean = sum[d] / static_cast<double>(count);
+            variance[d].first
+              = square[d] / static_cast<double>(count) - mean * mean;
+            variance[d].second = d;
+          }
+        std::size_t top = rank_ < top_dimensions ? rank_ : top_dimensions;
+        std::partial_sort(variance.begin(),
+                          variance.begin() + static_cast<difference_type>(top),
+                          variance.end(), Variance_greater());
+        dimension_type dim = variance[random(top)].second;
+        cut = sum[dim] / static_cast<double>(count);
+        return dim;
+      }
+
+      double coordinate(dimension_type d, const Key& key) const
+      { return compare_coordinate(_compare, d, key); }
+
+      //! Returns the squared euclidian distance between \c x and \c y.
+      double distance(const Key& x, const Key& y) const
+      {
+        double sum = 0.0;
+        for (dimension_type d = 0; d < dimension(); ++d)
+          {
+            double diff = coordinate(d, x) - coordinate(d, y);
+            sum += diff * diff;
+          }
+        return sum;
+      }
+
+      struct Coordinate_below
+      {
+        Coordinate_below(const Kd_forest& forest_, dimension_type dim_,
+                         double cut_)
+          : forest(forest_), dim(dim_), cut(cut_) { }
+        bool operator()(std::size_t i) const
+        { return forest.coordinate(dim, forest.slot(i)) < cut; }
+        const Kd_forest& forest;
+        dimension_type dim;
+        double cut;
+      };
+
+      struct Coordinate_less
+      {
+        Coordinate_less(const Kd_forest& forest_, dimension_type dim_)
+          : forest(forest_), dim(dim_) { }
+        bool operator()(std::size_t i, std::size_t j) const
+        {
+          return forest.coordinate(dim, forest.slot(i))
+            < forest.coordinate(dim, forest.slot(j));
+        }
+        const Kd_forest& forest;
+        dimension_type dim;
+      };
+
+      struct Variance_greater
+      {
+        bool operator()(const std::pair<double, dimension_type>& x,
+                        const std::pair<double, dimension_type>& y) const
+        { return y.first < x.first; }
+      };
+
+      //! The largest number of values in a leaf.
+      static const std::size_t leaf_size = 4;
+      //! The number of values sampled to choose a split.
+      static const std::size_t sample_size = 100;
+      //! The number of dimensions of highest variance to choose from.
+      static const std::size_t top_dimensions = 5;
+
+      std::vector<Tree> _trees;
+      std::size_t _checks;
+      Compare _compare;
+    };
+  } // namespace details
+} // namespace spatial
+
+#endif // SPATIAL_KD_FOREST_HPP
@@ -27,11 +27,14 @@
 #include "spatial_mapping.hpp"
 #include "spatial_equal.hpp"
 #include "spatial_rank.hpp"
+#include "spatial_prefetch.hpp"
 #include "spatial_compress.hpp"
 #include "spatial_value_compare.hpp"
 #include "spatial_template_member_swap.hpp"
 #include "spatial_assert.hpp"
 #include "spatial_except.hpp"
+#include "spatial_check_concept.hpp"
+#include "spatial_node_reserve.hpp"
 
 namespace spatial
 {
@@ -88,6 +91,10 @@ namespace spatial
       typedef typename mode_type::link_ptr            link_ptr;
       typedef typename mode_type::const_link_ptr      const_link_ptr;
 
+      // The nodes allocated in advance and the buffer to rebuild the tree
+      typedef Node_reserve<mode_type, Link_allocator> Reserve;
+      typedef typename Reserve::ptr_store             Ptr_store;
+
     private:
       /**
        *  \brief The tree header.
@@ -101,11 +108,13 @@ namespace spatial
       {
         Implementation(const rank_type& rank, const key_compare& compare,
                        const Link_allocator& alloc)
-          : Rank(rank), _count(compare, 0), _header(alloc) { initialize(); }
+          : Rank(rank), _count(compare, 0), _header(alloc), _reserve(alloc)
+        { initialize(); }
 
         Implementation(const Implementation& impl)
           : Rank(impl), _count(impl._count.base(), 0),
-            _header(impl._header.base()) { initialize(); }
+            _header(impl._header.base()), _reserve(impl._header.base())
+        { initialize(); }
 
         void initialize()
         {
@@ -118,6 +127,7 @@ namespace spatial
         Compress<key_compare, size_type>           _count;
         Compress<Link_allocator, Node<mode_type> > _header;
         Node<mode_type>* _leftmost;
+        Reserve _reserve;
       } _impl;
 
     private:
@@ -182,18 +192,19 @@ namespace spatial
       struct safe_allocator // RAII for exception-safe memory management
       {
         Link_allocator* alloc;
+        Reserve* reserve;
         link_ptr link;
-        safe_allocator(Link_allocator& a)
-          : alloc(&a), link(0)
-        { link = alloc->allocate(1); } // may throw
-        ~safe_allocator() { if (link) { alloc->deallocate(link, 1); } }
+        safe_allocator(Link_allocator& a, Reserve& r)
+          : alloc(&a), reserve(&r), link(0)
+        { link = reserve->get(*alloc); } // may throw
+        ~safe_allocator() { if (link) { reserve->put(*alloc, link); } }
         link_ptr release() { link_ptr p = link; link=0; return p; }
       };
 
       node_ptr
       create_node(const value_type& value)
       {
-        safe_allocator safe(get_link_allocator());
+        safe_allocator safe(get_link_allocator(), _impl._reserve);
         // the following may throw but we have RAII on safe_allocator
         auto alloc = get_value_allocator();
         std::allocator_traits<Value_allocator>::construct(alloc, mutate_pointer(&safe.link->value),
@@ -213,7 +224,7 @@ namespace spatial
       {
         auto alloc = get_value_allocator();
         std::allocator_traits<Value_allocator>::destroy(alloc, mutate_pointer(&value(node)));
-        get_link_allocator().deallocate(link(node), 1);
+        _impl._reserve.put(get_link_allocator(), link(node));
       }
 
       /**
@@ -236,8 +247,8 @@ namespace spatial
        *  nodes and recurse when walking down right nodes.
        */
       node_ptr rebalance_node_insert
-      (typename std::vector<node_ptr>::iterator first,
-       typename std::vector<node_ptr>::iterator last, dimension_type dim,
+      (typename Ptr_store::iterator first,
+       typename Ptr_store::iterator last, dimension_type dim,
        node_ptr header);
 
       /**
@@ -245,10 +256,10 @@ namespace spatial
        *  respects the invariant of the tree even when equal values are found in
        *  the tree.
        */
-      typename std::vector<node_ptr>::iterator
+      typename Ptr_store::iterator
       median
-      (typename std::vector<node_ptr>::iterator first,
-       typename std::vector<node_ptr>::iterator last, dimension_type dim);
+      (typename Ptr_store::iterator first,
+       typename Ptr_store::iterator last, dimension_type dim);
 
       /**
        *  Copy the exact sturcture of the sub-tree pointed to by \c
@@ -366,7 +377,49 @@ namespace spatial
        *  The maximum number of elements that can be allocated.
        */
       size_type max_size() const
-      { return _impl._header.base().max_size(); }
+      {
+        return std::allocator_traits<Link_allocator>
+          ::max_size(_impl._header.base());
+      }
+
+      /**
+       *  Returns the number of elements that the tree can hold without
+       *  allocating memory: its size and the number of nodes reserved in
+       *  advance.
+       *  \see reserve()
+       */
+      size_type capacity() const
+      { return size() + _impl._reserve.spares(); }
+
+      /**
+       *  Allocates nodes in advance, so that the tree can hold \c n elements
+       *  without allocating memory, as well as the buffer needed to \ref
+       *  rebalance() these elements.
+       *
+       *  From then on, erased nodes are kept by the tree for later insertions
+       *  rather than deallocated, and \ref clear() keeps all of them.
+       *  Therefore, while \ref size() does not exceed \c n, \ref insert(),
+       *  \ref erase(), \ref rebalance() and \ref insert_rebalance() do not
+       *  call the allocator, except to construct values that allocate memory
+       *  themselves. The nodes are released by \ref shrink_to_fit() or the
+       *  destruction of the tree.
+       *
+       *  \throws std::bad_alloc, or the exception thrown by the allocator, if
+       *  the memory cannot be allocated; the nodes already allocated are kept.
+       */
+      void reserve(size_type n)
+      {
+        _impl._reserve.reserve(get_link_allocator(),
+                               n > size() ? n - size() : 0, n);
+      }
+
+      /**
+       *  Releases the nodes reserved in advance that are not in use, and
+       *  deallocates erased nodes from then on.
+       *  \see reserve()
+       */
+      void shrink_to_fit()
+      { _impl._reserve.release(get_link_allocator()); }
 
     public:
       Kdtree()
@@ -439,7 +492,10 @@ namespace spatial
        *  Deallocate all nodes in the destructor.
        */
       ~Kdtree()
-      { destroy_all_nodes(); }
+      {
+        destroy_all_nodes();
+        _impl._reserve.release(get_link_allocator());
+      }
 
     public:
       /**
@@ -452,13 +508,14 @@ namespace spatial
       void
       swap(Self& other)
       {
+        template_allocator_swap<Link_allocator>::do_it
+          (get_link_allocator(), other.get_link_allocator());
+        _impl._reserve.swap(other._impl._reserve);
         if (empty() && other.empty()) return;
         template_member_swap<rank_type>::do_it
           (get_rank(), other.get_rank());
         template_member_swap<key_compare>::do_it
           (get_compare(), other.get_compare());
-        template_member_swap<Link_allocator>::do_it
-          (get_link_allocator(), other.get_link_allocator());
         if (_impl._header().parent == &_impl._header())
           {
             _impl._header().parent = &other._impl._header();
@@ -492,6 +549,10 @@ namespace spatial
        *  only once, when all the elements you will be working on have been
        *  inserted in the tree.
        *
+       *  After \ref reserve(), the vector reserved in advance is used instead,
+       *  and no memory is allocated while the tree holds no more elements
+       *  than the reserved number.
+       *
        *  If you need to insert and erase multiple elements continuously, consider
        *  using other containers than the "idle" family of containers.
        */
@@ -562,6 +623,34 @@ namespace spatial
         return const_iterator(first_equal(get_root(), 0, rank(),
                                           key_comp(), key).first);
       }
+
+      /**
+       *  Overloads of \ref find() for a \c key of another type than \ref
+       *  key_type, which are available only if \ref key_compare is
+       *  transparent, such as \ref bracket_less<void>. No temporary key is
+       *  built to perform the search.
+       */
+      template <typename Query>
+      typename enable_if_c
+      <details::is_transparent_query<key_compare, Query, key_type>::value,
+       iterator>::type
+      find(const Query& key)
+      {
+        if (empty()) return end();
+        return iterator(first_equal(get_root(), 0, rank(), key_comp(), key)
+                        .first);
+      }
+
+      template <typename Query>
+      typename enable_if_c
+      <details::is_transparent_query<key_compare, Query, key_type>::value,
+       const_iterator>::type
+      find(const Query& key) const
+      {
+        if (empty()) return end();
+        return const_iterator(first_equal(get_root(), 0, rank(), key_comp(),
+                                          key).first);
+      }
       ///@}
 
       /**
@@ -722,10 +811,14 @@ namespace spatial
         {
           while (true)
             {
-              if (key_comp()(node_dim % rank()(), target_key, const_key(node)))
+              prefetch_children(node);
+              if (key_comp()(node_dim, target_key, const_key(node)))
                 {
                   if (node->left != 0)
-                    { node = node->left; ++node_dim; }
+                    {
+                      node = node->left;
+                      node_dim = incr_dim(rank(), node_dim);
+                    }
                   else
                     {
                       node->left = target_node;
@@ -738,7 +831,10 @@ namespace spatial
               else
                 {
                   if (node->right != 0)
-                    { node = node->right; ++node_dim; }
+                    {
+                      node = node->right;
+                      node_dim = incr_dim(rank(), node_dim);
+                    }
                   else
                     {
                       node->right = target_node;
@@ -847,7 +943,8 @@ namespace spatial
     {
       SPATIAL_ASSERT_CHECK(empty());
       SPATIAL_ASSERT_CHECK(!other.empty());
-      std::vector<node_ptr> ptr_store;
+      Ptr_store local(_impl._reserve.get_allocator());
+      Ptr_store& ptr_store = _impl._reserve.store(local);
       ptr_store.reserve(other.size()); // may throw
       try
         {
@@ -856,7 +953,7 @@ namespace spatial
         }
       catch (...)
         {
-          for(typename std::vector<node_ptr>::iterator i = ptr_store.begin();
+          for(typename Ptr_store::iterator i = ptr_store.begin();
               i != ptr_store.end(); ++i)
             { destroy_node(*i); }
           throw;
@@ -895,7 +992,8 @@ namespace spatial
     ::insert_rebalance(InputIterator first, InputIterator last)
     {
       if (first == last && empty()) return;
-      std::vector<node_ptr> ptr_store;
+      Ptr_store local(_impl._reserve.get_allocator());
+      Ptr_store& ptr_store = _impl._reserve.store(local);
       ptr_store.reserve // may throw
         (size()
          + random_access_iterator_distance
@@ -908,7 +1006,7 @@ namespace spatial
         }
       catch (...)
         {
-          for(typename std::vector<node_ptr>::iterator i = ptr_store.begin();
+          for(typename Ptr_store::iterator i = ptr_store.begin();
               i != ptr_store.end(); ++i)
             { destroy_node(*i); }
           throw;
@@ -935,7 +1033,8 @@ namespace spatial
     Kdtree<Rank, Key, Value, Compare, Alloc>::rebalance()
     {
       if (empty()) return;
-      std::vector<node_ptr> ptr_store;
+      Ptr_store local(_impl._reserve.get_allocator());
+      Ptr_store& ptr_store = _impl._reserve.store(local);
       ptr_store.reserve(size()); // may throw
       for(iterator i = begin(); i != end(); ++i)
         { ptr_store.push_back(i.node); }
@@ -971,21 +1070,21 @@ namespace spatial
     template <typename Rank, typename Key, typename Value, typename Compare,
               typename Alloc>
     inline typename
-    std::vector<typename Kdtree<Rank, Key, Value, Compare, Alloc>::node_ptr>
+    Kdtree<Rank, Key, Value, Compare, Alloc>::Ptr_store
     ::iterator
     Kdtree<Rank, Key, Value, Compare, Alloc>::median
-    (typename std::vector<node_ptr>::iterator first,
-     typename std::vector<node_ptr>::iterator last,
+    (typename Ptr_store::iterator first,
+     typename Ptr_store::iterator last,
      dimension_type dim)
     {
       SPATIAL_ASSERT_CHECK(first != last);
       mapping_compare<Compare, node_ptr> less(key_comp(), dim);
       // Memory ordering varies between machines, so we use '/ 2' and not '>> 1'
       if (first == (last - 1)) return first;
-      typename std::vector<node_ptr>::iterator mid = first + (last - first) / 2;
+      typename Ptr_store::iterator mid = first + (last - first) / 2;
       std::nth_element(first, mid, last, less);
-      typename std::vector<node_ptr>::iterator seek = mid;
-      typename std::vector<node_ptr>::iterator pivot = mid;
+      typename Ptr_store::iterator seek = mid;
+      typename Ptr_store::iterator pivot = mid;
       do
         {
           --seek;
@@ -1008,13 +1107,13 @@ namespace spatial
     inline typename Kdtree<Rank, Key, Value, Compare, Alloc>::node_ptr
     Kdtree<Rank, Key, Value, Compare, Alloc>
     ::rebalance_node_insert
-    (typename std::vector<node_ptr>::iterator first,
-     typename std::vector<node_ptr>::iterator last,
+    (typename Ptr_store::iterator first,
+     typename Ptr_store::iterator last,
      dimension_type dim, node_ptr parent)
     {
       SPATIAL_ASSERT_CHECK(first != last);
       SPATIAL_ASSERT_CHECK(dim < dimension());
-      typename std::vector<node_ptr>::iterator med
+      typename Ptr_store::iterator med
         = median(first, last, dim);
       node_ptr root = *med;
       root->parent = parent;
@@ -1150,18 +1249,18 @@ namespace spatial
     {
       if (empty()) return 0;
       node_ptr node = get_root();
-      dimension_type depth;
-      import::tie(node, depth)
+      dimension_type dim;
+      import::tie(node, dim)
         = first_equal(node, 0, rank(), key_comp(), key);
       if (header(node)) return 0;
       size_type cnt = 0;
       for (;;)
         {
-          node_ptr tmp = erase_node(depth % rank()(), node);
+          node_ptr tmp = erase_node(dim, node);
           ++cnt;
           if (tmp == 0) break; // no further node to erase for sure!
-          import::tie(node, depth)
-            = first_equal(tmp, depth, rank(), key_comp(), key);
+          import::tie(node, dim)
+            = first_equal(tmp, dim, rank(), key_comp(), key);
           if (tmp->parent == node) break; // no more match
         }
       return cnt;
@@ -0,0 +1,188 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   spatial_locality.hpp
+ *  Provides \ref spatial::details::locality_sort(), which orders a batch of
+ *  keys so that keys that are close in space are also close in the batch.
+ *
+ *  Batches of insertions or queries that arrive in an arbitrary order, such
+ *  as the order of a sensor, visit paths of the tree that are unrelated from
+ *  one key to the next. Once ordered, consecutive keys walk down overlapping
+ *  paths and find most of their nodes already in cache.
+ */
+
+#ifndef SPATIAL_LOCALITY_HPP
+#define SPATIAL_LOCALITY_HPP
+
+#include <vector>
+#include <utility> // std::pair
+#include <iterator> // std::iterator_traits
+#include <algorithm> // std::nth_element, std::copy
+#include "spatial_node.hpp"
+#include "spatial_rank.hpp"
+#include "spatial_value_compare.hpp"
+
+namespace spatial
+{
+  namespace details
+  {
+    /**
+     *  Turns a comparator of elements along a dimension into a strict weak
+     *  ordering of elements on a fixed dimension.
+     */
+    template <typename Compare>
+    struct Dimension_less
+    {
+      Dimension_less(const Compare& compare_, dimension_type dim_)
+        : compare(compare_), dim(dim_) { }
+
+      template <typename Tp>
+      bool operator()(const Tp& x, const Tp& y) const
+      { return compare(dim, x, y); }
+
+      Compare compare;
+      dimension_type dim;
+    };
+
+    /**
+     *  Compares the keys of two nodes along a dimension with \c KeyCompare.
+     */
+    template <typename KeyCompare>
+    struct Node_key_compare
+    {
+      explicit Node_key_compare(const KeyCompare& key_comp_)
+        : key_comp(key_comp_) { }
+
+      template <typename NodePtr>
+      bool operator()(dimension_type dim, NodePtr x, NodePtr y) const
+      { return key_comp(dim, const_key(x), const_key(y)); }
+
+      KeyCompare key_comp;
+    };
+
+    /**
+     *  Partitions [\c first, \c last) recursively around the median on \c
+     *  dim, then on the next dimension for each half, as the elements of a
+     *  balanced k-d tree would be partitioned. The median of each sub-range
+     *  is left in its middle.
+     */
+    template <typename RandomAccessIterator, typename Rank,
+              typename Compare>
+    inline void
+    locality_partition(RandomAccessIterator first, RandomAccessIterator last,
+                       dimension_type dim, const Rank rank,
+                       const Compare& compare)
+    {
+      SPATIAL_ASSERT_CHECK(dim < rank());
+      while (last - first > 1)
+        {
+          RandomAccessIterator mid = first + (last - first) / 2;
+          std::nth_element(first, mid, last,
+                           Dimension_less<Compare>(compare, dim));
+          dim = incr_dim(rank, dim);
+          locality_partition(first, mid, dim, rank, compare);
+          first = mid + 1;
+        }
+    }
+
+    /**
+     *  Appends to \c out the medians of the sub-ranges of [\c first, \c
+     *  last) found at \c depth in its partition, from the lowest to the
+     *  highest. Returns \c false if there are no sub-ranges at this depth.
+     */
+    template <typename RandomAccessIterator, typename Tp>
+    inline bool
+    locality_level(RandomAccessIterator first, RandomAccessIterator last,
+                   std::size_t depth, std::vector<Tp>& out)
+    {
+      if (first == last) return false;
+      RandomAccessIterator mid = first + (last - first) / 2;
+      if (depth == 0) { out.push_back(*mid); return true; }
+      bool lower = locality_level(first, mid, depth - 1, out);
+      bool upper = locality_level(mid + 1, last, depth - 1, out);
+      return lower || upper;
+    }
+
+    /**
+     *  Reorders the elements in [\c first, \c last) in the breadth-first
+     *  order of the balanced k-d tree that they would form, starting with
+     *  the dimension \c dim: the median element on \c dim comes first,
+     *  followed by the medians of the lower and upper halves on the next
+     *  dimension, and so on, level after level.
+     *
+     *  Within a level, the medians are ordered from cell to adjacent cell of
+     *  a partition of the space, so that neighbors in the result are mostly
+     *  neighbors in space. Unlike a Morton or Hilbert curve, this order is
+     *  obtained with comparisons only: it applies to any key type and any
+     *  \generalized_compare, and adapts to the distribution of the keys. It
+     *  takes <tt>O(n log n)</tt> comparisons and a copy of the elements.
+     *
+     *  Inserting the elements of a batch in this order into an empty
+     *  relaxed tree keeps the tree balanced at each step, without any
+     *  rebalancing.
+     *
+     *  \param first The first element of the range.
+     *  \param last The end of the range.
+     *  \param dim The dimension on which the range is split first.
+     *  \param rank The rank of the container.
+     *  \param compare A functor called as <tt>compare(dim, x, y)</tt>, which
+     *  returns \c true if \c x is lower than \c y on the dimension \c dim.
+     */
+    template <typename RandomAccessIterator, typename Rank,
+              typename Compare>
+    inline void
+    locality_sort(RandomAccessIterator first, RandomAccessIterator last,
+                  dimension_type dim, const Rank rank, const Compare& compare)
+    {
+      typedef typename std::iterator_traits<RandomAccessIterator>::value_type
+        value_type;
+      if (last - first < 2) return;
+      locality_partition(first, last, dim, rank, compare);
+      std::vector<value_type> out;
+      out.reserve(static_cast<std::size_t>(last - first));
+      for (std::size_t depth = 0; locality_level(first, last, depth, out);
+           ++depth);
+      SPATIAL_ASSERT_CHECK(out.size() == static_cast<std::size_t>
+                           (last - first));
+      std::copy(out.begin(), out.end(), first);
+    }
+
+    /**
+     *  Copies the keys read from [\c first, \c last) into \c keys, in the
+     *  order given by \ref locality_sort(), and records in \c origin the
+     *  position that each key had in [\c first, \c last).
+     */
+    template <typename InputIterator, typename Rank, typename KeyCompare,
+              typename Key>
+    inline void
+    locality_order(InputIterator first, InputIterator last, const Rank rank,
+                   const KeyCompare& key_comp, std::vector<Key>& keys,
+                   std::vector<std::size_t>& origin)
+    {
+      typedef std::pair<Key, std::size_t> entry_type;
+      std::vector<entry_type> entries;
+      for (std::size_t i = 0; first != last; ++first, ++i)
+        { entries.push_back(entry_type(*first, i)); }
+      locality_sort(entries.begin(), entries.end(), 0, rank,
+                    ValueCompare<entry_type, KeyCompare>(key_comp));
+      keys.clear();
+      origin.clear();
+      keys.reserve(entries.size());
+      origin.reserve(entries.size());
+      for (typename std::vector<entry_type>::const_iterator
+             i = entries.begin(); i != entries.end(); ++i)
+        {
+          keys.push_back(i->first);
+          origin.push_back(i->second);
+        }
+    }
+
+  } // namespace details
+} // namespace spatial
+
+#endif // SPATIAL_LOCALITY_HPP
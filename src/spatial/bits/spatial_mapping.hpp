@@ -18,6 +18,8 @@
 #define SPATIAL_MAPPING_HPP
 
 #include <utility> // provides ::std::pair<> and ::std::make_pair()
+#include "spatial_rank.hpp"
+#include "spatial_stats.hpp"
 
 namespace spatial
 {
@@ -61,26 +63,26 @@ namespace spatial
       SPATIAL_ASSERT_CHECK(!header(node));
       NodePtr end = node->parent;
       while (node->left != 0)
-        { node = node->left; dim = incr_dim(rank, dim); }
+        { node = descend(node->left); dim = incr_dim(rank, dim); }
       NodePtr best = node;
       dimension_type best_dim = dim;
       for (;;)
         {
-          if (node->right != 0 && dim != map)
+          if (node->right != 0 && explore(dim != map))
             {
-              node = node->right; dim = incr_dim(rank, dim);
+              node = descend(node->right); dim = incr_dim(rank, dim);
               while (node->left != 0)
-                { node = node->left; dim = incr_dim(rank, dim); }
+                { node = descend(node->left); dim = incr_dim(rank, dim); }
             }
           else
             {
               NodePtr prev_node = node;
-              node = node->parent; dim = decr_dim(rank, dim);
+              node = climb(node); dim = decr_dim(rank, dim);
               while (node != end
                      && prev_node == node->right)
                 {
                   prev_node = node;
-                  node = node->parent; dim = decr_dim(rank, dim);
+                  node = climb(node); dim = decr_dim(rank, dim);
                 }
               if (node == end) break;
             }
@@ -135,26 +137,26 @@ namespace spatial
       SPATIAL_ASSERT_CHECK(!header(node));
       NodePtr end = node->parent;
       while (node->right != 0)
-        { node = node->right; dim = incr_dim(rank, dim); }
+        { node = descend(node->right); dim = incr_dim(rank, dim); }
       NodePtr best = node;
       dimension_type best_dim = dim;
       for (;;)
         {
-          if (node->left != 0 && dim != map)
+          if (node->left != 0 && explore(dim != map))
             {
-              node = node->left; dim = incr_dim(rank, dim);
+              node = descend(node->left); dim = incr_dim(rank, dim);
               while (node->right != 0)
-                { node = node->right; dim = incr_dim(rank, dim); }
+                { node = descend(node->right); dim = incr_dim(rank, dim); }
             }
           else
             {
               NodePtr prev_node = node;
-              node = node->parent; dim = decr_dim(rank, dim);
+              node = climb(node); dim = decr_dim(rank, dim);
               while (node != end
                      && prev_node == node->left)
                 {
                   prev_node = node;
-                  node = node->parent; dim = decr_dim(rank, dim);
+                  node = climb(node); dim = decr_dim(rank, dim);
                 }
               if (node == end) break;
             }
@@ -167,6 +169,42 @@ namespace spatial
       return std::make_pair(best, best_dim);
     }
 
+    /**
+     *  \name Dispatch of \dynamic_rank
+     *
+     *  Overloads of \ref minimum_mapping() and \ref maximum_mapping() for
+     *  \dynamic_rank. If the rank of the container is listed in \ref
+     *  SPATIAL_DISPATCH_RANKS, the search is carried out with the equivalent
+     *  \static_rank.
+     */
+    ///@{
+    template <typename NodePtr, typename KeyCompare>
+    inline std::pair<NodePtr, dimension_type>
+    minimum_mapping(NodePtr node, dimension_type dim, Dynamic_rank rank,
+                    dimension_type map, const KeyCompare& key_comp)
+    {
+#     define SPATIAL_RANK_DISPATCH_CALL(r) \
+        minimum_mapping(node, dim, r, map, key_comp)
+      SPATIAL_RANK_DISPATCH(rank)
+#     undef SPATIAL_RANK_DISPATCH_CALL
+      return minimum_mapping<NodePtr, Dynamic_rank, KeyCompare>
+        (node, dim, rank, map, key_comp);
+    }
+
+    template <typename NodePtr, typename KeyCompare>
+    inline std::pair<NodePtr, dimension_type>
+    maximum_mapping(NodePtr node, dimension_type dim, Dynamic_rank rank,
+                    dimension_type map, const KeyCompare& key_comp)
+    {
+#     define SPATIAL_RANK_DISPATCH_CALL(r) \
+        maximum_mapping(node, dim, r, map, key_comp)
+      SPATIAL_RANK_DISPATCH(rank)
+#     undef SPATIAL_RANK_DISPATCH_CALL
+      return maximum_mapping<NodePtr, Dynamic_rank, KeyCompare>
+        (node, dim, rank, map, key_comp);
+    }
+    ///@}
+
   } // namespace details
 } // namespace spatial
 
@@ -187,10 +187,11 @@ namespace spatial
      *  to the plane orthogonal to the axis of dimension \c dim and passing by
      *  \c key.
      */
-    template <typename Key, typename Difference, typename Unit>
+    template <typename Key, typename Difference, typename Unit,
+              typename Origin>
     inline typename enable_if<import::is_arithmetic<Unit>, Unit>::type
     square_euclid_distance_to_plane
-    (dimension_type dim, const Key& origin, const Key& key, Difference diff)
+    (dimension_type dim, const Origin& origin, const Key& key, Difference diff)
     {
       Unit d = diff(dim, origin, key);
 #ifdef SPATIAL_SAFER_ARITHMETICS
@@ -204,10 +205,12 @@ namespace spatial
      *  Compute the square value of the distance between \p origin and
      *  \p key.
      */
-    template <typename Key, typename Difference, typename Unit>
+    template <typename Key, typename Difference, typename Unit,
+              typename Origin>
     inline typename enable_if<import::is_arithmetic<Unit>, Unit>::type
     square_euclid_distance_to_key
-    (dimension_type rank, const Key& origin, const Key& key, Difference diff)
+    (dimension_type rank, const Origin& origin, const Key& key,
+     Difference diff)
     {
       Unit sum = square_euclid_distance_to_plane<Key, Difference, Unit>
         (0, origin, key, diff);
@@ -229,10 +232,11 @@ namespace spatial
      *  Compute the distance between the \p origin and the closest point to the
      *  plane orthogonal to the axis of dimension \c dim and passing by \c key.
      */
-    template <typename Key, typename Difference, typename Unit>
+    template <typename Key, typename Difference, typename Unit,
+              typename Origin>
     inline typename enable_if<import::is_floating_point<Unit>, Unit>::type
     euclid_distance_to_plane
-    (dimension_type dim, const Key& origin, const Key& key, Difference diff)
+    (dimension_type dim, const Origin& origin, const Key& key, Difference diff)
     {
       return std::abs(diff(dim, origin, key)); // floating types abs is always okay!
     }
@@ -257,10 +261,12 @@ namespace spatial
      *  Where the second form (on the right of the equation) is less likely to
      *  overflow or underflow than the first form during computation.
      */
-    template <typename Key, typename Difference, typename Unit>
+    template <typename Key, typename Difference, typename Unit,
+              typename Origin>
     inline typename enable_if<import::is_floating_point<Unit>, Unit>::type
     euclid_distance_to_key
-    (dimension_type rank, const Key& origin, const Key& key, Difference diff)
+    (dimension_type rank, const Origin& origin, const Key& key,
+     Difference diff)
     {
 #ifdef SPATIAL_SAFER_ARITHMETICS
       // Find a non zero maximum or return 0
@@ -299,10 +305,11 @@ namespace spatial
      *  to the plane orthogonal to the axis of dimension \c dim and passing by
      *  \c key.
      */
-    template <typename Key, typename Difference, typename Unit>
+    template <typename Key, typename Difference, typename Unit,
+              typename Origin>
     inline typename enable_if<import::is_arithmetic<Unit>, Unit>::type
     manhattan_distance_to_plane
-    (dimension_type dim, const Key& origin, const Key& key, Difference diff)
+    (dimension_type dim, const Origin& origin, const Key& key, Difference diff)
     {
 #ifdef SPATIAL_SAFER_ARITHMETICS
       return except::check_abs(diff(dim, origin, key));
@@ -314,10 +321,12 @@ namespace spatial
     /**
      *  Compute the manhattan distance between \p origin and \p key.
      */
-    template <typename Key, typename Difference, typename Unit>
+    template <typename Key, typename Difference, typename Unit,
+              typename Origin>
     inline typename enable_if<import::is_arithmetic<Unit>, Unit>::type
     manhattan_distance_to_key
-    (dimension_type rank, const Key& origin, const Key& key, Difference diff)
+    (dimension_type rank, const Origin& origin, const Key& key,
+     Difference diff)
     {
       Unit sum = manhattan_distance_to_plane<Key, Difference, Unit>
         (0, origin, key, diff);
@@ -0,0 +1,224 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   spatial_morton.hpp
+ *  Contains the operations on Morton codes used by \ref
+ *  spatial::morton_point_multiset: the encoding and decoding of the
+ *  coordinates, the comparison of two points in Morton order, the BIGMIN
+ *  computation used to skip the parts of the curve that leave a region, and
+ *  the radix sort of the codes.
+ *
+ *  The Morton code of a point interleaves the bits of its coordinates: bit \c
+ *  b of the coordinate on dimension \c d is stored at the bit <tt>b * rank +
+ *  d</tt> of the code. Ordering the points by their codes orders them along a
+ *  Z-shaped curve that visits every cell of a quadrant before leaving it.
+ */
+
+#ifndef SPATIAL_MORTON_HPP
+#define SPATIAL_MORTON_HPP
+
+#include <vector>
+#include <limits> // std::numeric_limits
+#include <utility> // std::pair
+#include <sstream>
+#include "../exception.hpp"
+#include "spatial_rank.hpp"
+#include "spatial_assert.hpp"
+
+namespace spatial
+{
+  namespace except
+  {
+    /**
+     *  Checks that the coordinate \c value does not exceed \c limit, the
+     *  largest coordinate that a Morton code can hold on one dimension.
+     *  \exception invalid_coordinate is thrown if the check fails.
+     */
+    template <typename Code>
+    inline void check_morton_coordinate(Code value, Code limit)
+    {
+      if (value > limit)
+        {
+          std::stringstream out;
+          out << value << " is not within [0, " << limit << "]";
+          throw invalid_coordinate(out.str());
+        }
+    }
+  }
+
+  namespace details
+  {
+    /**
+     *  Returns the number of bits of each coordinate that a Morton code of
+     *  type \c Code holds for a given \c rank.
+     */
+    template <typename Code>
+    inline unsigned int
+    morton_bits(dimension_type rank)
+    {
+      SPATIAL_ASSERT_CHECK(rank > 0);
+      return static_cast<unsigned int>(std::numeric_limits<Code>::digits)
+        / rank;
+    }
+
+    /**
+     *  Returns the Morton code of the \c rank coordinates in \c coord, each of
+     *  which must fit in \ref morton_bits() bits.
+     */
+    template <typename Code>
+    inline Code
+    morton_encode(const Code* coord, dimension_type rank)
+    {
+      const unsigned int bits = morton_bits<Code>(rank);
+      Code code = 0;
+      for (unsigned int b = 0; b < bits; ++b)
+        for (dimension_type d = 0; d < rank; ++d)
+          {
+            code |= static_cast<Code>(((coord[d] >> b) & 1u)
+                                      << (b * rank + d));
+          }
+      return code;
+    }
+
+    /**
+     *  Stores in \c coord the \c rank coordinates of the Morton code \c code.
+     */
+    template <typename Code>
+    inline void
+    morton_decode(Code code, dimension_type rank, Code* coord)
+    {
+      const unsigned int bits = morton_bits<Code>(rank);
+      for (dimension_type d = 0; d < rank; ++d) { coord[d] = 0; }
+      for (unsigned int b = 0; b < bits; ++b)
+        for (dimension_type d = 0; d < rank; ++d)
+          {
+            coord[d] |= static_cast<Code>(((code >> (b * rank + d)) & 1u)
+                                          << b);
+          }
+    }
+
+    /**
+     *  Returns \c true if the point \c x comes before the point \c y in Morton
+     *  order, without computing their codes.
+     *
+     *  The order of two codes is decided by the most significant bit in
+     *  which they differ. This bit belongs to the dimension whose
+     *  coordinates differ in the most significant bit, the last of them in
+     *  case of ties, since it is interleaved above the others.
+     */
+    template <typename Code>
+    inline bool
+    morton_less(const Code* x, const Code* y, dimension_type rank)
+    {
+      dimension_type dim = 0;
+      Code diff = 0;
+      for (dimension_type d = 0; d < rank; ++d)
+        {
+          Code other = x[d] ^ y[d];
+          // Unless 'diff' has a more significant highest bit than 'other'
+          if (!(other < diff && other < (other ^ diff)))
+            { dim = d; diff = other; }
+        }
+      return x[dim] < y[dim];
+    }
+
+    /**
+     *  Returns the smallest code greater than \c code that lies within the
+     *  box whose lowest corner has the code \c min_code and highest corner
+     *  has the code \c max_code.
+     *
+     *  \c code must be within [\c min_code, \c max_code] without being in
+     *  the box itself. This is the BIGMIN computation of Tropf and Herzog:
+     *  the bits of \c code are compared with those of both corners from the
+     *  most significant one, narrowing the box down to the half of the curve
+     *  that follows \c code.
+     */
+    template <typename Code>
+    inline Code
+    morton_bigmin(Code code, Code min_code, Code max_code,
+                  dimension_type rank)
+    {
+      SPATIAL_ASSERT_CHECK(min_code <= code && code < max_code);
+      const unsigned int bits = morton_bits<Code>(rank);
+      // The bits of the first dimension, shifted for the others
+      Code base = 0;
+      for (unsigned int b = 0; b < bits; ++b)
+        { base |= static_cast<Code>(Code(1) << (b * rank)); }
+      Code bigmin = 0;
+      for (unsigned int b = bits * rank; b-- > 0;)
+        {
+          const Code bit = static_cast<Code>(Code(1) << b);
+          const Code lower = static_cast<Code>
+            ((base << (b % rank)) & (bit - 1u));
+          const bool z = (code & bit) != 0;
+          const bool lo = (min_code & bit) != 0;
+          const bool hi = (max_code & bit) != 0;
+          if (!z)
+            {
+              if (lo) return min_code;
+              if (hi)
+                {
+                  // The upper half of the box follows 'code': its lowest
+                  // corner is a candidate; keep searching the lower half.
+                  bigmin = static_cast<Code>((min_code & ~lower) | bit);
+                  max_code = static_cast<Code>((max_code & ~bit) | lower);
+                }
+            }
+          else
+            {
+              if (!hi) return bigmin;
+              if (!lo)
+                {
+                  // 'code' lies after the lower half of the box.
+                  min_code = static_cast<Code>((min_code & ~lower) | bit);
+                }
+            }
+        }
+      return bigmin;
+    }
+
+    /**
+     *  Sorts \c entries by their first member, the Morton code, with a
+     *  least significant digit radix sort over the \c bits low bits of the
+     *  codes. The sort is stable, and digits on which all codes agree are
+     *  skipped.
+     */
+    template <typename Code>
+    inline void
+    morton_radix_sort(std::vector<std::pair<Code, std::size_t> >& entries,
+                      unsigned int bits)
+    {
+      typedef std::pair<Code, std::size_t> entry_type;
+      if (entries.size() < 2) return;
+      std::vector<entry_type> buffer(entries.size());
+      for (unsigned int shift = 0; shift < bits; shift += 8)
+        {
+          std::size_t count[256] = { 0 };
+          for (typename std::vector<entry_type>::const_iterator
+                 i = entries.begin(); i != entries.end(); ++i)
+            { ++count[(i->first >> shift) & 0xffu]; }
+          if (count[(entries.front().first >> shift) & 0xffu]
+              == entries.size()) continue;
+          std::size_t offset = 0;
+          for (std::size_t digit = 0; digit < 256; ++digit)
+            {
+              std::size_t n = count[digit];
+              count[digit] = offset;
+              offset += n;
+            }
+          for (typename std::vector<entry_type>::const_iterator
+                 i = entries.begin(); i != entries.end(); ++i)
+            { buffer[count[(i->first >> shift) & 0xffu]++] = *i; }
+          entries.swap(buffer);
+        }
+    }
+
+  } // namespace details
+} // namespace spatial
+
+#endif // SPATIAL_MORTON_HPP
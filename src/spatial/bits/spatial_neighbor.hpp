@@ -18,12 +18,47 @@
 #include "spatial_import_tuple.hpp"
 #include "../metric.hpp"
 #include "spatial_bidirectional.hpp"
+#include "spatial_rank.hpp"
+#include "spatial_prefetch.hpp"
 #include "spatial_compress.hpp"
 
 namespace spatial
 {
   namespace details
   {
+    /**
+     *  Statically resolves whether the \metric \c Metric declares the nested
+     *  type \c target_type, as \ref target_metric does.
+     */
+    template <typename Metric>
+    struct has_target_type
+    {
+    private:
+      template <typename Mp> static char test(typename Mp::target_type*);
+      template <typename Mp> static long test(...);
+
+    public:
+      static const bool value = (sizeof(test<Metric>(0)) == sizeof(char));
+    };
+
+    template <typename Container, typename Metric,
+              bool = has_target_type<Metric>::value>
+    struct neighbor_target_helper
+    { typedef typename Container::key_type type; };
+
+    template <typename Container, typename Metric>
+    struct neighbor_target_helper<Container, Metric, true>
+    { typedef typename Metric::target_type type; };
+
+    /**
+     *  The type of the target of a neighbor search in \c Container with \c
+     *  Metric: \c Metric::target_type if the metric declares it, or the key
+     *  type of the container otherwise.
+     */
+    template <typename Container, typename Metric>
+    struct neighbor_target
+      : neighbor_target_helper<Container, Metric> { };
+
     /**
      *  Extra information needed by the iterator to perform its work. This
      *  information is copied to each iterator from a given container.
@@ -57,7 +92,7 @@ namespace spatial
       Neighbor_data
       (const typename Container::key_compare& container,
        const Metric& metric,
-       const typename Container::key_type& key,
+       const typename neighbor_target<Container, Metric>::type& key,
        typename Metric::distance_type distance)
         : Container::key_compare(container), _target(metric, key),
           _distance(distance) { }
@@ -66,7 +101,8 @@ namespace spatial
        *  The target of the iteration; element of the container are iterate
        *  from the closest to the element furthest away from the target.
        */
-      Compress<Metric, typename Container::key_type> _target;
+      Compress<Metric, typename neighbor_target<Container, Metric>::type>
+      _target;
 
       /**
        *  The last valid computed value of the distance. The value stored is
@@ -137,7 +173,7 @@ namespace spatial
     typedef typename Metric::distance_type distance_type;
 
     //! The key type that is used as a target for the nearest neighbor search
-    typedef typename Container::key_type key_type;
+    typedef typename details::neighbor_target<Container, Metric>::type key_type;
 
     //! Uninitialized iterator.
     neighbor_iterator() { }
@@ -155,11 +191,11 @@ namespace spatial
      */
     neighbor_iterator
     (Container& container_, const Metric& metric_,
-     const typename Container::key_type& target_,
+     const key_type& target_,
      const typename Container::iterator& iter_,
      typename Metric::distance_type distance_)
       : Base(container_.rank(), iter_.node,
-             depth(iter_.node) % container_.dimension()),
+             modulo(iter_.node, container_.rank())),
         _data(container_.key_comp(), metric_, target_, distance_) { }
 
     /**
@@ -183,7 +219,7 @@ namespace spatial
      */
     neighbor_iterator
     (Container& container_, const Metric& metric_,
-     const typename Container::key_type& target_,
+     const key_type& target_,
      dimension_type node_dim_,
      typename Container::mode_type::node_ptr node_,
      typename Metric::distance_type distance_)
@@ -213,7 +249,7 @@ namespace spatial
     (const typename Container::rank_type& rank_,
      const typename Container::key_compare& key_comp_,
      const Metric& metric_,
-     const typename Container::key_type& target_,
+     const key_type& target_,
      dimension_type node_dim_,
      typename Container::mode_type::node_ptr node_,
      typename Metric::distance_type distance_)
@@ -224,6 +260,7 @@ namespace spatial
     //! use this form in \c for loops.
     neighbor_iterator<Container, Metric>& operator++()
     {
+      details::Stats_scope scope(*this);
       import::tie(node, node_dim, distance())
         = increment_neighbor(node, node_dim, rank(), key_comp(),
                              metric(), target_key(), distance());
@@ -234,6 +271,7 @@ namespace spatial
     //! the increment. Prefer to use the other form in \c for loops.
     neighbor_iterator<Container, Metric> operator++(int)
     {
+      details::Stats_scope scope(*this);
       neighbor_iterator<Container, Metric> x(*this);
       import::tie(node, node_dim, distance())
         = increment_neighbor(node, node_dim, rank(), key_comp(),
@@ -245,6 +283,7 @@ namespace spatial
     //! use this form in \c for loops.
     neighbor_iterator<Container, Metric>& operator--()
     {
+      details::Stats_scope scope(*this);
       import::tie(node, node_dim, distance())
         = decrement_neighbor(node, node_dim, rank(), key_comp(),
                              metric(), target_key(), distance());
@@ -255,6 +294,7 @@ namespace spatial
     //! the decrement. Prefer to use the other form in \c for loops.
     neighbor_iterator<Container, Metric> operator--(int)
     {
+      details::Stats_scope scope(*this);
       neighbor_iterator<Container, Metric> x(*this);
       import::tie(node, node_dim, distance())
         = decrement_neighbor(node, node_dim, rank(), key_comp(),
@@ -364,7 +404,7 @@ namespace spatial
     typedef typename Metric::distance_type distance_type;
 
     //! The key type that is used as a target for the nearest neighbor search
-    typedef typename Container::key_type key_type;
+    typedef typename details::neighbor_target<Container, Metric>::type key_type;
 
     //! \empty
     neighbor_iterator() { }
@@ -382,11 +422,11 @@ namespace spatial
      */
     neighbor_iterator
     (const Container& container_, const Metric& metric_,
-     const typename Container::key_type& target_,
+     const key_type& target_,
      typename Container::const_iterator iter_,
      typename Metric::distance_type distance_)
       : Base(container_.rank(), iter_.node,
-             depth(iter_.node) % container_.rank()),
+             modulo(iter_.node, container_.rank())),
         _data(container_.key_comp(), metric_, target_, distance_) { }
 
     /**
@@ -410,7 +450,7 @@ namespace spatial
      */
     neighbor_iterator
     (const Container& container_, const Metric& metric_,
-     const typename Container::key_type& target_,
+     const key_type& target_,
      dimension_type node_dim_,
      typename Container::mode_type::const_node_ptr node_,
      typename Metric::distance_type distance_)
@@ -441,7 +481,7 @@ namespace spatial
     (const typename Container::rank_type& rank_,
      const typename Container::key_compare& key_comp_,
      const Metric& metric_,
-     const typename Container::key_type& target_,
+     const key_type& target_,
      dimension_type node_dim_,
      typename Container::mode_type::const_node_ptr node_,
      typename Metric::distance_type distance_)
@@ -450,7 +490,7 @@ namespace spatial
 
     //! Convertion of mutable iterator into a constant iterator.
     neighbor_iterator(const neighbor_iterator<Container, Metric>& iter)
-      : Base(iter.rank(), iter.node, iter.node_dim),
+      : Base(iter.rank(), iter.node, iter.node_dim, iter),
         _data(iter.key_comp(), iter.metric(),
               iter.target_key(), iter.distance()) { }
 
@@ -458,6 +498,7 @@ namespace spatial
     //! use this form in \c for loops.
     neighbor_iterator<const Container, Metric>& operator++()
     {
+      details::Stats_scope scope(*this);
       import::tie(node, node_dim, distance())
         = increment_neighbor(node, node_dim, rank(), key_comp(),
                              metric(), target_key(), distance());
@@ -468,6 +509,7 @@ namespace spatial
     //! the increment. Prefer to use the other form in \c for loops.
     neighbor_iterator<const Container, Metric> operator++(int)
     {
+      details::Stats_scope scope(*this);
       neighbor_iterator<const Container, Metric> x(*this);
       import::tie(node, node_dim, distance())
         = increment_neighbor(node, node_dim, rank(), key_comp(),
@@ -479,6 +521,7 @@ namespace spatial
     //! use this form in \c for loops.
     neighbor_iterator<const Container, Metric>& operator--()
     {
+      details::Stats_scope scope(*this);
       import::tie(node, node_dim, distance())
         = decrement_neighbor(node, node_dim, rank(), key_comp(),
                              metric(), target_key(), distance());
@@ -489,6 +532,7 @@ namespace spatial
     //! the decrement. Prefer to use the other form in \c for loops.
     neighbor_iterator<const Container, Metric> operator--(int)
     {
+      details::Stats_scope scope(*this);
       neighbor_iterator<const Container, Metric> x(*this);
       import::tie(node, node_dim, distance())
         = decrement_neighbor(node, node_dim, rank(), key_comp(),
@@ -560,7 +604,7 @@ namespace spatial
    *  target for the nearest neighbor iteration.
    */
   template <typename Container, typename Metric>
-  inline const typename Container::key_type&
+  inline const typename details::neighbor_target<Container, Metric>::type&
   target_key(const neighbor_iterator<Container, Metric>& iter)
   { return iter.target_key(); }
 
@@ -641,7 +685,8 @@ namespace spatial
   template <typename Container, typename Metric>
   inline neighbor_iterator<Container, Metric>
   neighbor_end(Container& container, const Metric& metric,
-               const typename Container::key_type& target)
+               const typename details::neighbor_target
+               <Container, Metric>::type& target)
   {
     return neighbor_iterator<Container, Metric>
       (container, metric, target, container.dimension() - 1,
@@ -651,10 +696,10 @@ namespace spatial
   template <typename Container, typename Metric>
   inline neighbor_iterator<const Container, Metric>
   neighbor_cend(const Container& container, const Metric& metric,
-                const typename Container::key_type& target)
+                const typename details::neighbor_target
+                <Container, Metric>::type& target)
   {
-    return neighbor_end(container, metric, target,
-                        typename Metric::distance_type());
+    return neighbor_end(container, metric, target);
   }
   ///@}
 
@@ -706,23 +751,28 @@ namespace spatial
   template <typename Container, typename Metric>
   inline neighbor_iterator<Container, Metric>
   neighbor_begin(Container& container, const Metric& metric,
-                 const typename Container::key_type& target)
+                 const typename details::neighbor_target
+                 <Container, Metric>::type& target)
   {
     if (container.empty()) return neighbor_end(container, metric, target);
+    details::Stats_scope scope;
     typename Container::mode_type::node_ptr node = container.end().node->parent;
     dimension_type dim = 0;
     typename Metric::distance_type dist;
     import::tie(node, dim, dist)
       = first_neighbor(node, dim, container.rank(), container.key_comp(),
                        metric, target);
-    return neighbor_iterator<Container, Metric>
+    neighbor_iterator<Container, Metric> iter
       (container, metric, target, dim, node, dist);
+    scope.close(iter);
+    return iter;
   }
 
   template <typename Container, typename Metric>
   inline neighbor_iterator<const Container, Metric>
   neighbor_cbegin(const Container& container, const Metric& metric,
-                  const typename Container::key_type& target)
+                  const typename details::neighbor_target
+                  <Container, Metric>::type& target)
   { return neighbor_begin(container, metric, target); }
   ///@}
 
@@ -778,24 +828,29 @@ namespace spatial
   template <typename Container, typename Metric>
   inline neighbor_iterator<Container, Metric>
   neighbor_lower_bound(Container& container, const Metric& metric,
-                       const typename Container::key_type& target,
+                       const typename details::neighbor_target
+                       <Container, Metric>::type& target,
                        typename Metric::distance_type bound)
   {
     if (container.empty()) return neighbor_end(container, metric, target);
+    details::Stats_scope scope;
     typename Container::mode_type::node_ptr node = container.end().node->parent;
     dimension_type dim = 0;
     typename Metric::distance_type dist;
     import::tie(node, dim, dist)
       = lower_bound_neighbor(node, dim, container.rank(), container.key_comp(),
                              metric, target, bound);
-    return neighbor_iterator<Container, Metric>
+    neighbor_iterator<Container, Metric> iter
       (container, metric, target, dim, node, dist);
+    scope.close(iter);
+    return iter;
   }
 
   template <typename Container, typename Metric>
   inline neighbor_iterator<const Container, Metric>
   neighbor_clower_bound(const Container& container, const Metric& metric,
-                        const typename Container::key_type& target,
+                        const typename details::neighbor_target
+                        <Container, Metric>::type& target,
                         typename Metric::distance_type bound)
   { return neighbor_lower_bound(container, metric, target, bound); }
   ///@}
@@ -857,24 +912,29 @@ namespace spatial
   template <typename Container, typename Metric>
   inline neighbor_iterator<Container, Metric>
   neighbor_upper_bound(Container& container, const Metric& metric,
-                       const typename Container::key_type& target,
+                       const typename details::neighbor_target
+                       <Container, Metric>::type& target,
                        typename Metric::distance_type bound)
   {
     if (container.empty()) return neighbor_end(container, metric, target);
+    details::Stats_scope scope;
     typename Container::mode_type::node_ptr node = container.end().node->parent;
     dimension_type dim = 0;
     typename Metric::distance_type dist;
     import::tie(node, dim, dist)
       = upper_bound_neighbor(node, dim, container.rank(), container.key_comp(),
                              metric, target, bound);
-    return neighbor_iterator<Container, Metric>
+    neighbor_iterator<Container, Metric> iter
       (container, metric, target, dim, node, dist);
+    scope.close(iter);
+    return iter;
   }
 
   template <typename Container, typename Metric>
   inline neighbor_iterator<const Container, Metric>
   neighbor_cupper_bound(const Container& container, const Metric& metric,
-                        const typename Container::key_type& target,
+                        const typename details::neighbor_target
+                        <Container, Metric>::type& target,
                         typename Metric::distance_type bound)
   { return neighbor_upper_bound(container, metric, target, bound); }
   ///@}
@@ -935,7 +995,8 @@ namespace spatial
   template <typename Container, typename Metric>
   inline neighbor_iterator_pair<Container, Metric>
   neighbor_range(Container& container, const Metric& metric,
-                 const typename Container::key_type& target)
+                 const typename details::neighbor_target
+                 <Container, Metric>::type& target)
   {
     return neighbor_iterator_pair<Container, Metric>
       (neighbor_begin(container, metric, target),
@@ -945,7 +1006,8 @@ namespace spatial
   template <typename Container, typename Metric>
   inline neighbor_iterator_pair<const Container, Metric>
   neighbor_crange(const Container& container, const Metric& metric,
-                  const typename Container::key_type& target)
+                  const typename details::neighbor_target
+                  <Container, Metric>::type& target)
   {
     return neighbor_iterator_pair<const Container, Metric>
       (neighbor_begin(container, metric, target),
@@ -1013,7 +1075,7 @@ namespace spatial
       for (;;)
         {
           typename Metric::distance_type test_dist
-            = met.distance_to_key(rank(), target, const_key(node));
+            = distance_to_key(met, rank(), target, const_key(node));
           if (test_dist >= best_dist)
             {
               best = node;
@@ -1031,16 +1093,16 @@ namespace spatial
                 {
                   import::tuple<NodePtr, dimension_type,
                                 typename Metric::distance_type>
-                    triplet = last_neighbor_sub(near, child_dim, rank,
+                    triplet = last_neighbor_sub(descend(near), child_dim, rank,
                                                 key_comp, met, target,
                                                 best_dist);
                   if (import::get<0>(triplet) != node)
                     { import::tie(best, best_dim, best_dist) = triplet; }
                 }
-              node = far; dim = child_dim;
+              node = descend(far); dim = child_dim;
             }
           else if (near != 0)
-            { node = near; dim = incr_dim(rank, dim); }
+            { node = descend(near); dim = incr_dim(rank, dim); }
           else
             { return import::make_tuple(best, best_dim, best_dist); }
         }
@@ -1053,8 +1115,8 @@ namespace spatial
     last_neighbor(NodePtr node, dimension_type dim, Rank rank,
                   KeyCompare key_comp, const Metric& met, const Key& target)
     {
-      return last_neighbor_sub(node, dim, rank, key_comp, met, target,
-                               typename Metric::distance_type());
+      return last_neighbor_sub(descend(node), dim, rank, key_comp, met,
+                               target, typename Metric::distance_type());
     }
 
     template <typename NodePtr, typename Rank, typename KeyCompare,
@@ -1074,8 +1136,11 @@ namespace spatial
       dimension_type best_dim = 0;
       for (;;)
         {
+          // Both children are requested while the distance is computed: the
+          // far child may be visited after the near one.
+          prefetch_children(node);
           typename Metric::distance_type test_dist
-            = met.distance_to_key(rank(), target, const_key(node));
+            = distance_to_key(met, rank(), target, const_key(node));
           if (test_dist < best_dist)
             {
               best = node;
@@ -1086,31 +1151,33 @@ namespace spatial
           import::tie(near, far) = key_comp(dim, const_key(node), target)
             ? import::make_tuple(node->right, node->left)
             : import::make_tuple(node->left, node->right);
-          if (far != 0 && (met.distance_to_plane
-                           (rank(), dim, target, const_key(node)) < best_dist))
+          if (far != 0
+              && explore(distance_to_plane
+                         (met, rank(), dim, target, const_key(node))
+                         < best_dist))
             {
               dimension_type child_dim = incr_dim(rank, dim);
               if (near != 0)
                 {
                   import::tuple<NodePtr, dimension_type,
                                 typename Metric::distance_type>
-                    triplet = first_neighbor_sub(near, child_dim, rank,
-                                                 key_comp, met, target,
+                    triplet = first_neighbor_sub(descend(near), child_dim,
+                                                 rank, key_comp, met, target,
                                                  best_dist);
                   if (import::get<0>(triplet) != node)
                     {
                       // If I can't go right after exploring left, I'm done
-                      if (!(met.distance_to_plane
-                            (rank(), dim, target, const_key(node))
-                            < import::get<2>(triplet)))
+                      if (!explore(distance_to_plane
+                                   (met, rank(), dim, target, const_key(node))
+                                   < import::get<2>(triplet)))
                         { return triplet; }
                       import::tie(best, best_dim, best_dist) = triplet;
                     }
                 }
-              node = far; dim = child_dim;
+              node = descend(far); dim = child_dim;
             }
           else if (near != 0)
-            { node = near; dim = incr_dim(rank, dim); }
+            { node = descend(near); dim = incr_dim(rank, dim); }
           else
             { return import::make_tuple(best, best_dim, best_dist); }
         }
@@ -1124,7 +1191,7 @@ namespace spatial
                    const KeyCompare& key_comp, const Metric& met, const Key& target)
     {
       return first_neighbor_sub
-        (node, dim, rank, key_comp, met, target,
+        (descend(node), dim, rank, key_comp, met, target,
          (std::numeric_limits<typename Metric::distance_type>::max)());
     }
 
@@ -1147,7 +1214,7 @@ namespace spatial
       for (;;)
         {
           typename Metric::distance_type test_dist
-            = met.distance_to_key(rank(), target, const_key(node));
+            = distance_to_key(met, rank(), target, const_key(node));
           if (test_dist > bound)
             {
               if (test_dist < best_dist)
@@ -1163,32 +1230,36 @@ namespace spatial
           import::tie(near, far) = key_comp(dim, const_key(node), target)
             ? import::make_tuple(node->right, node->left)
             : import::make_tuple(node->left, node->right);
-          if (far != 0 && (met.distance_to_plane
-                           (rank(), dim, target, const_key(node)) < best_dist))
+          if (far != 0
+              && explore(distance_to_plane
+                         (met, rank(), dim, target, const_key(node))
+                         < best_dist))
             {
               dimension_type child_dim = incr_dim(rank, dim);
               if (near != 0)
                 {
                   import::tuple<NodePtr, dimension_type,
                                 typename Metric::distance_type>
-                    triplet = lower_bound_neighbor_sub(near, child_dim, rank,
-                                                       key_comp, met, target,
-                                                       bound, best_dist);
+                    triplet = lower_bound_neighbor_sub(descend(near), child_dim,
+                                                       rank, key_comp, met,
+                                                       target, bound,
+                                                       best_dist);
                   if (import::get<0>(triplet) != node)
                     {
                       if (import::get<2>(triplet) == bound
                           // If I can't go right after exploring left, I'm done
-                          || !(met.distance_to_plane
-                               (rank(), dim, target, const_key(node))
-                               < import::get<2>(triplet)))
+                          || !explore(distance_to_plane
+                                      (met, rank(), dim, target,
+                                       const_key(node))
+                                      < import::get<2>(triplet)))
                         { return triplet; }
                       import::tie(best, best_dim, best_dist) = triplet;
                     }
                 }
-              node = far; dim = child_dim;
+              node = descend(far); dim = child_dim;
             }
           else if (near != 0)
-            { node = near; dim = incr_dim(rank, dim); }
+            { node = descend(near); dim = incr_dim(rank, dim); }
           else
             { return import::make_tuple(best, best_dim, best_dist); }
         }
@@ -1204,7 +1275,7 @@ namespace spatial
                          typename Metric::distance_type bound)
     {
       return lower_bound_neighbor_sub
-        (node, dim, rank, key_comp, met, target, bound,
+        (descend(node), dim, rank, key_comp, met, target, bound,
          (std::numeric_limits<typename Metric::distance_type>::max)());
     }
 
@@ -1226,7 +1297,7 @@ namespace spatial
       for (;;)
         {
           typename Metric::distance_type test_dist
-            = met.distance_to_key(rank(), target, const_key(node));
+            = distance_to_key(met, rank(), target, const_key(node));
           if (test_dist > bound && test_dist < best_dist)
             {
               best = node;
@@ -1237,31 +1308,34 @@ namespace spatial
           import::tie(near, far) = key_comp(dim, const_key(node), target)
             ? import::make_tuple(node->right, node->left)
             : import::make_tuple(node->left, node->right);
-          if (far != 0 && (met.distance_to_plane
-                           (rank(), dim, target, const_key(node)) < best_dist))
+          if (far != 0
+              && explore(distance_to_plane
+                         (met, rank(), dim, target, const_key(node))
+                         < best_dist))
             {
               dimension_type child_dim = incr_dim(rank, dim);
               if (near != 0)
                 {
                   import::tuple<NodePtr, dimension_type,
                                 typename Metric::distance_type>
-                    triplet = upper_bound_neighbor_sub(near, child_dim, rank,
-                                                       key_comp, met, target,
-                                                       bound, best_dist);
+                    triplet = upper_bound_neighbor_sub(descend(near), child_dim,
+                                                       rank, key_comp, met,
+                                                       target, bound,
+                                                       best_dist);
                   if (import::get<0>(triplet) != node)
                     {
                       // If I can't go right after exploring left, I'm done
-                      if (!(met.distance_to_plane
-                            (rank(), dim, target, const_key(node))
-                            < import::get<2>(triplet)))
+                      if (!explore(distance_to_plane
+                                   (met, rank(), dim, target, const_key(node))
+                                   < import::get<2>(triplet)))
                         { return triplet; }
                       import::tie(best, best_dim, best_dist) = triplet;
                     }
                 }
-              node = far; dim = child_dim;
+              node = descend(far); dim = child_dim;
             }
           else if (near != 0)
-            { node = near; dim = incr_dim(rank, dim); }
+            { node = descend(near); dim = incr_dim(rank, dim); }
           else
             { return import::make_tuple(best, best_dim, best_dist); }
         }
@@ -1277,7 +1351,7 @@ namespace spatial
                          typename Metric::distance_type bound)
     {
       return upper_bound_neighbor_sub
-        (node, dim, rank, key_comp, met, target, bound,
+        (descend(node), dim, rank, key_comp, met, target, bound,
          (std::numeric_limits<typename Metric::distance_type>::max)());
     }
 
@@ -1308,36 +1382,38 @@ namespace spatial
             ? import::make_tuple(node->right, node->left)
             : import::make_tuple(node->left, node->right);
           if (near != 0)
-            { node = near; dim = incr_dim(rank, dim); }
+            { node = descend(near); dim = incr_dim(rank, dim); }
           else if (far != 0
-                   && (best == 0
-                       || met.distance_to_plane
-                       (rank(), dim, target, const_key(node)) < best_dist))
-            { node = far; dim = incr_dim(rank, dim); }
+                   && explore(best == 0
+                              || distance_to_plane
+                              (met, rank(), dim, target, const_key(node))
+                              < best_dist))
+            { node = descend(far); dim = incr_dim(rank, dim); }
           else
             {
               NodePtr prev_node = node;
-              node = node->parent; dim = decr_dim(rank, dim);
+              node = climb(node); dim = decr_dim(rank, dim);
               while (!header(node)
                      && (prev_node
                          == (far = key_comp(dim, const_key(node), target)
                              ? node->left : node->right)
                          || far == 0
-                         || !(best == 0
-                              || (met.distance_to_plane
-                                  (rank(), dim, target, const_key(node))
-                                  < best_dist))))
+                         || !explore(best == 0
+                                     || (distance_to_plane
+                                         (met, rank(), dim, target,
+                                          const_key(node))
+                                         < best_dist))))
                 {
                   prev_node = node;
-                  node = node->parent; dim = decr_dim(rank, dim);
+                  node = climb(node); dim = decr_dim(rank, dim);
                 }
               if (!header(node))
-                { node = far; dim = incr_dim(rank, dim); }
+                { node = descend(far); dim = incr_dim(rank, dim); }
               else break;
             }
           // Test node here and stops as soon as it finds an equal
           typename Metric::distance_type test_dist
-            = met.distance_to_key(rank(), target, const_key(node));
+            = distance_to_key(met, rank(), target, const_key(node));
           if (test_dist == node_dist)
             {
               SPATIAL_ASSERT_CHECK(dim < rank());
@@ -1366,7 +1442,7 @@ namespace spatial
             : import::make_tuple(node->left, node->right);
           if (far == prev_node && near != 0)
             {
-              node = near;
+              node = descend(near);
               dim = prev_dim;
               for (;;)
                 {
@@ -1374,20 +1450,19 @@ namespace spatial
                     ? import::make_tuple(node->right, node->left)
                     : import::make_tuple(node->left, node->right);
                   if (far != 0
-                      && (best == 0
-                          || (met.distance_to_plane(rank(), dim, target,
-                                                    const_key(node))
-                              <= best_dist))
-                      )
-                    { node = far; dim = incr_dim(rank, dim); }
+                      && explore(best == 0
+                                 || (distance_to_plane(met, rank(), dim,
+                                                       target, const_key(node))
+                                     <= best_dist)))
+                    { node = descend(far); dim = incr_dim(rank, dim); }
                   else if (near != 0)
-                    { node = near; dim = incr_dim(rank, dim); }
+                    { node = descend(near); dim = incr_dim(rank, dim); }
                   else break;
                 }
             }
           // Test node here for new best
           typename Metric::distance_type test_dist
-            = met.distance_to_key(rank(), target, const_key(node));
+            = distance_to_key(met, rank(), target, const_key(node));
           if (test_dist > node_dist && (best == 0 || test_dist <= best_dist))
             {
               best = node;
@@ -1396,7 +1471,7 @@ namespace spatial
             }
           prev_node = node;
           prev_dim = dim;
-          node = node->parent;
+          node = climb(node);
           dim = decr_dim(rank, dim);
         }
       SPATIAL_ASSERT_CHECK(dim < rank());
@@ -1428,7 +1503,7 @@ namespace spatial
       // refer to tree walking in near-pre-order.
       NodePtr prev_node = node;
       dimension_type prev_dim = dim;
-      node = node->parent;
+      node = climb(node);
       dim = decr_dim(rank, dim);
       while (!header(node))
         {
@@ -1438,7 +1513,7 @@ namespace spatial
             : import::make_tuple(node->left, node->right);
           if (prev_node == far && near != 0)
             {
-              node = near;
+              node = descend(near);
               dim = prev_dim;
               for (;;)
                 {
@@ -1446,18 +1521,18 @@ namespace spatial
                     ? import::make_tuple(node->right, node->left)
                     : import::make_tuple(node->left, node->right);
                   if (far != 0
-                      && (met.distance_to_plane(rank(), dim, target,
-                                                const_key(node))
-                          <= node_dist))
-                    { node = far; dim = incr_dim(rank, dim); }
+                      && explore(distance_to_plane(met, rank(), dim, target,
+                                                   const_key(node))
+                                 <= node_dist))
+                    { node = descend(far); dim = incr_dim(rank, dim); }
                   else if (near != 0)
-                    { node = near; dim = incr_dim(rank, dim); }
+                    { node = descend(near); dim = incr_dim(rank, dim); }
                   else break;
                 }
             }
           // Test node here and stops as soon as it finds an equal
           typename Metric::distance_type test_dist
-            = met.distance_to_key(rank(), target, const_key(node));
+            = distance_to_key(met, rank(), target, const_key(node));
           if (test_dist == node_dist)
             {
               SPATIAL_ASSERT_CHECK(dim < rank());
@@ -1473,7 +1548,7 @@ namespace spatial
             }
           prev_node = node;
           prev_dim = dim;
-          node = node->parent;
+          node = climb(node);
           dim = decr_dim(rank, dim);
         }
       // Here, current best_dist < node_dist or best == 0, maybe there is a
@@ -1487,34 +1562,34 @@ namespace spatial
             ? import::make_tuple(node->right, node->left)
             : import::make_tuple(node->left, node->right);
           if (near != 0)
-            { node = near; dim = incr_dim(rank, dim); }
+            { node = descend(near); dim = incr_dim(rank, dim); }
           else if (far != 0
-                   && (met.distance_to_plane(rank(), dim, target,
-                                             const_key(node))
-                       < node_dist))
-            { node = far; dim = incr_dim(rank, dim); }
+                   && explore(distance_to_plane(met, rank(), dim, target,
+                                                const_key(node))
+                              < node_dist))
+            { node = descend(far); dim = incr_dim(rank, dim); }
           else
             {
               prev_node = node;
-              node = node->parent; dim = decr_dim(rank, dim);
+              node = climb(node); dim = decr_dim(rank, dim);
               while (!header(node)
                      && (prev_node
                          == (far = key_comp(dim, const_key(node), target)
                              ? node->left : node->right)
                          || far == 0
-                         || !(met.distance_to_plane(rank(), dim, target,
-                                                    const_key(node))
-                                  < node_dist)))
+                         || !explore(distance_to_plane(met, rank(), dim,
+                                                       target, const_key(node))
+                                     < node_dist)))
                 {
                   prev_node = node;
-                  node = node->parent; dim = decr_dim(rank, dim);
+                  node = climb(node); dim = decr_dim(rank, dim);
                 }
               if (!header(node))
-                { node = far; dim = incr_dim(rank, dim); }
+                { node = descend(far); dim = incr_dim(rank, dim); }
               else break;
             }
           typename Metric::distance_type test_dist
-            = met.distance_to_key(rank(), target, const_key(node));
+            = distance_to_key(met, rank(), target, const_key(node));
           if (test_dist < node_dist && (best == 0 || test_dist >= best_dist))
             {
               best = node;
@@ -1528,6 +1603,119 @@ namespace spatial
       return import::make_tuple(node, dim, best_dist);
     }
 
+    /**
+     *  \name Dispatch of \dynamic_rank
+     *
+     *  Overloads of the neighbor traversals for \dynamic_rank. If the rank of
+     *  the container is listed in \ref SPATIAL_DISPATCH_RANKS, the traversal
+     *  is carried out with the equivalent \static_rank, and the metric
+     *  computes distances with loops of fixed length.
+     */
+    ///@{
+    template <typename NodePtr, typename KeyCompare, typename Key,
+              typename Metric>
+    inline import::tuple<NodePtr, dimension_type,
+                         typename Metric::distance_type>
+    last_neighbor(NodePtr node, dimension_type dim, Dynamic_rank rank,
+                  KeyCompare key_comp, const Metric& met, const Key& target)
+    {
+#     define SPATIAL_RANK_DISPATCH_CALL(r) \
+        last_neighbor(node, dim, r, key_comp, met, target)
+      SPATIAL_RANK_DISPATCH(rank)
+#     undef SPATIAL_RANK_DISPATCH_CALL
+      return last_neighbor<NodePtr, Dynamic_rank, KeyCompare, Key, Metric>
+        (node, dim, rank, key_comp, met, target);
+    }
+
+    template <typename NodePtr, typename KeyCompare, typename Key,
+              typename Metric>
+    inline import::tuple<NodePtr, dimension_type,
+                         typename Metric::distance_type>
+    first_neighbor(NodePtr node, dimension_type dim, Dynamic_rank rank,
+                   const KeyCompare& key_comp, const Metric& met,
+                   const Key& target)
+    {
+#     define SPATIAL_RANK_DISPATCH_CALL(r) \
+        first_neighbor(node, dim, r, key_comp, met, target)
+      SPATIAL_RANK_DISPATCH(rank)
+#     undef SPATIAL_RANK_DISPATCH_CALL
+      return first_neighbor<NodePtr, Dynamic_rank, KeyCompare, Key, Metric>
+        (node, dim, rank, key_comp, met, target);
+    }
+
+    template <typename NodePtr, typename KeyCompare, typename Key,
+              typename Metric>
+    inline import::tuple<NodePtr, dimension_type,
+                         typename Metric::distance_type>
+    lower_bound_neighbor(NodePtr node, dimension_type dim, Dynamic_rank rank,
+                         KeyCompare key_comp, const Metric& met,
+                         const Key& target,
+                         typename Metric::distance_type bound)
+    {
+#     define SPATIAL_RANK_DISPATCH_CALL(r) \
+        lower_bound_neighbor(node, dim, r, key_comp, met, target, bound)
+      SPATIAL_RANK_DISPATCH(rank)
+#     undef SPATIAL_RANK_DISPATCH_CALL
+      return lower_bound_neighbor
+        <NodePtr, Dynamic_rank, KeyCompare, Key, Metric>
+        (node, dim, rank, key_comp, met, target, bound);
+    }
+
+    template <typename NodePtr, typename KeyCompare, typename Key,
+              typename Metric>
+    inline import::tuple<NodePtr, dimension_type,
+                         typename Metric::distance_type>
+    upper_bound_neighbor(NodePtr node, dimension_type dim, Dynamic_rank rank,
+                         KeyCompare key_comp, const Metric& met,
+                         const Key& target,
+                         typename Metric::distance_type bound)
+    {
+#     define SPATIAL_RANK_DISPATCH_CALL(r) \
+        upper_bound_neighbor(node, dim, r, key_comp, met, target, bound)
+      SPATIAL_RANK_DISPATCH(rank)
+#     undef SPATIAL_RANK_DISPATCH_CALL
+      return upper_bound_neighbor
+        <NodePtr, Dynamic_rank, KeyCompare, Key, Metric>
+        (node, dim, rank, key_comp, met, target, bound);
+    }
+
+    template <typename NodePtr, typename KeyCompare, typename Key,
+              typename Metric>
+    inline import::tuple<NodePtr, dimension_type,
+                         typename Metric::distance_type>
+    increment_neighbor(NodePtr node, dimension_type dim, Dynamic_rank rank,
+                       KeyCompare key_comp, const Metric& met,
+                       const Key& target,
+                       typename Metric::distance_type node_dist)
+    {
+#     define SPATIAL_RANK_DISPATCH_CALL(r) \
+        increment_neighbor(node, dim, r, key_comp, met, target, node_dist)
+      SPATIAL_RANK_DISPATCH(rank)
+#     undef SPATIAL_RANK_DISPATCH_CALL
+      return increment_neighbor
+        <NodePtr, Dynamic_rank, KeyCompare, Key, Metric>
+        (node, dim, rank, key_comp, met, target, node_dist);
+    }
+
+    template <typename NodePtr, typename KeyCompare, typename Key,
+              typename Metric>
+    inline import::tuple<NodePtr, dimension_type,
+                         typename Metric::distance_type>
+    decrement_neighbor(NodePtr node, dimension_type dim, Dynamic_rank rank,
+                       KeyCompare key_comp, const Metric& met,
+                       const Key& target,
+                       typename Metric::distance_type node_dist)
+    {
+#     define SPATIAL_RANK_DISPATCH_CALL(r) \
+        decrement_neighbor(node, dim, r, key_comp, met, target, node_dist)
+      SPATIAL_RANK_DISPATCH(rank)
+#     undef SPATIAL_RANK_DISPATCH_CALL
+      return decrement_neighbor
+        <NodePtr, Dynamic_rank, KeyCompare, Key, Metric>
+        (node, dim, rank, key_comp, met, target, node_dist);
+    }
+    ///@}
+
   } // namespace details
 } // namespace spatial
 
@@ -365,6 +365,115 @@ namespace spatial
       operator= (const Relaxed_kdtree_link<Key, Value>&);
     };
 
+    /**
+     *  Define a weighted link type for the relaxed \kdtree, that holds the key
+     *  in the node and the value in a separate allocation.
+     *
+     *  Traversals only read the links, the weight and the key, which stay
+     *  together in a small node; the value, e.g. a pair with a large mapped
+     *  type, is only read when an iterator is dereferenced. The value keeps
+     *  its address for as long as it is in the container.
+     *
+     *  \tparam Key The key type that is held by the Relaxed_kdtree_cold_link.
+     *  \tparam Value The value type that is referred to by the
+     *  Relaxed_kdtree_cold_link.
+     */
+    template<typename Key, typename Value>
+    struct Relaxed_kdtree_cold_link
+      : Node<Relaxed_kdtree_cold_link<Key, Value> >
+    {
+      //! The link to the key type.
+      typedef Key                                 key_type;
+      //! The link to the value type.
+      typedef Value                               value_type;
+      //! The link type, which is also itself, since mode are also
+      //! contained in this type.
+      typedef Relaxed_kdtree_cold_link<Key, Value> link_type;
+      //! The link pointer which is often used, has a dedicated type.
+      typedef link_type*                          link_ptr;
+      //! The constant link pointer which is often used, has a dedicated type.
+      typedef const link_type*                    const_link_ptr;
+      //! The node pointer type deduced from the mode.
+      typedef Node<link_type>*                    node_ptr;
+      //! The constant node pointer deduced from the mode.
+      typedef const Node<link_type>*              const_node_ptr;
+      //! The category of invariant with associated with this mode.
+      typedef relaxed_invariant_tag               invariant_category;
+
+      //! \empty
+      Relaxed_kdtree_cold_link() { }
+
+      //! A copy of the key of the value, read by all traversals.
+      Key key;
+
+      //! The weight is equal to 1 plus the amount of child nodes below the
+      //! current node. It is always equal to 1 at least.
+      weight_type weight;
+
+      //! The value of the node, allocated separately.
+      Value* value;
+
+    private:
+      //! The link_type is a non-assignable type, like \ref
+      //! Relaxed_kdtree_link.
+      Relaxed_kdtree_cold_link<Key, Value>&
+      operator= (const Relaxed_kdtree_cold_link<Key, Value>&);
+    };
+
+    /**
+     *  Define a weighted link type for the relaxed \kdtree, that holds the
+     *  value and, as its key, a copy of the coordinates of the value.
+     *
+     *  The key is computed once, when the node is created, so that
+     *  traversals read the coordinates from the node instead of reading them
+     *  through the value.
+     *
+     *  \tparam Key The type of the copy of the coordinates.
+     *  \tparam Value The value type that is held by the
+     *  Relaxed_kdtree_cached_link.
+     */
+    template<typename Key, typename Value>
+    struct Relaxed_kdtree_cached_link
+      : Node<Relaxed_kdtree_cached_link<Key, Value> >
+    {
+      //! The link to the key type.
+      typedef Key                                 key_type;
+      //! The link to the value type.
+      typedef Value                               value_type;
+      //! The link type, which is also itself, since mode are also
+      //! contained in this type.
+      typedef Relaxed_kdtree_cached_link<Key, Value> link_type;
+      //! The link pointer which is often used, has a dedicated type.
+      typedef link_type*                          link_ptr;
+      //! The constant link pointer which is often used, has a dedicated type.
+      typedef const link_type*                    const_link_ptr;
+      //! The node pointer type deduced from the mode.
+      typedef Node<link_type>*                    node_ptr;
+      //! The constant node pointer deduced from the mode.
+      typedef const Node<link_type>*              const_node_ptr;
+      //! The category of invariant with associated with this mode.
+      typedef relaxed_invariant_tag               invariant_category;
+
+      //! \empty
+      Relaxed_kdtree_cached_link() { }
+
+      //! The coordinates of the value, read by all traversals.
+      Key key;
+
+      //! The weight is equal to 1 plus the amount of child nodes below the
+      //! current node. It is always equal to 1 at least.
+      weight_type weight;
+
+      //! The value of the node.
+      Value value;
+
+    private:
+      //! The link_type is a non-assignable type, like \ref
+      //! Relaxed_kdtree_link.
+      Relaxed_kdtree_cached_link<Key, Value>&
+      operator= (const Relaxed_kdtree_cached_link<Key, Value>&);
+    };
+
     /**
      *  This function converts a pointer on a node into a link for a \ref
      *  Kdtree_link type.
@@ -525,6 +634,98 @@ namespace spatial
     }
     ///@}
 
+    /**
+     *  These functions convert a pointer on a node into a link, a key or a
+     *  value for a \ref Relaxed_kdtree_cold_link type.
+     *  \tparam Key the key type for the \ref Relaxed_kdtree_cold_link.
+     *  \tparam Value the value type for the \ref Relaxed_kdtree_cold_link.
+     *  \param node the node to convert.
+     */
+    ///@{
+    template <typename Key, typename Value>
+    inline Relaxed_kdtree_cold_link<Key, Value>*
+    link(Node<Relaxed_kdtree_cold_link<Key, Value> >* node)
+    {
+      return static_cast<Relaxed_kdtree_cold_link<Key, Value>*>(node);
+    }
+
+    template <typename Key, typename Value>
+    inline const Relaxed_kdtree_cold_link<Key, Value>*
+    const_link(const Node<Relaxed_kdtree_cold_link<Key, Value> >* node)
+    {
+      return static_cast<const Relaxed_kdtree_cold_link<Key, Value>*>(node);
+    }
+
+    template <typename Key, typename Value>
+    inline const typename Relaxed_kdtree_cold_link<Key, Value>::key_type&
+    const_key(const Node<Relaxed_kdtree_cold_link<Key, Value> >* node)
+    {
+      return static_cast<const Relaxed_kdtree_cold_link<Key, Value>*>
+        (node)->key;
+    }
+
+    template <typename Key, typename Value>
+    inline typename Relaxed_kdtree_cold_link<Key, Value>::value_type&
+    value(Node<Relaxed_kdtree_cold_link<Key, Value> >* node)
+    {
+      return *static_cast<Relaxed_kdtree_cold_link<Key, Value>*>(node)->value;
+    }
+
+    template <typename Key, typename Value>
+    inline const typename Relaxed_kdtree_cold_link<Key, Value>::value_type&
+    const_value(const Node<Relaxed_kdtree_cold_link<Key, Value> >* node)
+    {
+      return *static_cast<const Relaxed_kdtree_cold_link<Key, Value>*>
+        (node)->value;
+    }
+    ///@}
+
+    /**
+     *  These functions convert a pointer on a node into a link, a key or a
+     *  value for a \ref Relaxed_kdtree_cached_link type.
+     *  \tparam Key the key type for the \ref Relaxed_kdtree_cached_link.
+     *  \tparam Value the value type for the \ref Relaxed_kdtree_cached_link.
+     *  \param node the node to convert.
+     */
+    ///@{
+    template <typename Key, typename Value>
+    inline Relaxed_kdtree_cached_link<Key, Value>*
+    link(Node<Relaxed_kdtree_cached_link<Key, Value> >* node)
+    {
+      return static_cast<Relaxed_kdtree_cached_link<Key, Value>*>(node);
+    }
+
+    template <typename Key, typename Value>
+    inline const Relaxed_kdtree_cached_link<Key, Value>*
+    const_link(const Node<Relaxed_kdtree_cached_link<Key, Value> >* node)
+    {
+      return static_cast<const Relaxed_kdtree_cached_link<Key, Value>*>(node);
+    }
+
+    template <typename Key, typename Value>
+    inline const typename Relaxed_kdtree_cached_link<Key, Value>::key_type&
+    const_key(const Node<Relaxed_kdtree_cached_link<Key, Value> >* node)
+    {
+      return static_cast<const Relaxed_kdtree_cached_link<Key, Value>*>
+        (node)->key;
+    }
+
+    template <typename Key, typename Value>
+    inline typename Relaxed_kdtree_cached_link<Key, Value>::value_type&
+    value(Node<Relaxed_kdtree_cached_link<Key, Value> >* node)
+    {
+      return static_cast<Relaxed_kdtree_cached_link<Key, Value>*>(node)->value;
+    }
+
+    template <typename Key, typename Value>
+    inline const typename Relaxed_kdtree_cached_link<Key, Value>::value_type&
+    const_value(const Node<Relaxed_kdtree_cached_link<Key, Value> >* node)
+    {
+      return static_cast<const Relaxed_kdtree_cached_link<Key, Value>*>
+        (node)->value;
+    }
+    ///@}
+
     /**
      *  Swaps nodes position in the tree.
      *
@@ -534,6 +735,8 @@ namespace spatial
      *  \see Node
      *  \see Kdtree_link
      *  \see Relaxed_kdtree_link
+     *  \see Relaxed_kdtree_cold_link
+     *  \see Relaxed_kdtree_cached_link
      */
     ///@{
     template <typename Link>
@@ -552,6 +755,24 @@ namespace spatial
       std::swap(link(a)->weight, link(b)->weight);
       std::swap(a, b);
     }
+
+    template<typename Key, typename Value>
+    inline void swap_node(Node<Relaxed_kdtree_cold_link<Key, Value> >*& a,
+                          Node<Relaxed_kdtree_cold_link<Key, Value> >*& b)
+    {
+      swap_node_aux(a, b);
+      std::swap(link(a)->weight, link(b)->weight);
+      std::swap(a, b);
+    }
+
+    template<typename Key, typename Value>
+    inline void swap_node(Node<Relaxed_kdtree_cached_link<Key, Value> >*& a,
+                          Node<Relaxed_kdtree_cached_link<Key, Value> >*& b)
+    {
+      swap_node_aux(a, b);
+      std::swap(link(a)->weight, link(b)->weight);
+      std::swap(a, b);
+    }
     ///@}
 
     /**
@@ -0,0 +1,152 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   spatial_node_reserve.hpp
+ *  Provides \ref spatial::details::Node_reserve, the nodes that a tree
+ *  allocates in advance with \c reserve(), together with the buffer of node
+ *  pointers used to rebuild the tree.
+ *
+ *  Once a tree has reserved nodes, erased nodes are kept for later
+ *  insertions rather than deallocated, and rebalancing reuses the same
+ *  buffer, so that inserting, erasing and rebalancing within the reserved
+ *  capacity never calls the allocator.
+ */
+
+#ifndef SPATIAL_NODE_RESERVE_HPP
+#define SPATIAL_NODE_RESERVE_HPP
+
+#include <memory> // std::allocator_traits
+#include <vector>
+#include <algorithm> // std::swap
+#include "spatial_node.hpp"
+
+namespace spatial
+{
+  namespace details
+  {
+    /**
+     *  A free list of nodes of type \c Link allocated in advance, linked
+     *  through their parent pointer, and a buffer of node pointers.
+     *
+     *  The nodes of the free list are allocated but not constructed. Both the
+     *  nodes and the buffer are allocated with \c Alloc, the allocator of the
+     *  nodes of the tree, so that a tree using a memory resource also
+     *  allocates its buffer from that resource.
+     *
+     *  \tparam Link The type of the nodes of the tree.
+     *  \tparam Alloc The allocator of \c Link used by the tree.
+     */
+    template <typename Link, typename Alloc>
+    class Node_reserve
+    {
+      typedef typename Link::link_ptr                 link_ptr;
+      typedef typename Link::node_ptr                 node_ptr;
+
+    public:
+      typedef typename std::allocator_traits<Alloc>
+      ::template rebind_alloc<node_ptr>               ptr_allocator;
+      //! The buffer of node pointers used to rebuild the tree.
+      typedef std::vector<node_ptr, ptr_allocator>    ptr_store;
+
+      explicit Node_reserve(const Alloc& alloc)
+        : _spare(0), _spares(0), _recycle(false), _store(ptr_allocator(alloc))
+      { }
+
+      //! Returns the number of nodes allocated in advance and not in use.
+      std::size_t spares() const { return _spares; }
+
+      //! Returns \c true if erased nodes are kept rather than deallocated.
+      bool recycle() const { return _recycle; }
+
+      //! Returns a node of the free list, or allocates one if it is empty.
+      link_ptr get(Alloc& alloc)
+      {
+        link_ptr link = take();
+        return (link != 0) ? link : alloc.allocate(1); // may throw
+      }
+
+      //! Puts \c link in the free list if erased nodes are kept, or
+      //! deallocates it.
+      void put(Alloc& alloc, link_ptr link)
+      {
+        if (_recycle) { give(link); }
+        else { alloc.deallocate(link, 1); }
+      }
+
+      /**
+       *  Allocates nodes until \c n nodes are in the free list, makes room
+       *  for \c capacity pointers in the buffer, and keeps erased nodes from
+       *  then on.
+       */
+      void reserve(Alloc& alloc, std::size_t n, std::size_t capacity)
+      {
+        _store.reserve(capacity); // may throw
+        _recycle = true;
+        while (_spares < n) { give(alloc.allocate(1)); } // may throw
+      }
+
+      //! Deallocates the nodes of the free list and the buffer, and
+      //! deallocates erased nodes from then on.
+      void release(Alloc& alloc)
+      {
+        while (_spare != 0) { alloc.deallocate(take(), 1); }
+        ptr_store(_store.get_allocator()).swap(_store);
+        _recycle = false;
+      }
+
+      /**
+       *  Returns the buffer of the reserve, emptied, if nodes are recycled,
+       *  or \c local otherwise, so that a tree without reserve does not keep
+       *  a buffer the size of the tree after rebuilding it.
+       */
+      ptr_store& store(ptr_store& local)
+      {
+        if (!_recycle) return local;
+        _store.clear();
+        return _store;
+      }
+
+      //! Returns the allocator of the buffer.
+      ptr_allocator get_allocator() const { return _store.get_allocator(); }
+
+      void swap(Node_reserve& other)
+      {
+        std::swap(_spare, other._spare);
+        std::swap(_spares, other._spares);
+        std::swap(_recycle, other._recycle);
+        _store.swap(other._store);
+      }
+
+    private:
+      //! Returns a node of the free list, or 0 if the list is empty.
+      link_ptr take()
+      {
+        if (_spare == 0) return 0;
+        link_ptr link = _spare;
+        _spare = static_cast<link_ptr>(link->parent);
+        --_spares;
+        return link;
+      }
+
+      //! Puts \c link, which is not constructed, in the free list.
+      void give(link_ptr link)
+      {
+        link->parent = _spare;
+        _spare = link;
+        ++_spares;
+      }
+
+      link_ptr _spare;
+      std::size_t _spares;
+      bool _recycle;
+      ptr_store _store;
+    };
+  } // namespace details
+} // namespace spatial
+
+#endif // SPATIAL_NODE_RESERVE_HPP
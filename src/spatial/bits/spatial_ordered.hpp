@@ -15,6 +15,7 @@
 
 #include <utility> // provides ::std::pair<>
 #include "spatial_bidirectional.hpp"
+#include "spatial_rank.hpp"
 #include "spatial_import_tuple.hpp"
 
 namespace spatial
@@ -58,22 +59,23 @@ namespace spatial
      */
     ordered_iterator(Container& container,
                      typename Container::iterator iter)
-      : Base(container.rank(), iter.node, depth(iter.node)),
+      : Base(container.rank(), iter.node,
+             modulo(iter.node, container.rank())),
         _cmp(container.key_comp())
     { }
 
     /**
      *  This constructor builds an ordered iterator from a container's node
-     *  and its related depth.
+     *  and its related dimension.
      *
      *  \param container The container to iterate.
-     *  \param depth     The depth of the node pointed to by iterator.
+     *  \param dim       The dimension of the node pointed to by iterator.
      *  \param ptr       Use the value of node as the start point for the
      *                   iteration.
      */
-    ordered_iterator(Container& container, dimension_type depth,
+    ordered_iterator(Container& container, dimension_type dim,
                      typename Container::mode_type::node_ptr ptr)
-      : Base(container.rank(), ptr, depth), _cmp(container.key_comp())
+      : Base(container.rank(), ptr, dim), _cmp(container.key_comp())
     { }
 
     //! Increments the iterator and returns the incremented value. Prefer to
@@ -161,28 +163,30 @@ namespace spatial
      */
     ordered_iterator(const Container& container,
                      typename Container::const_iterator iter)
-      : Base(container.rank(), iter.node, depth(iter.node)),
+      : Base(container.rank(), iter.node,
+             modulo(iter.node, container.rank())),
         _cmp(container.key_comp())
     { }
 
     /**
      *  This constructor builds an ordered iterator from a container's node
-     *  and its related depth.
+     *  and its related dimension.
      *
      *  \param container The container to iterate.
-     *  \param depth     The depth of the node pointed to by iterator.
+     *  \param dim       The dimension of the node pointed to by iterator.
      *  \param ptr       Use the value of node as the start point for the
      *                   iteration.
      */
     ordered_iterator
-    (const Container& container, dimension_type depth,
+    (const Container& container, dimension_type dim,
      typename Container::mode_type::const_node_ptr ptr)
-      : Base(container.rank(), ptr, depth), _cmp(container.key_comp())
+      : Base(container.rank(), ptr, dim), _cmp(container.key_comp())
     { }
 
     //! Convertion of mutable iterator into a constant iterator is permitted.
     ordered_iterator(const ordered_iterator<Container>& iter)
-      : Base(iter.rank(), iter.node, iter.node_dim), _cmp(iter.key_comp())
+      : Base(iter.rank(), iter.node, iter.node_dim, iter),
+        _cmp(iter.key_comp())
     { }
 
     //! Increments the iterator and returns the incremented value. Prefer to
@@ -324,7 +328,7 @@ namespace spatial
      *
      *  \tparam Container The type of container to iterate.
      *  \param node The node pointed to by the iterator
-     *  \param dth  The depth of the node pointed to by the iterator.
+     *  \param dth  The dimension of the node pointed to by the iterator.
      *  \param rank The rank of the container which node belongs to.
      *  \param cmp  The comparator used by the container which node belongs to.
      *  \return A pair of node, dimension pointing to the minimum element in
@@ -346,7 +350,7 @@ namespace spatial
       SPATIAL_ASSERT_CHECK(node != 0);
       NodePtr end = node->parent;
       while (node->left != 0)
-        { node = node->left; ++dth; }
+        { node = node->left; dth = incr_dim(rank, dth); }
       NodePtr best = node;
       dimension_type best_dth = dth;
       // Similarly to mapping iterator, scans all nodes and prune whichever is
@@ -356,21 +360,21 @@ namespace spatial
       for(;;)
         {
           if (node->right != 0
-              && ((dth % rank()) > 0
+              && (dth > 0
                   || !cmp(0, const_key(best), const_key(node))))
             {
-              node = node->right; ++dth;
+              node = node->right; dth = incr_dim(rank, dth);
               while (node->left != 0)
-                { node = node->left; ++dth; }
+                { node = node->left; dth = incr_dim(rank, dth); }
             }
           else
             {
               NodePtr prev_node = node;
-              node = node->parent; --dth;
+              node = node->parent; dth = decr_dim(rank, dth);
               while (node != end && prev_node == node->right)
                 {
                   prev_node = node;
-                  node = node->parent; --dth;
+                  node = node->parent; dth = decr_dim(rank, dth);
                 }
               if (node == end) break;
             }
@@ -388,7 +392,7 @@ namespace spatial
      *
      *  \tparam Container The type of container to iterate.
      *  \param node The node pointed to by the iterator
-     *  \param dth  The depth of the node pointed to by the iterator.
+     *  \param dth  The dimension of the node pointed to by the iterator.
      *  \param rank The rank of the container which node belongs to.
      *  \param cmp  The comparator used by the container which node belongs to.
      *  \return A pair of node, dimension pointing to the maximum element in
@@ -410,28 +414,28 @@ namespace spatial
       SPATIAL_ASSERT_CHECK(node != 0);
       NodePtr end = node->parent;
       while (node->right != 0)
-        { node = node->right; ++dth; }
+        { node = node->right; dth = incr_dim(rank, dth); }
       NodePtr best = node;
       dimension_type best_dth = dth;
       for (;;)
         {
           if (node->left != 0
-              && ((dth % rank()) > 0
+              && (dth > 0
                   || !cmp(0, const_key(node), const_key(best))))
             {
-              node = node->left; ++dth;
+              node = node->left; dth = incr_dim(rank, dth);
               while (node->right != 0)
-                { node = node->right; ++dth; }
+                { node = node->right; dth = incr_dim(rank, dth); }
             }
           else
             {
               NodePtr prev_node = node;
-              node = node->parent; --dth;
+              node = node->parent; dth = decr_dim(rank, dth);
               while (node != end
                      && prev_node == node->left)
                 {
                   prev_node = node;
-                  node = node->parent; --dth;
+                  node = node->parent; dth = decr_dim(rank, dth);
                 }
               if (node == end) break;
             }
@@ -449,7 +453,7 @@ namespace spatial
      *
      *  \tparam Container The type of container to iterate.
      *  \param node The node pointed to by the iterator
-     *  \param dth  The depth of the node pointed to by the iterator.
+     *  \param dth  The dimension of the node pointed to by the iterator.
      *  \param rank The rank of the container which node belongs to.
      *  \param cmp  The comparator used by the container which node belongs to.
      *  \return A pair of node, dimension pointing to the next element in the
@@ -478,23 +482,23 @@ namespace spatial
       for (;;)
         {
           if (node->right != 0
-              && ((dth % rank()) > 0 || best == 0
+              && (dth > 0 || best == 0
                   || !cmp(0, const_key(best), const_key(node))))
             {
-              node = node->right; ++dth;
+              node = node->right; dth = incr_dim(rank, dth);
               while (node->left != 0
-                     && ((dth % rank()) > 0
+                     && (dth > 0
                          || !cmp(0, const_key(node), const_key(orig))))
-                { node = node->left; ++dth; }
+                { node = node->left; dth = incr_dim(rank, dth); }
             }
           else
             {
               NodePtr prev_node = node;
-              node = node->parent; --dth;
+              node = node->parent; dth = decr_dim(rank, dth);
               while (!header(node) && prev_node == node->right)
                 {
                   prev_node = node;
-                  node = node->parent; --dth;
+                  node = node->parent; dth = decr_dim(rank, dth);
                 }
               if (header(node)) break;
             }
@@ -514,23 +518,23 @@ namespace spatial
       for (;;)
         {
           if (node->left != 0
-              && (dth % rank() > 0
+              && (dth > 0
                   || !cmp(0, const_key(node), const_key(orig))))
             {
-              node = node->left; ++dth;
+              node = node->left; dth = incr_dim(rank, dth);
               while (node->right != 0
-                     && (dth % rank() > 0 || best == 0
+                     && (dth > 0 || best == 0
                          || !cmp(0, const_key(best), const_key(node))))
-                { node = node->right; ++dth; }
+                { node = node->right; dth = incr_dim(rank, dth); }
             }
           else
             {
               NodePtr prev_node = node;
-              node = node->parent; --dth;
+              node = node->parent; dth = decr_dim(rank, dth);
               while (!header(node) && prev_node == node->left)
                 {
                   prev_node = node;
-                  node = node->parent; --dth;
+                  node = node->parent; dth = decr_dim(rank, dth);
                 }
               if (header(node)) break;
             }
@@ -552,7 +556,7 @@ namespace spatial
      *
      *  \tparam Container The type of container to iterate.
      *  \param node The node pointed to by the iterator
-     *  \param dth  The depth of the node pointed to by the iterator.
+     *  \param dth  The dimension of the node pointed to by the iterator.
      *  \param rank The rank of the container which node belongs to.
      *  \param cmp  The comparator used by the container which node belongs to.
      *  \return A pair of node, dimension pointing to the previous element in
@@ -582,23 +586,23 @@ namespace spatial
       for (;;)
         {
           if (node->left != 0
-              && ((dth % rank()) > 0 || best == 0
+              && (dth > 0 || best == 0
                   || !cmp(0, const_key(node), const_key(best))))
             {
-              node = node->left; ++dth;
+              node = node->left; dth = incr_dim(rank, dth);
               while (node->right != 0
-                     && ((dth % rank()) > 0
+                     && (dth > 0
                          || !cmp(0, const_key(orig), const_key(node))))
-                { node = node->right; ++dth; }
+                { node = node->right; dth = incr_dim(rank, dth); }
             }
           else
             {
               NodePtr prev_node = node;
-              node = node->parent; --dth;
+              node = node->parent; dth = decr_dim(rank, dth);
               while (!header(node) && prev_node == node->left)
                 {
                   prev_node = node;
-                  node = node->parent; --dth;
+                  node = node->parent; dth = decr_dim(rank, dth);
                 }
               if (header(node)) break;
             }
@@ -618,23 +622,23 @@ namespace spatial
       for (;;)
         {
           if (node->right != 0
-              && ((dth % rank()) > 0
+              && (dth > 0
                   || !cmp(0, const_key(orig), const_key(node))))
             {
-              node = node->right; ++dth;
+              node = node->right; dth = incr_dim(rank, dth);
               while (node->left != 0
-                     && ((dth % rank()) > 0 || best == 0
+                     && (dth > 0 || best == 0
                          || !cmp(0, const_key(node), const_key(best))))
-                { node = node->left; ++dth; }
+                { node = node->left; dth = incr_dim(rank, dth); }
             }
           else
             {
               NodePtr prev_node = node;
-              node = node->parent; --dth;
+              node = node->parent; dth = decr_dim(rank, dth);
               while (!header(node) && prev_node == node->right)
                 {
                   prev_node = node;
-                  node = node->parent; --dth;
+                  node = node->parent; dth = decr_dim(rank, dth);
                 }
               if (header(node)) break;
             }
@@ -650,6 +654,67 @@ namespace spatial
       return std::make_pair(node, dth);
     }
 
+    /**
+     *  \name Dispatch of \dynamic_rank
+     *
+     *  Overloads of the ordered traversals for \dynamic_rank. If the rank of
+     *  the container is listed in \ref SPATIAL_DISPATCH_RANKS, the traversal
+     *  is carried out with the equivalent \static_rank.
+     */
+    ///@{
+    template <typename NodePtr, typename KeyCompare>
+    inline std::pair<NodePtr, dimension_type>
+    first_ordered(NodePtr node, dimension_type dth, Dynamic_rank rank,
+                  const KeyCompare& cmp)
+    {
+#     define SPATIAL_RANK_DISPATCH_CALL(r) first_ordered(node, dth, r, cmp)
+      SPATIAL_RANK_DISPATCH(rank)
+#     undef SPATIAL_RANK_DISPATCH_CALL
+      return first_ordered<NodePtr, Dynamic_rank, KeyCompare>
+        (node, dth, rank, cmp);
+    }
+
+    template <typename NodePtr, typename KeyCompare>
+    inline std::pair<NodePtr, dimension_type>
+    last_ordered(NodePtr node, dimension_type dth, Dynamic_rank rank,
+                 const KeyCompare& cmp)
+    {
+#     define SPATIAL_RANK_DISPATCH_CALL(r) last_ordered(node, dth, r, cmp)
+      SPATIAL_RANK_DISPATCH(rank)
+#     undef SPATIAL_RANK_DISPATCH_CALL
+      return last_ordered<NodePtr, Dynamic_rank, KeyCompare>
+        (node, dth, rank, cmp);
+    }
+
+    template <typename NodePtr, typename KeyCompare>
+    inline std::pair<NodePtr, dimension_type>
+    increment_ordered
+    (NodePtr node, dimension_type dth, Dynamic_rank rank,
+     const KeyCompare& cmp)
+    {
+#     define SPATIAL_RANK_DISPATCH_CALL(r) \
+        increment_ordered(node, dth, r, cmp)
+      SPATIAL_RANK_DISPATCH(rank)
+#     undef SPATIAL_RANK_DISPATCH_CALL
+      return increment_ordered<NodePtr, Dynamic_rank, KeyCompare>
+        (node, dth, rank, cmp);
+    }
+
+    template <typename NodePtr, typename KeyCompare>
+    inline std::pair<NodePtr, dimension_type>
+    decrement_ordered
+    (NodePtr node, dimension_type dth, Dynamic_rank rank,
+     const KeyCompare& cmp)
+    {
+#     define SPATIAL_RANK_DISPATCH_CALL(r) \
+        decrement_ordered(node, dth, r, cmp)
+      SPATIAL_RANK_DISPATCH(rank)
+#     undef SPATIAL_RANK_DISPATCH_CALL
+      return decrement_ordered<NodePtr, Dynamic_rank, KeyCompare>
+        (node, dth, rank, cmp);
+    }
+    ///@}
+
   } // namespace details
 } // namespace spatial
 
@@ -0,0 +1,75 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   spatial_prefetch.hpp
+ *  Provides the functions that request the nodes of the tree to be loaded in
+ *  cache ahead of their use during a descent.
+ *
+ *  The prefetching is disabled by default. It is enabled by defining
+ *  SPATIAL_ENABLE_PREFETCH before including any of the library headers, and
+ *  pays off mostly with trees that are too large to fit in cache, where the
+ *  load of each child would otherwise stall the descent once the comparison
+ *  that selects it is known. With smaller trees, the additional instructions
+ *  may cost more than they save.
+ */
+
+#ifndef SPATIAL_PREFETCH_HPP
+#define SPATIAL_PREFETCH_HPP
+
+#ifdef SPATIAL_ENABLE_PREFETCH
+#  if defined(_MSC_VER) && !defined(__clang__)
+#    include <xmmintrin.h> // _mm_prefetch
+#  endif
+#endif
+
+#include "spatial_node.hpp"
+
+namespace spatial
+{
+  namespace details
+  {
+    /**
+     *  Requests the memory pointed to by \c ptr to be loaded in cache, if
+     *  SPATIAL_ENABLE_PREFETCH is defined and the compiler provides a way to
+     *  do so. Otherwise does nothing. \c ptr may be null.
+     */
+    inline void
+    prefetch(const void* ptr)
+    {
+#ifdef SPATIAL_ENABLE_PREFETCH
+#  if defined(__GNUC__) || defined(__clang__)
+      __builtin_prefetch(ptr);
+#  elif defined(_MSC_VER)
+      _mm_prefetch(static_cast<const char*>(ptr), _MM_HINT_T0);
+#  else
+      static_cast<void>(ptr);
+#  endif
+#else
+      static_cast<void>(ptr);
+#endif
+    }
+
+    /**
+     *  Requests both children of \c node to be loaded in cache, before the
+     *  descent decides which one to follow.
+     *
+     *  \tparam Link A model of \linkmode.
+     *  \param node A pointer to a node that is not the header.
+     */
+    template <typename Link>
+    inline void
+    prefetch_children(const Node<Link>* node)
+    {
+      SPATIAL_ASSERT_CHECK(node != 0);
+      prefetch(node->left);
+      prefetch(node->right);
+    }
+  } // namespace details
+} // namespace spatial
+
+#endif // SPATIAL_PREFETCH_HPP
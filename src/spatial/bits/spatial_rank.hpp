@@ -16,6 +16,51 @@
 
 #include "spatial_node.hpp" // for modulo()
 
+/**
+ *  \def SPATIAL_DISPATCH_RANKS(CASE)
+ *  Lists the ranks for which the traversals of a container using \dynamic_rank
+ *  are carried out by the same algorithms instantiated with \static_rank.
+ *  When the rank of such a container is in the list, the loops over its
+ *  dimensions have a fixed length and the computation of the next dimension
+ *  no longer requires a division, which lets the compiler unroll and inline
+ *  them, including in the metrics. Other ranks use the generic algorithms.
+ *
+ *  The list is empty unless \c SPATIAL_ENABLE_RANK_DISPATCH is defined, in
+ *  which case it holds the ranks 2, 3, 4 and 6. Every rank in the list is
+ *  instantiated for each traversal of each container using \dynamic_rank, so
+ *  the list should be limited to the ranks that the keys of these containers
+ *  can hold. It may be defined before including any of the library headers,
+ *  for example to dispatch only rank 3:
+ *  \code
+ *  #define SPATIAL_DISPATCH_RANKS(CASE) CASE(3)
+ *  \endcode
+ */
+#ifndef SPATIAL_DISPATCH_RANKS
+#  ifdef SPATIAL_ENABLE_RANK_DISPATCH
+#    define SPATIAL_DISPATCH_RANKS(CASE) CASE(2) CASE(3) CASE(4) CASE(6)
+#  else
+#    define SPATIAL_DISPATCH_RANKS(CASE)
+#  endif
+#endif
+
+/**
+ *  \def SPATIAL_RANK_DISPATCH(rank)
+ *  Within a function that takes a \dynamic_rank, returns the value of \c
+ *  SPATIAL_RANK_DISPATCH_CALL(r), where \c r is the \static_rank equal to \c
+ *  rank, if this rank is listed in \ref SPATIAL_DISPATCH_RANKS. Otherwise,
+ *  does nothing. \c SPATIAL_RANK_DISPATCH_CALL must be defined by the caller.
+ */
+#define SPATIAL_RANK_DISPATCH_CASE(N)                                 \
+  case N:                                                             \
+    return SPATIAL_RANK_DISPATCH_CALL                                 \
+      (::spatial::details::Static_rank<N>());
+#define SPATIAL_RANK_DISPATCH(rank)                                   \
+  switch ((rank)())                                                   \
+    {                                                                 \
+      SPATIAL_DISPATCH_RANKS(SPATIAL_RANK_DISPATCH_CASE)              \
+    default: break;                                                   \
+    }
+
 namespace spatial
 {
   namespace details
@@ -59,25 +104,40 @@ namespace spatial
 
     /**
      *  Increment dimension \c node_dim, given \c rank.
+     *
+     *  The dimension wraps around to 0 after <tt>rank() - 1</tt> without a
+     *  division: the selection is usually compiled into a conditional move,
+     *  which is the reason why traversals carry the dimension of the current
+     *  node rather than its depth.
+     *
      *  \tparam Rank Either \static_rank or \dynamic_rank.
      *  \param rank The magnitude of the rank.
-     *  \param node_dim The value of the dimension for the node.
+     *  \param node_dim The value of the dimension for the node, which must be
+     *  lower than \c rank().
      */
     template<typename Rank>
     inline dimension_type
     incr_dim(Rank rank, dimension_type node_dim)
-    { return (node_dim + 1) % rank(); }
+    {
+      dimension_type next = node_dim + 1;
+      return next == rank() ? 0 : next;
+    }
 
     /**
      *  Decrement dimension \c node_dim, given \c rank.
+     *
+     *  The dimension wraps around to <tt>rank() - 1</tt> after 0 without a
+     *  division.
+     *
      *  \tparam Rank Either \static_rank or \dynamic_rank.
      *  \param rank The magnitude of the rank.
-     *  \param node_dim The value of the dimension for the node.
+     *  \param node_dim The value of the dimension for the node, which must be
+     *  lower than \c rank().
      */
     template<typename Rank>
     inline dimension_type
     decr_dim(Rank rank, dimension_type node_dim)
-    { return (rank() + node_dim - 1) % rank(); }
+    { return (node_dim == 0 ? rank() : node_dim) - 1; }
 
     /**
      *  Returns the modulo of a node's heigth by a container's rank. This, in
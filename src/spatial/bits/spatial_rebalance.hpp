@@ -0,0 +1,226 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   spatial_rebalance.hpp
+ *  Provides \ref spatial::observed_balancing, a balancing policy that reports
+ *  each rebalancing of a \ref spatial::details::Relaxed_kdtree to an
+ *  observer, and \ref spatial::rebalance_counters, the observer that
+ *  aggregates these reports.
+ *
+ *  A node is rebalanced by erasing it from its subtree and inserting it
+ *  back, which may in turn rebalance other nodes of the subtree. The cost of
+ *  an insertion or an erasure in the tree depends on these rebalancing, and
+ *  the reports measure them for each of the balancing policies:
+ *
+ *  \code
+ *    typedef observed_balancing<loose_balancing> balancing;
+ *    point_multiset<3, point, bracket_less<point>, balancing> points;
+ *    // ... insert and erase points
+ *    rebalance_counters counters = points.balancing().observer();
+ *    // counters.events, counters.max_elapsed, ...
+ *  \endcode
+ *
+ *  The other balancing policies report nothing and cost nothing more.
+ */
+
+#ifndef SPATIAL_REBALANCE_HPP
+#define SPATIAL_REBALANCE_HPP
+
+#include <cstddef> // std::size_t
+#include <chrono>
+#include "spatial_node.hpp"
+
+namespace spatial
+{
+  /**
+   *  The report of one rebalancing of a node in a \ref
+   *  spatial::details::Relaxed_kdtree.
+   */
+  struct rebalance_event
+  {
+    //! The depth of the node that is rebalanced, the root being at depth 0.
+    std::size_t depth;
+    //! The weight of the subtree of the node that is rebalanced.
+    weight_type weight;
+    //! The number of the rebalancing that were already in progress when this
+    //! one started, since rebalancing a node may rebalance others below it.
+    std::size_t nesting;
+    //! The number of nodes erased from a subtree during the rebalancing,
+    //! including the ones of the nested rebalancing.
+    std::size_t erase_nodes;
+    //! The number of nodes inserted in a subtree during the rebalancing,
+    //! including the ones of the nested rebalancing.
+    std::size_t insert_nodes;
+    //! The time spent in the rebalancing, including the nested ones.
+    std::chrono::steady_clock::duration elapsed;
+  };
+
+  /**
+   *  An observer for \ref spatial::observed_balancing that aggregates all
+   *  the rebalancing reported to it.
+   *
+   *  Since the nested rebalancing are included in the one that contains
+   *  them, \c erase_nodes, \c insert_nodes and \c elapsed only sum the
+   *  rebalancing that were not nested.
+   */
+  struct rebalance_counters
+  {
+    rebalance_counters()
+      : events(0), nested_events(0), erase_nodes(0), insert_nodes(0),
+        total_weight(0), max_weight(0), max_depth(0), max_nesting(0),
+        elapsed(std::chrono::steady_clock::duration::zero()),
+        max_elapsed(std::chrono::steady_clock::duration::zero()) { }
+
+    //! Adds \c event to the counters.
+    void operator()(const rebalance_event& event)
+    {
+      ++events;
+      total_weight += event.weight;
+      if (max_weight < event.weight) max_weight = event.weight;
+      if (max_depth < event.depth) max_depth = event.depth;
+      if (max_nesting < event.nesting) max_nesting = event.nesting;
+      if (max_elapsed < event.elapsed) max_elapsed = event.elapsed;
+      if (event.nesting != 0) { ++nested_events; return; }
+      erase_nodes += event.erase_nodes;
+      insert_nodes += event.insert_nodes;
+      elapsed += event.elapsed;
+    }
+
+    //! Sets all the counters to zero.
+    void clear() { *this = rebalance_counters(); }
+
+    //! The number of rebalancing, nested or not.
+    std::size_t events;
+    //! The number of rebalancing that were nested in another.
+    std::size_t nested_events;
+    //! The number of nodes erased from a subtree by the rebalancing.
+    std::size_t erase_nodes;
+    //! The number of nodes inserted in a subtree by the rebalancing.
+    std::size_t insert_nodes;
+    //! The sum of the weights of the rebalanced subtrees.
+    std::size_t total_weight;
+    //! The weight of the largest rebalanced subtree.
+    weight_type max_weight;
+    //! The depth of the deepest rebalanced node.
+    std::size_t max_depth;
+    //! The deepest nesting of a rebalancing.
+    std::size_t max_nesting;
+    //! The time spent rebalancing.
+    std::chrono::steady_clock::duration elapsed;
+    //! The time spent in the longest rebalancing.
+    std::chrono::steady_clock::duration max_elapsed;
+  };
+
+  template <typename Balancing, typename Observer>
+  class observed_balancing;
+
+  namespace details
+  {
+    /**
+     *  Measures a rebalancing in a \ref spatial::details::Relaxed_kdtree and
+     *  reports it to the policy when it is destroyed. For policies other
+     *  than \ref spatial::observed_balancing, it does nothing.
+     */
+    template <typename Balancing>
+    struct Rebalance_probe
+    {
+      template <typename NodePtr>
+      Rebalance_probe(Balancing&, NodePtr, weight_type) { }
+
+      //! Counts a node erased from a subtree.
+      static void count_erase(Balancing&) { }
+
+      //! Counts a node inserted in a subtree.
+      static void count_insert(Balancing&) { }
+    };
+
+    template <typename Balancing, typename Observer>
+    struct Rebalance_probe<observed_balancing<Balancing, Observer> >
+    {
+      typedef observed_balancing<Balancing, Observer> policy_type;
+
+      template <typename NodePtr>
+      Rebalance_probe(policy_type& policy, NodePtr node, weight_type weight)
+        : _policy(policy)
+      {
+        _event.depth = 0;
+        for (NodePtr p = node->parent; !header(p); p = p->parent)
+          { ++_event.depth; }
+        _event.weight = weight;
+        _event.nesting = policy._nesting++;
+        _event.erase_nodes = policy._erase_nodes;
+        _event.insert_nodes = policy._insert_nodes;
+        _start = std::chrono::steady_clock::now();
+      }
+
+      ~Rebalance_probe()
+      {
+        _event.elapsed = std::chrono::steady_clock::now() - _start;
+        _event.erase_nodes = _policy._erase_nodes - _event.erase_nodes;
+        _event.insert_nodes = _policy._insert_nodes - _event.insert_nodes;
+        --_policy._nesting;
+        _policy._observer(_event);
+      }
+
+      static void count_erase(policy_type& policy)
+      { ++policy._erase_nodes; }
+
+      static void count_insert(policy_type& policy)
+      { ++policy._insert_nodes; }
+
+    private:
+      Rebalance_probe(const Rebalance_probe&);
+      Rebalance_probe& operator=(const Rebalance_probe&);
+
+      policy_type& _policy;
+      rebalance_event _event;
+      std::chrono::steady_clock::time_point _start;
+    };
+  } // namespace details
+
+  /**
+   *  A balancing policy that decides like \c Balancing when to rebalance a
+   *  node, and reports each rebalancing to an \c Observer as a \ref
+   *  spatial::rebalance_event.
+   *
+   *  \tparam Balancing The policy that decides when to rebalance, such as
+   *  \ref loose_balancing, \ref tight_balancing or \ref perfect_balancing.
+   *  \tparam Observer A function object called with each \ref
+   *  spatial::rebalance_event, after the end of the rebalancing. It is
+   *  copied with the policy, and thus with the container.
+   */
+  template <typename Balancing, typename Observer = rebalance_counters>
+  class observed_balancing : public Balancing
+  {
+  public:
+    observed_balancing()
+      : Balancing(), _observer(), _erase_nodes(0), _insert_nodes(0),
+        _nesting(0) { }
+
+    explicit observed_balancing(const Observer& observer,
+                                const Balancing& balancing = Balancing())
+      : Balancing(balancing), _observer(observer), _erase_nodes(0),
+        _insert_nodes(0), _nesting(0) { }
+
+    //! Returns the observer of the rebalancing.
+    const Observer& observer() const { return _observer; }
+
+    //! Returns the observer of the rebalancing.
+    Observer& observer() { return _observer; }
+
+  private:
+    template <typename> friend struct details::Rebalance_probe;
+
+    Observer _observer;
+    std::size_t _erase_nodes;
+    std::size_t _insert_nodes;
+    std::size_t _nesting;
+  };
+} // namespace spatial
+
+#endif // SPATIAL_REBALANCE_HPP
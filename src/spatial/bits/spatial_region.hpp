@@ -17,8 +17,11 @@
 
 #include <utility> // std::pair<> and std::make_pair()
 #include "spatial_bidirectional.hpp"
+#include "spatial_rank.hpp"
+#include "spatial_prefetch.hpp"
 #include "spatial_except.hpp"
 #include "spatial_import_tuple.hpp"
+#include "spatial_check_concept.hpp"
 
 namespace spatial
 {
@@ -74,6 +77,21 @@ namespace spatial
                  : above));
     }
 
+    /**
+     *  The same operator, for a \c key of another type than \c Key, when \c
+     *  Key is the type of a query given to a transparent \c Compare.
+     */
+    template <typename Other>
+    relative_order
+    operator()(dimension_type dim, dimension_type, const Other& key) const
+    {
+      return (Compare::operator()(dim, key, _lower)
+              ? below
+              : (Compare::operator()(dim, key, _upper)
+                 ? matching
+                 : above));
+    }
+
   private:
     /**
      *  The lower bound for the orthogonal region.
@@ -119,6 +137,27 @@ namespace spatial
       (container.key_comp(), lower, upper);
   }
 
+  /**
+   *  Overload of \ref make_bounds() for \c lower and \c upper of another
+   *  type than the key type of \c container, such as a \c std::array of
+   *  coordinates. It is available only if the comparator of \c container is
+   *  transparent, such as \ref bracket_less<void>, and the returned \ref
+   *  bounds stores \c lower and \c upper without converting them.
+   *
+   *  \throws invalid_bounds
+   */
+  template <typename Tp, typename Query>
+  typename enable_if_c
+  <details::is_transparent_query<typename Tp::key_compare, Query,
+                                 typename Tp::key_type>::value,
+   bounds<Query, typename Tp::key_compare> >::type
+  make_bounds(const Tp& container, const Query& lower, const Query& upper)
+  {
+    except::check_bounds(container, lower, upper);
+    return bounds<Query, typename Tp::key_compare>
+      (container.key_comp(), lower, upper);
+  }
+
   /**
    *  This type provides both an iterator and a constant iterator to iterate
    *  through all elements of a tree that match an orthogonal region defined by
@@ -170,7 +209,8 @@ namespace spatial
      */
     region_iterator(Container& container, const Predicate& pred,
                     typename Container::iterator iter)
-      : Base(container.rank(), iter.node, depth(iter.node)),
+      : Base(container.rank(), iter.node,
+             modulo(iter.node, container.rank())),
         _pred(pred) { }
 
     /**
@@ -199,6 +239,7 @@ namespace spatial
     //! use this form in \c for loops.
     region_iterator<Container, Predicate>& operator++()
     {
+      details::Stats_scope scope(*this);
       import::tie(node, node_dim)
         = increment_region(node, node_dim, rank(), _pred);
       return *this;
@@ -208,6 +249,7 @@ namespace spatial
     //! the increment. Prefer to use the other form in \c for loops.
     region_iterator<Container, Predicate> operator++(int)
     {
+      details::Stats_scope scope(*this);
       region_iterator<Container, Predicate> x(*this);
       import::tie(node, node_dim)
         = increment_region(node, node_dim, rank(), _pred);
@@ -218,6 +260,7 @@ namespace spatial
     //! use this form in \c for loops.
     region_iterator<Container, Predicate>& operator--()
     {
+      details::Stats_scope scope(*this);
       import::tie(node, node_dim)
         = decrement_region(node, node_dim, rank(), _pred);
       return *this;
@@ -227,6 +270,7 @@ namespace spatial
     //! the decrement. Prefer to use the other form in \c for loops.
     region_iterator<Container, Predicate> operator--(int)
     {
+      details::Stats_scope scope(*this);
       region_iterator<Container, Predicate> x(*this);
       import::tie(node, node_dim)
         = decrement_region(node, node_dim, rank(), _pred);
@@ -290,7 +334,8 @@ namespace spatial
      */
     region_iterator(const Container& container, const Predicate& pred,
                     typename Container::const_iterator iter)
-      : Base(container.rank(), iter.node, depth(iter.node)),
+      : Base(container.rank(), iter.node,
+             modulo(iter.node, container.rank())),
         _pred(pred) { }
 
     /**
@@ -318,12 +363,14 @@ namespace spatial
 
     //! Convertion of an iterator into a const_iterator is permitted.
     region_iterator(const region_iterator<Container, Predicate>& iter)
-      : Base(iter.rank(), iter.node, iter.node_dim), _pred(iter.predicate()) { }
+      : Base(iter.rank(), iter.node, iter.node_dim, iter),
+        _pred(iter.predicate()) { }
 
     //! Increments the iterator and returns the incremented value. Prefer to
     //! use this form in \c for loops.
     region_iterator<const Container, Predicate>& operator++()
     {
+      details::Stats_scope scope(*this);
       import::tie(node, node_dim)
         = increment_region(node, node_dim, rank(), _pred);
       return *this;
@@ -333,6 +380,7 @@ namespace spatial
     //! the increment. Prefer to use the other form in \c for loops.
     region_iterator<const Container, Predicate> operator++(int)
     {
+      details::Stats_scope scope(*this);
       region_iterator<const Container, Predicate> x(*this);
       import::tie(node, node_dim)
         = increment_region(node, node_dim, rank(), _pred);
@@ -343,6 +391,7 @@ namespace spatial
     //! use this form in \c for loops.
     region_iterator<const Container, Predicate>& operator--()
     {
+      details::Stats_scope scope(*this);
       import::tie(node, node_dim)
         = decrement_region(node, node_dim, rank(), _pred);
       return *this;
@@ -352,6 +401,7 @@ namespace spatial
     //! the decrement. Prefer to use the other form in \c for loops.
     region_iterator<const Container, Predicate> operator--(int)
     {
+      details::Stats_scope scope(*this);
       region_iterator<const Container, Predicate> x(*this);
       import::tie(node, node_dim)
         = decrement_region(node, node_dim, rank(), _pred);
@@ -399,12 +449,15 @@ namespace spatial
   region_begin(Container& container, const Predicate& pred)
   {
     if (container.empty()) return region_end(container, pred);
+    details::Stats_scope scope;
     typename region_iterator<Container>::node_ptr node
-      = container.end().node->parent;
+      = details::descend(container.end().node->parent);
     dimension_type kth;
     import::tie(node, kth)
       = first_region(node, 0, container.rank(), pred);
-    return region_iterator<Container, Predicate>(container, pred, kth, node);
+    region_iterator<Container, Predicate> iter(container, pred, kth, node);
+    scope.close(iter);
+    return iter;
   }
 
   template <typename Container, typename Predicate>
@@ -537,6 +590,34 @@ namespace spatial
 
   namespace details
   {
+    /**
+     *  Returns the position of the key of \c node relative to the region
+     *  delimited by \c pred along the dimension \c dim, counting the
+     *  evaluation of the predicate.
+     */
+    template <typename NodePtr, typename Rank, typename Predicate>
+    inline relative_order
+    test_region(NodePtr node, dimension_type dim, const Rank rank,
+                const Predicate& pred)
+    { return evaluated(pred(dim, rank(), const_key(node))); }
+
+    /**
+     *  Returns the position of the key of \c node relative to the region
+     *  delimited by \c pred along the dimension \c kth that divides \c node,
+     *  counting the children of \c node that are excluded from the region as
+     *  pruned subtrees.
+     */
+    template <typename NodePtr, typename Rank, typename Predicate>
+    inline relative_order
+    split_region(NodePtr node, dimension_type kth, const Rank rank,
+                 const Predicate& pred)
+    {
+      relative_order rel = test_region(node, kth, rank, pred);
+      if (node->left != 0) explore(rel != below);
+      if (node->right != 0) explore(rel != above);
+      return rel;
+    }
+
     /**
      *  In the children of the node pointed to by \c node, find the first
      *  matching node in the region delimited by \c Predicate, with pre-order
@@ -555,24 +636,24 @@ namespace spatial
                  const Predicate& pred)
     {
       NodePtr end = node->parent;
-      dimension_type end_kth = kth - 1;
+      dimension_type end_kth = decr_dim(rank, kth);
       SPATIAL_ASSERT_CHECK(!header(node));
       SPATIAL_ASSERT_CHECK(node != 0);
       for (;;)
         {
-          dimension_type dim = kth % rank();
-          relative_order rel = pred(dim, rank(), const_key(node));
+          prefetch_children(node);
+          relative_order rel = split_region(node, kth, rank, pred);
           if (rel == matching)
             {
               dimension_type test = 0;
-              for (; test < dim
-                     && pred(test, rank(), const_key(node)) == matching;
+              for (; test < kth
+                     && test_region(node, test, rank, pred) == matching;
                    ++test);
-              if (test == dim)
+              if (test == kth)
                 {
-                  test = dim + 1;
+                  test = kth + 1;
                   for (; test < rank()
-                         && pred(test, rank(), const_key(node)) == matching;
+                         && test_region(node, test, rank, pred) == matching;
                        ++test);
                   if (test == rank())
                     { return std::make_pair(node, kth); }
@@ -580,20 +661,20 @@ namespace spatial
             }
           if (rel != above && node->right != 0)
             {
-              ++kth;
+              kth = incr_dim(rank, kth);
               if (rel != below && node->left != 0)
                 {
                   NodePtr other;
                   dimension_type other_kth;
                   import::tie(other, other_kth)
-                    = first_region(node->left, kth, rank, pred);
+                    = first_region(descend(node->left), kth, rank, pred);
                   if (other != node)
                     { return std::make_pair(other, other_kth); }
                 }
-              node = node->right;
+              node = descend(node->right);
             }
           else if (rel != below && node->left != 0)
-            { node = node->left; ++kth; }
+            { node = descend(node->left); kth = incr_dim(rank, kth); }
           else { return std::make_pair(end, end_kth); }
         }
     }
@@ -619,36 +700,36 @@ namespace spatial
       SPATIAL_ASSERT_CHECK(node != 0);
       for (;;)
         {
-          relative_order rel = pred(kth % rank(), rank(), const_key(node));
+          relative_order rel = split_region(node, kth, rank, pred);
           if (rel != above && node->right != 0)
-            { node = node->right; ++kth; }
+            { node = descend(node->right); kth = incr_dim(rank, kth); }
           else if (rel != below && node->left != 0)
-            { node = node->left; ++kth; }
+            { node = descend(node->left); kth = incr_dim(rank, kth); }
           else break;
         }
       for (;;)
         {
           dimension_type test = 0;
           for(; test < rank()
-                && pred(test, rank(), const_key(node)) == matching; ++test);
+                && test_region(node, test, rank, pred) == matching; ++test);
           if (test == rank())
             { return std::make_pair(node, kth); }
           NodePtr prev_node = node;
-          node = node->parent; --kth;
+          node = climb(node); kth = decr_dim(rank, kth);
           if (header(node))
             { return std::make_pair(node, kth); }
           if (node->right == prev_node
-              && pred(kth % rank(), rank(), const_key(node)) != below
+              && test_region(node, kth, rank, pred) != below
               && node->left != 0)
             {
-              node = node->left; ++kth;
+              node = descend(node->left); kth = incr_dim(rank, kth);
               for (;;)
                 {
-                  relative_order rel = pred(kth % rank(), rank(), const_key(node));
+                  relative_order rel = split_region(node, kth, rank, pred);
                   if (rel != above && node->right != 0)
-                    { node = node->right; ++kth; }
+                    { node = descend(node->right); kth = incr_dim(rank, kth); }
                   else if (rel != below && node->left != 0)
-                    { node = node->left; ++kth; }
+                    { node = descend(node->left); kth = incr_dim(rank, kth); }
                   else break;
                 }
             }
@@ -675,31 +756,30 @@ namespace spatial
       SPATIAL_ASSERT_CHECK(node != 0);
       for (;;)
         {
-          relative_order rel = pred(kth % rank(), rank(), const_key(node));
+          relative_order rel = split_region(node, kth, rank, pred);
           if (rel != below && node->left != 0)
-            { node = node->left; ++kth; }
+            { node = descend(node->left); kth = incr_dim(rank, kth); }
           else if (rel != above && node->right != 0)
-            { node = node->right; ++kth; }
+            { node = descend(node->right); kth = incr_dim(rank, kth); }
           else
             {
               NodePtr prev_node = node;
-              node = node->parent; --kth;
+              node = climb(node); kth = decr_dim(rank, kth);
               while (!header(node)
                      && (prev_node == node->right
-                         || pred(kth % rank(), rank(),
-                                 const_key(node)) == above
+                         || test_region(node, kth, rank, pred) == above
                          || node->right == 0))
                 {
                   prev_node = node;
-                  node = node->parent; --kth;
+                  node = climb(node); kth = decr_dim(rank, kth);
                 }
               if (!header(node))
-                { node = node->right; ++kth; }
+                { node = descend(node->right); kth = incr_dim(rank, kth); }
               else { return std::make_pair(node, kth); }
             }
           dimension_type test = 0;
           for(; test < rank()
-                && pred(test, rank(), const_key(node)) == matching; ++test);
+                && test_region(node, test, rank, pred) == matching; ++test);
           if (test == rank())
             { return std::make_pair(node, kth); }
         }
@@ -722,37 +802,96 @@ namespace spatial
                      const Predicate& pred)
     {
       if (header(node))
-        { return last_region(node->parent, 0, rank, pred); }
+        { return last_region(descend(node->parent), 0, rank, pred); }
       SPATIAL_ASSERT_CHECK(node != 0);
       NodePtr prev_node = node;
-      node = node->parent; --kth;
+      node = climb(node); kth = decr_dim(rank, kth);
       while (!header(node))
         {
           if (node->right == prev_node
-              && pred(kth % rank(), rank(), const_key(node)) != below
+              && test_region(node, kth, rank, pred) != below
               && node->left != 0)
             {
-              node = node->left; ++kth;
+              node = descend(node->left); kth = incr_dim(rank, kth);
               for (;;)
                 {
-                  relative_order rel = pred(kth % rank(), rank(), const_key(node));
+                  relative_order rel = split_region(node, kth, rank, pred);
                   if (rel != above && node->right != 0)
-                    { node = node->right; ++kth; }
+                    { node = descend(node->right); kth = incr_dim(rank, kth); }
                   else if (rel != below && node->left != 0)
-                    { node = node->left; ++kth; }
+                    { node = descend(node->left); kth = incr_dim(rank, kth); }
                   else break;
                 }
             }
           dimension_type test = 0;
           for(; test < rank()
-                && pred(test, rank(), const_key(node)) == matching; ++test);
+                && test_region(node, test, rank, pred) == matching; ++test);
           if (test == rank()) break;
           prev_node = node;
-          node = node->parent; --kth;
+          node = climb(node); kth = decr_dim(rank, kth);
         }
       return std::make_pair(node, kth);
     }
 
+    /**
+     *  \name Dispatch of \dynamic_rank
+     *
+     *  The overloads below are preferred to the generic algorithms when the
+     *  container uses \dynamic_rank. If the rank of the container is listed
+     *  in \ref SPATIAL_DISPATCH_RANKS, they call the algorithm instantiated
+     *  with the equivalent \static_rank; otherwise they call the generic
+     *  algorithm.
+     */
+    ///@{
+    template <typename NodePtr, typename Predicate>
+    inline std::pair<NodePtr, dimension_type>
+    first_region(NodePtr node, dimension_type kth, Dynamic_rank rank,
+                 const Predicate& pred)
+    {
+#     define SPATIAL_RANK_DISPATCH_CALL(r) first_region(node, kth, r, pred)
+      SPATIAL_RANK_DISPATCH(rank)
+#     undef SPATIAL_RANK_DISPATCH_CALL
+      return first_region<NodePtr, Dynamic_rank, Predicate>
+        (node, kth, rank, pred);
+    }
+
+    template <typename NodePtr, typename Predicate>
+    inline std::pair<NodePtr, dimension_type>
+    last_region(NodePtr node, dimension_type kth, Dynamic_rank rank,
+                const Predicate& pred)
+    {
+#     define SPATIAL_RANK_DISPATCH_CALL(r) last_region(node, kth, r, pred)
+      SPATIAL_RANK_DISPATCH(rank)
+#     undef SPATIAL_RANK_DISPATCH_CALL
+      return last_region<NodePtr, Dynamic_rank, Predicate>
+        (node, kth, rank, pred);
+    }
+
+    template <typename NodePtr, typename Predicate>
+    inline std::pair<NodePtr, dimension_type>
+    increment_region(NodePtr node, dimension_type kth, Dynamic_rank rank,
+                     const Predicate& pred)
+    {
+#     define SPATIAL_RANK_DISPATCH_CALL(r) increment_region(node, kth, r, pred)
+      SPATIAL_RANK_DISPATCH(rank)
+#     undef SPATIAL_RANK_DISPATCH_CALL
+      return increment_region<NodePtr, Dynamic_rank, Predicate>
+        (node, kth, rank, pred);
+    }
+
+    template <typename NodePtr, typename Predicate>
+    inline std::pair<NodePtr, dimension_type>
+    decrement_region(NodePtr node, dimension_type kth, Dynamic_rank rank,
+                     const Predicate& pred)
+    {
+#     define SPATIAL_RANK_DISPATCH_CALL(r) decrement_region(node, kth, r, pred)
+      SPATIAL_RANK_DISPATCH(rank)
+#     undef SPATIAL_RANK_DISPATCH_CALL
+      return decrement_region<NodePtr, Dynamic_rank, Predicate>
+        (node, kth, rank, pred);
+    }
+    ///@}
+
   } // namespace details
 } // namespace spatial
 
@@ -29,6 +29,7 @@
 #ifndef SPATIAL_RELAXED_KDTREE_HPP
 #define SPATIAL_RELAXED_KDTREE_HPP
 
+#include <vector>
 #include <utility> // for std::pair
 #include <algorithm> // for std::min, std::max, std::equal,
                      // std::lexicographical_compare
@@ -37,11 +38,16 @@
 #include "spatial_mapping.hpp"
 #include "spatial_equal.hpp"
 #include "spatial_rank.hpp"
+#include "spatial_prefetch.hpp"
+#include "spatial_locality.hpp"
 #include "spatial_compress.hpp"
 #include "spatial_value_compare.hpp"
 #include "spatial_template_member_swap.hpp"
 #include "spatial_assert.hpp"
 #include "spatial_except.hpp"
+#include "spatial_check_concept.hpp"
+#include "spatial_node_reserve.hpp"
+#include "spatial_rebalance.hpp"
 
 namespace spatial
 {
@@ -136,8 +142,160 @@ namespace spatial
     }
   };
 
+  /**
+   *  A storage policy that holds each value in its node, next to the key and
+   *  the links. The default policy for storage.
+   */
+  struct inline_storage
+  {
+    //! The type of link that holds a value of type \c Value.
+    template <typename Key, typename Value>
+    struct link { typedef details::Relaxed_kdtree_link<Key, Value> type; };
+  };
+
+  /**
+   *  A storage policy that holds a copy of the key in the node and each value
+   *  in a separate allocation, through the allocator of the container.
+   *
+   *  In a \point_multimap or a \box_multimap with a large mapped type, this
+   *  policy keeps the nodes small, so that traversals, which only read the
+   *  keys, load fewer cache lines. The values are read only when an
+   *  iterator is dereferenced, at the cost of an extra indirection, and
+   *  their address remains the same for as long as they are in the
+   *  container. It is not useful when the mapped type is small, or in
+   *  containers where the key is the value.
+   */
+  struct cold_storage
+  {
+    //! The type of link that refers to a value of type \c Value.
+    template <typename Key, typename Value>
+    struct link
+    { typedef details::Relaxed_kdtree_cold_link<Key, Value> type; };
+  };
+
+  /**
+   *  A storage policy that holds, in each node, a copy of the coordinates of
+   *  the value read through \c Accessor when the value is inserted.
+   *
+   *  It is used by \ref cached_point_multiset, whose keys are these copies:
+   *  comparisons and metrics read the coordinates from the nodes and do not
+   *  call \c Accessor, which is useful when reading a coordinate is
+   *  expensive, e.g. through a virtual function.
+   *
+   *  \tparam Accessor A functor that returns the coordinate \c n of a value.
+   *  It is default constructed each time a value is inserted.
+   */
+  template <typename Accessor>
+  struct cached_storage
+  {
+    //! The type of link that holds a value of type \c Value and a copy of
+    //! its coordinates, of type \c Key.
+    template <typename Key, typename Value>
+    struct link
+    { typedef details::Relaxed_kdtree_cached_link<Key, Value> type; };
+
+    //! Copies the \c rank coordinates of \c value into \c key.
+    template <typename Key, typename Value>
+    void cache(dimension_type rank, Key& key, const Value& value) const
+    {
+      Accessor access;
+      for (dimension_type n = 0; n < rank; ++n)
+        { key[n] = access(n, value); }
+    }
+  };
+
   namespace details
   {
+    /**
+     *  Constructs the value of \c link with a copy of \c value, using \c
+     *  alloc, and destroys it. The key of links that hold their own key is
+     *  built from the \c rank coordinates of \c value, as read by \c
+     *  storage.
+     */
+    ///@{
+    template <typename Alloc, typename Key, typename Value, typename Storage>
+    inline void
+    construct_link_value(Alloc& alloc, Relaxed_kdtree_link<Key, Value>* link,
+                         const typename mutate<Value>::type& value,
+                         dimension_type, const Storage&)
+    {
+      std::allocator_traits<Alloc>::construct
+        (alloc, mutate_pointer(&link->value), value);
+    }
+
+    template <typename Alloc, typename Key, typename Value>
+    inline void
+    destroy_link_value(Alloc& alloc, Relaxed_kdtree_link<Key, Value>* link)
+    {
+      std::allocator_traits<Alloc>::destroy
+        (alloc, mutate_pointer(&link->value));
+    }
+
+    template <typename Alloc, typename Key, typename Value, typename Storage>
+    inline void
+    construct_link_value(Alloc& alloc,
+                         Relaxed_kdtree_cold_link<Key, Value>* link,
+                         const typename mutate<Value>::type& value,
+                         dimension_type, const Storage&)
+    {
+      typedef std::allocator_traits<Alloc> traits;
+      typename traits::pointer cold = traits::allocate(alloc, 1);
+      try
+        {
+          traits::construct(alloc, &*cold, value);
+          try
+            {
+              typename traits::template rebind_alloc
+                <typename mutate<Key>::type> key_alloc(alloc);
+              std::allocator_traits<typename traits::template rebind_alloc
+                                    <typename mutate<Key>::type> >
+                ::construct(key_alloc, mutate_pointer(&link->key),
+                            value.first);
+            }
+          catch (...) { traits::destroy(alloc, &*cold); throw; }
+        }
+      catch (...) { traits::deallocate(alloc, cold, 1); throw; }
+      link->value = &*cold;
+    }
+
+    template <typename Alloc, typename Key, typename Value>
+    inline void
+    destroy_link_value(Alloc& alloc, Relaxed_kdtree_cold_link<Key, Value>* link)
+    {
+      typedef std::allocator_traits<Alloc> traits;
+      typename traits::template rebind_alloc<typename mutate<Key>::type>
+        key_alloc(alloc);
+      std::allocator_traits<typename traits::template rebind_alloc
+                            <typename mutate<Key>::type> >
+        ::destroy(key_alloc, mutate_pointer(&link->key));
+      traits::destroy(alloc, mutate_pointer(link->value));
+      traits::deallocate(alloc, mutate_pointer(link->value), 1);
+    }
+
+    template <typename Alloc, typename Key, typename Value, typename Storage>
+    inline void
+    construct_link_value(Alloc& alloc,
+                         Relaxed_kdtree_cached_link<Key, Value>* link,
+                         const typename mutate<Value>::type& value,
+                         dimension_type rank, const Storage& storage)
+    {
+      // The coordinates are cached first, so that the value, once
+      // constructed, is never left behind by an exception.
+      storage.cache(rank, *mutate_pointer(&link->key), value);
+      std::allocator_traits<Alloc>::construct
+        (alloc, mutate_pointer(&link->value), value);
+    }
+
+    template <typename Alloc, typename Key, typename Value>
+    inline void
+    destroy_link_value(Alloc& alloc,
+                       Relaxed_kdtree_cached_link<Key, Value>* link)
+    {
+      std::allocator_traits<Alloc>::destroy
+        (alloc, mutate_pointer(&link->value));
+    }
+    ///@}
+
     /**
      *  Detailed implementation of the kd-tree. Used by point_set,
      *  point_multiset, point_map, point_multimap, box_set, box_multiset and
@@ -145,22 +303,24 @@ namespace spatial
      *  the templates.
      */
     template <typename Rank, typename Key, typename Value, typename Compare,
-              typename Balancing, typename Alloc>
+              typename Balancing, typename Alloc,
+              typename Storage = inline_storage>
     class Relaxed_kdtree
     {
       typedef Relaxed_kdtree<Rank, Key, Value, Compare, Balancing,
-                             Alloc>                   Self;
+                             Alloc, Storage>          Self;
 
     public:
       // Container intrincsic types
       typedef Rank                                    rank_type;
       typedef typename mutate<Key>::type              key_type;
       typedef typename mutate<Value>::type            value_type;
-      typedef Relaxed_kdtree_link<Key, Value>         mode_type;
+      typedef typename Storage::template link<Key, Value>::type mode_type;
       typedef Compare                                 key_compare;
       typedef ValueCompare<value_type, key_compare>   value_compare;
       typedef Alloc                                   allocator_type;
       typedef Balancing                               balancing_policy;
+      typedef Storage                                 storage_policy;
 
       // Container iterator related types
       typedef Value*                                  pointer;
@@ -179,7 +339,7 @@ namespace spatial
       typedef std::reverse_iterator<const_iterator>   const_reverse_iterator;
 
     private:
-      typedef typename std::allocator_traits<Alloc>::template rebind_alloc<Relaxed_kdtree_link<Key, Value>> Link_allocator;
+      typedef typename std::allocator_traits<Alloc>::template rebind_alloc<mode_type> Link_allocator;
       typedef typename std::allocator_traits<Alloc>::template rebind_alloc<value_type> Value_allocator;
 
       // The types used to deal with nodes
@@ -188,6 +348,10 @@ namespace spatial
       typedef typename mode_type::link_ptr            link_ptr;
       typedef typename mode_type::const_link_ptr      const_link_ptr;
 
+      // The nodes allocated in advance and the buffer to insert a range
+      typedef Node_reserve<mode_type, Link_allocator> Reserve;
+      typedef typename Reserve::ptr_store             Ptr_store;
+
     private:
       /**
        *  \brief The tree header.
@@ -202,11 +366,13 @@ namespace spatial
         Implementation(const rank_type& rank, const key_compare& compare,
                        const Balancing& balance, const Link_allocator& alloc)
           : Rank(rank), _compare(balance, compare),
-            _header(alloc, Node<mode_type>()) { initialize(); }
+            _header(alloc, Node<mode_type>()), _reserve(alloc)
+        { initialize(); }
 
         Implementation(const Implementation& impl)
           : Rank(impl), _compare(impl._compare.base(), impl._compare()),
-            _header(impl._header.base()) { initialize(); }
+            _header(impl._header.base()), _reserve(impl._header.base())
+        { initialize(); }
 
         void initialize()
         {
@@ -219,6 +385,7 @@ namespace spatial
         Compress<Balancing, key_compare> _compare;
         Compress<Link_allocator, Node<mode_type> > _header;
         node_ptr _leftmost;
+        Reserve _reserve;
       } _impl;
 
     private:
@@ -276,22 +443,23 @@ namespace spatial
       struct safe_allocator // RAII for exception-safe memory management
       {
         Link_allocator* alloc;
+        Reserve* reserve;
         link_ptr link;
-        safe_allocator(Link_allocator& a)
-          : alloc(&a), link(0)
-        { link = alloc->allocate(1); } // may throw
-        ~safe_allocator() { if (link) { alloc->deallocate(link, 1); } }
+        safe_allocator(Link_allocator& a, Reserve& r)
+          : alloc(&a), reserve(&r), link(0)
+        { link = reserve->get(*alloc); } // may throw
+        ~safe_allocator() { if (link) { reserve->put(*alloc, link); } }
         link_ptr release() { link_ptr p = link; link=0; return p; }
       };
 
       node_ptr
       create_node(const value_type& value)
       {
-        safe_allocator safe(get_link_allocator());
+        safe_allocator safe(get_link_allocator(), _impl._reserve);
         // the following may throw. But we have RAII on safe_allocator
         auto alloc = get_value_allocator();
-        std::allocator_traits<Value_allocator>::construct(alloc, mutate_pointer(&safe.link->value),
-                                        value);
+        construct_link_value(alloc, safe.link, value, dimension(),
+                             storage_policy());
         link_ptr node = safe.release();
         // leave parent uninitialized: its value will change during insertion.
         node->left = 0;
@@ -315,8 +483,8 @@ namespace spatial
       destroy_node(node_ptr node)
       {
         auto alloc = get_value_allocator();
-        std::allocator_traits<Value_allocator>::destroy(alloc, mutate_pointer(&value(node)));
-        get_link_allocator().deallocate(link(node), 1);
+        destroy_link_value(alloc, link(node));
+        _impl._reserve.put(get_link_allocator(), link(node));
       }
 
       /**
@@ -388,6 +556,30 @@ namespace spatial
        */
       node_ptr balance_node(dimension_type dim, node_ptr node);
 
+      /**
+       *  Insert a node that was just created in the tree.
+       */
+      iterator
+      insert_created(node_ptr target_node)
+      {
+        node_ptr node = get_root();
+        if (header(node))
+          {
+            // insert root node in empty tree
+            set_leftmost(target_node);
+            set_rightmost(target_node);
+            set_root(target_node);
+            target_node->parent = node;
+            return iterator(target_node);
+          }
+        else
+          {
+            iterator i = insert_node(0, node, target_node);
+            SPATIAL_ASSERT_INVARIANT(*this);
+            return i;
+          }
+      }
+
     public:
       // Iterators standard interface
       iterator begin()
@@ -496,7 +688,20 @@ namespace spatial
        */
       size_type
       max_size() const
-      { return _impl._header.base().max_size(); }
+      {
+        return std::allocator_traits<Link_allocator>
+          ::max_size(_impl._header.base());
+      }
+
+      /**
+       *  Returns the number of elements that the tree can hold without
+       *  allocating memory: its size and the number of nodes reserved in
+       *  advance.
+       *  \see reserve()
+       */
+      size_type
+      capacity() const
+      { return size() + _impl._reserve.spares(); }
 
       ///@{
       /**
@@ -528,6 +733,34 @@ namespace spatial
                                           key)
                               .first);
       }
+
+      /**
+       *  Overloads of \ref find() for a \c key of another type than \ref
+       *  key_type, which are available only if \ref key_compare is
+       *  transparent, such as \ref bracket_less<void>. No temporary key is
+       *  built to perform the search.
+       */
+      template <typename Query>
+      typename enable_if_c
+      <details::is_transparent_query<key_compare, Query, key_type>::value,
+       iterator>::type
+      find(const Query& key)
+      {
+        if (empty()) return end();
+        return iterator(first_equal(get_root(), 0, rank(), key_comp(), key)
+                        .first);
+      }
+
+      template <typename Query>
+      typename enable_if_c
+      <details::is_transparent_query<key_compare, Query, key_type>::value,
+       const_iterator>::type
+      find(const Query& key) const
+      {
+        if (empty()) return end();
+        return const_iterator(first_equal(get_root(), 0, rank(), key_comp(),
+                                          key).first);
+      }
       ///@}
 
     public:
@@ -595,7 +828,10 @@ namespace spatial
        *  Deallocate all nodes in the destructor.
        */
       ~Relaxed_kdtree()
-      { destroy_all_nodes(); }
+      {
+        destroy_all_nodes();
+        _impl._reserve.release(get_link_allocator());
+      }
 
     public:
       // Mutable functions
@@ -609,6 +845,9 @@ namespace spatial
       void
       swap(Self& other)
       {
+        template_allocator_swap<Link_allocator>::do_it
+          (get_link_allocator(), other.get_link_allocator());
+        _impl._reserve.swap(other._impl._reserve);
         if (empty() && other.empty()) return;
         template_member_swap<rank_type>::do_it
           (get_rank(), other.get_rank());
@@ -616,8 +855,6 @@ namespace spatial
           (get_compare(), other.get_compare());
         template_member_swap<balancing_policy>::do_it
           (get_balancing(), other.get_balancing());
-        template_member_swap<Link_allocator>::do_it
-          (get_link_allocator(), other.get_link_allocator());
         if (_impl._header().parent == &_impl._header())
           {
             _impl._header().parent = &other._impl._header();
@@ -654,33 +891,76 @@ namespace spatial
        */
       iterator
       insert(const value_type& value)
+      { return insert_created(create_node(value)); } // may throw
+
+      /**
+       *  Allocates nodes in advance, so that the tree can hold \c n elements
+       *  without allocating memory.
+       *
+       *  From then on, erased nodes are kept by the tree for later insertions
+       *  rather than deallocated, and \ref clear() keeps all of them.
+       *  Therefore, while \ref size() does not exceed \c n, the insertion of
+       *  a value and \ref erase() do not call the allocator, including when
+       *  they rebalance the tree, except to construct values that allocate
+       *  memory themselves or that are stored with \ref cold_storage. The
+       *  insertion of a range still orders the range in a temporary buffer.
+       *  The nodes are released by \ref shrink_to_fit() or the destruction of
+       *  the tree.
+       *
+       *  \throws std::bad_alloc, or the exception thrown by the allocator, if
+       *  the memory cannot be allocated; the nodes already allocated are kept.
+       */
+      void
+      reserve(size_type n)
       {
-        node_ptr target_node = create_node(value); // may throw
-        node_ptr node = get_root();
-        if (header(node))
-          {
-            // insert root node in empty tree
-            set_leftmost(target_node);
-            set_rightmost(target_node);
-            set_root(target_node);
-            target_node->parent = node;
-            return iterator(target_node);
-          }
-        else
-          {
-            iterator i = insert_node(0, node, target_node);
-            SPATIAL_ASSERT_INVARIANT(*this);
-            return i;
-          }
+        _impl._reserve.reserve(get_link_allocator(),
+                               n > size() ? n - size() : 0, n);
       }
 
+      /**
+       *  Releases the nodes reserved in advance that are not in use, and
+       *  deallocates erased nodes from then on.
+       *  \see reserve()
+       */
+      void
+      shrink_to_fit()
+      { _impl._reserve.release(get_link_allocator()); }
+
       /**
        *  Insert a serie of values in the tree at once.
+       *
+       *  The values are inserted in the order given by \ref locality_sort(),
+       *  rather than in the order in which they are read. Consecutive
+       *  insertions thus walk down neighboring paths of the tree and, if the
+       *  tree was empty, leave it balanced without any rebalancing. Values
+       *  with equivalent keys may therefore be inserted in a different order
+       *  from the order in which they are read.
        */
       template<typename InputIterator>
       void
       insert(InputIterator first, InputIterator last)
-      { for (; first != last; ++first) { insert(*first); } }
+      {
+        Ptr_store local(_impl._reserve.get_allocator());
+        Ptr_store& ptr_store = _impl._reserve.store(local);
+        try
+          {
+            for (; first != last; ++first)
+              { ptr_store.push_back(create_node(*first)); } // may throw
+          }
+        catch (...)
+          {
+            for (typename Ptr_store::iterator
+                   i = ptr_store.begin(); i != ptr_store.end(); ++i)
+              { destroy_node(*i); }
+            throw;
+          }
+        if (ptr_store.empty()) return;
+        locality_sort(ptr_store.begin(), ptr_store.end(), 0, rank(),
+                      Node_key_compare<key_compare>(key_comp()));
+        for (typename Ptr_store::iterator
+               i = ptr_store.begin(); i != ptr_store.end(); ++i)
+          { insert_created(*i); }
+      }
 
       // Deletion
       /**
@@ -706,10 +986,12 @@ namespace spatial
      *  Swap the content of the relaxed \kdtree \p left and \p right.
      */
     template <typename Rank, typename Key, typename Value, typename Compare,
-              typename Balancing, typename Alloc>
+              typename Balancing, typename Alloc, typename Storage>
     inline void swap
-    (Relaxed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc>& left,
-     Relaxed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc>& right)
+    (Relaxed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc,
+                    Storage>& left,
+     Relaxed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc,
+                    Storage>& right)
     { left.swap(right); }
 
     /**
@@ -726,12 +1008,12 @@ namespace spatial
      */
     ///@{
     template <typename Rank, typename Key, typename Value, typename Compare,
-              typename Balancing, typename Alloc>
+              typename Balancing, typename Alloc, typename Storage>
     inline bool
     operator==(const Relaxed_kdtree
-               <Rank, Key, Value, Compare, Balancing, Alloc>& lhs,
+               <Rank, Key, Value, Compare, Balancing, Alloc, Storage>& lhs,
                const Relaxed_kdtree
-               <Rank, Key, Value, Compare, Balancing, Alloc>& rhs)
+               <Rank, Key, Value, Compare, Balancing, Alloc, Storage>& rhs)
     {
       return lhs.size() == rhs.size()
         && std::equal(ordered_begin(lhs), ordered_end(lhs),
@@ -739,12 +1021,12 @@ namespace spatial
     }
 
     template <typename Rank, typename Key, typename Value, typename Compare,
-              typename Balancing, typename Alloc>
+              typename Balancing, typename Alloc, typename Storage>
     inline bool
     operator!=(const Relaxed_kdtree
-               <Rank, Key, Value, Compare, Balancing, Alloc>& lhs,
+               <Rank, Key, Value, Compare, Balancing, Alloc, Storage>& lhs,
                const Relaxed_kdtree
-               <Rank, Key, Value, Compare, Balancing, Alloc>& rhs)
+               <Rank, Key, Value, Compare, Balancing, Alloc, Storage>& rhs)
     { return !(lhs == rhs); }
     ///@}
 
@@ -762,12 +1044,12 @@ namespace spatial
      */
     ///@{
     template <typename Rank, typename Key, typename Value, typename Compare,
-              typename Balancing, typename Alloc>
+              typename Balancing, typename Alloc, typename Storage>
     inline bool
     operator<(const Relaxed_kdtree
-              <Rank, Key, Value, Compare, Balancing, Alloc>& lhs,
+              <Rank, Key, Value, Compare, Balancing, Alloc, Storage>& lhs,
               const Relaxed_kdtree
-              <Rank, Key, Value, Compare, Balancing, Alloc>& rhs)
+              <Rank, Key, Value, Compare, Balancing, Alloc, Storage>& rhs)
     {
       return std::lexicographical_compare
         (ordered_begin(lhs), ordered_end(lhs),
@@ -775,37 +1057,37 @@ namespace spatial
     }
 
     template <typename Rank, typename Key, typename Value, typename Compare,
-              typename Balancing, typename Alloc>
+              typename Balancing, typename Alloc, typename Storage>
     inline bool
     operator>(const Relaxed_kdtree
-              <Rank, Key, Value, Compare, Balancing, Alloc>& lhs,
+              <Rank, Key, Value, Compare, Balancing, Alloc, Storage>& lhs,
               const Relaxed_kdtree
-              <Rank, Key, Value, Compare, Balancing, Alloc>& rhs)
+              <Rank, Key, Value, Compare, Balancing, Alloc, Storage>& rhs)
     { return rhs < lhs; }
 
     template <typename Rank, typename Key, typename Value, typename Compare,
-              typename Balancing, typename Alloc>
+              typename Balancing, typename Alloc, typename Storage>
     inline bool
     operator<=(const Relaxed_kdtree
-               <Rank, Key, Value, Compare, Balancing, Alloc>& lhs,
+               <Rank, Key, Value, Compare, Balancing, Alloc, Storage>& lhs,
                const Relaxed_kdtree
-               <Rank, Key, Value, Compare, Balancing, Alloc>& rhs)
+               <Rank, Key, Value, Compare, Balancing, Alloc, Storage>& rhs)
     { return !(rhs < lhs); }
 
     template <typename Rank, typename Key, typename Value, typename Compare,
-              typename Balancing, typename Alloc>
+              typename Balancing, typename Alloc, typename Storage>
     inline bool
     operator>=(const Relaxed_kdtree
-               <Rank, Key, Value, Compare, Balancing, Alloc>& lhs,
+               <Rank, Key, Value, Compare, Balancing, Alloc, Storage>& lhs,
                const Relaxed_kdtree
-               <Rank, Key, Value, Compare, Balancing, Alloc>& rhs)
+               <Rank, Key, Value, Compare, Balancing, Alloc, Storage>& rhs)
     { return !(lhs < rhs); }
     ///@}
 
     template <typename Rank, typename Key, typename Value, typename Compare,
-              typename Balancing, typename Alloc>
+              typename Balancing, typename Alloc, typename Storage>
     inline void
-    Relaxed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc>
+    Relaxed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc, Storage>
     ::destroy_all_nodes()
     {
       node_ptr node = get_root();
@@ -836,9 +1118,9 @@ namespace spatial
     }
 
     template <typename Rank, typename Key, typename Value, typename Compare,
-              typename Balancing, typename Alloc>
+              typename Balancing, typename Alloc, typename Storage>
     inline void
-    Relaxed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc>
+    Relaxed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc, Storage>
     ::copy_structure
     (const Self& other)
     {
@@ -901,15 +1183,18 @@ namespace spatial
     }
 
     template <typename Rank, typename Key, typename Value, typename Compare,
-              typename Balancing, typename Alloc>
+              typename Balancing, typename Alloc, typename Storage>
     inline
-    typename Relaxed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc>::node_ptr
-    Relaxed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc>
+    typename Relaxed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc,
+                            Storage>::node_ptr
+    Relaxed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc, Storage>
     ::balance_node
     (dimension_type node_dim, node_ptr node)
     {
       const_node_ptr p = node->parent; // Parent is not swapped, node is!
       bool left_node = (p->left == node);
+      details::Rebalance_probe<Balancing>
+        probe(get_balancing(), node, const_link(node)->weight);
       // erase first...
       erase_node(node_dim, node);
       node_ptr replacing = header(p) ? p->parent
@@ -920,17 +1205,21 @@ namespace spatial
     }
 
     template <typename Rank, typename Key, typename Value, typename Compare,
-              typename Balancing, typename Alloc>
+              typename Balancing, typename Alloc, typename Storage>
     inline
-    typename Relaxed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc>::iterator
-    Relaxed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc>
+    typename Relaxed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc,
+                            Storage>::iterator
+    Relaxed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc, Storage>
     ::insert_node
     (dimension_type node_dim, node_ptr node, node_ptr target_node)
     {
       SPATIAL_ASSERT_CHECK(node != 0);
       SPATIAL_ASSERT_CHECK(!header(node));
+      details::Rebalance_probe<Balancing>::count_insert(get_balancing());
       while (true)
         {
+          // The weights of both children are read below
+          prefetch_children(node);
           SPATIAL_ASSERT_CHECK
             ((node->right ? const_link(node->right)->weight : 0)
              + (node->left ? const_link(node->left)->weight: 0)
@@ -955,7 +1244,7 @@ namespace spatial
                 }
               else
                 {
-                  if(balancing()
+                  if(get_balancing()
                      (rank(),
                       1 + (node->left ? const_link(node->left)->weight : 0),
                       (node->right ? const_link(node->right)->weight : 0)))
@@ -983,7 +1272,7 @@ namespace spatial
                 }
               else
                 {
-                  if(balancing()
+                  if(get_balancing()
                      (rank(),
                       (node->left ? const_link(node->left)->weight : 0),
                       1 + (node->right ? const_link(node->right)->weight : 0)))
@@ -1009,11 +1298,11 @@ namespace spatial
     }
 
     template <typename Rank, typename Key, typename Value, typename Compare,
-              typename Balancing, typename Alloc>
+              typename Balancing, typename Alloc, typename Storage>
     inline
-    typename Relaxed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc>
-    ::node_ptr
-    Relaxed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc>
+    typename Relaxed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc,
+                            Storage>::node_ptr
+    Relaxed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc, Storage>
     ::erase_node
     (dimension_type node_dim, node_ptr node)
     {
@@ -1021,6 +1310,7 @@ namespace spatial
       SPATIAL_ASSERT_CHECK(!header(node));
       // never ask to erase a single root node in this function
       SPATIAL_ASSERT_CHECK(get_rightmost() != get_leftmost());
+      details::Rebalance_probe<Balancing>::count_erase(get_balancing());
       node_ptr parent = node->parent;
       while (node->right != 0 || node->left != 0)
         {
@@ -1075,7 +1365,7 @@ namespace spatial
           node_dim = decr_dim(rank(), node_dim);
           SPATIAL_ASSERT_CHECK(const_link(node)->weight > 1);
           --link(node)->weight;
-          if(balancing()
+          if(get_balancing()
              (rank(),
               (node->left ? const_link(node->left)->weight : 0),
               (node->right ? const_link(node->right)->weight : 0)))
@@ -1089,9 +1379,9 @@ namespace spatial
     }
 
     template <typename Rank, typename Key, typename Value, typename Compare,
-              typename Balancing, typename Alloc>
+              typename Balancing, typename Alloc, typename Storage>
     inline void
-    Relaxed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc>
+    Relaxed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc, Storage>
     ::erase_node_balance
     (dimension_type node_dim, node_ptr node)
     {
@@ -1114,7 +1404,7 @@ namespace spatial
             {
               SPATIAL_ASSERT_CHECK(const_link(p)->weight > 1);
               --link(p)->weight;
-              if(balancing()
+              if(get_balancing()
                  (rank(),
                   (node->left ? const_link(node->left)->weight : 0),
                   (node->right ? const_link(node->right)->weight : 0)))
@@ -1126,9 +1416,9 @@ namespace spatial
     }
 
     template <typename Rank, typename Key, typename Value, typename Compare,
-              typename Balancing, typename Alloc>
+              typename Balancing, typename Alloc, typename Storage>
     inline void
-    Relaxed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc>
+    Relaxed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc, Storage>
     ::erase
     (iterator target)
     {
@@ -1147,11 +1437,11 @@ namespace spatial
     }
 
     template <typename Rank, typename Key, typename Value, typename Compare,
-              typename Balancing, typename Alloc>
+              typename Balancing, typename Alloc, typename Storage>
     inline
-    typename Relaxed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc>
-    ::size_type
-    Relaxed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc>
+    typename Relaxed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc,
+                            Storage>::size_type
+    Relaxed_kdtree<Rank, Key, Value, Compare, Balancing, Alloc, Storage>
     ::erase
     (const key_type& key)
     {
@@ -1159,11 +1449,11 @@ namespace spatial
       while (!empty())
         {
           node_ptr node;
-          dimension_type depth;
-          import::tie(node, depth)
+          dimension_type dim;
+          import::tie(node, dim)
             = first_equal(get_root(), 0, rank(), key_comp(), key);
           if (node == get_header()) break;
-          erase_node_balance(depth % rank()(), node);
+          erase_node_balance(dim, node);
           destroy_node(node);
           ++cnt;
         }
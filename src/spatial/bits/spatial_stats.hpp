@@ -0,0 +1,346 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   spatial_stats.hpp
+ *  Provides \ref spatial::traversal_stats, the counts of the work carried out
+ *  by the neighbor, region, equal and mapping traversals of a tree, and the
+ *  functions that the traversals use to count it.
+ *
+ *  The counting is disabled by default and then costs nothing: the counting
+ *  functions reduce to the operations they wrap and the iterators hold no
+ *  counts. It is enabled by defining SPATIAL_ENABLE_STATS before including
+ *  any of the library headers, consistently in all the translation units of
+ *  a program. The counts are then available in two ways:
+ *
+ *  \li each iterator accumulates the work carried out to build it and to
+ *  move it in \c stats(), which is copied along with the iterator;
+ *  \li each thread accumulates the work of all the traversals that it
+ *  carries out in \ref spatial::thread_traversal_stats(), which also counts
+ *  the distances computed by the queries of \c query.hpp and by the batched
+ *  queries.
+ *
+ *  \code
+ *    spatial::thread_traversal_stats().clear();
+ *    neighbor_iterator<points_type> i = neighbor_begin(points, target);
+ *    for (int n = 0; n < 10; ++n, ++i) { }
+ *    // i.stats().distances_to_key, i.stats().pruned_subtrees...
+ *  \endcode
+ */
+
+#ifndef SPATIAL_STATS_HPP
+#define SPATIAL_STATS_HPP
+
+#include <cstddef> // std::size_t
+#include "../spatial.hpp"
+
+#ifdef SPATIAL_ENABLE_STATS
+#  if __cplusplus >= 201103L
+#    define SPATIAL_THREAD_LOCAL thread_local
+#  elif defined(__GNUC__) || defined(__clang__)
+#    define SPATIAL_THREAD_LOCAL __thread
+#  elif defined(_MSC_VER)
+#    define SPATIAL_THREAD_LOCAL __declspec(thread)
+#  else
+#    error "SPATIAL_ENABLE_STATS requires thread-local storage"
+#  endif
+#endif
+
+namespace spatial
+{
+  /**
+   *  The counts of the work carried out by one or several traversals of a
+   *  tree. It is an aggregate: value-initialize it to start from zero.
+   *
+   *  \code
+   *    spatial::traversal_stats total = spatial::traversal_stats();
+   *  \endcode
+   */
+  struct traversal_stats
+  {
+    //! The number of times a traversal moved to a node, whether going down
+    //! to a child or up to a parent, including the root it starts from.
+    std::size_t nodes_visited;
+    //! The number of distances computed between the target and a key.
+    std::size_t distances_to_key;
+    //! The number of distances computed between the target and the
+    //! splitting plane of a node.
+    std::size_t distances_to_plane;
+    //! The number of evaluations of a region predicate or of a comparison
+    //! of keys by equal and mapping traversals.
+    std::size_t predicate_evaluations;
+    //! The number of moves from a node up to its parent.
+    std::size_t climbs;
+    //! The number of non-empty subtrees that a traversal excluded without
+    //! visiting them.
+    std::size_t pruned_subtrees;
+
+    //! Sets all the counts to zero.
+    void clear() { *this = traversal_stats(); }
+
+    traversal_stats& operator+=(const traversal_stats& other)
+    {
+      nodes_visited += other.nodes_visited;
+      distances_to_key += other.distances_to_key;
+      distances_to_plane += other.distances_to_plane;
+      predicate_evaluations += other.predicate_evaluations;
+      climbs += other.climbs;
+      pruned_subtrees += other.pruned_subtrees;
+      return *this;
+    }
+
+    traversal_stats& operator-=(const traversal_stats& other)
+    {
+      nodes_visited -= other.nodes_visited;
+      distances_to_key -= other.distances_to_key;
+      distances_to_plane -= other.distances_to_plane;
+      predicate_evaluations -= other.predicate_evaluations;
+      climbs -= other.climbs;
+      pruned_subtrees -= other.pruned_subtrees;
+      return *this;
+    }
+  };
+
+  inline traversal_stats
+  operator+(traversal_stats lhs, const traversal_stats& rhs)
+  { return lhs += rhs; }
+
+  //! Returns the work carried out between 2 snapshots of the same counts.
+  inline traversal_stats
+  operator-(traversal_stats lhs, const traversal_stats& rhs)
+  { return lhs -= rhs; }
+
+  inline bool
+  operator==(const traversal_stats& lhs, const traversal_stats& rhs)
+  {
+    return lhs.nodes_visited == rhs.nodes_visited
+      && lhs.distances_to_key == rhs.distances_to_key
+      && lhs.distances_to_plane == rhs.distances_to_plane
+      && lhs.predicate_evaluations == rhs.predicate_evaluations
+      && lhs.climbs == rhs.climbs
+      && lhs.pruned_subtrees == rhs.pruned_subtrees;
+  }
+
+  inline bool
+  operator!=(const traversal_stats& lhs, const traversal_stats& rhs)
+  { return !(lhs == rhs); }
+
+  /**
+   *  Returns the counts of all the traversals carried out by the calling
+   *  thread since it started or since the counts were last cleared. The
+   *  counts remain zero unless SPATIAL_ENABLE_STATS is defined.
+   */
+  inline traversal_stats&
+  thread_traversal_stats()
+  {
+#ifdef SPATIAL_ENABLE_STATS
+    static SPATIAL_THREAD_LOCAL traversal_stats stats;
+#else
+    static traversal_stats stats;
+#endif
+    return stats;
+  }
+
+  namespace details
+  {
+    /**
+     *  The counts held by each iterator of the library, which only exist if
+     *  SPATIAL_ENABLE_STATS is defined.
+     */
+    class Iterator_stats
+    {
+    public:
+#ifdef SPATIAL_ENABLE_STATS
+      Iterator_stats() : _stats() { }
+
+      //! Returns the work carried out to build and move this iterator.
+      const traversal_stats& stats() const { return _stats; }
+
+      //! Sets the counts of this iterator to zero.
+      void clear_stats() { _stats.clear(); }
+
+    private:
+      friend class Stats_scope;
+      traversal_stats _stats;
+#else
+      //! Returns zero counts, since SPATIAL_ENABLE_STATS is not defined.
+      const traversal_stats& stats() const
+      {
+        static const traversal_stats zero = traversal_stats();
+        return zero;
+      }
+
+      //! Does nothing, since SPATIAL_ENABLE_STATS is not defined.
+      void clear_stats() { }
+#endif
+    };
+
+    /**
+     *  Adds to an iterator the counts of the calling thread that increased
+     *  during the lifetime of the scope.
+     *
+     *  The scope built with an iterator adds them when it is destroyed, which
+     *  suits the increment and decrement operators. The scope built without
+     *  an iterator adds them on \c close(), for the functions that build the
+     *  iterator after the traversal.
+     */
+    class Stats_scope
+    {
+    public:
+#ifdef SPATIAL_ENABLE_STATS
+      Stats_scope() : _start(thread_traversal_stats()), _iter(0) { }
+
+      explicit Stats_scope(Iterator_stats& iter)
+        : _start(thread_traversal_stats()), _iter(&iter) { }
+
+      ~Stats_scope() { if (_iter != 0) close(*_iter); }
+
+      void close(Iterator_stats& iter)
+      {
+        iter._stats += thread_traversal_stats() - _start;
+        _start = thread_traversal_stats();
+      }
+
+    private:
+      Stats_scope(const Stats_scope&);
+      Stats_scope& operator=(const Stats_scope&);
+
+      traversal_stats _start;
+      Iterator_stats* _iter;
+#else
+      Stats_scope() { }
+      explicit Stats_scope(Iterator_stats&) { }
+      void close(Iterator_stats&) { }
+#endif
+    };
+
+    /**
+     *  Returns \c child, counting the move to it.
+     */
+    template <typename NodePtr>
+    inline NodePtr
+    descend(NodePtr child)
+    {
+#ifdef SPATIAL_ENABLE_STATS
+      ++thread_traversal_stats().nodes_visited;
+#endif
+      return child;
+    }
+
+    /**
+     *  Returns the parent of \c node, counting the move to it.
+     */
+    template <typename NodePtr>
+    inline NodePtr
+    climb(NodePtr node)
+    {
+#ifdef SPATIAL_ENABLE_STATS
+      traversal_stats& stats = thread_traversal_stats();
+      ++stats.nodes_visited;
+      ++stats.climbs;
+#endif
+      return node->parent;
+    }
+
+    /**
+     *  Returns \c visit, the decision to visit a non-empty subtree, counting
+     *  the subtree as pruned if it is \c false.
+     */
+    inline bool
+    explore(bool visit)
+    {
+#ifdef SPATIAL_ENABLE_STATS
+      if (!visit) ++thread_traversal_stats().pruned_subtrees;
+#endif
+      return visit;
+    }
+
+    /**
+     *  Returns \c result, the result of a predicate or of a comparison of
+     *  keys, counting its evaluation.
+     */
+    template <typename Tp>
+    inline Tp
+    evaluated(Tp result)
+    {
+#ifdef SPATIAL_ENABLE_STATS
+      ++thread_traversal_stats().predicate_evaluations;
+#endif
+      return result;
+    }
+
+#ifdef SPATIAL_ENABLE_STATS
+    /**
+     *  A comparison of keys along a dimension that counts its evaluations.
+     */
+    template <typename KeyCompare>
+    class Counted_compare
+    {
+    public:
+      explicit Counted_compare(const KeyCompare& key_comp)
+        : _key_comp(key_comp) { }
+
+      template <typename Key1, typename Key2>
+      bool operator()(dimension_type dim, const Key1& x, const Key2& y) const
+      { return evaluated(_key_comp(dim, x, y)); }
+
+    private:
+      KeyCompare _key_comp;
+    };
+
+    /**
+     *  Returns \c key_comp wrapped so that its evaluations are counted.
+     */
+    template <typename KeyCompare>
+    inline Counted_compare<KeyCompare>
+    counted(const KeyCompare& key_comp)
+    { return Counted_compare<KeyCompare>(key_comp); }
+#else
+    /**
+     *  Returns \c key_comp, since SPATIAL_ENABLE_STATS is not defined.
+     */
+    template <typename KeyCompare>
+    inline const KeyCompare&
+    counted(const KeyCompare& key_comp)
+    { return key_comp; }
+#endif
+
+    /**
+     *  Returns the distance between \c target and \c key computed by \c met,
+     *  counting the computation.
+     */
+    template <typename Metric, typename Target, typename Key>
+    inline typename Metric::distance_type
+    distance_to_key(const Metric& met, dimension_type rank,
+                    const Target& target, const Key& key)
+    {
+#ifdef SPATIAL_ENABLE_STATS
+      ++thread_traversal_stats().distances_to_key;
+#endif
+      return met.distance_to_key(rank, target, key);
+    }
+
+    /**
+     *  Returns the distance between \c target and the plane orthogonal to
+     *  the dimension \c dim that goes through \c key computed by \c met,
+     *  counting the computation.
+     */
+    template <typename Metric, typename Target, typename Key>
+    inline typename Metric::distance_type
+    distance_to_plane(const Metric& met, dimension_type rank,
+                      dimension_type dim, const Target& target,
+                      const Key& key)
+    {
+#ifdef SPATIAL_ENABLE_STATS
+      ++thread_traversal_stats().distances_to_plane;
+#endif
+      return met.distance_to_plane(rank, dim, target, key);
+    }
+  } // namespace details
+} // namespace spatial
+
+#endif // SPATIAL_STATS_HPP
@@ -15,6 +15,7 @@
 #define SPATIAL_TEMPLATE_MEMBER_SWAP_HPP
 
 #include <algorithm> // provides: ::std::swap
+#include <memory> // provides: ::std::allocator_traits
 // provides: import::is_empty, import::false_type and import::true_type
 #include "spatial_import_type_traits.hpp"
 
@@ -66,6 +67,20 @@ namespace spatial
       : template_member_swap_provider<import::is_empty<Tp>::value, Tp>
     { };
     ///@}
+
+    /**
+     *  Perform a swap of allocators only if they propagate on swap, as the
+     *  containers of the standard library do. Allocators that do not
+     *  propagate, such as \c std::pmr::polymorphic_allocator, stay with their
+     *  container, and must then compare equal for the swap to be valid.
+     */
+    template <typename Alloc>
+    struct template_allocator_swap
+      : template_member_swap_provider
+        <import::is_empty<Alloc>::value
+         || !std::allocator_traits<Alloc>::propagate_on_container_swap::value,
+         Alloc>
+    { };
   }
 }
 
@@ -0,0 +1,433 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   spatial_traversal.hpp
+ *  Contains the traversal engine used by the one-shot queries of \ref
+ *  query.hpp. Rather than climbing back through the parent of each node, as
+ *  the iterators do, these traversals record the subtrees that remain to be
+ *  visited on an explicit stack.
+ */
+
+#ifndef SPATIAL_TRAVERSAL_HPP
+#define SPATIAL_TRAVERSAL_HPP
+
+#include <vector>
+#include <algorithm> // std::push_heap, std::pop_heap, std::sort_heap
+#include <utility> // std::pair
+#include "spatial_node.hpp"
+#include "spatial_rank.hpp"
+#include "spatial_prefetch.hpp"
+#include "spatial_assert.hpp"
+#include "spatial_stats.hpp"
+
+/**
+ *  \def SPATIAL_TRAVERSAL_STACK_SIZE
+ *  The number of entries held by a traversal stack without allocating any
+ *  memory. A traversal pushes at most one entry per level of the tree, so
+ *  the default is enough for any balanced tree that fits in memory. Deeper
+ *  trees, such as idle trees that were never rebalanced, spill the entries
+ *  in excess onto the heap.
+ */
+#ifndef SPATIAL_TRAVERSAL_STACK_SIZE
+#  define SPATIAL_TRAVERSAL_STACK_SIZE 64
+#endif
+
+namespace spatial
+{
+  namespace details
+  {
+    /**
+     *  Returns an upper bound of the depth of a balanced tree holding \c size
+     *  nodes, which is used to size the stack of the traversals.
+     *
+     *  The balancing policies of the library keep the depth of the trees
+     *  within twice the depth of a perfectly balanced tree.
+     */
+    inline std::size_t
+    traversal_depth_bound(std::size_t size)
+    {
+      std::size_t log2 = 0;
+      for (; size > 1; size >>= 1) { ++log2; }
+      return 2 * (log2 + 1);
+    }
+
+    /**
+     *  Returns the value held by \c node, which is constant if \c node is a
+     *  pointer to a constant node.
+     */
+    ///@{
+    template <typename Link>
+    inline typename Link::value_type&
+    visited_value(Node<Link>* node)
+    { return value(node); }
+
+    template <typename Link>
+    inline const typename Link::value_type&
+    visited_value(const Node<Link>* node)
+    { return const_value(node); }
+    ///@}
+
+    /**
+     *  A stack of the subtrees that remain to be visited by a traversal.
+     *
+     *  The first \c Capacity entries are held in the stack itself, so that
+     *  most traversals never allocate memory. Entries beyond \c Capacity are
+     *  stored in a vector, which is reserved upfront from the depth bound
+     *  given at construction.
+     *
+     *  \tparam Entry A copyable type that describes the subtree to visit.
+     *  \tparam Capacity The number of entries held without allocation.
+     */
+    template <typename Entry,
+              std::size_t Capacity = SPATIAL_TRAVERSAL_STACK_SIZE>
+    class Traversal_stack
+    {
+    public:
+      //! Build a stack for the traversal of a tree of depth \c depth_bound.
+      explicit Traversal_stack(std::size_t depth_bound)
+        : _size(0)
+      {
+        if (depth_bound > Capacity)
+          { _spill.reserve(depth_bound - Capacity); }
+      }
+
+      //! True if no subtree remains to be visited.
+      bool empty() const { return _size == 0; }
+
+      //! The number of entries in the stack.
+      std::size_t size() const { return _size; }
+
+      //! Record \c entry as the next subtree to visit.
+      void push(const Entry& entry)
+      {
+        if (_size < Capacity) { _fixed[_size] = entry; }
+        else { _spill.push_back(entry); }
+        ++_size;
+      }
+
+      //! Remove all entries, keeping the memory reserved for the spill.
+      void clear() { _size = 0; _spill.clear(); }
+
+      //! Remove and return the last subtree that was recorded.
+      Entry pop()
+      {
+        SPATIAL_ASSERT_CHECK(_size != 0);
+        --_size;
+        if (_size < Capacity) { return _fixed[_size]; }
+        Entry entry = _spill.back();
+        _spill.pop_back();
+        return entry;
+      }
+
+    private:
+      //! The entries held without allocation.
+      Entry _fixed[Capacity];
+
+      //! The entries in excess of \c Capacity.
+      std::vector<Entry> _spill;
+
+      //! The total number of entries.
+      std::size_t _size;
+    };
+
+    /**
+     *  A subtree that remains to be visited: its root and the dimension of
+     *  its root.
+     */
+    template <typename NodePtr>
+    struct Traversal_entry
+    {
+      Traversal_entry() { }
+      Traversal_entry(NodePtr node_, dimension_type dim_)
+        : node(node_), dim(dim_) { }
+      NodePtr node;
+      dimension_type dim;
+    };
+
+    /**
+     *  A subtree that remains to be visited along with the smallest distance
+     *  at which its values may lie from the target.
+     */
+    template <typename NodePtr, typename Distance>
+    struct Neighbor_entry
+    {
+      Neighbor_entry() { }
+      Neighbor_entry(NodePtr node_, dimension_type dim_, Distance bound_)
+        : node(node_), dim(dim_), bound(bound_) { }
+      NodePtr node;
+      dimension_type dim;
+      Distance bound;
+    };
+
+    /**
+     *  Calls \c visitor on the value of each node under \c node that matches
+     *  \c pred, in pre-order.
+     *
+     *  Each node is visited once: the predicate is evaluated a single time
+     *  on its splitting dimension, and on its other dimensions only if the
+     *  splitting dimension matches.
+     *
+     *  \param node The root of the tree, which must not be the header.
+     *  \param rank The rank of the container.
+     *  \param depth_bound The expected depth of the tree.
+     *  \param pred A model of \region_predicate.
+     *  \param visitor A functor called with the value of each matching node.
+     *  \return The visitor, after it was called on all matching values.
+     */
+    template <typename NodePtr, typename Rank, typename Predicate,
+              typename Visitor>
+    inline Visitor
+    visit_region(NodePtr node, const Rank rank, std::size_t depth_bound,
+                 const Predicate& pred, Visitor visitor)
+    {
+      SPATIAL_ASSERT_CHECK(node != 0);
+      SPATIAL_ASSERT_CHECK(!header(node));
+      Traversal_stack<Traversal_entry<NodePtr> > stack(depth_bound);
+      dimension_type dim = 0;
+      for (;;)
+        {
+          prefetch_children(node);
+          relative_order rel = pred(dim, rank(), const_key(node));
+          if (rel == matching)
+            {
+              dimension_type test = 0;
+              for (; test < rank()
+                     && (test == dim
+                         || pred(test, rank(), const_key(node)) == matching);
+                   ++test);
+              if (test == rank()) { visitor(visited_value(node)); }
+            }
+          NodePtr left = (rel != below) ? node->left : 0;
+          NodePtr right = (rel != above) ? node->right : 0;
+          dimension_type child_dim = incr_dim(rank, dim);
+          if (left != 0)
+            {
+              if (right != 0)
+                { stack.push(Traversal_entry<NodePtr>(right, child_dim)); }
+              node = left; dim = child_dim;
+            }
+          else if (right != 0)
+            { node = right; dim = child_dim; }
+          else if (!stack.empty())
+            {
+              Traversal_entry<NodePtr> entry = stack.pop();
+              node = entry.node; dim = entry.dim;
+            }
+          else break;
+        }
+      return visitor;
+    }
+
+    /**
+     *  Calls \c visitor on the value of each node under \c node whose
+     *  distance to \c target, as computed by \c met, is lower or equal to \c
+     *  radius.
+     *
+     *  \param node The root of the tree, which must not be the header.
+     *  \param rank The rank of the container.
+     *  \param depth_bound The expected depth of the tree.
+     *  \param key_comp The key comparator of the container.
+     *  \param met A model of \metric.
+     *  \param target The key from which distances are measured.
+     *  \param radius The largest distance at which values are visited.
+     *  \param visitor A functor called with the value of each node found.
+     *  \return The visitor, after it was called on all values found.
+     */
+    template <typename NodePtr, typename Rank, typename KeyCompare,
+              typename Metric, typename Key, typename Visitor>
+    inline Visitor
+    visit_radius(NodePtr node, const Rank rank, std::size_t depth_bound,
+                 const KeyCompare& key_comp, const Metric& met,
+                 const Key& target, typename Metric::distance_type radius,
+                 Visitor visitor)
+    {
+      SPATIAL_ASSERT_CHECK(node != 0);
+      SPATIAL_ASSERT_CHECK(!header(node));
+      Traversal_stack<Traversal_entry<NodePtr> > stack(depth_bound);
+      dimension_type dim = 0;
+      for (;;)
+        {
+          prefetch_children(node);
+          if (!(radius < distance_to_key(met, rank(), target, const_key(node))))
+            { visitor(visited_value(node)); }
+          NodePtr near, far;
+          if (key_comp(dim, const_key(node), target))
+            { near = node->right; far = node->left; }
+          else
+            { near = node->left; far = node->right; }
+          dimension_type child_dim = incr_dim(rank, dim);
+          if (far != 0
+              && !(radius < distance_to_plane(met, rank(), dim, target,
+                                              const_key(node))))
+            { stack.push(Traversal_entry<NodePtr>(far, child_dim)); }
+          if (near != 0)
+            { node = near; dim = child_dim; }
+          else if (!stack.empty())
+            {
+              Traversal_entry<NodePtr> entry = stack.pop();
+              node = entry.node; dim = entry.dim;
+            }
+          else break;
+        }
+      return visitor;
+    }
+
+    /**
+     *  Orders the candidates of a nearest neighbor search so that the
+     *  farthest candidate is at the top of the heap.
+     */
+    struct Nearest_less
+    {
+      template <typename Candidate>
+      bool operator()(const Candidate& x, const Candidate& y) const
+      { return x.first < y.first; }
+    };
+
+    /**
+     *  Finds the \c k nodes under \c node that are the closest to \c target
+     *  according to \c met, and stores them in \c nearest as pairs of
+     *  distance and node, by increasing distance.
+     *
+     *  Subtrees are recorded on the stack with the distance of their
+     *  splitting plane to \c target, and discarded without being visited if
+     *  \c k candidates closer than this distance have been found in the
+     *  meantime.
+     *
+     *  \param node The root of the tree, which must not be the header.
+     *  \param rank The rank of the container.
+     *  \param depth_bound The expected depth of the tree.
+     *  \param key_comp The key comparator of the container.
+     *  \param met A model of \metric.
+     *  \param target The key from which distances are measured.
+     *  \param k The number of nodes to find.
+     *  \param nearest The vector where the nodes found are stored. Its
+     *  previous content is lost.
+     */
+    template <typename NodePtr, typename Rank, typename KeyCompare,
+              typename Metric, typename Key, typename Alloc>
+    inline void
+    nearest_k(NodePtr node, const Rank rank, std::size_t depth_bound,
+              const KeyCompare& key_comp, const Metric& met,
+              const Key& target, std::size_t k,
+              std::vector<std::pair<typename Metric::distance_type, NodePtr>,
+                          Alloc>& nearest)
+    {
+      typedef typename Metric::distance_type distance_type;
+      typedef std::pair<distance_type, NodePtr> candidate_type;
+      typedef Neighbor_entry<NodePtr, distance_type> entry_type;
+      SPATIAL_ASSERT_CHECK(node != 0);
+      SPATIAL_ASSERT_CHECK(!header(node));
+      nearest.clear();
+      if (k == 0) return;
+      nearest.reserve(k);
+      Traversal_stack<entry_type> stack(depth_bound);
+      dimension_type dim = 0;
+      for (;;)
+        {
+          prefetch_children(node);
+          distance_type dist
+            = distance_to_key(met, rank(), target, const_key(node));
+          if (nearest.size() < k)
+            {
+              nearest.push_back(candidate_type(dist, node));
+              std::push_heap(nearest.begin(), nearest.end(), Nearest_less());
+            }
+          else if (dist < nearest.front().first)
+            {
+              std::pop_heap(nearest.begin(), nearest.end(), Nearest_less());
+              nearest.back() = candidate_type(dist, node);
+              std::push_heap(nearest.begin(), nearest.end(), Nearest_less());
+            }
+          NodePtr near, far;
+          if (key_comp(dim, const_key(node), target))
+            { near = node->right; far = node->left; }
+          else
+            { near = node->left; far = node->right; }
+          dimension_type child_dim = incr_dim(rank, dim);
+          if (far != 0)
+            {
+              distance_type bound
+                = distance_to_plane(met, rank(), dim, target, const_key(node));
+              if (nearest.size() < k || bound < nearest.front().first)
+                { stack.push(entry_type(far, child_dim, bound)); }
+            }
+          if (near != 0)
+            { node = near; dim = child_dim; continue; }
+          node = 0;
+          while (!stack.empty())
+            {
+              entry_type entry = stack.pop();
+              if (nearest.size() < k || entry.bound < nearest.front().first)
+                { node = entry.node; dim = entry.dim; break; }
+            }
+          if (node == 0) break;
+        }
+      std::sort_heap(nearest.begin(), nearest.end(), Nearest_less());
+    }
+
+    /**
+     *  \name Dispatch of \dynamic_rank
+     *
+     *  Overloads of the traversals for \dynamic_rank. If the rank of the
+     *  container is listed in \ref SPATIAL_DISPATCH_RANKS, the traversal is
+     *  carried out with the equivalent \static_rank.
+     */
+    ///@{
+    template <typename NodePtr, typename Predicate, typename Visitor>
+    inline Visitor
+    visit_region(NodePtr node, Dynamic_rank rank, std::size_t depth_bound,
+                 const Predicate& pred, Visitor visitor)
+    {
+#     define SPATIAL_RANK_DISPATCH_CALL(r) \
+        visit_region(node, r, depth_bound, pred, visitor)
+      SPATIAL_RANK_DISPATCH(rank)
+#     undef SPATIAL_RANK_DISPATCH_CALL
+      return visit_region<NodePtr, Dynamic_rank, Predicate, Visitor>
+        (node, rank, depth_bound, pred, visitor);
+    }
+
+    template <typename NodePtr, typename KeyCompare, typename Metric,
+              typename Key, typename Visitor>
+    inline Visitor
+    visit_radius(NodePtr node, Dynamic_rank rank, std::size_t depth_bound,
+                 const KeyCompare& key_comp, const Metric& met,
+                 const Key& target, typename Metric::distance_type radius,
+                 Visitor visitor)
+    {
+#     define SPATIAL_RANK_DISPATCH_CALL(r)                             \
+        visit_radius(node, r, depth_bound, key_comp, met, target, radius, \
+                     visitor)
+      SPATIAL_RANK_DISPATCH(rank)
+#     undef SPATIAL_RANK_DISPATCH_CALL
+      return visit_radius
+        <NodePtr, Dynamic_rank, KeyCompare, Metric, Key, Visitor>
+        (node, rank, depth_bound, key_comp, met, target, radius, visitor);
+    }
+
+    template <typename NodePtr, typename KeyCompare, typename Metric,
+              typename Key, typename Alloc>
+    inline void
+    nearest_k(NodePtr node, Dynamic_rank rank, std::size_t depth_bound,
+              const KeyCompare& key_comp, const Metric& met,
+              const Key& target, std::size_t k,
+              std::vector<std::pair<typename Metric::distance_type, NodePtr>,
+                          Alloc>& nearest)
+    {
+#     define SPATIAL_RANK_DISPATCH_CALL(r)                             \
+        nearest_k(node, r, depth_bound, key_comp, met, target, k, nearest)
+      SPATIAL_RANK_DISPATCH(rank)
+#     undef SPATIAL_RANK_DISPATCH_CALL
+      nearest_k<NodePtr, Dynamic_rank, KeyCompare, Metric, Key, Alloc>
+        (node, rank, depth_bound, key_comp, met, target, k, nearest);
+    }
+    ///@}
+
+  } // namespace details
+} // namespace spatial
+
+#endif // SPATIAL_TRAVERSAL_HPP
@@ -25,15 +25,21 @@ namespace spatial
   /**
    *  A mapped containers to store values in space that can be represented as
    *  boxes.
+   *
+   *  With \ref cold_storage as \c StoragePolicy, the nodes only hold the keys
+   *  and the values are allocated separately, which speeds up the traversals
+   *  when the mapped type is large.
    */
   template<dimension_type Rank, typename Key, typename Mapped,
            typename Compare = bracket_less<Key>,
            typename BalancingPolicy = loose_balancing,
-           typename Alloc = std::allocator<std::pair<const Key, Mapped> > >
+           typename Alloc = std::allocator<std::pair<const Key, Mapped> >,
+           typename StoragePolicy = inline_storage>
   class box_multimap
     : public details::Relaxed_kdtree<details::Static_rank<Rank>, const Key,
                                      std::pair<const Key, Mapped>,
-                                     Compare, BalancingPolicy, Alloc>
+                                     Compare, BalancingPolicy, Alloc,
+                                     StoragePolicy>
   {
   private:
     typedef typename
@@ -41,9 +47,9 @@ namespace spatial
 
     typedef details::Relaxed_kdtree
     <details::Static_rank<Rank>, const Key, std::pair<const Key, Mapped>,
-     Compare, BalancingPolicy, Alloc>         base_type;
+     Compare, BalancingPolicy, Alloc, StoragePolicy> base_type;
     typedef box_multimap<Rank, Key, Mapped, Compare,
-                   BalancingPolicy, Alloc>    Self;
+                         BalancingPolicy, Alloc, StoragePolicy> Self;
 
   public:
     typedef Mapped                            mapped_type;
@@ -89,18 +95,20 @@ namespace spatial
   template<typename Key, typename Mapped,
            typename Compare,
            typename BalancingPolicy,
-           typename Alloc>
-  struct box_multimap<0, Key, Mapped, Compare, BalancingPolicy, Alloc>
+           typename Alloc,
+           typename StoragePolicy>
+  struct box_multimap<0, Key, Mapped, Compare, BalancingPolicy, Alloc,
+                      StoragePolicy>
     : details::Relaxed_kdtree<details::Dynamic_rank, const Key,
                               std::pair<const Key, Mapped>, Compare,
-                              BalancingPolicy, Alloc>
+                              BalancingPolicy, Alloc, StoragePolicy>
   {
   private:
     typedef details::Relaxed_kdtree
     <details::Dynamic_rank, const Key, std::pair<const Key, Mapped>,
-     Compare, BalancingPolicy, Alloc>         base_type;
+     Compare, BalancingPolicy, Alloc, StoragePolicy> base_type;
     typedef box_multimap<0, Key, Mapped, Compare,
-                   BalancingPolicy, Alloc>    Self;
+                         BalancingPolicy, Alloc, StoragePolicy> Self;
 
   public:
     typedef Mapped                            mapped_type;
@@ -0,0 +1,134 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   cached_point_multiset.hpp
+ *  Contains the definition of \ref spatial::cached_point_multiset, a
+ *  container of user objects that keeps a copy of the coordinates of each
+ *  object in its node, and of \ref spatial::cached_coordinates, the type of
+ *  these copies.
+ */
+
+#ifndef SPATIAL_CACHED_POINT_MULTISET_HPP
+#define SPATIAL_CACHED_POINT_MULTISET_HPP
+
+#include <memory>  // std::allocator
+#include "function.hpp"
+#include "bits/spatial_check_concept.hpp"
+#include "bits/spatial_relaxed_kdtree.hpp"
+
+namespace spatial
+{
+  /**
+   *  A copy of the \c Rank coordinates of a value, read with \c operator[].
+   *  It is the key of a \ref cached_point_multiset.
+   */
+  template <dimension_type Rank, typename Tp>
+  struct cached_coordinates
+  {
+    typedef Tp value_type;
+
+    Tp operator[](dimension_type n) const { return coord[n]; }
+    Tp& operator[](dimension_type n) { return coord[n]; }
+
+    Tp coord[Rank];
+  };
+
+  template <dimension_type Rank, typename Tp>
+  inline bool operator==(const cached_coordinates<Rank, Tp>& x,
+                         const cached_coordinates<Rank, Tp>& y)
+  {
+    for (dimension_type n = 0; n < Rank; ++n)
+      { if (x[n] != y[n]) return false; }
+    return true;
+  }
+
+  template <dimension_type Rank, typename Tp>
+  inline bool operator!=(const cached_coordinates<Rank, Tp>& x,
+                         const cached_coordinates<Rank, Tp>& y)
+  { return !(x == y); }
+
+  /**
+   *  A multiset of user objects whose coordinates are read through \c
+   *  Accessor, such as the objects of a \point_multiset used with \ref
+   *  accessor_less, but where the coordinates are read only once.
+   *
+   *  When a value is inserted, its coordinates are copied into a \ref
+   *  cached_coordinates, stored in the node next to the value, which is the
+   *  key of the container. All comparisons, region predicates and metrics
+   *  then read the copy, with \ref bracket_less and \ref bracket_minus, and
+   *  \c Accessor is never called during a search. Iterators still
+   *  dereference to the value.
+   *
+   *  Bounds of regions, targets of neighbor searches and the arguments of
+   *  \ref find() and \ref erase() are keys: they are obtained from a value
+   *  with \ref key_of(), or built directly as a \ref cached_coordinates.
+   *
+   *  \tparam Rank The number of coordinates, which must be fixed.
+   *  \tparam Value The type of the objects.
+   *  \tparam Accessor A functor that returns the coordinate \c n of a value
+   *  when called with <tt>(n, value)</tt>; it is default constructed.
+   *  \tparam Tp The type in which the coordinates are copied.
+   */
+  template <dimension_type Rank, typename Value, typename Accessor,
+            typename Tp = double,
+            typename BalancingPolicy = loose_balancing,
+            typename Alloc = std::allocator<Value> >
+  struct cached_point_multiset
+    : details::Relaxed_kdtree<details::Static_rank<Rank>,
+                              const cached_coordinates<Rank, Tp>, const Value,
+                              bracket_less<cached_coordinates<Rank, Tp> >,
+                              BalancingPolicy, Alloc, cached_storage<Accessor> >
+  {
+  private:
+    typedef typename
+    enable_if_c<(Rank != 0)>::type check_concept_rank_is_not_null;
+
+    typedef details::Relaxed_kdtree
+    <details::Static_rank<Rank>, const cached_coordinates<Rank, Tp>,
+     const Value, bracket_less<cached_coordinates<Rank, Tp> >,
+     BalancingPolicy, Alloc, cached_storage<Accessor> >   base_type;
+    typedef cached_point_multiset<Rank, Value, Accessor, Tp,
+                                  BalancingPolicy, Alloc> Self;
+
+  public:
+    typedef typename base_type::key_type                  key_type;
+    typedef typename base_type::value_type                value_type;
+
+    cached_point_multiset() { }
+
+    explicit cached_point_multiset(const BalancingPolicy& balancing)
+      : base_type(details::Static_rank<Rank>(),
+                  bracket_less<cached_coordinates<Rank, Tp> >(), balancing)
+    { }
+
+    cached_point_multiset(const BalancingPolicy& balancing,
+                          const Alloc& alloc)
+      : base_type(details::Static_rank<Rank>(),
+                  bracket_less<cached_coordinates<Rank, Tp> >(), balancing,
+                  alloc)
+    { }
+
+    cached_point_multiset(const cached_point_multiset& other)
+      : base_type(other)
+    { }
+
+    cached_point_multiset&
+    operator=(const cached_point_multiset& other)
+    { return static_cast<Self&>(base_type::operator=(other)); }
+
+    //! Returns the coordinates of \c value, read through \c Accessor.
+    key_type key_of(const value_type& value) const
+    {
+      key_type key;
+      cached_storage<Accessor>().cache(Rank, key, value);
+      return key;
+    }
+  };
+}
+
+#endif // SPATIAL_CACHED_POINT_MULTISET_HPP
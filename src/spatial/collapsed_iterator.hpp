@@ -0,0 +1,195 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   collapsed_iterator.hpp
+ *  Provides \ref spatial::collapsed_iterator, which enumerates every value held
+ *  in the nodes of the collapsed containers.
+ */
+
+#ifndef SPATIAL_COLLAPSED_ITERATOR_HPP
+#define SPATIAL_COLLAPSED_ITERATOR_HPP
+
+#include <cstddef> // std::size_t, std::ptrdiff_t
+#include <iterator> // std::bidirectional_iterator_tag
+#include "bits/spatial_mutate.hpp"
+
+namespace spatial
+{
+  /**
+   *  This type adapts any iterator on the nodes of a \collapsed_point_multiset
+   *  or a \collapsed_point_multimap, such as its in-order iterator, a \ref
+   *  region_iterator, an \ref equal_iterator or a \ref neighbor_iterator, in
+   *  order to enumerate each of the values held in these nodes.
+   *
+   *  Every node of a collapsed container holds a single key along with the
+   *  values that were inserted with this key, or their count if the
+   *  container is a set. The adapted iterator visits the values of a node in
+   *  their order of insertion before it moves to the next node.
+   *
+   *  \tparam NodeIterator An iterator on the nodes of a collapsed container.
+   *  \tparam Value The type of values returned by the iterator, \c const
+   *  qualified if the values must not be modified.
+   */
+  template <typename NodeIterator, typename Value>
+  class collapsed_iterator
+  {
+  public:
+    typedef typename details::mutate<Value>::type value_type;
+    typedef Value&                                reference;
+    typedef Value*                                pointer;
+    typedef std::ptrdiff_t                        difference_type;
+    typedef std::bidirectional_iterator_tag       iterator_category;
+
+    //! \empty
+    collapsed_iterator() : _pos(0) { }
+
+    /**
+     *  Build an iterator on the first value of the node pointed to by \c
+     *  iter.
+     */
+    explicit collapsed_iterator(const NodeIterator& iter)
+      : _iter(iter), _pos(0) { }
+
+    /**
+     *  Build an iterator on the value at the position \c pos in the node
+     *  pointed to by \c iter.
+     */
+    collapsed_iterator(const NodeIterator& iter, std::size_t pos)
+      : _iter(iter), _pos(pos) { }
+
+    //! Convertion of an iterator into a const_iterator is permitted.
+    template <typename OtherIterator, typename OtherValue>
+    collapsed_iterator
+    (const collapsed_iterator<OtherIterator, OtherValue>& other)
+      : _iter(other.base()), _pos(other.position()) { }
+
+    reference operator*()
+    { return (*_iter).second.value((*_iter).first, _pos); }
+
+    pointer operator->()
+    { return &(*_iter).second.value((*_iter).first, _pos); }
+
+    //! Moves to the next value in the node, or to the first value of the next
+    //! node if all values in the node have been visited.
+    collapsed_iterator& operator++()
+    {
+      if (++_pos == (*_iter).second.size()) { ++_iter; _pos = 0; }
+      return *this;
+    }
+
+    collapsed_iterator operator++(int)
+    {
+      collapsed_iterator x(*this);
+      ++*this;
+      return x;
+    }
+
+    //! Moves to the previous value in the node, or to the last value of the
+    //! previous node if the first value of the node was reached.
+    collapsed_iterator& operator--()
+    {
+      if (_pos == 0) { --_iter; _pos = (*_iter).second.size(); }
+      --_pos;
+      return *this;
+    }
+
+    collapsed_iterator operator--(int)
+    {
+      collapsed_iterator x(*this);
+      --*this;
+      return x;
+    }
+
+    template <typename OtherIterator, typename OtherValue>
+    bool operator==
+    (const collapsed_iterator<OtherIterator, OtherValue>& x) const
+    { return _iter == x.base() && _pos == x.position(); }
+
+    template <typename OtherIterator, typename OtherValue>
+    bool operator!=
+    (const collapsed_iterator<OtherIterator, OtherValue>& x) const
+    { return !(*this == x); }
+
+    //! The iterator on the current node.
+    const NodeIterator& base() const { return _iter; }
+
+    //! The position of the current value in the current node.
+    std::size_t position() const { return _pos; }
+
+  private:
+    //! The iterator on the current node.
+    NodeIterator _iter;
+
+    //! The position of the current value in the current node.
+    std::size_t _pos;
+  };
+
+  namespace details
+  {
+    /**
+     *  The base of the \ref region_iterator of the collapsed containers: a
+     *  \ref collapsed_iterator over the region iterator of their tree.
+     */
+    template <typename NodeIterator, typename Value, typename Predicate>
+    struct Collapsed_region : collapsed_iterator<NodeIterator, Value>
+    {
+      Collapsed_region() { }
+
+      explicit Collapsed_region(const NodeIterator& iter)
+        : collapsed_iterator<NodeIterator, Value>(iter) { }
+
+      template <typename OtherIterator, typename OtherValue>
+      Collapsed_region
+      (const collapsed_iterator<OtherIterator, OtherValue>& other)
+        : collapsed_iterator<NodeIterator, Value>(other) { }
+
+      //! Return the region predicate of the iterator.
+      Predicate predicate() const
+      { return this->base().predicate(); }
+    };
+
+    /**
+     *  The base of the \ref neighbor_iterator of the collapsed containers: a
+     *  \ref collapsed_iterator over the neighbor iterator of their tree. The
+     *  values of a node are visited together, at the distance of their key.
+     */
+    template <typename NodeIterator, typename Value>
+    struct Collapsed_neighbor : collapsed_iterator<NodeIterator, Value>
+    {
+      typedef typename NodeIterator::key_type key_type;
+      typedef typename NodeIterator::key_compare key_compare;
+      typedef typename NodeIterator::metric_type metric_type;
+      typedef typename NodeIterator::distance_type distance_type;
+
+      Collapsed_neighbor() { }
+
+      explicit Collapsed_neighbor(const NodeIterator& iter)
+        : collapsed_iterator<NodeIterator, Value>(iter) { }
+
+      template <typename OtherIterator, typename OtherValue>
+      Collapsed_neighbor
+      (const collapsed_iterator<OtherIterator, OtherValue>& other)
+        : collapsed_iterator<NodeIterator, Value>(other) { }
+
+      //! Return the key_comparator used by the iterator
+      key_compare key_comp() const { return this->base().key_comp(); }
+
+      //! Return the metric used by the iterator
+      metric_type metric() const { return this->base().metric(); }
+
+      //! Read-only accessor to the last valid distance of the iterator.
+      distance_type distance() const { return this->base().distance(); }
+
+      //! Read-only accessor to the target of the iterator
+      const key_type& target_key() const { return this->base().target_key(); }
+    };
+  } // namespace details
+
+} // namespace spatial
+
+#endif // SPATIAL_COLLAPSED_ITERATOR_HPP
@@ -0,0 +1,505 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   collapsed_point_multiset.hpp
+ *  Contains the definition of the \collapsed_point_multiset. This container
+ *  stores values in space that can be represented as points, and keeps all
+ *  values with equal keys in a single node of its tree.
+ */
+
+#ifndef SPATIAL_COLLAPSED_POINT_MULTISET_HPP
+#define SPATIAL_COLLAPSED_POINT_MULTISET_HPP
+
+#include <memory>  // std::allocator
+#include "function.hpp"
+#include "region_iterator.hpp"
+#include "neighbor_iterator.hpp"
+#include "bits/spatial_collapsed_kdtree.hpp"
+
+namespace spatial
+{
+  /**
+   *  A multiset of points in which each node of the tree holds one distinct
+   *  key along with all the values inserted with that key.
+   *
+   *  When the values inserted in the container contain many duplicates, such
+   *  as quantized or voxelized coordinates, the tree remains as shallow as
+   *  the number of distinct keys allows, and all duplicates of a key are found
+   *  with a single descent. Iterating the container still visits each value
+   *  that was inserted and \c size() returns the number of values, not the
+   *  number of keys; \c key_count() returns the latter.
+   *
+   *  Since all the values of a node are equal to its key, a node only counts
+   *  them. The \ref region_iterator and \ref neighbor_iterator of the
+   *  container run over the distinct keys of \c tree() and visit each value,
+   *  as a \ref collapsed_iterator does.
+   *
+   *  \see point_multiset
+   */
+  template<dimension_type Rank, typename Key,
+           typename Compare = bracket_less<Key>,
+           typename BalancingPolicy = loose_balancing,
+           typename Alloc = std::allocator<Key> >
+  struct collapsed_point_multiset
+    : details::Collapsed_kdtree<details::Static_rank<Rank>, Key,
+                                const Key, Compare,
+                                BalancingPolicy, Alloc>
+  {
+  private:
+    typedef details::Collapsed_kdtree
+    <details::Static_rank<Rank>, Key, const Key, Compare,
+     BalancingPolicy, Alloc>                  base_type;
+    typedef collapsed_point_multiset<Rank, Key,
+                                     Compare, BalancingPolicy, Alloc> Self;
+
+  public:
+    collapsed_point_multiset() { }
+
+    explicit collapsed_point_multiset(const Compare& compare)
+      : base_type(details::Static_rank<Rank>(), compare)
+    { }
+
+    collapsed_point_multiset(const Compare& compare,
+                             const BalancingPolicy& balancing)
+      : base_type(details::Static_rank<Rank>(), compare, balancing)
+    { }
+
+    collapsed_point_multiset(const Compare& compare,
+                             const BalancingPolicy& balancing,
+                             const Alloc& alloc)
+      : base_type(details::Static_rank<Rank>(), compare, balancing, alloc)
+    { }
+
+    collapsed_point_multiset(const collapsed_point_multiset& other)
+      : base_type(other)
+    { }
+
+    collapsed_point_multiset&
+    operator=(const collapsed_point_multiset& other)
+    { return static_cast<Self&>(base_type::operator=(other)); }
+  };
+
+  /**
+   *  Specialization for \collapsed_point_multiset with runtime rank support.
+   *  The rank of the container can be determined at run time and does not
+   *  need to be fixed at compile time.
+   */
+  template<typename Key, typename Compare, typename BalancingPolicy,
+           typename Alloc>
+  struct collapsed_point_multiset<0, Key, Compare, BalancingPolicy, Alloc>
+    : details::Collapsed_kdtree<details::Dynamic_rank, Key,
+                                const Key, Compare,
+                                BalancingPolicy, Alloc>
+  {
+  private:
+    typedef details::Collapsed_kdtree
+    <details::Dynamic_rank, Key, const Key, Compare,
+     BalancingPolicy, Alloc>                  base_type;
+    typedef collapsed_point_multiset<0, Key,
+                                     Compare, BalancingPolicy, Alloc> Self;
+
+  public:
+    collapsed_point_multiset() { }
+
+    explicit collapsed_point_multiset(dimension_type dim)
+      : base_type(details::Dynamic_rank(dim), Compare())
+    { except::check_rank(dim); }
+
+    collapsed_point_multiset(dimension_type dim, const Compare& compare)
+      : base_type(details::Dynamic_rank(dim), compare)
+    { except::check_rank(dim); }
+
+    collapsed_point_multiset(dimension_type dim, const Compare& compare,
+                             const BalancingPolicy& policy)
+      : base_type(details::Dynamic_rank(dim), compare, policy)
+    { except::check_rank(dim); }
+
+    collapsed_point_multiset(dimension_type dim, const Compare& compare,
+                             const BalancingPolicy& policy,
+                             const Alloc& alloc)
+      : base_type(details::Dynamic_rank(dim), compare, policy, alloc)
+    { except::check_rank(dim); }
+
+    explicit collapsed_point_multiset(const Compare& compare)
+      : base_type(details::Dynamic_rank(), compare)
+    { }
+
+    collapsed_point_multiset(const Compare& compare,
+                                             const BalancingPolicy& policy)
+      : base_type(details::Dynamic_rank(), compare, policy)
+    { }
+
+    collapsed_point_multiset(const Compare& compare,
+                             const BalancingPolicy& policy,
+                             const Alloc& alloc)
+      : base_type(details::Dynamic_rank(), compare, policy, alloc)
+    { }
+
+    collapsed_point_multiset(const collapsed_point_multiset& other)
+      : base_type(other)
+    { }
+
+    collapsed_point_multiset&
+    operator=(const collapsed_point_multiset& other)
+    { return static_cast<Self&>(base_type::operator=(other)); }
+  };
+
+  /**
+   *  Specialization of \ref region_iterator for \collapsed_point_multiset. The
+   *  iterator visits each value held by the nodes of the tree that match the
+   *  region, as a \ref collapsed_iterator over the region iterator of \c
+   *  tree().
+   */
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Balancing, typename Alloc, typename Predicate>
+  class region_iterator<collapsed_point_multiset<Rank, Key, Compare,
+                                                 Balancing, Alloc>,
+                        Predicate>
+    : public details::Collapsed_region
+      <region_iterator<const typename collapsed_point_multiset
+                       <Rank, Key, Compare, Balancing, Alloc>::tree_type,
+                       Predicate>, const Key, Predicate>
+  {
+  private:
+    typedef region_iterator<const typename collapsed_point_multiset
+                            <Rank, Key, Compare, Balancing, Alloc>
+                            ::tree_type, Predicate> node_iterator;
+
+  public:
+    //! Uninitialized iterator.
+    region_iterator() { }
+
+    //! Builds an iterator on the first value of the node of \c iter.
+    explicit region_iterator(const node_iterator& iter)
+      : details::Collapsed_region<node_iterator, const Key, Predicate>(iter)
+    { }
+  };
+
+  /**
+   *  Specialization of \ref region_iterator for constant \ref
+   *  collapsed_point_multiset, which is the same iterator since the values of
+   *  the container are always constant.
+   */
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Balancing, typename Alloc, typename Predicate>
+  class region_iterator<const collapsed_point_multiset<Rank, Key, Compare,
+                                                       Balancing, Alloc>,
+                        Predicate>
+    : public region_iterator<collapsed_point_multiset<Rank, Key, Compare,
+                                                      Balancing, Alloc>,
+                             Predicate>
+  {
+  private:
+    typedef region_iterator<collapsed_point_multiset
+                            <Rank, Key, Compare, Balancing, Alloc>,
+                            Predicate> Base;
+
+  public:
+    //! Uninitialized iterator.
+    region_iterator() { }
+
+    //! Builds an iterator on the first value of the node of \c iter.
+    explicit region_iterator
+    (const region_iterator<const typename collapsed_point_multiset
+                           <Rank, Key, Compare, Balancing, Alloc>
+                           ::tree_type, Predicate>& iter)
+      : Base(iter) { }
+
+    //! Converts a mutable iterator into a constant iterator.
+    region_iterator(const Base& iter) : Base(iter) { }
+  };
+
+  /**
+   *  Specialization of \ref neighbor_iterator for \collapsed_point_multiset.
+   *  The iterator visits each value held by the nodes of the tree by
+   *  increasing distance to the target, as a \ref collapsed_iterator over the
+   *  neighbor iterator of \c tree().
+   */
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Balancing, typename Alloc, typename Metric>
+  class neighbor_iterator<collapsed_point_multiset<Rank, Key, Compare,
+                                                   Balancing, Alloc>,
+                          Metric>
+    : public details::Collapsed_neighbor
+      <neighbor_iterator<const typename collapsed_point_multiset
+                         <Rank, Key, Compare, Balancing, Alloc>
+                         ::tree_type, Metric>, const Key>
+  {
+  private:
+    typedef neighbor_iterator<const typename collapsed_point_multiset
+                              <Rank, Key, Compare, Balancing, Alloc>
+                              ::tree_type, Metric> node_iterator;
+
+  public:
+    //! Uninitialized iterator.
+    neighbor_iterator() { }
+
+    //! Builds an iterator on the first value of the node of \c iter.
+    explicit neighbor_iterator(const node_iterator& iter)
+      : details::Collapsed_neighbor<node_iterator, const Key>(iter) { }
+  };
+
+  /**
+   *  Specialization of \ref neighbor_iterator for constant \ref
+   *  collapsed_point_multiset, which is the same iterator since the values of
+   *  the container are always constant.
+   */
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Balancing, typename Alloc, typename Metric>
+  class neighbor_iterator<const collapsed_point_multiset
+                          <Rank, Key, Compare, Balancing, Alloc>,
+                          Metric>
+    : public neighbor_iterator<collapsed_point_multiset
+                               <Rank, Key, Compare, Balancing, Alloc>,
+                               Metric>
+  {
+  private:
+    typedef neighbor_iterator<collapsed_point_multiset
+                              <Rank, Key, Compare, Balancing, Alloc>,
+                              Metric> Base;
+
+  public:
+    //! Uninitialized iterator.
+    neighbor_iterator() { }
+
+    //! Builds an iterator on the first value of the node of \c iter.
+    explicit neighbor_iterator
+    (const neighbor_iterator<const typename collapsed_point_multiset
+                             <Rank, Key, Compare, Balancing, Alloc>
+                             ::tree_type, Metric>& iter)
+      : Base(iter) { }
+
+    //! Converts a mutable iterator into a constant iterator.
+    neighbor_iterator(const Base& iter) : Base(iter) { }
+  };
+
+  /**
+   *  Overloads of region_begin() and region_end() for \ref
+   *  collapsed_point_multiset. The other region functions, such as
+   *  region_cbegin() or region_range(), call them.
+   */
+  ///@{
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Balancing, typename Alloc,
+            typename Predicate>
+  inline region_iterator<collapsed_point_multiset
+                         <Rank, Key, Compare, Balancing, Alloc>,
+                         Predicate>
+  region_begin
+  (collapsed_point_multiset
+   <Rank, Key, Compare, Balancing, Alloc>& container,
+   const Predicate& pred)
+  {
+    return region_iterator<collapsed_point_multiset
+                           <Rank, Key, Compare, Balancing, Alloc>,
+                           Predicate>
+      (region_begin(container.tree(), pred));
+  }
+
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Balancing, typename Alloc,
+            typename Predicate>
+  inline region_iterator<const collapsed_point_multiset
+                         <Rank, Key, Compare, Balancing, Alloc>,
+                         Predicate>
+  region_begin
+  (const collapsed_point_multiset
+   <Rank, Key, Compare, Balancing, Alloc>& container,
+   const Predicate& pred)
+  {
+    return region_iterator<const collapsed_point_multiset
+                           <Rank, Key, Compare, Balancing, Alloc>,
+                           Predicate>
+      (region_begin(container.tree(), pred));
+  }
+
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Balancing, typename Alloc,
+            typename Predicate>
+  inline region_iterator<collapsed_point_multiset
+                         <Rank, Key, Compare, Balancing, Alloc>,
+                         Predicate>
+  region_end
+  (collapsed_point_multiset
+   <Rank, Key, Compare, Balancing, Alloc>& container,
+   const Predicate& pred)
+  {
+    return region_iterator<collapsed_point_multiset
+                           <Rank, Key, Compare, Balancing, Alloc>,
+                           Predicate>
+      (region_end(container.tree(), pred));
+  }
+
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Balancing, typename Alloc,
+            typename Predicate>
+  inline region_iterator<const collapsed_point_multiset
+                         <Rank, Key, Compare, Balancing, Alloc>,
+                         Predicate>
+  region_end
+  (const collapsed_point_multiset
+   <Rank, Key, Compare, Balancing, Alloc>& container,
+   const Predicate& pred)
+  {
+    return region_iterator<const collapsed_point_multiset
+                           <Rank, Key, Compare, Balancing, Alloc>,
+                           Predicate>
+      (region_end(container.tree(), pred));
+  }
+  ///@}
+
+  /**
+   *  Overloads of neighbor_begin(), neighbor_end(), neighbor_lower_bound()
+   *  and neighbor_upper_bound() for \ref collapsed_point_multiset. The other
+   *  neighbor functions, such as neighbor_cbegin(), neighbor_range(), or the
+   *  overloads that assume an euclidian metric, call them.
+   */
+  ///@{
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Balancing, typename Alloc,
+            typename Metric>
+  inline neighbor_iterator<collapsed_point_multiset
+                           <Rank, Key, Compare, Balancing, Alloc>,
+                           Metric>
+  neighbor_begin
+  (collapsed_point_multiset
+   <Rank, Key, Compare, Balancing, Alloc>& container,
+   const Metric& metric, const Key& target)
+  {
+    return neighbor_iterator<collapsed_point_multiset
+                             <Rank, Key, Compare, Balancing, Alloc>,
+                             Metric>
+      (neighbor_begin(container.tree(), metric, target));
+  }
+
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Balancing, typename Alloc,
+            typename Metric>
+  inline neighbor_iterator<const collapsed_point_multiset
+                           <Rank, Key, Compare, Balancing, Alloc>,
+                           Metric>
+  neighbor_begin
+  (const collapsed_point_multiset
+   <Rank, Key, Compare, Balancing, Alloc>& container,
+   const Metric& metric, const Key& target)
+  {
+    return neighbor_iterator<const collapsed_point_multiset
+                             <Rank, Key, Compare, Balancing, Alloc>,
+                             Metric>
+      (neighbor_begin(container.tree(), metric, target));
+  }
+
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Balancing, typename Alloc,
+            typename Metric>
+  inline neighbor_iterator<collapsed_point_multiset
+                           <Rank, Key, Compare, Balancing, Alloc>,
+                           Metric>
+  neighbor_end
+  (collapsed_point_multiset
+   <Rank, Key, Compare, Balancing, Alloc>& container,
+   const Metric& metric, const Key& target)
+  {
+    return neighbor_iterator<collapsed_point_multiset
+                             <Rank, Key, Compare, Balancing, Alloc>,
+                             Metric>
+      (neighbor_end(container.tree(), metric, target));
+  }
+
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Balancing, typename Alloc,
+            typename Metric>
+  inline neighbor_iterator<const collapsed_point_multiset
+                           <Rank, Key, Compare, Balancing, Alloc>,
+                           Metric>
+  neighbor_end
+  (const collapsed_point_multiset
+   <Rank, Key, Compare, Balancing, Alloc>& container,
+   const Metric& metric, const Key& target)
+  {
+    return neighbor_iterator<const collapsed_point_multiset
+                             <Rank, Key, Compare, Balancing, Alloc>,
+                             Metric>
+      (neighbor_end(container.tree(), metric, target));
+  }
+
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Balancing, typename Alloc,
+            typename Metric>
+  inline neighbor_iterator<collapsed_point_multiset
+                           <Rank, Key, Compare, Balancing, Alloc>,
+                           Metric>
+  neighbor_lower_bound
+  (collapsed_point_multiset
+   <Rank, Key, Compare, Balancing, Alloc>& container,
+   const Metric& metric, const Key& target,
+   typename Metric::distance_type bound)
+  {
+    return neighbor_iterator<collapsed_point_multiset
+                             <Rank, Key, Compare, Balancing, Alloc>,
+                             Metric>
+      (neighbor_lower_bound(container.tree(), metric, target, bound));
+  }
+
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Balancing, typename Alloc,
+            typename Metric>
+  inline neighbor_iterator<const collapsed_point_multiset
+                           <Rank, Key, Compare, Balancing, Alloc>,
+                           Metric>
+  neighbor_lower_bound
+  (const collapsed_point_multiset
+   <Rank, Key, Compare, Balancing, Alloc>& container,
+   const Metric& metric, const Key& target,
+   typename Metric::distance_type bound)
+  {
+    return neighbor_iterator<const collapsed_point_multiset
+                             <Rank, Key, Compare, Balancing, Alloc>,
+                             Metric>
+      (neighbor_lower_bound(container.tree(), metric, target, bound));
+  }
+
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Balancing, typename Alloc,
+            typename Metric>
+  inline neighbor_iterator<collapsed_point_multiset
+                           <Rank, Key, Compare, Balancing, Alloc>,
+                           Metric>
+  neighbor_upper_bound
+  (collapsed_point_multiset
+   <Rank, Key, Compare, Balancing, Alloc>& container,
+   const Metric& metric, const Key& target,
+   typename Metric::distance_type bound)
+  {
+    return neighbor_iterator<collapsed_point_multiset
+                             <Rank, Key, Compare, Balancing, Alloc>,
+                             Metric>
+      (neighbor_upper_bound(container.tree(), metric, target, bound));
+  }
+
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Balancing, typename Alloc,
+            typename Metric>
+  inline neighbor_iterator<const collapsed_point_multiset
+                           <Rank, Key, Compare, Balancing, Alloc>,
+                           Metric>
+  neighbor_upper_bound
+  (const collapsed_point_multiset
+   <Rank, Key, Compare, Balancing, Alloc>& container,
+   const Metric& metric, const Key& target,
+   typename Metric::distance_type bound)
+  {
+    return neighbor_iterator<const collapsed_point_multiset
+                             <Rank, Key, Compare, Balancing, Alloc>,
+                             Metric>
+      (neighbor_upper_bound(container.tree(), metric, target, bound));
+  }
+  ///@}
+}
+
+#endif // SPATIAL_COLLAPSED_POINT_MULTISET_HPP
@@ -0,0 +1,284 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   diagnostics.hpp
+ *  Provides \ref spatial::diagnose(), which reports on the shape of the tree
+ *  of a container: the depths of its leaves, the balance of its nodes level
+ *  by level, its most unbalanced node and an estimate of its memory.
+ *
+ *  It applies to the containers built on \ref spatial::details::Kdtree, such
+ *  as \idle_point_multiset, and on \ref spatial::details::Relaxed_kdtree,
+ *  such as \point_multiset. It visits all the nodes of the tree once, without
+ *  recursion, and allocates memory only for the results. For example, an
+ *  idle container could be rebalanced when its tree has grown too deep:
+ *
+ *  \code
+ *    if (diagnose(points).depth_ratio() > 2.0) { points.rebalance(); }
+ *  \endcode
+ */
+
+#ifndef SPATIAL_DIAGNOSTICS_HPP
+#define SPATIAL_DIAGNOSTICS_HPP
+
+#include <cstddef> // std::size_t
+#include <vector>
+#include <utility> // std::pair
+#include <limits> // std::numeric_limits
+#include "spatial.hpp"
+#include "bits/spatial_node.hpp"
+#include "bits/spatial_assert.hpp"
+
+namespace spatial
+{
+  /**
+   *  The balance of the nodes found at one level of a tree.
+   *
+   *  The imbalance of a node whose subtrees hold \c l and \c r nodes is \c
+   *  |l-r|/(l+r+1): 0 when both subtrees have the same weight, close to 1
+   *  when one of them is empty and the other is large. Leaves are not
+   *  counted in the imbalance.
+   */
+  struct level_balance
+  {
+    level_balance()
+      : nodes(0), leaves(0), mean_imbalance(0.0), max_imbalance(0.0) { }
+
+    //! The number of nodes at this level, leaves included.
+    std::size_t nodes;
+    //! The number of leaves at this level.
+    std::size_t leaves;
+    //! The mean of the imbalance of the nodes that are not leaves.
+    double mean_imbalance;
+    //! The highest imbalance of the nodes at this level.
+    double max_imbalance;
+  };
+
+  /**
+   *  The report returned by \ref diagnose() on the tree of a \c Container.
+   *
+   *  Depths count the nodes on the path from the root, so that the root is
+   *  at depth 1, as in \ref minmax_depth(). The vectors are indexed by depth,
+   *  and their first element, for depth 0, is always empty.
+   */
+  template <typename Container>
+  struct tree_diagnostics
+  {
+    tree_diagnostics()
+      : size(0), leaves(0), min_depth(0), max_depth(0), mean_depth(0.0),
+        worst(), worst_depth(0), worst_left(0), worst_right(0),
+        node_size(0), value_size(0), capacity(0),
+        container_size(sizeof(Container)) { }
+
+    //! The number of nodes in the tree.
+    std::size_t size;
+    //! The number of leaves in the tree.
+    std::size_t leaves;
+    //! The depth of the leaf nearest to the root, 0 for an empty tree.
+    std::size_t min_depth;
+    //! The depth of the leaf furthest from the root, 0 for an empty tree.
+    std::size_t max_depth;
+    //! The mean depth of the leaves.
+    double mean_depth;
+    //! The number of leaves found at each depth.
+    std::vector<std::size_t> depth_histogram;
+    //! The balance of the nodes found at each depth.
+    std::vector<level_balance> levels;
+
+    //! The node with the largest difference in weight between its left and
+    //! right subtrees, the nearest to the root among equals, or the end of
+    //! the container if it is empty.
+    typename Container::const_iterator worst;
+    //! The depth of \c worst.
+    std::size_t worst_depth;
+    //! The number of nodes in the left subtree of \c worst.
+    std::size_t worst_left;
+    //! The number of nodes in the right subtree of \c worst.
+    std::size_t worst_right;
+
+    //! The size of a node in memory.
+    std::size_t node_size;
+    //! The size of a value, if it is allocated apart from its node, as done
+    //! by \ref cold_storage, otherwise 0.
+    std::size_t value_size;
+    //! The number of nodes allocated, including the nodes reserved in
+    //! advance.
+    std::size_t capacity;
+    //! The size of the container itself, which holds the header of the tree.
+    std::size_t container_size;
+
+    /**
+     *  Returns the depth of a tree of the same size that is perfectly
+     *  balanced.
+     */
+    std::size_t optimal_depth() const
+    {
+      std::size_t depth = 0;
+      for (std::size_t n = size; n != 0; n >>= 1) { ++depth; }
+      return depth;
+    }
+
+    /**
+     *  Returns the ratio of \c max_depth to \ref optimal_depth(), which is 1
+     *  for a perfectly balanced tree and grows as the tree degrades, or 1 if
+     *  the tree is empty.
+     */
+    double depth_ratio() const
+    {
+      return size == 0 ? 1.0
+        : static_cast<double>(max_depth)
+        / static_cast<double>(optimal_depth());
+    }
+
+    /**
+     *  Returns an estimate of the memory used by the container, in bytes.
+     *
+     *  \param allocation_overhead The memory used by the allocator for each
+     *  allocation in addition to the memory requested, which depends on the
+     *  allocator: the default is typical of \c malloc.
+     */
+    std::size_t memory(std::size_t allocation_overhead
+                       = 2 * sizeof(void*)) const
+    {
+      return container_size + capacity * (node_size + allocation_overhead)
+        + (value_size == 0 ? 0 : size * (value_size + allocation_overhead));
+    }
+  };
+
+  namespace details
+  {
+    //! Returns the size of the nodes of type \c Link.
+    template <typename Link>
+    inline std::size_t
+    node_size(const Node<Link>*)
+    { return sizeof(Link); }
+
+    //! Returns 0, since values are held in the nodes.
+    template <typename Link>
+    inline std::size_t
+    separate_value_size(const Node<Link>*)
+    { return 0; }
+
+    //! Returns the size of the values allocated apart from the nodes.
+    template <typename Key, typename Value>
+    inline std::size_t
+    separate_value_size(const Node<Relaxed_kdtree_cold_link<Key, Value> >*)
+    { return sizeof(Value); }
+
+    /**
+     *  Adds the node with subtrees of weights \c left and \c right at \c
+     *  depth to \c diag.
+     */
+    template <typename Container, typename NodePtr>
+    inline void
+    diagnose_node(tree_diagnostics<Container>& diag, NodePtr node,
+                  std::size_t depth, std::size_t left, std::size_t right)
+    {
+      if (diag.levels.size() <= depth)
+        {
+          diag.levels.resize(depth + 1);
+          diag.depth_histogram.resize(depth + 1, 0);
+        }
+      level_balance& level = diag.levels[depth];
+      ++level.nodes;
+      ++diag.size;
+      if (left == 0 && right == 0)
+        {
+          ++level.leaves;
+          ++diag.leaves;
+          ++diag.depth_histogram[depth];
+          if (depth < diag.min_depth) diag.min_depth = depth;
+          if (depth > diag.max_depth) diag.max_depth = depth;
+          diag.mean_depth += static_cast<double>(depth);
+          return;
+        }
+      std::size_t diff = left < right ? right - left : left - right;
+      double imbalance = static_cast<double>(diff)
+        / static_cast<double>(left + right + 1);
+      level.mean_imbalance += imbalance; // divided at the end
+      if (imbalance > level.max_imbalance) level.max_imbalance = imbalance;
+      std::size_t worst = diag.worst_left < diag.worst_right
+        ? diag.worst_right - diag.worst_left
+        : diag.worst_left - diag.worst_right;
+      if (diag.worst_depth == 0 || diff > worst
+          || (diff == worst && depth < diag.worst_depth))
+        {
+          diag.worst = typename Container::const_iterator(node);
+          diag.worst_depth = depth;
+          diag.worst_left = left;
+          diag.worst_right = right;
+        }
+    }
+  } // namespace details
+
+  /**
+   *  Returns a report on the shape of the tree of \c container, and an
+   *  estimate of its memory.
+   *
+   *  \param container The container built on a \ref details::Kdtree or on a
+   *  \ref details::Relaxed_kdtree to inspect.
+   *
+   *  \fractime
+   */
+  template <typename Container>
+  inline tree_diagnostics<Container>
+  diagnose(const Container& container)
+  {
+    typedef typename Container::const_iterator::node_ptr node_ptr;
+    tree_diagnostics<Container> diag;
+    diag.worst = container.end();
+    node_ptr end = container.end().node;
+    diag.node_size = details::node_size(end);
+    diag.value_size = details::separate_value_size(end);
+    diag.capacity = container.capacity();
+    node_ptr node = end->parent;
+    if (header(node)) return diag;
+    diag.min_depth = std::numeric_limits<std::size_t>::max();
+    // Post-order traversal through the parent links. For each node on the
+    // path from the root, the weights of its subtrees already visited.
+    std::vector<std::pair<std::size_t, std::size_t> > path;
+    node_ptr prev = end;
+    while (!header(node))
+      {
+        if (prev == node->parent)
+          {
+            path.push_back(std::pair<std::size_t, std::size_t>(0, 0));
+            if (node->left != 0)
+              { prev = node; node = node->left; continue; }
+            if (node->right != 0)
+              { prev = node; node = node->right; continue; }
+          }
+        else if (prev == node->left && node->right != 0)
+          { prev = node; node = node->right; continue; }
+        // Both subtrees are visited
+        std::pair<std::size_t, std::size_t> weights = path.back();
+        path.pop_back();
+        details::diagnose_node(diag, node, path.size() + 1,
+                               weights.first, weights.second);
+        std::size_t weight = weights.first + weights.second + 1;
+        if (!path.empty())
+          {
+            if (node->parent->left == node) path.back().first = weight;
+            else path.back().second = weight;
+          }
+        prev = node;
+        node = node->parent;
+      }
+    SPATIAL_ASSERT_CHECK(path.empty());
+    SPATIAL_ASSERT_CHECK(diag.size == container.size());
+    diag.mean_depth /= static_cast<double>(diag.leaves);
+    for (std::vector<level_balance>::iterator i = diag.levels.begin();
+         i != diag.levels.end(); ++i)
+      {
+        if (i->nodes != i->leaves)
+          { i->mean_imbalance /= static_cast<double>(i->nodes - i->leaves); }
+      }
+    return diag;
+  }
+} // namespace spatial
+
+#endif // SPATIAL_DIAGNOSTICS_HPP
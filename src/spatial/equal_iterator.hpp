@@ -15,8 +15,10 @@
 
 #include "spatial.hpp"
 #include "bits/spatial_equal.hpp"
+#include "bits/spatial_rank.hpp"
 #include "bits/spatial_bidirectional.hpp"
 #include "bits/spatial_compress.hpp"
+#include "bits/spatial_check_concept.hpp"
 
 namespace spatial
 {
@@ -26,9 +28,13 @@ namespace spatial
    *  constructor. The given key is called the model.
    *
    *  \tparam Container The container upon which these iterator relate to.
+   *  \tparam Query The type of the model, which differs from the key type of
+   *  the container only if its \c key_compare is transparent, such as \ref
+   *  bracket_less<void>.
    *  \headerfile equal_iterator.hpp
    */
-  template <typename Container>
+  template <typename Container,
+            typename Query = typename Container::key_type>
   class equal_iterator
     : public details::Bidirectional_iterator
       <typename Container::mode_type,
@@ -73,15 +79,16 @@ namespace spatial
      *  \param container The container being iterated.
      */
     equal_iterator
-    (Container& container, const key_type& value, dimension_type dim,
+    (Container& container, const Query& value, dimension_type dim,
      typename Container::mode_type::node_ptr ptr)
       : Base(container.rank(), ptr, dim), _data(container.key_comp(), value)
     { }
 
     //! Increments the iterator and returns the incremented value. Prefer to
     //! use this form in \c for loops.
-    equal_iterator<Container>& operator++()
+    equal_iterator<Container, Query>& operator++()
     {
+      details::Stats_scope scope(*this);
       import::tie(node, node_dim)
         = increment_equal(node, node_dim, rank(), _data.base(), _data());
       return *this;
@@ -89,9 +96,10 @@ namespace spatial
 
     //! Increments the iterator but returns the value of the iterator before
     //! the increment. Prefer to use the other form in \c for loops.
-    equal_iterator<Container> operator++(int)
+    equal_iterator<Container, Query> operator++(int)
     {
-      equal_iterator<Container> x(*this);
+      details::Stats_scope scope(*this);
+      equal_iterator<Container, Query> x(*this);
       import::tie(node, node_dim)
         = increment_equal(node, node_dim, rank(), _data.base(), _data());
       return x;
@@ -99,8 +107,9 @@ namespace spatial
 
     //! Decrements the iterator and returns the decremented value. Prefer to
     //! use this form in \c for loops.
-    equal_iterator<Container>& operator--()
+    equal_iterator<Container, Query>& operator--()
     {
+      details::Stats_scope scope(*this);
       import::tie(node, node_dim)
         = decrement_equal(node, node_dim, rank(), _data.base(), _data());
       return *this;
@@ -108,23 +117,24 @@ namespace spatial
 
     //! Decrements the iterator but returns the value of the iterator before
     //! the decrement. Prefer to use the other form in \c for loops.
-    equal_iterator<Container> operator--(int)
+    equal_iterator<Container, Query> operator--(int)
     {
-      equal_iterator<Container> x(*this);
+      details::Stats_scope scope(*this);
+      equal_iterator<Container, Query> x(*this);
       import::tie(node, node_dim)
         = decrement_equal(node, node_dim, rank(), _data.base(), _data());
       return x;
     }
 
     //! Return the value of key used to find equal keys in the container.
-    key_type value() const { return _data(); }
+    Query value() const { return _data(); }
 
     //! Return the functor used to compare keys in this iterator.
     key_compare key_comp() const { return _data.base(); }
 
   private:
     //! The model key used to find equal keys in the container.
-    details::Compress<key_compare, key_type> _data;
+    details::Compress<key_compare, Query> _data;
   };
 
   /**
@@ -136,8 +146,8 @@ namespace spatial
    *
    *  \tparam Ct The container upon which these iterator relate to.
    */
-  template <typename Container>
-  class equal_iterator<const Container>
+  template <typename Container, typename Query>
+  class equal_iterator<const Container, Query>
     : public details::Const_bidirectional_iterator
       <typename Container::mode_type,
        typename Container::rank_type>
@@ -178,20 +188,21 @@ namespace spatial
      *  \param ptr A pointer to a node belonging to \c container.
      */
     equal_iterator
-    (const Container& container, const key_type& value, dimension_type dim,
+    (const Container& container, const Query& value, dimension_type dim,
      typename Container::mode_type::const_node_ptr ptr)
       : Base(container.rank(), ptr, dim), _data(container.key_comp(), value)
     { }
 
     //! Convertion of an iterator into a const_iterator is permitted.
-    equal_iterator(const equal_iterator<Container>& iter)
-      : Base(iter.rank(), iter.node, iter.node_dim),
+    equal_iterator(const equal_iterator<Container, Query>& iter)
+      : Base(iter.rank(), iter.node, iter.node_dim, iter),
         _data(iter.key_comp(), iter.value()) { }
 
     //! Increments the iterator and returns the incremented value. Prefer to
     //! use this form in \c for loops.
-    equal_iterator<const Container>& operator++()
+    equal_iterator<const Container, Query>& operator++()
     {
+      details::Stats_scope scope(*this);
       import::tie(node, node_dim)
         = increment_equal(node, node_dim, rank(), _data.base(), _data());
       return *this;
@@ -199,9 +210,10 @@ namespace spatial
 
     //! Increments the iterator but returns the value of the iterator before
     //! the increment. Prefer to use the other form in \c for loops.
-    equal_iterator<const Container> operator++(int)
+    equal_iterator<const Container, Query> operator++(int)
     {
-      equal_iterator<const Container> x(*this);
+      details::Stats_scope scope(*this);
+      equal_iterator<const Container, Query> x(*this);
       import::tie(node, node_dim)
         = increment_equal(node, node_dim, rank(), _data.base(), _data());
       return x;
@@ -209,8 +221,9 @@ namespace spatial
 
     //! Decrements the iterator and returns the decremented value. Prefer to
     //! use this form in \c for loops.
-    equal_iterator<const Container>& operator--()
+    equal_iterator<const Container, Query>& operator--()
     {
+      details::Stats_scope scope(*this);
       import::tie(node, node_dim)
         = decrement_equal(node, node_dim, rank(), _data.base(), _data());
       return *this;
@@ -218,23 +231,24 @@ namespace spatial
 
     //! Decrements the iterator but returns the value of the iterator before
     //! the decrement. Prefer to use the other form in \c for loops.
-    equal_iterator<const Container> operator--(int)
+    equal_iterator<const Container, Query> operator--(int)
     {
-      equal_iterator<const Container> x(*this);
+      details::Stats_scope scope(*this);
+      equal_iterator<const Container, Query> x(*this);
       import::tie(node, node_dim)
-        = preorder_decrement(node, node_dim, rank(), _data.base(), _data());
+        = decrement_equal(node, node_dim, rank(), _data.base(), _data());
       return x;
     }
 
     //! Returns the value used to find equivalent keys in the container.
-    key_type value() const { return _data(); }
+    Query value() const { return _data(); }
 
     //! Returns the functor used to compare keys in this iterator.
     key_compare key_comp() const { return _data.base(); }
 
   private:
     //! The model key used to find equal keys in the container.
-    details::Compress<key_compare, key_type> _data;
+    details::Compress<key_compare, Query> _data;
   };
 
   /**
@@ -262,6 +276,31 @@ namespace spatial
   equal_cend(const Container& container,
              const typename equal_iterator<Container>::key_type& value)
   { return equal_end(container, value); }
+
+  /**
+   *  Overloads of equal_end() for a \c value of another type than the key
+   *  type of \c container, which are available only if its \c key_compare
+   *  is transparent, such as \ref bracket_less<void>.
+   */
+  template <typename Container, typename Query>
+  inline typename enable_if_c
+  <details::is_transparent_query<typename Container::key_compare, Query,
+                                 typename Container::key_type>::value,
+   equal_iterator<Container, Query> >::type
+  equal_end(Container& container, const Query& value)
+  {
+    return equal_iterator<Container, Query>
+      (container, value, container.dimension() - 1,
+       container.end().node); // At header, dim = rank - 1
+  }
+
+  template <typename Container, typename Query>
+  inline typename enable_if_c
+  <details::is_transparent_query<typename Container::key_compare, Query,
+                                 typename Container::key_type>::value,
+   equal_iterator<const Container, Query> >::type
+  equal_cend(const Container& container, const Query& value)
+  { return equal_end(container, value); }
   ///@}
 
   /**
@@ -280,13 +319,16 @@ namespace spatial
               const typename equal_iterator<Container>::key_type& value)
   {
     if (container.empty()) return equal_end(container, value);
+    details::Stats_scope scope;
     typename equal_iterator<Container>::node_ptr node
-      = container.end().node->parent;
-    dimension_type depth;
-    import::tie(node, depth)
+      = details::descend(container.end().node->parent);
+    dimension_type dim;
+    import::tie(node, dim)
       = first_equal(node, 0, container.rank(),
                     container.key_comp(), value);
-    return equal_iterator<Container>(container, value, depth, node);
+    equal_iterator<Container> iter(container, value, dim, node);
+    scope.close(iter);
+    return iter;
   }
 
   template <typename Container>
@@ -294,6 +336,40 @@ namespace spatial
   equal_cbegin(const Container& container,
                const typename equal_iterator<Container>::key_type& value)
   { return equal_begin(container, value); }
+
+  /**
+   *  Overloads of equal_begin() for a \c value of another type than the key
+   *  type of \c container, which are available only if its \c key_compare
+   *  is transparent, such as \ref bracket_less<void>. The iterator stores
+   *  \c value, and no key of the container is built.
+   */
+  template <typename Container, typename Query>
+  inline typename enable_if_c
+  <details::is_transparent_query<typename Container::key_compare, Query,
+                                 typename Container::key_type>::value,
+   equal_iterator<Container, Query> >::type
+  equal_begin(Container& container, const Query& value)
+  {
+    if (container.empty()) return equal_end(container, value);
+    details::Stats_scope scope;
+    typename equal_iterator<Container, Query>::node_ptr node
+      = details::descend(container.end().node->parent);
+    dimension_type dim;
+    import::tie(node, dim)
+      = first_equal(node, 0, container.rank(),
+                    container.key_comp(), value);
+    equal_iterator<Container, Query> iter(container, value, dim, node);
+    scope.close(iter);
+    return iter;
+  }
+
+  template <typename Container, typename Query>
+  inline typename enable_if_c
+  <details::is_transparent_query<typename Container::key_compare, Query,
+                                 typename Container::key_type>::value,
+   equal_iterator<const Container, Query> >::type
+  equal_cbegin(const Container& container, const Query& value)
+  { return equal_begin(container, value); }
   ///@}
 
   /**
@@ -390,46 +466,44 @@ namespace spatial
     template <typename NodePtr, typename Rank, typename KeyCompare,
               typename Key>
     inline std::pair<NodePtr, dimension_type>
-    last_equal(NodePtr node, dimension_type depth, const Rank rank,
+    last_equal(NodePtr node, dimension_type dim, const Rank rank,
                const KeyCompare& key_comp, const Key& key)
     {
       SPATIAL_ASSERT_CHECK(!header(node));
       SPATIAL_ASSERT_CHECK(node != 0);
       for (;;)
         {
-          dimension_type dim = depth % rank();
-          if (!key_comp(dim, key, const_key(node)) && node->right != 0)
-            { node = node->right; ++depth; }
-          else if (!key_comp(dim, const_key(node), key) && node->left != 0)
-            { node = node->left; ++depth; }
+          if (node->right != 0
+              && explore(equal_right(node, dim, key_comp, key)))
+            { node = descend(node->right); dim = incr_dim(rank, dim); }
+          else if (node->left != 0
+                   && explore(equal_left(node, dim, key_comp, key)))
+            { node = descend(node->left); dim = incr_dim(rank, dim); }
           else break;
         }
       for (;;)
         {
           dimension_type test = 0;
-          for(; test < rank() && !(key_comp(test, key, const_key(node))
-                                   || key_comp(test, const_key(node), key));
+          for(; test < rank() && equal_key(node, test, key_comp, key);
               ++test);
           if (test == rank())
-            { return std::make_pair(node, depth); }
+            { return std::make_pair(node, dim); }
           NodePtr prev_node = node;
-          node = node->parent; --depth;
+          node = climb(node); dim = decr_dim(rank, dim);
           if (header(node))
-            { return std::make_pair(node, depth); }
-          if (node->right == prev_node
-              && !key_comp(depth % rank(), const_key(node), key)
-              && node->left != 0)
+            { return std::make_pair(node, dim); }
+          if (node->right == prev_node && node->left != 0
+              && explore(equal_left(node, dim, key_comp, key)))
             {
-              node = node->left; ++depth;
+              node = descend(node->left); dim = incr_dim(rank, dim);
               for (;;)
                 {
-                  dimension_type dim = depth % rank();
-                  if (!key_comp(dim, key, const_key(node))
-                      && node->right != 0)
-                    { node = node->right; ++depth; }
-                  else if (!key_comp(dim, const_key(node), key)
-                           && node->left != 0)
-                    { node = node->left; ++depth; }
+                  if (node->right != 0
+                      && explore(equal_right(node, dim, key_comp, key)))
+                    { node = descend(node->right); dim = incr_dim(rank, dim); }
+                  else if (node->left != 0
+                           && explore(equal_left(node, dim, key_comp, key)))
+                    { node = descend(node->left); dim = incr_dim(rank, dim); }
                   else break;
                 }
             }
@@ -439,85 +513,127 @@ namespace spatial
     template <typename NodePtr, typename Rank, typename KeyCompare,
               typename Key>
     inline std::pair<NodePtr, dimension_type>
-    increment_equal(NodePtr node, dimension_type depth, const Rank rank,
+    increment_equal(NodePtr node, dimension_type dim, const Rank rank,
                     const KeyCompare& key_comp, const Key& key)
     {
       SPATIAL_ASSERT_CHECK(!header(node));
       SPATIAL_ASSERT_CHECK(node != 0);
       for (;;)
         {
-          dimension_type dim = depth % rank();
-          if (!key_comp(dim, const_key(node), key)
-              && node->left != 0)
-            { node = node->left; ++depth; }
-          else if (!key_comp(dim, key, const_key(node))
-                   && node->right != 0)
-            { node = node->right; ++depth; }
+          if (node->left != 0
+              && explore(equal_left(node, dim, key_comp, key)))
+            { node = descend(node->left); dim = incr_dim(rank, dim); }
+          else if (node->right != 0
+                   && explore(equal_right(node, dim, key_comp, key)))
+            { node = descend(node->right); dim = incr_dim(rank, dim); }
           else
             {
               NodePtr prev_node = node;
-              node = node->parent; --depth;
+              node = climb(node); dim = decr_dim(rank, dim);
               while (!header(node)
-                     && (prev_node == node->right
-                         || key_comp(depth % rank(), key, const_key(node))
-                         || node->right == 0))
+                     && (prev_node == node->right || node->right == 0
+                         || !explore(equal_right(node, dim, key_comp, key))))
                 {
                   prev_node = node;
-                  node = node->parent; --depth;
+                  node = climb(node); dim = decr_dim(rank, dim);
                 }
               if (!header(node))
-                { node = node->right; ++depth; }
-              else { return std::make_pair(node, depth); }
+                { node = descend(node->right); dim = incr_dim(rank, dim); }
+              else { return std::make_pair(node, dim); }
             }
           dimension_type test = 0;
-          for(; test < rank() && !(key_comp(test, key, const_key(node))
-                                   || key_comp(test, const_key(node), key));
+          for(; test < rank() && equal_key(node, test, key_comp, key);
               ++test);
           if (test == rank())
-            { return std::make_pair(node, depth); }
+            { return std::make_pair(node, dim); }
         }
     }
 
     template <typename NodePtr, typename Rank, typename KeyCompare,
               typename Key>
     inline std::pair<NodePtr, dimension_type>
-    decrement_equal(NodePtr node, dimension_type depth, const Rank rank,
+    decrement_equal(NodePtr node, dimension_type dim, const Rank rank,
                     const KeyCompare& key_comp, const Key& key)
     {
       if (header(node))
-        { return last_equal(node->parent, 0, rank, key_comp, key); }
+        { return last_equal(descend(node->parent), 0, rank, key_comp, key); }
       SPATIAL_ASSERT_CHECK(node != 0);
       NodePtr prev_node = node;
-      node = node->parent; --depth;
+      node = climb(node); dim = decr_dim(rank, dim);
       while (!header(node))
         {
-          if (node->right == prev_node
-              && !key_comp(depth % rank(), const_key(node), key)
-              && node->left != 0)
+          if (node->right == prev_node && node->left != 0
+              && explore(equal_left(node, dim, key_comp, key)))
             {
-              node = node->left; ++depth;
+              node = descend(node->left); dim = incr_dim(rank, dim);
               for (;;)
                 {
-                  dimension_type dim = depth % rank();
-                  if (!key_comp(dim, key, const_key(node))
-                      && node->right != 0)
-                    { node = node->right; ++depth; }
-                  else if (!key_comp(dim, const_key(node), key)
-                           && node->left != 0)
-                    { node = node->left; ++depth; }
+                  if (node->right != 0
+                      && explore(equal_right(node, dim, key_comp, key)))
+                    { node = descend(node->right); dim = incr_dim(rank, dim); }
+                  else if (node->left != 0
+                           && explore(equal_left(node, dim, key_comp, key)))
+                    { node = descend(node->left); dim = incr_dim(rank, dim); }
                   else break;
                 }
             }
           dimension_type test = 0;
-          for(; test < rank() && !(key_comp(test, key, const_key(node))
-                                   || key_comp(test, const_key(node), key));
+          for(; test < rank() && equal_key(node, test, key_comp, key);
               ++test);
           if (test == rank()) break;
           prev_node = node;
-          node = node->parent; --depth;
+          node = climb(node); dim = decr_dim(rank, dim);
         }
-      return std::make_pair(node, depth);
+      return std::make_pair(node, dim);
+    }
+
+    /**
+     *  \name Dispatch of \dynamic_rank
+     *
+     *  Overloads of the equal traversals for \dynamic_rank. If the rank of the
+     *  container is listed in \ref SPATIAL_DISPATCH_RANKS, the traversal is
+     *  carried out with the equivalent \static_rank.
+     */
+    ///@{
+    template <typename NodePtr, typename KeyCompare, typename Key>
+    inline std::pair<NodePtr, dimension_type>
+    last_equal(NodePtr node, dimension_type dim, Dynamic_rank rank,
+               const KeyCompare& key_comp, const Key& key)
+    {
+#     define SPATIAL_RANK_DISPATCH_CALL(r) \
+        last_equal(node, dim, r, key_comp, key)
+      SPATIAL_RANK_DISPATCH(rank)
+#     undef SPATIAL_RANK_DISPATCH_CALL
+      return last_equal<NodePtr, Dynamic_rank, KeyCompare, Key>
+        (node, dim, rank, key_comp, key);
+    }
+
+    template <typename NodePtr, typename KeyCompare, typename Key>
+    inline std::pair<NodePtr, dimension_type>
+    increment_equal(NodePtr node, dimension_type dim, Dynamic_rank rank,
+                    const KeyCompare& key_comp, const Key& key)
+    {
+#     define SPATIAL_RANK_DISPATCH_CALL(r) \
+        increment_equal(node, dim, r, key_comp, key)
+      SPATIAL_RANK_DISPATCH(rank)
+#     undef SPATIAL_RANK_DISPATCH_CALL
+      return increment_equal<NodePtr, Dynamic_rank, KeyCompare, Key>
+        (node, dim, rank, key_comp, key);
+    }
+
+    template <typename NodePtr, typename KeyCompare, typename Key>
+    inline std::pair<NodePtr, dimension_type>
+    decrement_equal(NodePtr node, dimension_type dim, Dynamic_rank rank,
+                    const KeyCompare& key_comp, const Key& key)
+    {
+#     define SPATIAL_RANK_DISPATCH_CALL(r) \
+        decrement_equal(node, dim, r, key_comp, key)
+      SPATIAL_RANK_DISPATCH(rank)
+#     undef SPATIAL_RANK_DISPATCH_CALL
+      return decrement_equal<NodePtr, Dynamic_rank, KeyCompare, Key>
+        (node, dim, rank, key_comp, key);
     }
+    ///@}
 
   } // namespace details
 } // namespace spatial
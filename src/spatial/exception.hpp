@@ -100,6 +100,19 @@ namespace spatial
       : std::logic_error(arg) { }
   };
 
+  /**
+   *  Thrown to report that a coordinate cannot be represented in the Morton
+   *  code of a \ref morton_point_multiset, or in the integers of a \ref
+   *  quantizer.
+   *  \see except::check_morton_coordinate()
+   *  \see except::check_quantized_coordinate()
+   */
+  struct invalid_coordinate : std::logic_error
+  {
+    explicit invalid_coordinate(const std::string& arg)
+      : std::logic_error(arg) { }
+  };
+
   /**
    *  Thrown to report that an negative distance has been passed as a parameter
    *  while distances are expected to be positive.
@@ -14,6 +14,7 @@
 #define SPATIAL_FUNCTION_HPP
 
 #include <iterator> // std::advance
+#include <functional> // std::hash
 #include "spatial.hpp"
 
 namespace spatial
@@ -65,6 +66,30 @@ namespace spatial
     { return x[n] - y[n]; }
   };
 
+  /**
+   *  A transparent version of \ref bracket_minus, which computes the
+   *  difference between 2 objects of any types that have coordinates
+   *  accessible via the bracket operator, such as a key of a container and
+   *  a \c std::array used as the target of a search.
+   *
+   *  \concept_difference
+   */
+  template <typename Unit>
+  struct bracket_minus<void, Unit>
+  {
+    typedef void is_transparent;
+
+    bracket_minus() { }
+
+    template <typename AnyUnit>
+    bracket_minus(const bracket_minus<void, AnyUnit>&) { }
+
+    template <typename Xp, typename Yp>
+    Unit
+    operator() (dimension_type n, const Xp& x, const Yp& y) const
+    { return x[n] - y[n]; }
+  };
+
   /**
    *  \brief This functor uses the minus operator to calculate the difference
    *  between 2 elements of Tp along the dimension \c n accessed through the
@@ -175,6 +200,36 @@ namespace spatial
     }
   };
 
+  /**
+   *  A transparent version of \ref bracket_less, which compares objects of
+   *  any types that have coordinates accessible via the bracket operator.
+   *  With this comparator, \ref find(), \ref make_bounds(), \ref
+   *  equal_begin() and the neighbor iterators accept query keys of a type
+   *  that differs from the key type of the container, and no key is built
+   *  for each query.
+   *
+   *  \concept_generalized_compare
+   */
+  template <>
+  struct bracket_less<void>
+  {
+    typedef void is_transparent;
+
+    template <typename Xp, typename Yp>
+    bool
+    operator() (dimension_type n, const Xp& x, const Yp& y) const
+    {
+      return (x[n] < y[n]);
+    }
+
+    template <typename Xp, typename Yp>
+    bool operator()
+    (dimension_type a, const Xp& x, dimension_type b, const Yp& y) const
+    {
+      return (x[a] < y[b]);
+    }
+  };
+
   /**
    *  A comparator that simplifies using the spatial containers with a Key type
    *  that has coordiates accessible via the parenthesis operator.
@@ -237,6 +292,129 @@ namespace spatial
     }
   };
 
+  /**
+   *  An accessor that returns the coordinates of a key of type Tp, accessed
+   *  through the bracket operator, after casting them into the type \c Unit.
+   *
+   *  It is the default accessor of \ref morton_point_multiset, and may be
+   *  used with \ref accessor_less or \ref accessor_hash.
+   */
+  template <typename Tp, typename Unit>
+  struct bracket_accessor
+  {
+    Unit
+    operator() (dimension_type n, const Tp& x) const
+    { return static_cast<Unit>(x[n]); }
+  };
+
+  namespace details
+  {
+    /**
+     *  Mixes the hash \c value of one coordinate into the hash \c seed of the
+     *  coordinates that preceded it.
+     */
+    inline std::size_t
+    hash_combine(std::size_t seed, std::size_t value)
+    { return seed ^ (value + 0x9e3779b9u + (seed << 6) + (seed >> 2)); }
+  }
+
+  /**
+   *  This functor hashes all the coordinates of a key of type Tp, accessed
+   *  through the bracket operator, after casting them into the type \c Unit.
+   *
+   *  Two keys that are equivalent with respect to \ref bracket_less on every
+   *  dimension must produce the same hash, therefore \c Unit should be the
+   *  type of the coordinates of \c Tp.
+   *
+   *  \concept_hash
+   */
+  template <typename Tp, typename Unit>
+  struct bracket_hash
+  {
+    std::size_t
+    operator() (dimension_type rank, const Tp& x) const
+    {
+      std::hash<Unit> hasher;
+      std::size_t seed = 0;
+      for (dimension_type n = 0; n < rank; ++n)
+        { seed = details::hash_combine(seed, hasher(x[n])); }
+      return seed;
+    }
+  };
+
+  /**
+   *  This functor hashes all the coordinates of a key of type Tp, accessed
+   *  through the parenthesis operator, after casting them into the type \c
+   *  Unit.
+   *
+   *  \concept_hash
+   */
+  template <typename Tp, typename Unit>
+  struct paren_hash
+  {
+    std::size_t
+    operator() (dimension_type rank, const Tp& x) const
+    {
+      std::hash<Unit> hasher;
+      std::size_t seed = 0;
+      for (dimension_type n = 0; n < rank; ++n)
+        { seed = details::hash_combine(seed, hasher(x(n))); }
+      return seed;
+    }
+  };
+
+  /**
+   *  This functor hashes all the coordinates of a key of type Tp, accessed
+   *  through iterator deference, after casting them into the type \c Unit.
+   *
+   *  \concept_hash
+   */
+  template <typename Tp, typename Unit>
+  struct iterator_hash
+  {
+    std::size_t
+    operator() (dimension_type rank, const Tp& x) const
+    {
+      std::hash<Unit> hasher;
+      std::size_t seed = 0;
+      typename Tp::const_iterator ix = x.begin();
+      for (dimension_type n = 0; n < rank; ++n, ++ix)
+        { seed = details::hash_combine(seed, hasher(*ix)); }
+      return seed;
+    }
+  };
+
+  /**
+   *  This functor hashes all the coordinates of a key of type Tp, accessed
+   *  through a custom accessor, after casting them into the type \c Unit.
+   *
+   *  \concept_hash
+   */
+  template <typename Accessor, typename Tp, typename Unit>
+  struct accessor_hash
+    : private Accessor // empty member optimization
+  {
+    explicit accessor_hash(Accessor accessor_ = Accessor())
+      : Accessor(accessor_)
+    { }
+
+    std::size_t
+    operator() (dimension_type rank, const Tp& x) const
+    {
+      std::hash<Unit> hasher;
+      std::size_t seed = 0;
+      for (dimension_type n = 0; n < rank; ++n)
+        {
+          seed = details::hash_combine
+            (seed, hasher(Accessor::operator()(n, x)));
+        }
+      return seed;
+    }
+
+    const Accessor& accessor() const
+    { return *static_cast<const Accessor*>(this); }
+  };
+
 } // namespace spatial
 
 #endif // SPATIAL_FUNCTION_HPP
@@ -0,0 +1,737 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   grid_multimap.hpp
+ *  Contains the definition of \ref spatial::grid_multimap, a container that
+ *  hashes its values into the cells of a uniform grid, and of \ref
+ *  spatial::grid_iterator, the iterator over the values of the cells that
+ *  overlap a region or a sphere.
+ */
+
+#ifndef SPATIAL_GRID_MULTIMAP_HPP
+#define SPATIAL_GRID_MULTIMAP_HPP
+
+#include <memory>  // std::allocator
+#include <sstream>
+#include <limits>
+#include <list>
+#include <deque>
+#include <vector>
+#include <utility> // std::pair
+#include <iterator> // std::forward_iterator_tag, std::advance
+#include <cmath> // std::floor
+#include <algorithm> // std::swap
+#include "function.hpp"
+#include "bits/spatial_region.hpp"
+#include "bits/spatial_math.hpp"
+#include "bits/spatial_hash_index.hpp"
+#include "bits/spatial_coordinate.hpp"
+
+namespace spatial
+{
+  namespace details
+  {
+    /**
+     *  Selects the iterator over the values of a \ref grid_multimap, which is
+     *  constant when the container is constant.
+     */
+    ///@{
+    template <typename Container>
+    struct Grid_types
+    { typedef typename Container::iterator iterator; };
+
+    template <typename Container>
+    struct Grid_types<const Container>
+    { typedef typename Container::const_iterator iterator; };
+    ///@}
+
+    /**
+     *  Matches the keys within the boundaries of a \ref bounds predicate on
+     *  every dimension of \c Rank.
+     */
+    template <dimension_type Rank, typename Key, typename Compare>
+    struct Grid_region
+    {
+      Grid_region() { }
+      explicit Grid_region(const bounds<Key, Compare>& bounds_)
+        : pred(bounds_) { }
+
+      bool operator()(const Key& key) const
+      {
+        for (dimension_type d = 0; d < Rank; ++d)
+          { if (pred(d, Rank, key) != matching) return false; }
+        return true;
+      }
+
+      bounds<Key, Compare> pred;
+    };
+
+    /**
+     *  Matches the keys whose euclidian distance to a target is lower or
+     *  equal to a radius.
+     */
+    template <dimension_type Rank, typename Key, typename Compare>
+    struct Grid_ball
+    {
+      Grid_ball() : compare(), radius(0.0) { }
+      Grid_ball(const Compare& compare_, const Key& target, double radius_)
+        : compare(compare_), radius(radius_)
+      {
+        for (dimension_type d = 0; d < Rank; ++d)
+          { center[d] = compare_coordinate(compare, d, target); }
+      }
+
+      bool operator()(const Key& key) const
+      {
+        double sum = 0.0;
+        for (dimension_type d = 0; d < Rank; ++d)
+          {
+            double diff = compare_coordinate(compare, d, key) - center[d];
+            sum += diff * diff;
+          }
+        return sum <= radius * radius;
+      }
+
+      Compare compare;
+      double center[Rank];
+      double radius;
+    };
+  } // namespace details
+
+  template <typename Container, typename Predicate>
+  class grid_iterator;
+
+  /**
+   *  A multimap of points hashed into the cells of a uniform grid.
+   *
+   *  Each value is stored in the cell of its key, and cells are found by
+   *  hashing their coordinates, so inserting and erasing a value take a
+   *  constant time on average, and never rebalance anything. Region and
+   *  radius queries, through \ref region_range() and \ref radius_range(),
+   *  visit only the cells that overlap the query.
+   *
+   *  This container outperforms the trees of the library when the data is
+   *  roughly uniform and the extent of the queries is known in advance, such
+   *  as fixed-radius queries in particle simulations: choose a cell size
+   *  close to the radius of the queries. With clustered data or queries of
+   *  widely varying extents, prefer the trees.
+   *
+   *  The coordinates of the keys are read as the comparator reads them, for
+   *  \ref bracket_less, \ref paren_less, \ref iterator_less and \ref
+   *  accessor_less, and converted to \c double. A coordinate that is not a
+   *  number, infinite, or so far from the origin that the coordinate of its
+   *  cell cannot be stored in a \c long raises \ref invalid_coordinate.
+   *  Iterators are invalidated only by the erasure of the value they point
+   *  to.
+   *
+   *  \tparam Rank The number of dimensions of the keys.
+   *  \tparam Key The type of the keys.
+   *  \tparam Mapped The type of the values mapped to the keys.
+   *  \tparam Compare A model of \generalized_compare.
+   *  \tparam Alloc The allocator of the values.
+   */
+  template<dimension_type Rank, typename Key, typename Mapped,
+           typename Compare = bracket_less<Key>,
+           typename Alloc = std::allocator<std::pair<const Key, Mapped> > >
+  class grid_multimap
+  {
+  private:
+    typedef std::list<std::pair<const Key, Mapped>, Alloc> storage_type;
+
+    template <typename, typename> friend class grid_iterator;
+
+  public:
+    typedef details::Static_rank<Rank>                   rank_type;
+    typedef Key                                          key_type;
+    typedef Mapped                                       mapped_type;
+    typedef std::pair<const Key, Mapped>                 value_type;
+    typedef Compare                                      key_compare;
+    typedef Alloc                                        allocator_type;
+    typedef typename storage_type::size_type             size_type;
+    typedef typename storage_type::difference_type       difference_type;
+    typedef value_type*                                  pointer;
+    typedef const value_type*                            const_pointer;
+    typedef value_type&                                  reference;
+    typedef const value_type&                            const_reference;
+    typedef typename storage_type::iterator              iterator;
+    typedef typename storage_type::const_iterator        const_iterator;
+    //! The type of the coordinates of the cells.
+    typedef long                                         cell_type;
+
+    //! The rank of the container, as a constant expression.
+    static const dimension_type rank_value = Rank;
+
+    /**
+     *  Builds an empty grid whose cells have sides of length \c cell_size_.
+     *  \throws invalid_distance if \c cell_size_ is not strictly positive.
+     */
+    explicit grid_multimap(double cell_size_ = 1.0,
+                           const Compare& compare = Compare(),
+                           const Alloc& alloc = Alloc())
+      : _values(alloc), _index(alloc), _cell_size(cell_size_),
+        _compare(compare)
+    { check_cell_size(cell_size_); }
+
+    grid_multimap(const grid_multimap& other)
+      : _values(other.get_allocator()), _index(other.get_allocator()),
+        _cell_size(other._cell_size), _compare(other._compare)
+    { insert(other.begin(), other.end()); }
+
+    grid_multimap& operator=(const grid_multimap& other)
+    {
+      if (&other != this)
+        {
+          grid_multimap copy(other);
+          swap(copy);
+        }
+      return *this;
+    }
+
+    //! Returns the rank of the container.
+    rank_type rank() const { return rank_type(); }
+
+    //! Returns the number of dimensions of the container.
+    dimension_type dimension() const { return Rank; }
+
+    key_compare key_comp() const { return _compare; }
+
+    allocator_type get_allocator() const { return _values.get_allocator(); }
+
+    //! Returns the length of the sides of the cells.
+    double cell_size() const { return _cell_size; }
+
+    //! Returns the number of cells that hold at least one value.
+    size_type cell_count() const { return _index.size(); }
+
+    ///@{
+    //! Iterates over the values, grouped by cell, in no particular order.
+    iterator begin() { return _values.begin(); }
+    iterator end() { return _values.end(); }
+    const_iterator begin() const { return _values.begin(); }
+    const_iterator end() const { return _values.end(); }
+    const_iterator cbegin() const { return _values.begin(); }
+    const_iterator cend() const { return _values.end(); }
+    ///@}
+
+    bool empty() const { return _values.empty(); }
+    size_type size() const { return _values.size(); }
+    size_type max_size() const { return _values.max_size(); }
+
+    void clear()
+    {
+      _values.clear();
+      _index.clear();
+      _cells.clear();
+      _free.clear();
+    }
+
+    void swap(grid_multimap& other)
+    {
+      _values.swap(other._values);
+      _index.swap(other._index);
+      _cells.swap(other._cells);
+      _free.swap(other._free);
+      std::swap(_cell_size, other._cell_size);
+      std::swap(_compare, other._compare);
+    }
+
+    //! Inserts \c value in the cell of its key and returns an iterator to it.
+    iterator insert(const value_type& value)
+    {
+      cell_type coord[Rank];
+      cell_of(value.first, coord);
+      std::size_t hash = cell_hash(coord);
+      Cell* cell = find_cell(coord, hash);
+      if (cell != 0)
+        {
+          cell->first = _values.insert(cell->first, value);
+          ++cell->count;
+          return cell->first;
+        }
+      iterator pos = _values.insert(_values.end(), value);
+      try
+        {
+          cell = new_cell();
+          _index.insert(hash, cell);
+        }
+      catch (...)
+        {
+          if (cell != 0) { _free.push_back(cell); }
+          _values.erase(pos);
+          throw;
+        }
+      for (dimension_type d = 0; d < Rank; ++d)
+        { cell->coord[d] = coord[d]; }
+      cell->first = pos;
+      cell->count = 1;
+      return pos;
+    }
+
+    //! Inserts the values of [\c first, \c last).
+    template <typename InputIterator>
+    void insert(InputIterator first, InputIterator last)
+    { for (; first != last; ++first) { insert(*first); } }
+
+    //! Erases the value pointed to by \c pos.
+    void erase(iterator pos)
+    {
+      cell_type coord[Rank];
+      cell_of(pos->first, coord);
+      std::size_t hash = cell_hash(coord);
+      Cell* cell = find_cell(coord, hash);
+      SPATIAL_ASSERT_CHECK(cell != 0);
+      if (cell->first == pos) { ++cell->first; }
+      if (--cell->count == 0)
+        {
+          _index.erase(hash, cell);
+          _free.push_back(cell); // never throws, see new_cell()
+        }
+      _values.erase(pos);
+    }
+
+    //! Erases all values whose key is equal to \c key, and returns their
+    //! number.
+    size_type erase(const key_type& key)
+    {
+      size_type erased = 0;
+      cell_type coord[Rank];
+      cell_of(key, coord);
+      Cell* cell = find_cell(coord, cell_hash(coord));
+      if (cell == 0) return 0;
+      iterator pos = cell->first;
+      for (size_type left = cell->count; left != 0; --left)
+        {
+          iterator next = pos; ++next;
+          if (details::equal_key(rank(), _compare, pos->first, key))
+            { erase(pos); ++erased; }
+          pos = next;
+        }
+      return erased;
+    }
+
+    //! Returns a value whose key is equal to \c key, or \ref end() if there
+    //! are none.
+    ///@{
+    iterator find(const key_type& key)
+    {
+      cell_type coord[Rank];
+      cell_of(key, coord);
+      Cell* cell = find_cell(coord, cell_hash(coord));
+      if (cell == 0) return end();
+      iterator pos = cell->first;
+      for (size_type left = cell->count; left != 0; --left, ++pos)
+        {
+          if (details::equal_key(rank(), _compare, pos->first, key))
+            return pos;
+        }
+      return end();
+    }
+
+    const_iterator find(const key_type& key) const
+    { return const_cast<grid_multimap*>(this)->find(key); }
+    ///@}
+
+    //! Returns the number of values whose key is equal to \c key.
+    size_type count(const key_type& key) const
+    {
+      size_type found = 0;
+      cell_type coord[Rank];
+      cell_of(key, coord);
+      const Cell* cell = find_cell(coord, cell_hash(coord));
+      if (cell == 0) return 0;
+      const_iterator pos = cell->first;
+      for (size_type left = cell->count; left != 0; --left, ++pos)
+        {
+          if (details::equal_key(rank(), _compare, pos->first, key))
+            ++found;
+        }
+      return found;
+    }
+
+    //! Stores in \c coord the coordinates of the cell of \c key.
+    void cell_of(const key_type& key, cell_type (&coord)[Rank]) const
+    {
+      for (dimension_type d = 0; d < Rank; ++d)
+        {
+          coord[d] = cell_of(details::compare_coordinate(_compare, d, key));
+        }
+    }
+
+    /**
+     *  Returns the coordinate of the cell of \c coordinate on any dimension.
+     *  \throws invalid_coordinate if \c coordinate is not a number, or if the
+     *  coordinate of its cell is out of the range of \ref cell_type.
+     */
+    cell_type cell_of(double coordinate) const
+    {
+      double cell = std::floor(coordinate / _cell_size);
+      check_cell(coordinate, cell);
+      return static_cast<cell_type>(cell);
+    }
+
+  private:
+    //! A cell of the grid, whose values are the \c count values of the list
+    //! from \c first.
+    struct Cell
+    {
+      Cell() : first(), count(0) { }
+      cell_type coord[Rank];
+      iterator first;
+      size_type count;
+    };
+
+    typedef typename std::allocator_traits<Alloc>
+    ::template rebind_alloc<Cell>                       cell_allocator;
+    typedef typename std::allocator_traits<Alloc>
+    ::template rebind_alloc<Cell*>                      free_allocator;
+
+    static void check_cell_size(double size)
+    {
+      if (!(size > 0.0))
+        throw invalid_distance("the size of the cells must be positive");
+    }
+
+    static void check_cell(double coordinate, double cell)
+    {
+      // The bounds are powers of 2, which a double holds exactly
+      const double low
+        = static_cast<double>((std::numeric_limits<cell_type>::min)());
+      if (!(low <= cell && cell < -low))
+        {
+          std::stringstream out;
+          out << coordinate << " is not within the range of the cells";
+          throw invalid_coordinate(out.str());
+        }
+    }
+
+    static std::size_t cell_hash(const cell_type (&coord)[Rank])
+    {
+      std::size_t seed = 0;
+      for (dimension_type d = 0; d < Rank; ++d)
+        {
+          seed = details::hash_combine
+            (seed, static_cast<std::size_t>(coord[d]) * 0x9e3779b1u);
+        }
+      return seed;
+    }
+
+    //! Returns the cell at \c coord, whose hash is \c hash, or null.
+    Cell* find_cell(const cell_type (&coord)[Rank], std::size_t hash) const
+    {
+      for (std::size_t slot = _index.first(hash);
+           slot != _index.bucket_count(); slot = _index.next(slot, hash))
+        {
+          Cell* cell = _index.node(slot);
+          dimension_type d = 0;
+          while (d < Rank && cell->coord[d] == coord[d]) { ++d; }
+          if (d == Rank) return cell;
+        }
+      return 0;
+    }
+
+    //! Returns an unused cell. The free list keeps enough room for all the
+    //! cells, so that erasing a value never allocates.
+    Cell* new_cell()
+    {
+      if (!_free.empty())
+        {
+          Cell* cell = _free.back();
+          _free.pop_back();
+          return cell;
+        }
+      _free.reserve(_cells.size() + 1);
+      _cells.push_back(Cell());
+      return &_cells.back();
+    }
+
+    storage_type _values;
+    details::Hash_index<Cell*, Alloc> _index;
+    std::deque<Cell, cell_allocator> _cells;
+    std::vector<Cell*, free_allocator> _free;
+    double _cell_size;
+    Compare _compare;
+  };
+
+  /**
+   *  An iterator over the values of a \ref grid_multimap that match a
+   *  predicate, among the values of a box of cells. The values are not
+   *  returned in any particular order.
+   *
+   *  When the box covers more cells than the container holds, the iterator
+   *  walks all the values of the container instead of looking up each cell.
+   *
+   *  \tparam Container The \ref grid_multimap being iterated.
+   *  \tparam Predicate A functor called with a key, that returns \c true if
+   *  the value must be visited.
+   */
+  template <typename Container, typename Predicate>
+  class grid_iterator
+  {
+  private:
+    typedef typename details::Grid_types<Container>::iterator base_iterator;
+    typedef typename Container::cell_type cell_type;
+
+  public:
+    typedef std::forward_iterator_tag                       iterator_category;
+    typedef typename std::iterator_traits<base_iterator>::value_type
+    value_type;
+    typedef typename std::iterator_traits<base_iterator>::difference_type
+    difference_type;
+    typedef typename std::iterator_traits<base_iterator>::pointer pointer;
+    typedef typename std::iterator_traits<base_iterator>::reference
+    reference;
+
+    //! Uninitialized iterator.
+    grid_iterator() : _container(0) { }
+
+    /**
+     *  Builds an iterator to the first value of \c container that matches \c
+     *  pred among the cells from \c lower to \c upper, both included.
+     */
+    grid_iterator(Container& container, const Predicate& pred,
+                  const cell_type (&lower)[Container::rank_value],
+                  const cell_type (&upper)[Container::rank_value])
+      : _container(&container), _pred(pred), _scan(false), _left(0)
+    {
+      double cells = 1.0;
+      for (dimension_type d = 0; d < Rank; ++d)
+        {
+          _lower[d] = _cell[d] = lower[d];
+          _upper[d] = upper[d];
+          cells *= static_cast<double>(upper[d] - lower[d]) + 1.0;
+          if (upper[d] < lower[d]) cells = 0.0;
+        }
+      if (cells > static_cast<double>(container.cell_count()))
+        {
+          _scan = true;
+          for (_pos = container.begin();
+               _pos != container.end() && !_pred(_pos->first); ++_pos);
+          return;
+        }
+      _pos = container.end();
+      if (cells == 0.0) return;
+      load();
+      satisfy();
+    }
+
+    //! Builds a past-the-end iterator of \c container.
+    explicit grid_iterator(Container& container)
+      : _container(&container), _pred(), _scan(false),
+        _pos(container.end()), _left(0) { }
+
+    reference operator*() const { return *_pos; }
+    pointer operator->() const { return &*_pos; }
+
+    grid_iterator& operator++()
+    {
+      if (_scan)
+        {
+          for (++_pos; _pos != _container->end() && !_pred(_pos->first);
+               ++_pos);
+        }
+      else { ++_pos; --_left; satisfy(); }
+      return *this;
+    }
+
+    grid_iterator operator++(int)
+    {
+      grid_iterator x(*this);
+      ++*this;
+      return x;
+    }
+
+    bool operator==(const grid_iterator& other) const
+    { return _pos == other._pos; }
+
+    bool operator!=(const grid_iterator& other) const
+    { return _pos != other._pos; }
+
+    //! Returns the position of the iterator in the container.
+    base_iterator base() const { return _pos; }
+
+  private:
+    static const dimension_type Rank = Container::rank_value;
+
+    //! Points \c _pos to the values of the cell \c _cell, if any.
+    void load()
+    {
+      typename Container::Cell* cell = _container->find_cell
+        (_cell, Container::cell_hash(_cell));
+      if (cell != 0) { _pos = cell->first; _left = cell->count; }
+      else { _left = 0; }
+    }
+
+    //! Moves to the first matching value from \c _pos, going through the
+    //! following cells of the box as long as the current one is exhausted.
+    void satisfy()
+    {
+      for (;;)
+        {
+          for (; _left != 0; ++_pos, --_left)
+            { if (_pred(_pos->first)) return; }
+          dimension_type d = 0;
+          for (; d < Rank && _cell[d] == _upper[d]; ++d)
+            { _cell[d] = _lower[d]; }
+          if (d == Rank) { _pos = _container->end(); return; }
+          ++_cell[d];
+          load();
+        }
+    }
+
+    Container* _container;
+    Predicate _pred;
+    bool _scan;
+    base_iterator _pos;
+    typename Container::size_type _left;
+    cell_type _cell[Container::rank_value];
+    cell_type _lower[Container::rank_value];
+    cell_type _upper[Container::rank_value];
+  };
+
+  /**
+   *  A pair of \ref grid_iterator that delimits the values found by a query.
+   */
+  template <typename Container, typename Predicate>
+  struct grid_iterator_pair
+    : std::pair<grid_iterator<Container, Predicate>,
+                grid_iterator<Container, Predicate> >
+  {
+    typedef std::pair<grid_iterator<Container, Predicate>,
+                      grid_iterator<Container, Predicate> > Base;
+
+    //! Empty constructor.
+    grid_iterator_pair() { }
+
+    //! Builds a grid_iterator_pair out of 2 grid_iterators.
+    grid_iterator_pair(const grid_iterator<Container, Predicate>& a,
+                       const grid_iterator<Container, Predicate>& b)
+      : Base(a, b) { }
+  };
+
+  namespace details
+  {
+    //! Returns the values of \c container that match \c pred, among the
+    //! cells that cover the box from \c lower to \c upper.
+    template <typename Container, typename Predicate>
+    inline grid_iterator_pair<Container, Predicate>
+    grid_range(Container& container, const Predicate& pred,
+               const double (&lower)[Container::rank_value],
+               const double (&upper)[Container::rank_value])
+    {
+      typename Container::cell_type cell_lower[Container::rank_value];
+      typename Container::cell_type cell_upper[Container::rank_value];
+      for (dimension_type d = 0; d < Container::rank_value; ++d)
+        {
+          cell_lower[d] = container.cell_of(lower[d]);
+          cell_upper[d] = container.cell_of(upper[d]);
+        }
+      return grid_iterator_pair<Container, Predicate>
+        (grid_iterator<Container, Predicate>
+         (container, pred, cell_lower, cell_upper),
+         grid_iterator<Container, Predicate>(container));
+    }
+  }
+
+  /**
+   *  Returns the values of a \ref grid_multimap whose keys are within the
+   *  region formed by \c lower and \c upper, inclusive of lower values, but
+   *  exclusive of upper values, as with \ref bounds.
+   *  \throws invalid_bounds if \c lower is not less than \c upper over every
+   *  dimension.
+   */
+  ///@{
+  template <dimension_type Rank, typename Key, typename Mapped,
+            typename Compare, typename Alloc>
+  inline grid_iterator_pair
+  <grid_multimap<Rank, Key, Mapped, Compare, Alloc>,
+   details::Grid_region<Rank, Key, Compare> >
+  region_range(grid_multimap<Rank, Key, Mapped, Compare, Alloc>& container,
+               const Key& lower, const Key& upper)
+  {
+    double l[Rank], h[Rank];
+    for (dimension_type d = 0; d < Rank; ++d)
+      {
+        l[d] = details::compare_coordinate(container.key_comp(), d, lower);
+        h[d] = details::compare_coordinate(container.key_comp(), d, upper);
+      }
+    return details::grid_range
+      (container, details::Grid_region<Rank, Key, Compare>
+       (make_bounds(container, lower, upper)), l, h);
+  }
+
+  template <dimension_type Rank, typename Key, typename Mapped,
+            typename Compare, typename Alloc>
+  inline grid_iterator_pair
+  <const grid_multimap<Rank, Key, Mapped, Compare, Alloc>,
+   details::Grid_region<Rank, Key, Compare> >
+  region_crange(const grid_multimap<Rank, Key, Mapped, Compare, Alloc>&
+                container, const Key& lower, const Key& upper)
+  {
+    double l[Rank], h[Rank];
+    for (dimension_type d = 0; d < Rank; ++d)
+      {
+        l[d] = details::compare_coordinate(container.key_comp(), d, lower);
+        h[d] = details::compare_coordinate(container.key_comp(), d, upper);
+      }
+    return details::grid_range
+      (container, details::Grid_region<Rank, Key, Compare>
+       (make_bounds(container, lower, upper)), l, h);
+  }
+  ///@}
+
+  /**
+   *  Returns the values of a \ref grid_multimap whose keys are at an
+   *  euclidian distance lower or equal to \c radius from \c target. Only the
+   *  cells that overlap the bounding box of the sphere are visited.
+   *  \throws invalid_distance if \c radius is negative.
+   */
+  ///@{
+  template <dimension_type Rank, typename Key, typename Mapped,
+            typename Compare, typename Alloc>
+  inline grid_iterator_pair
+  <grid_multimap<Rank, Key, Mapped, Compare, Alloc>,
+   details::Grid_ball<Rank, Key, Compare> >
+  radius_range(grid_multimap<Rank, Key, Mapped, Compare, Alloc>& container,
+               const Key& target, double radius)
+  {
+    except::check_positive_distance(radius);
+    details::Grid_ball<Rank, Key, Compare>
+      ball(container.key_comp(), target, radius);
+    double l[Rank], h[Rank];
+    for (dimension_type d = 0; d < Rank; ++d)
+      {
+        l[d] = ball.center[d] - radius;
+        h[d] = ball.center[d] + radius;
+      }
+    return details::grid_range(container, ball, l, h);
+  }
+
+  template <dimension_type Rank, typename Key, typename Mapped,
+            typename Compare, typename Alloc>
+  inline grid_iterator_pair
+  <const grid_multimap<Rank, Key, Mapped, Compare, Alloc>,
+   details::Grid_ball<Rank, Key, Compare> >
+  radius_crange(const grid_multimap<Rank, Key, Mapped, Compare, Alloc>&
+                container, const Key& target, double radius)
+  {
+    except::check_positive_distance(radius);
+    details::Grid_ball<Rank, Key, Compare>
+      ball(container.key_comp(), target, radius);
+    double l[Rank], h[Rank];
+    for (dimension_type d = 0; d < Rank; ++d)
+      {
+        l[d] = ball.center[d] - radius;
+        h[d] = ball.center[d] + radius;
+      }
+    return details::grid_range(container, ball, l, h);
+  }
+  ///@}
+
+} // namespace spatial
+
+#endif // SPATIAL_GRID_MULTIMAP_HPP
@@ -0,0 +1,618 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   hash_indexed.hpp
+ *  Contains the definition of \ref spatial::hash_indexed, an adaptor that
+ *  maintains a hash index over the keys of any container of the library, and
+ *  of \ref spatial::hash_equal_iterator, the iterator it uses to enumerate
+ *  the elements matching a key.
+ */
+
+#ifndef SPATIAL_HASH_INDEXED_HPP
+#define SPATIAL_HASH_INDEXED_HPP
+
+#include <utility> // std::pair
+#include <iterator> // std::forward_iterator_tag
+#include "equal_iterator.hpp"
+#include "bits/spatial_hash_index.hpp"
+#include "bits/spatial_template_member_swap.hpp"
+
+namespace spatial
+{
+  /**
+   *  This type provides an iterator to iterate through all elements of a \ref
+   *  hash_indexed container that match a given key, called the model.
+   *
+   *  When the index of the container is enabled, the iterator walks the
+   *  entries of the index for the hash of the model. Otherwise it walks the
+   *  tree, exactly like \ref equal_iterator. Either way, the elements are not
+   *  returned in any particular order.
+   *
+   *  \tparam Container The \ref hash_indexed container upon which these
+   *  iterator relate to.
+   */
+  template <typename Container>
+  class hash_equal_iterator
+    : public details::Bidirectional_iterator
+      <typename Container::mode_type,
+       typename Container::rank_type>
+  {
+  private:
+    typedef typename details::Bidirectional_iterator
+    <typename Container::mode_type,
+     typename Container::rank_type> Base;
+    typedef typename Container::index_type index_type;
+
+  public:
+    using Base::node;
+    using Base::node_dim;
+    using Base::rank;
+
+    //! This iterator may only be incremented.
+    typedef std::forward_iterator_tag iterator_category;
+
+    //! The type used to store the model key to be looked up in the container.
+    typedef typename Container::key_type key_type;
+
+    //! The comparison functor used to compare keys.
+    typedef typename Container::key_compare key_compare;
+
+    //! \empty
+    hash_equal_iterator() { }
+
+    /**
+     *  Build an iterator walking the tree of \c container from \c ptr, whose
+     *  dimension is \c dim, like an \ref equal_iterator would.
+     */
+    hash_equal_iterator
+    (Container& container, const key_type& value, dimension_type dim,
+     typename Container::mode_type::node_ptr ptr)
+      : Base(container.rank(), ptr, dim), _data(container.key_comp(), value),
+        _index(0), _slot(0), _hash(0), _end(0)
+    { }
+
+    /**
+     *  Build an iterator walking the index of \c container from the entry in
+     *  \c slot, whose node is \c ptr.
+     */
+    hash_equal_iterator
+    (Container& container, const key_type& value, const index_type& index,
+     typename index_type::size_type slot, std::size_t hash,
+     typename Container::mode_type::node_ptr ptr)
+      : Base(container.rank(), ptr, 0), _data(container.key_comp(), value),
+        _index(&index), _slot(slot), _hash(hash),
+        _end(container.end().node)
+    { }
+
+    //! Increments the iterator and returns the incremented value.
+    hash_equal_iterator<Container>& operator++()
+    { increment(); return *this; }
+
+    //! Increments the iterator but returns the value of the iterator before
+    //! the increment.
+    hash_equal_iterator<Container> operator++(int)
+    {
+      hash_equal_iterator<Container> x(*this);
+      increment();
+      return x;
+    }
+
+    //! Return the value of key used to find equal keys in the container.
+    key_type value() const { return _data(); }
+
+    //! Return the functor used to compare keys in this iterator.
+    key_compare key_comp() const { return _data.base(); }
+
+  private:
+    void increment()
+    {
+      if (_index == 0)
+        {
+          import::tie(node, node_dim)
+            = details::increment_equal(node, node_dim, rank(), _data.base(),
+                                       _data());
+          return;
+        }
+      _slot = details::next_indexed_equal(*_index, _slot, _hash, rank(),
+                                          _data.base(), _data());
+      node = (_slot == _index->bucket_count()) ? _end : _index->node(_slot);
+    }
+
+    //! The model key used to find equal keys in the container.
+    details::Compress<key_compare, key_type> _data;
+
+    //! The index walked by the iterator, or null when walking the tree.
+    const index_type* _index;
+
+    //! The current slot in the index.
+    typename index_type::size_type _slot;
+
+    //! The hash of the model key.
+    std::size_t _hash;
+
+    //! The past-the-end node of the container.
+    typename Container::mode_type::node_ptr _end;
+
+    friend class hash_equal_iterator<const Container>;
+  };
+
+  /**
+   *  This type provides an iterator to iterate through all elements of a \ref
+   *  hash_indexed container that match a given key, called the model.
+   *
+   *  The values returned by this iterator will not be mutable.
+   *
+   *  \tparam Container The \ref hash_indexed container upon which these
+   *  iterator relate to.
+   */
+  template <typename Container>
+  class hash_equal_iterator<const Container>
+    : public details::Const_bidirectional_iterator
+      <typename Container::mode_type,
+       typename Container::rank_type>
+  {
+  private:
+    typedef details::Const_bidirectional_iterator
+    <typename Container::mode_type,
+     typename Container::rank_type> Base;
+    typedef typename Container::index_type index_type;
+
+  public:
+    using Base::node;
+    using Base::node_dim;
+    using Base::rank;
+
+    //! This iterator may only be incremented.
+    typedef std::forward_iterator_tag iterator_category;
+
+    //! The type used to store the model key to be looked up in the container.
+    typedef typename Container::key_type key_type;
+
+    //! The comparison functor used to compare keys.
+    typedef typename Container::key_compare key_compare;
+
+    //! \empty
+    hash_equal_iterator() { }
+
+    /**
+     *  Build an iterator walking the tree of \c container from \c ptr, whose
+     *  dimension is \c dim, like an \ref equal_iterator would.
+     */
+    hash_equal_iterator
+    (const Container& container, const key_type& value, dimension_type dim,
+     typename Container::mode_type::const_node_ptr ptr)
+      : Base(container.rank(), ptr, dim), _data(container.key_comp(), value),
+        _index(0), _slot(0), _hash(0), _end(0)
+    { }
+
+    /**
+     *  Build an iterator walking the index of \c container from the entry in
+     *  \c slot, whose node is \c ptr.
+     */
+    hash_equal_iterator
+    (const Container& container, const key_type& value,
+     const index_type& index, typename index_type::size_type slot,
+     std::size_t hash, typename Container::mode_type::const_node_ptr ptr)
+      : Base(container.rank(), ptr, 0), _data(container.key_comp(), value),
+        _index(&index), _slot(slot), _hash(hash),
+        _end(container.end().node)
+    { }
+
+    //! Convertion of an iterator into a const_iterator is permitted.
+    hash_equal_iterator(const hash_equal_iterator<Container>& iter)
+      : Base(iter.rank(), iter.node, iter.node_dim, iter),
+        _data(iter.key_comp(), iter.value()), _index(iter._index),
+        _slot(iter._slot), _hash(iter._hash), _end(iter._end)
+    { }
+
+    //! Increments the iterator and returns the incremented value.
+    hash_equal_iterator<const Container>& operator++()
+    { increment(); return *this; }
+
+    //! Increments the iterator but returns the value of the iterator before
+    //! the increment.
+    hash_equal_iterator<const Container> operator++(int)
+    {
+      hash_equal_iterator<const Container> x(*this);
+      increment();
+      return x;
+    }
+
+    //! Returns the value used to find equivalent keys in the container.
+    key_type value() const { return _data(); }
+
+    //! Returns the functor used to compare keys in this iterator.
+    key_compare key_comp() const { return _data.base(); }
+
+  private:
+    void increment()
+    {
+      if (_index == 0)
+        {
+          import::tie(node, node_dim)
+            = details::increment_equal(node, node_dim, rank(), _data.base(),
+                                       _data());
+          return;
+        }
+      _slot = details::next_indexed_equal(*_index, _slot, _hash, rank(),
+                                          _data.base(), _data());
+      node = (_slot == _index->bucket_count()) ? _end : _index->node(_slot);
+    }
+
+    //! The model key used to find equal keys in the container.
+    details::Compress<key_compare, key_type> _data;
+
+    //! The index walked by the iterator, or null when walking the tree.
+    const index_type* _index;
+
+    //! The current slot in the index.
+    typename index_type::size_type _slot;
+
+    //! The hash of the model key.
+    std::size_t _hash;
+
+    //! The past-the-end node of the container.
+    typename Container::mode_type::const_node_ptr _end;
+  };
+
+  /**
+   *  An adaptor that maintains a hash index over the keys of a \point_multiset,
+   *  \point_multimap, \box_multiset, \box_multimap or any of their idle
+   *  variants, in order to answer exact key lookups with \ref find(), \ref
+   *  count() and \ref equal_range() in expected constant time, instead of
+   *  descending the tree.
+   *
+   *  The index holds pointers to the nodes of the tree. Nodes are never moved
+   *  in memory, even when the tree rebalances itself or when a node is
+   *  relinked during an erasure, so only the insertion and the erasure of
+   *  elements need to update the index. The adaptor hides every function of
+   *  \c Container that inserts or erases elements; calling these functions
+   *  through a reference to \c Container leaves the index out of date.
+   *
+   *  The index can be disabled at run time, for example while loading a large
+   *  number of elements, and enabled again afterward at the cost of a single
+   *  pass over the container. While it is disabled, \ref find(), \ref count()
+   *  and \ref equal_range() fall back to searching the tree.
+   *
+   *  \code
+   *    typedef point_multiset<3, double3> base;
+   *    hash_indexed<base, bracket_hash<double3, double> > voxels;
+   *    if (voxels.count(center) == 0) voxels.insert(center);
+   *  \endcode
+   *
+   *  \tparam Container The container being indexed.
+   *  \tparam Hash A model of \hash for the keys of \c Container, which must be
+   *  consistent with the comparator of \c Container.
+   */
+  template <typename Container, typename Hash>
+  class hash_indexed : public Container
+  {
+    typedef Container                                 base_type;
+    typedef hash_indexed<Container, Hash>             Self;
+    typedef typename Container::mode_type::node_ptr   node_ptr;
+
+  public:
+    typedef Hash                                      hasher;
+    typedef typename Container::key_type              key_type;
+    typedef typename Container::value_type            value_type;
+    typedef typename Container::size_type             size_type;
+    typedef typename Container::allocator_type        allocator_type;
+    typedef typename Container::iterator              iterator;
+    typedef typename Container::const_iterator        const_iterator;
+
+    //! The type of the index maintained alongside the container.
+    typedef details::Hash_index<node_ptr, allocator_type> index_type;
+
+    //! Iterator over the elements matching a key.
+    typedef hash_equal_iterator<Self>                 equal_iterator;
+
+    //! Constant iterator over the elements matching a key.
+    typedef hash_equal_iterator<const Self>           const_equal_iterator;
+
+    hash_indexed()
+      : _index(Hash(), index_type(base_type::get_allocator())),
+        _enabled(true)
+    { }
+
+    /**
+     *  Builds the index over a copy of \c container.
+     */
+    explicit hash_indexed(const Container& container,
+                          const Hash& hash = Hash())
+      : base_type(container), _index(hash, index_type(container.get_allocator())),
+        _enabled(true)
+    { rebuild_index(); }
+
+    //! Forwards \c arg1 to the constructor of \c Container.
+    template <typename Arg1>
+    explicit hash_indexed(const Arg1& arg1)
+      : base_type(arg1), _index(Hash(), index_type(base_type::get_allocator())),
+        _enabled(true)
+    { }
+
+    //! Forwards \c arg1 and \c arg2 to the constructor of \c Container.
+    template <typename Arg1, typename Arg2>
+    hash_indexed(const Arg1& arg1, const Arg2& arg2)
+      : base_type(arg1, arg2),
+        _index(Hash(), index_type(base_type::get_allocator())), _enabled(true)
+    { }
+
+    //! Forwards \c arg1 to \c arg3 to the constructor of \c Container.
+    template <typename Arg1, typename Arg2, typename Arg3>
+    hash_indexed(const Arg1& arg1, const Arg2& arg2, const Arg3& arg3)
+      : base_type(arg1, arg2, arg3),
+        _index(Hash(), index_type(base_type::get_allocator())), _enabled(true)
+    { }
+
+    //! Forwards \c arg1 to \c arg4 to the constructor of \c Container.
+    template <typename Arg1, typename Arg2, typename Arg3, typename Arg4>
+    hash_indexed(const Arg1& arg1, const Arg2& arg2, const Arg3& arg3,
+                 const Arg4& arg4)
+      : base_type(arg1, arg2, arg3, arg4),
+        _index(Hash(), index_type(base_type::get_allocator())), _enabled(true)
+    { }
+
+    hash_indexed(const hash_indexed& other)
+      : base_type(other),
+        _index(other.hash_function(), index_type(other.get_allocator())),
+        _enabled(other._enabled)
+    { if (_enabled) rebuild_index(); }
+
+    hash_indexed&
+    operator=(const hash_indexed& other)
+    {
+      if (&other != this)
+        {
+          _index().clear();
+          base_type::operator=(other);
+          details::template_member_assign<Hash>::do_it
+            (_index.base(), other.hash_function());
+          _enabled = other._enabled;
+          if (_enabled) rebuild_index();
+        }
+      return *this;
+    }
+
+    //! Returns the hash functor used by the index.
+    hasher hash_function() const { return _index.base(); }
+
+    //! Returns the index maintained alongside the container.
+    const index_type& index() const { return _index(); }
+
+    //! True if the index is currently maintained and used for lookups.
+    bool index_enabled() const { return _enabled; }
+
+    /**
+     *  Builds the index over the elements of the container and maintains it
+     *  until \ref disable_index() is called. Does nothing if the index is
+     *  already enabled.
+     *
+     *  \lintime
+     */
+    void enable_index()
+    {
+      if (_enabled) return;
+      rebuild_index();
+      _enabled = true;
+    }
+
+    /**
+     *  Releases the index; lookups search the tree until \ref enable_index()
+     *  is called.
+     */
+    void disable_index()
+    {
+      _enabled = false;
+      _index().clear();
+    }
+
+    /**
+     *  Swap the content of the container and its index with \c other.
+     */
+    void swap(Self& other)
+    {
+      base_type::swap(other);
+      details::template_member_swap<Hash>::do_it
+        (_index.base(), other._index.base());
+      _index().swap(other._index());
+      std::swap(_enabled, other._enabled);
+    }
+
+    //! Erase all elements in the container and the index.
+    void clear()
+    {
+      base_type::clear();
+      _index().clear();
+    }
+
+    /**
+     *  Insert a single value in the container and the index.
+     */
+    iterator insert(const value_type& value)
+    {
+      if (!_enabled) return base_type::insert(value);
+      _index().reserve(base_type::size() + 1); // may throw
+      iterator i = base_type::insert(value);
+      _index().insert(hash_key(const_key(i.node)), i.node); // cannot throw
+      return i;
+    }
+
+    /**
+     *  Insert a serie of values in the container and the index.
+     */
+    template <typename InputIterator>
+    void insert(InputIterator first, InputIterator last)
+    { for (; first != last; ++first) { insert(*first); } }
+
+    /**
+     *  Insert a serie of values in an idle container and rebalance it; the
+     *  index is built again afterward.
+     */
+    template <typename InputIterator>
+    void insert_rebalance(InputIterator first, InputIterator last)
+    {
+      base_type::insert_rebalance(first, last);
+      if (_enabled) rebuild_index();
+    }
+
+    /**
+     *  Deletes the node pointed to by the iterator from the container and the
+     *  index.
+     */
+    void erase(iterator position)
+    {
+      if (_enabled)
+        { _index().erase(hash_key(const_key(position.node)), position.node); }
+      base_type::erase(position);
+    }
+
+    /**
+     *  Deletes all elements that match \c key from the container and the
+     *  index, and returns the number of elements deleted.
+     */
+    size_type erase(const key_type& key)
+    {
+      if (!_enabled) return base_type::erase(key);
+      std::size_t hash = hash_key(key);
+      size_type erased = 0;
+      for (;;)
+        {
+          typename index_type::size_type slot = details::first_indexed_equal
+            (_index(), hash, base_type::rank(), base_type::key_comp(), key);
+          if (slot == _index().bucket_count()) break;
+          node_ptr node = _index().node(slot);
+          _index().erase(hash, node);
+          base_type::erase(iterator(node));
+          ++erased;
+        }
+      return erased;
+    }
+
+    ///@{
+    /**
+     *  Find one of the elements that match with \c key and returns an iterator
+     *  to it, otherwise it returns an iterator to the element past the end of
+     *  the container.
+     */
+    iterator find(const key_type& key)
+    {
+      if (!_enabled) return base_type::find(key);
+      typename index_type::size_type slot = details::first_indexed_equal
+        (_index(), hash_key(key), base_type::rank(), base_type::key_comp(),
+         key);
+      return (slot == _index().bucket_count()) ? base_type::end()
+        : iterator(_index().node(slot));
+    }
+
+    const_iterator find(const key_type& key) const
+    {
+      if (!_enabled) return base_type::find(key);
+      typename index_type::size_type slot = details::first_indexed_equal
+        (_index(), hash_key(key), base_type::rank(), base_type::key_comp(),
+         key);
+      return (slot == _index().bucket_count()) ? base_type::end()
+        : const_iterator(_index().node(slot));
+    }
+    ///@}
+
+    using base_type::count;
+
+    /**
+     *  Returns the number of elements that match with \c key.
+     */
+    size_type count(const key_type& key) const
+    {
+      size_type matches = 0;
+      for (const_equal_iterator i = equal_range(key).first;
+           i.node != base_type::end().node; ++i)
+        { ++matches; }
+      return matches;
+    }
+
+    ///@{
+    /**
+     *  Returns the range of elements that match with \c key.
+     */
+    std::pair<equal_iterator, equal_iterator>
+    equal_range(const key_type& key)
+    {
+      if (!_enabled)
+        {
+          typename spatial::equal_iterator<base_type> first
+            = equal_begin(static_cast<base_type&>(*this), key);
+          return std::make_pair
+            (equal_iterator(*this, key, first.node_dim, first.node),
+             equal_iterator(*this, key, 0, base_type::end().node));
+        }
+      std::size_t hash = hash_key(key);
+      typename index_type::size_type slot = details::first_indexed_equal
+        (_index(), hash, base_type::rank(), base_type::key_comp(), key);
+      node_ptr end = base_type::end().node;
+      return std::make_pair
+        (equal_iterator(*this, key, _index(), slot, hash,
+                        slot == _index().bucket_count() ? end
+                        : _index().node(slot)),
+         equal_iterator(*this, key, 0, end));
+    }
+
+    std::pair<const_equal_iterator, const_equal_iterator>
+    equal_range(const key_type& key) const
+    {
+      if (!_enabled)
+        {
+          typename spatial::equal_iterator<const base_type> first
+            = equal_cbegin(static_cast<const base_type&>(*this), key);
+          return std::make_pair
+            (const_equal_iterator(*this, key, first.node_dim, first.node),
+             const_equal_iterator(*this, key, 0, base_type::end().node));
+        }
+      std::size_t hash = hash_key(key);
+      typename index_type::size_type slot = details::first_indexed_equal
+        (_index(), hash, base_type::rank(), base_type::key_comp(), key);
+      typename Container::mode_type::const_node_ptr end
+        = base_type::end().node;
+      return std::make_pair
+        (const_equal_iterator(*this, key, _index(), slot, hash,
+                              slot == _index().bucket_count() ? end
+                              : _index().node(slot)),
+         const_equal_iterator(*this, key, 0, end));
+    }
+    ///@}
+
+  private:
+    std::size_t hash_key(const key_type& key) const
+    { return _index.base()(base_type::dimension(), key); }
+
+    //! Fills the index with all the nodes of the container.
+    void rebuild_index()
+    {
+      _index().clear();
+      _index().reserve(base_type::size()); // may throw
+      for (iterator i = base_type::begin(); i != base_type::end(); ++i)
+        { _index().insert(hash_key(const_key(i.node)), i.node); }
+    }
+
+    //! The hash functor, compressed with the index.
+    details::Compress<Hash, index_type> _index;
+
+    //! Set when the index is maintained.
+    bool _enabled;
+  };
+
+  /**
+   *  Swap the content of the \ref hash_indexed containers \c left and \c
+   *  right.
+   */
+  template <typename Container, typename Hash>
+  inline void swap(hash_indexed<Container, Hash>& left,
+                   hash_indexed<Container, Hash>& right)
+  { left.swap(right); }
+
+} // namespace spatial
+
+#endif // SPATIAL_HASH_INDEXED_HPP
@@ -0,0 +1,191 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   kd_forest_multiset.hpp
+ *  Contains the definition of \ref spatial::kd_forest_multiset, a container
+ *  for approximate nearest neighbor search among keys of high rank.
+ */
+
+#ifndef SPATIAL_KD_FOREST_MULTISET_HPP
+#define SPATIAL_KD_FOREST_MULTISET_HPP
+
+#include <memory>  // std::allocator
+#include "function.hpp"
+#include "metric.hpp"
+#include "bits/spatial_except.hpp"
+#include "bits/spatial_kd_forest.hpp"
+
+namespace spatial
+{
+  /**
+   *  A multiset of points indexed by several randomized k-d trees, for
+   *  approximate nearest neighbor search among keys of high rank, such as
+   *  feature descriptors.
+   *
+   *  Beyond a few tens of dimensions, the cut planes of a k-d tree no longer
+   *  prune its exact searches, which end up visiting nearly every node. The
+   *  searches of this container compare the target with a fixed budget of
+   *  values, chosen as the closest cells of all its trees. Their cost does
+   *  not grow with the number of values, and their accuracy grows with the
+   *  budget, set by \c set_max_checks(), and with the number of trees, set
+   *  at construction.
+   *
+   *  The k nearest values are obtained with \c nearest_neighbors(), which
+   *  has the same interface as in \ref morton_point_multiset, or with \ref
+   *  spatial::nearest_neighbors() given a \ref euclidian or \ref quadrance
+   *  metric, and the distance is the euclidian distance between the
+   *  coordinates read by \c Compare. Erased values are skipped by the
+   *  searches until the forest is rebuilt.
+   *
+   *  \tparam Rank The rank of the keys, or 0 to set it at run time.
+   *  \tparam Key The type of the keys.
+   *  \tparam Compare The comparator that reads the coordinates of the keys;
+   *  one of \ref bracket_less, \ref paren_less, \ref iterator_less or \ref
+   *  accessor_less.
+   *  \tparam Alloc The allocator of the values.
+   */
+  template<dimension_type Rank, typename Key,
+           typename Compare = bracket_less<Key>,
+           typename Alloc = std::allocator<Key> >
+  struct kd_forest_multiset
+    : details::Kd_forest<details::Static_rank<Rank>, Key, Compare, Alloc>
+  {
+  private:
+    typedef details::Kd_forest<details::Static_rank<Rank>, Key, Compare,
+                               Alloc> base_type;
+
+  public:
+    kd_forest_multiset()
+      : base_type(details::Static_rank<Rank>(), Compare(),
+                  base_type::default_trees, Alloc())
+    { }
+
+    explicit kd_forest_multiset(const Compare& compare)
+      : base_type(details::Static_rank<Rank>(), compare,
+                  base_type::default_trees, Alloc())
+    { }
+
+    kd_forest_multiset(const Compare& compare, std::size_t trees)
+      : base_type(details::Static_rank<Rank>(), compare, trees, Alloc())
+    { }
+
+    kd_forest_multiset(const Compare& compare, std::size_t trees,
+                       const Alloc& alloc)
+      : base_type(details::Static_rank<Rank>(), compare, trees, alloc)
+    { }
+  };
+
+  /**
+   *  Specialization for \ref kd_forest_multiset with runtime rank support.
+   *
+   *  \code
+   *    struct descriptor { ... };
+   *    kd_forest_multiset<0, descriptor> index(128);
+   *  \endcode
+   */
+  template<typename Key, typename Compare, typename Alloc>
+  struct kd_forest_multiset<0, Key, Compare, Alloc>
+    : details::Kd_forest<details::Dynamic_rank, Key, Compare, Alloc>
+  {
+  private:
+    typedef details::Kd_forest<details::Dynamic_rank, Key, Compare, Alloc>
+    base_type;
+
+  public:
+    kd_forest_multiset()
+      : base_type(details::Dynamic_rank(), Compare(),
+                  base_type::default_trees, Alloc())
+    { }
+
+    explicit kd_forest_multiset(dimension_type dim)
+      : base_type(details::Dynamic_rank(dim), Compare(),
+                  base_type::default_trees, Alloc())
+    { except::check_rank(dim); }
+
+    kd_forest_multiset(dimension_type dim, const Compare& compare)
+      : base_type(details::Dynamic_rank(dim), compare,
+                  base_type::default_trees, Alloc())
+    { except::check_rank(dim); }
+
+    kd_forest_multiset(dimension_type dim, const Compare& compare,
+                       std::size_t trees)
+      : base_type(details::Dynamic_rank(dim), compare, trees, Alloc())
+    { except::check_rank(dim); }
+
+    kd_forest_multiset(dimension_type dim, const Compare& compare,
+                       std::size_t trees, const Alloc& alloc)
+      : base_type(details::Dynamic_rank(dim), compare, trees, alloc)
+    { except::check_rank(dim); }
+  };
+
+  /**
+   *  Overloads of \ref spatial::nearest_neighbors() for \ref
+   *  kd_forest_multiset, which write iterators to the \c k values that are
+   *  approximately the closest to \c target, by increasing distance.
+   *
+   *  The forest ranks the values by their euclidian distance to \c target,
+   *  so only the \ref euclidian and \ref quadrance metrics, which rank them
+   *  in the same order, are accepted. The number of values compared with \c
+   *  target is the one set by \c set_max_checks().
+   */
+  ///@{
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Alloc, typename MetricContainer, typename DistanceType,
+            typename Diff, typename OutputIterator>
+  inline OutputIterator
+  nearest_neighbors
+  (const kd_forest_multiset<Rank, Key, Compare, Alloc>& container,
+   const euclidian<MetricContainer, DistanceType, Diff>&,
+   const typename kd_forest_multiset<Rank, Key, Compare, Alloc>::key_type&
+   target,
+   typename kd_forest_multiset<Rank, Key, Compare, Alloc>::size_type k,
+   OutputIterator out)
+  { return container.nearest_neighbors(target, k, out); }
+
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Alloc, typename MetricContainer, typename DistanceType,
+            typename Diff, typename OutputIterator>
+  inline OutputIterator
+  nearest_neighbors
+  (kd_forest_multiset<Rank, Key, Compare, Alloc>& container,
+   const euclidian<MetricContainer, DistanceType, Diff>&,
+   const typename kd_forest_multiset<Rank, Key, Compare, Alloc>::key_type&
+   target,
+   typename kd_forest_multiset<Rank, Key, Compare, Alloc>::size_type k,
+   OutputIterator out)
+  { return container.nearest_neighbors(target, k, out); }
+
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Alloc, typename MetricContainer, typename DistanceType,
+            typename Diff, typename OutputIterator>
+  inline OutputIterator
+  nearest_neighbors
+  (const kd_forest_multiset<Rank, Key, Compare, Alloc>& container,
+   const quadrance<MetricContainer, DistanceType, Diff>&,
+   const typename kd_forest_multiset<Rank, Key, Compare, Alloc>::key_type&
+   target,
+   typename kd_forest_multiset<Rank, Key, Compare, Alloc>::size_type k,
+   OutputIterator out)
+  { return container.nearest_neighbors(target, k, out); }
+
+  template <dimension_type Rank, typename Key, typename Compare,
+            typename Alloc, typename MetricContainer, typename DistanceType,
+            typename Diff, typename OutputIterator>
+  inline OutputIterator
+  nearest_neighbors
+  (kd_forest_multiset<Rank, Key, Compare, Alloc>& container,
+   const quadrance<MetricContainer, DistanceType, Diff>&,
+   const typename kd_forest_multiset<Rank, Key, Compare, Alloc>::key_type&
+   target,
+   typename kd_forest_multiset<Rank, Key, Compare, Alloc>::size_type k,
+   OutputIterator out)
+  { return container.nearest_neighbors(target, k, out); }
+  ///@}
+}
+
+#endif // SPATIAL_KD_FOREST_MULTISET_HPP
@@ -157,9 +157,10 @@ namespace spatial
     //! use this form in \c for loops.
     mapping_iterator<Ct>& operator++()
     {
+      details::Stats_scope scope(*this);
       import::tie(node, node_dim)
         = increment_mapping(node, node_dim, rank(),
-                            _data.mapping_dim, key_comp());
+                            _data.mapping_dim, details::counted(key_comp()));
       return *this;
     }
 
@@ -167,10 +168,11 @@ namespace spatial
     //! the increment. Prefer to use the other form in \c for loops.
     mapping_iterator<Ct> operator++(int)
     {
+      details::Stats_scope scope(*this);
       mapping_iterator<Ct> x(*this);
       import::tie(node, node_dim)
         = increment_mapping(node, node_dim, rank(),
-                            _data.mapping_dim, key_comp());
+                            _data.mapping_dim, details::counted(key_comp()));
       return x;
     }
 
@@ -178,9 +180,10 @@ namespace spatial
     //! use this form in \c for loops.
     mapping_iterator<Ct>& operator--()
     {
+      details::Stats_scope scope(*this);
       import::tie(node, node_dim)
         = decrement_mapping(node, node_dim, rank(),
-                            _data.mapping_dim, key_comp());
+                            _data.mapping_dim, details::counted(key_comp()));
       return *this;
     }
 
@@ -188,10 +191,11 @@ namespace spatial
     //! the decrement. Prefer to use the other form in \c for loops.
     mapping_iterator<Ct> operator--(int)
     {
+      details::Stats_scope scope(*this);
       mapping_iterator<Ct> x(*this);
       import::tie(node, node_dim)
         = decrement_mapping(node, node_dim, rank(),
-                            _data.mapping_dim, key_comp());
+                            _data.mapping_dim, details::counted(key_comp()));
       return x;
     }
 
@@ -314,16 +318,17 @@ namespace spatial
 
     //! Convertion of mutable iterator into a constant iterator is permitted.
     mapping_iterator(const mapping_iterator<Ct>& iter)
-      : Base(iter.rank(), iter.node, iter.node_dim),
+      : Base(iter.rank(), iter.node, iter.node_dim, iter),
         _data(iter.key_comp(), iter.mapping_dimension()) { }
 
     //! Increments the iterator and returns the incremented value. Prefer to
     //! use this form in \c for loops.
     mapping_iterator<const Ct>& operator++()
     {
+      details::Stats_scope scope(*this);
       import::tie(node, node_dim)
         = increment_mapping(node, node_dim, rank(),
-                            _data.mapping_dim, key_comp());
+                            _data.mapping_dim, details::counted(key_comp()));
       return *this;
     }
 
@@ -331,10 +336,11 @@ namespace spatial
     //! the increment. Prefer to use the other form in \c for loops.
     mapping_iterator<const Ct> operator++(int)
     {
+      details::Stats_scope scope(*this);
       mapping_iterator<const Ct> x(*this);
       import::tie(node, node_dim)
         = increment_mapping(node, node_dim, rank(),
-                            _data.mapping_dim, key_comp());
+                            _data.mapping_dim, details::counted(key_comp()));
       return x;
     }
 
@@ -342,9 +348,10 @@ namespace spatial
     //! use this form in \c for loops.
     mapping_iterator<const Ct>& operator--()
     {
+      details::Stats_scope scope(*this);
       import::tie(node, node_dim)
         = decrement_mapping(node, node_dim, rank(),
-                            _data.mapping_dim, key_comp());
+                            _data.mapping_dim, details::counted(key_comp()));
       return *this;
     }
 
@@ -352,10 +359,11 @@ namespace spatial
     //! the decrement. Prefer to use the other form in \c for loops.
     mapping_iterator<const Ct> operator--(int)
     {
+      details::Stats_scope scope(*this);
       mapping_iterator<const Ct> x(*this);
       import::tie(node, node_dim)
         = decrement_mapping(node, node_dim, rank(),
-                            _data.mapping_dim, key_comp());
+                            _data.mapping_dim, details::counted(key_comp()));
       return x;
     }
 
@@ -480,14 +488,17 @@ namespace spatial
   {
     if (container.empty()) return mapping_end(container, mapping_dim);
     except::check_dimension(container.dimension(), mapping_dim);
+    details::Stats_scope scope;
     typename mapping_iterator<Container>::node_ptr node
-      = container.end().node->parent;
+      = details::descend(container.end().node->parent);
     dimension_type dim;
     import::tie(node, dim)
       = minimum_mapping(node, 0,
                         container.rank(), mapping_dim,
-                        container.key_comp());
-    return mapping_iterator<Container>(container, mapping_dim, dim, node);
+                        details::counted(container.key_comp()));
+    mapping_iterator<Container> iter(container, mapping_dim, dim, node);
+    scope.close(iter);
+    return iter;
   }
 
   template <typename Container>
@@ -681,13 +692,16 @@ namespace spatial
   {
     if (container.empty()) return mapping_end(container, mapping_dim);
     except::check_dimension(container.dimension(), mapping_dim);
+    details::Stats_scope scope;
     typename mapping_iterator<Container>::node_ptr node
-      = container.end().node->parent;
+      = details::descend(container.end().node->parent);
     dimension_type dim;
     import::tie(node, dim)
       = lower_bound_mapping(node, 0, container.rank(), mapping_dim,
-                            container.key_comp(), bound);
-    return mapping_iterator<Container>(container, mapping_dim, dim, node);
+                            details::counted(container.key_comp()), bound);
+    mapping_iterator<Container> iter(container, mapping_dim, dim, node);
+    scope.close(iter);
+    return iter;
   }
 
   template <typename Container>
@@ -731,13 +745,16 @@ namespace spatial
   {
     if (container.empty()) return mapping_end(container, mapping_dim);
     except::check_dimension(container.dimension(), mapping_dim);
+    details::Stats_scope scope;
     typename mapping_iterator<Container>::node_ptr node
-      = container.end().node->parent;
+      = details::descend(container.end().node->parent);
     dimension_type dim;
     import::tie(node, dim)
       = upper_bound_mapping(node, 0, container.rank(), mapping_dim,
-                            container.key_comp(), bound);
-    return mapping_iterator<Container>(container, mapping_dim, dim, node);
+                            details::counted(container.key_comp()), bound);
+    mapping_iterator<Container> iter(container, mapping_dim, dim, node);
+    scope.close(iter);
+    return iter;
   }
 
   template <typename Container>
@@ -812,26 +829,26 @@ namespace spatial
       for (;;)
         {
           if (node->right != 0
-              && (dim != map || best == 0
-                  || key_comp(map, const_key(node), const_key(best))))
+              && explore(dim != map || best == 0
+                         || key_comp(map, const_key(node), const_key(best))))
             {
-              node = node->right; dim = incr_dim(rank, dim);
+              node = descend(node->right); dim = incr_dim(rank, dim);
               while (node->left != 0
-                     && (dim != map
-                         || left_compare_mapping
-                            (key_comp, map, const_key(orig), const_key(node),
-                             invariant_category(node))))
-                { node = node->left; dim = incr_dim(rank, dim); }
+                     && explore(dim != map
+                                || left_compare_mapping
+                                (key_comp, map, const_key(orig),
+                                 const_key(node), invariant_category(node))))
+                { node = descend(node->left); dim = incr_dim(rank, dim); }
             }
           else
             {
               NodePtr prev_node = node;
-              node = node->parent; dim = decr_dim(rank, dim);
+              node = climb(node); dim = decr_dim(rank, dim);
               while (!header(node)
                      && prev_node == node->right)
                 {
                   prev_node = node;
-                  node = node->parent; dim = decr_dim(rank, dim);
+                  node = climb(node); dim = decr_dim(rank, dim);
                 }
               if (header(node)) break;
             }
@@ -855,24 +872,25 @@ namespace spatial
       for (;;)
         {
           if (node->left != 0
-              && (dim != map
-                  || key_comp(map, const_key(orig), const_key(node))))
+              && explore(dim != map
+                         || key_comp(map, const_key(orig), const_key(node))))
             {
-              node = node->left; dim = incr_dim(rank, dim);
+              node = descend(node->left); dim = incr_dim(rank, dim);
               while (node->right != 0
-                     && (dim != map || best == 0
-                         || key_comp(map, const_key(node), const_key(best))))
-                { node = node->right; dim = incr_dim(rank, dim); }
+                     && explore(dim != map || best == 0
+                                || key_comp(map, const_key(node),
+                                            const_key(best))))
+                { node = descend(node->right); dim = incr_dim(rank, dim); }
             }
           else
             {
               NodePtr prev_node = node;
-              node = node->parent; dim = decr_dim(rank, dim);
+              node = climb(node); dim = decr_dim(rank, dim);
               while (!header(node)
                      && prev_node == node->left)
                 {
                   prev_node = node;
-                  node = node->parent; dim = decr_dim(rank, dim);
+                  node = climb(node); dim = decr_dim(rank, dim);
                 }
               if (header(node)) break;
             }
@@ -925,7 +943,7 @@ namespace spatial
     {
       SPATIAL_ASSERT_CHECK(dim < rank());
       if (header(node))
-        return maximum_mapping(node->parent, 0, rank, map, key_comp);
+        return maximum_mapping(descend(node->parent), 0, rank, map, key_comp);
       NodePtr orig = node;
       dimension_type orig_dim = dim;
       NodePtr best = 0;
@@ -935,24 +953,25 @@ namespace spatial
       for (;;)
         {
           if (node->left != 0
-              && (dim != map || best == 0
-                  || key_comp(map, const_key(best), const_key(node))))
+              && explore(dim != map || best == 0
+                         || key_comp(map, const_key(best), const_key(node))))
             {
-              node = node->left; dim = incr_dim(rank, dim);
+              node = descend(node->left); dim = incr_dim(rank, dim);
               while (node->right != 0
-                     && (dim != map
-                         || !key_comp(map, const_key(orig), const_key(node))))
-                { node = node->right; dim = incr_dim(rank, dim); }
+                     && explore(dim != map
+                                || !key_comp(map, const_key(orig),
+                                             const_key(node))))
+                { node = descend(node->right); dim = incr_dim(rank, dim); }
             }
           else
             {
               NodePtr prev_node = node;
-              node = node->parent; dim = decr_dim(rank, dim);
+              node = climb(node); dim = decr_dim(rank, dim);
               while (!header(node)
                      && prev_node == node->left)
                 {
                   prev_node = node;
-                  node = node->parent; dim = decr_dim(rank, dim);
+                  node = climb(node); dim = decr_dim(rank, dim);
                 }
               if (header(node)) break;
             }
@@ -976,24 +995,25 @@ namespace spatial
       for (;;)
         {
           if (node->right != 0
-              && (dim != map
-                  || key_comp(map, const_key(node), const_key(orig))))
+              && explore(dim != map
+                         || key_comp(map, const_key(node), const_key(orig))))
             {
-              node = node->right; dim = incr_dim(rank, dim);
+              node = descend(node->right); dim = incr_dim(rank, dim);
               while (node->left != 0
-                     && (dim != map || best == 0
-                         || key_comp(map, const_key(best), const_key(node))))
-                { node = node->left; dim = incr_dim(rank, dim); }
+                     && explore(dim != map || best == 0
+                                || key_comp(map, const_key(best),
+                                            const_key(node))))
+                { node = descend(node->left); dim = incr_dim(rank, dim); }
             }
           else
             {
               NodePtr prev_node = node;
-              node = node->parent; dim = decr_dim(rank, dim);
+              node = climb(node); dim = decr_dim(rank, dim);
               while (!header(node)
                      && prev_node == node->right)
                 {
                   prev_node = node;
-                  node = node->parent; dim = decr_dim(rank, dim);
+                  node = climb(node); dim = decr_dim(rank, dim);
                 }
               if (header(node)) break;
             }
@@ -1049,37 +1069,38 @@ namespace spatial
       SPATIAL_ASSERT_CHECK(dim < rank());
       SPATIAL_ASSERT_CHECK(!header(node));
       while (node->left != 0
-             && (dim != map
-                 || left_compare_mapping(key_comp, map, bound, const_key(node),
-                                         invariant_category(node))))
-        { node = node->left; dim = incr_dim(rank, dim); }
+             && explore(dim != map
+                        || left_compare_mapping(key_comp, map, bound,
+                                                const_key(node),
+                                                invariant_category(node))))
+        { node = descend(node->left); dim = incr_dim(rank, dim); }
       NodePtr best = 0;
       dimension_type best_dim = 0;
       if (!key_comp(map, const_key(node), bound))
         { best = node; best_dim = dim; }
       for (;;)
         {
-          if (node->right != 0 && (dim != map || best == 0))
+          if (node->right != 0 && explore(dim != map || best == 0))
             {
-              node = node->right;
+              node = descend(node->right);
               dim = incr_dim(rank, dim);
               while (node->left != 0
-                     && (dim != map
-                         || left_compare_mapping(key_comp, map, bound,
-                                                 const_key(node),
-                                                 invariant_category(node))))
-                { node = node->left; dim = incr_dim(rank, dim); }
+                     && explore(dim != map
+                                || left_compare_mapping
+                                (key_comp, map, bound, const_key(node),
+                                 invariant_category(node))))
+                { node = descend(node->left); dim = incr_dim(rank, dim); }
             }
           else
             {
               NodePtr prev_node = node;
-              node = node->parent;
+              node = climb(node);
               dim = decr_dim(rank, dim);
               while (!header(node)
                      && prev_node == node->right)
                 {
                   prev_node = node;
-                  node = node->parent; dim = decr_dim(rank, dim);
+                  node = climb(node); dim = decr_dim(rank, dim);
                 }
               if (header(node)) break;
             }
@@ -1134,34 +1155,34 @@ namespace spatial
       SPATIAL_ASSERT_CHECK(dim < rank());
       SPATIAL_ASSERT_CHECK(!header(node));
       while (node->left != 0
-             && (dim != map
-                 || key_comp(map, bound, const_key(node))))
-        { node = node->left; dim = incr_dim(rank, dim); }
+             && explore(dim != map
+                        || key_comp(map, bound, const_key(node))))
+        { node = descend(node->left); dim = incr_dim(rank, dim); }
       NodePtr best = 0;
       dimension_type best_dim = 0;
       if (key_comp(map, bound, const_key(node)))
         { best = node; best_dim = dim; }
       for (;;)
         {
-          if (node->right != 0 && (dim != map || best == 0))
+          if (node->right != 0 && explore(dim != map || best == 0))
             {
-              node = node->right;
+              node = descend(node->right);
               dim = incr_dim(rank, dim);
               while (node->left != 0
-                     && (dim != map
-                         || key_comp(map, bound, const_key(node))))
-                { node = node->left; dim = incr_dim(rank, dim); }
+                     && explore(dim != map
+                                || key_comp(map, bound, const_key(node))))
+                { node = descend(node->left); dim = incr_dim(rank, dim); }
             }
           else
             {
               NodePtr prev_node = node;
-              node = node->parent;
+              node = climb(node);
               dim = decr_dim(rank, dim);
               while (!header(node)
                      && prev_node == node->right)
                 {
                   prev_node = node;
-                  node = node->parent; dim = decr_dim(rank, dim);
+                  node = climb(node); dim = decr_dim(rank, dim);
                 }
               if (header(node)) break;
             }
@@ -1177,6 +1198,71 @@ namespace spatial
       return std::make_pair(best, best_dim);
     }
 
+    /**
+     *  \name Dispatch of \dynamic_rank
+     *
+     *  Overloads of the mapping traversals for \dynamic_rank. If the rank of
+     *  the container is listed in \ref SPATIAL_DISPATCH_RANKS, the traversal
+     *  is carried out with the equivalent \static_rank.
+     */
+    ///@{
+    template <typename NodePtr, typename KeyCompare>
+    inline std::pair<NodePtr, dimension_type>
+    increment_mapping
+    (NodePtr node, dimension_type dim, Dynamic_rank rank, dimension_type map,
+     const KeyCompare& key_comp)
+    {
+#     define SPATIAL_RANK_DISPATCH_CALL(r) \
+        increment_mapping(node, dim, r, map, key_comp)
+      SPATIAL_RANK_DISPATCH(rank)
+#     undef SPATIAL_RANK_DISPATCH_CALL
+      return increment_mapping<NodePtr, Dynamic_rank, KeyCompare>
+        (node, dim, rank, map, key_comp);
+    }
+
+    template <typename NodePtr, typename KeyCompare>
+    inline std::pair<NodePtr, dimension_type>
+    decrement_mapping
+    (NodePtr node, dimension_type dim, Dynamic_rank rank, dimension_type map,
+     const KeyCompare& key_comp)
+    {
+#     define SPATIAL_RANK_DISPATCH_CALL(r) \
+        decrement_mapping(node, dim, r, map, key_comp)
+      SPATIAL_RANK_DISPATCH(rank)
+#     undef SPATIAL_RANK_DISPATCH_CALL
+      return decrement_mapping<NodePtr, Dynamic_rank, KeyCompare>
+        (node, dim, rank, map, key_comp);
+    }
+
+    template <typename NodePtr, typename KeyCompare, typename KeyType>
+    inline std::pair<NodePtr, dimension_type>
+    lower_bound_mapping
+    (NodePtr node, dimension_type dim, Dynamic_rank rank, dimension_type map,
+     const KeyCompare& key_comp, const KeyType& bound)
+    {
+#     define SPATIAL_RANK_DISPATCH_CALL(r) \
+        lower_bound_mapping(node, dim, r, map, key_comp, bound)
+      SPATIAL_RANK_DISPATCH(rank)
+#     undef SPATIAL_RANK_DISPATCH_CALL
+      return lower_bound_mapping<NodePtr, Dynamic_rank, KeyCompare, KeyType>
+        (node, dim, rank, map, key_comp, bound);
+    }
+
+    template <typename NodePtr, typename KeyCompare, typename KeyType>
+    inline std::pair<NodePtr, dimension_type>
+    upper_bound_mapping
+    (NodePtr node, dimension_type dim, Dynamic_rank rank, dimension_type map,
+     const KeyCompare& key_comp, const KeyType& bound)
+    {
+#     define SPATIAL_RANK_DISPATCH_CALL(r) \
+        upper_bound_mapping(node, dim, r, map, key_comp, bound)
+      SPATIAL_RANK_DISPATCH(rank)
+#     undef SPATIAL_RANK_DISPATCH_CALL
+      return upper_bound_mapping<NodePtr, Dynamic_rank, KeyCompare, KeyType>
+        (node, dim, rank, map, key_comp, bound);
+    }
+    ///@}
+
   } // namespace details
 }
 
@@ -104,6 +104,37 @@ namespace spatial
                                                   difference());
     }
 
+    /**
+     *  The same distances, from an \c origin of another type than the key
+     *  type of the container. They are available only if the difference
+     *  functor is transparent, such as \ref bracket_minus<void, Unit>.
+     */
+    ///@{
+    template <typename Origin>
+    typename enable_if_c
+    <details::is_transparent_query<difference_type, Origin, key_type>::value,
+     distance_type>::type
+    distance_to_key(dimension_type rank,
+                    const Origin& origin, const key_type& key) const
+    {
+      return math::euclid_distance_to_key
+        <key_type, difference_type, DistanceType>(rank, origin, key,
+                                                  difference());
+    }
+
+    template <typename Origin>
+    typename enable_if_c
+    <details::is_transparent_query<difference_type, Origin, key_type>::value,
+     distance_type>::type
+    distance_to_plane(dimension_type, dimension_type dim,
+                      const Origin& origin, const key_type& key) const
+    {
+      return math::euclid_distance_to_plane
+        <key_type, difference_type, DistanceType>(dim, origin, key,
+                                                  difference());
+    }
+    ///@}
+
     /**
      *  Returns the difference functor used in this type.
      */
@@ -193,6 +224,37 @@ namespace spatial
                                                   difference());
     }
 
+    /**
+     *  The same distances, from an \c origin of another type than the key
+     *  type of the container. They are available only if the difference
+     *  functor is transparent, such as \ref bracket_minus<void, Unit>.
+     */
+    ///@{
+    template <typename Origin>
+    typename enable_if_c
+    <details::is_transparent_query<difference_type, Origin, key_type>::value,
+     distance_type>::type
+    distance_to_key(dimension_type rank,
+                    const Origin& origin, const key_type& key) const
+    {
+      return math::square_euclid_distance_to_key
+        <key_type, difference_type, DistanceType>(rank, origin, key,
+                                                  difference());
+    }
+
+    template <typename Origin>
+    typename enable_if_c
+    <details::is_transparent_query<difference_type, Origin, key_type>::value,
+     distance_type>::type
+    distance_to_plane(dimension_type, dimension_type dim,
+                      const Origin& origin, const key_type& key) const
+    {
+      return math::square_euclid_distance_to_plane
+        <key_type, difference_type, DistanceType>(dim, origin, key,
+                                                  difference());
+    }
+    ///@}
+
     /**
      *  Returns the difference functor used in this type.
      */
@@ -287,6 +349,37 @@ namespace spatial
                                                   difference());
     }
 
+    /**
+     *  The same distances, from an \c origin of another type than the key
+     *  type of the container. They are available only if the difference
+     *  functor is transparent, such as \ref bracket_minus<void, Unit>.
+     */
+    ///@{
+    template <typename Origin>
+    typename enable_if_c
+    <details::is_transparent_query<difference_type, Origin, key_type>::value,
+     distance_type>::type
+    distance_to_key(dimension_type rank,
+                    const Origin& origin, const key_type& key) const
+    {
+      return math::manhattan_distance_to_key
+        <key_type, difference_type, DistanceType>(rank, origin, key,
+                                                  difference());
+    }
+
+    template <typename Origin>
+    typename enable_if_c
+    <details::is_transparent_query<difference_type, Origin, key_type>::value,
+     distance_type>::type
+    distance_to_plane(dimension_type, dimension_type dim,
+                      const Origin& origin, const key_type& key) const
+    {
+      return math::manhattan_distance_to_plane
+        <key_type, difference_type, DistanceType>(dim, origin, key,
+                                                  difference());
+    }
+    ///@}
+
     /**
      *  Returns the difference functor used in this type.
      */
@@ -294,6 +387,31 @@ namespace spatial
     { return *static_cast<const Diff*>(this); }
   };
 
+  /**
+   *  Adapts a \metric so that the neighbor iterators built with it store a
+   *  target of type \c Target, instead of the key type of the container.
+   *
+   *  \c Target is any type that the comparator of the container and the
+   *  difference functor of \c Metric can read, such as a \c std::array of
+   *  coordinates queried against a container of heavier keys. Both must
+   *  therefore be transparent, such as \ref bracket_less<void> and \ref
+   *  bracket_minus<void, Unit>.
+   *
+   *  \tparam Metric The adapted metric, such as \ref euclidian.
+   *  \tparam Target The type of the targets of the neighbor searches.
+   */
+  template <typename Metric, typename Target>
+  struct target_metric : Metric
+  {
+    //! The type of the targets of the neighbor searches.
+    typedef Target target_type;
+
+    target_metric() { }
+
+    //! Adapts a copy of \c metric.
+    explicit target_metric(const Metric& metric) : Metric(metric) { }
+  };
+
 } // namespace spatial
 
 #endif // SPATIAL_METRIC_HPP
@@ -0,0 +1,706 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   morton_point_multiset.hpp
+ *  Contains the definition of \ref spatial::morton_point_multiset, a static
+ *  container that stores points with integral coordinates in a flat array
+ *  sorted by Morton code, and of \ref spatial::morton_region_iterator, the
+ *  iterator over the points of this container that lie in a region.
+ */
+
+#ifndef SPATIAL_MORTON_POINT_MULTISET_HPP
+#define SPATIAL_MORTON_POINT_MULTISET_HPP
+
+#include <memory>  // std::allocator
+#include <vector>
+#include <limits> // std::numeric_limits
+#include <utility> // std::pair
+#include <iterator> // std::forward_iterator_tag, std::reverse_iterator
+#include <algorithm> // std::inplace_merge, std::push_heap, std::pop_heap
+#include "function.hpp"
+#include "bits/spatial_morton.hpp"
+#include "bits/spatial_except.hpp"
+
+namespace spatial
+{
+  namespace details
+  {
+    //! Only defined for \c true, to fail the compilation otherwise.
+    template <bool Valid> struct Morton_rank_check;
+    template <> struct Morton_rank_check<true> { };
+
+    /**
+     *  A box of a \ref morton_point_multiset, given by its lowest and highest
+     *  coordinates, which are both included, and by the Morton codes of its
+     *  lowest and highest corners. An empty box has a \c min_code greater
+     *  than its \c max_code.
+     */
+    template <typename Code, dimension_type Rank>
+    struct Morton_region
+    {
+      Code lower[Rank];
+      Code upper[Rank];
+      Code min_code;
+      Code max_code;
+    };
+  }
+
+  template <typename Container>
+  class morton_region_iterator;
+
+  /**
+   *  A multiset of points with non-negative integral coordinates, stored in a
+   *  single array sorted by the Morton code of the points.
+   *
+   *  This container is an alternative to \idle_point_multiset for keys of low
+   *  rank that are integers or that were quantized, such as the cells of a
+   *  2D or 3D grid. It holds no pointers: its memory is the array of values,
+   *  and building it is a radix sort of the codes, in linear time.
+   *
+   *  Regions are searched with \ref morton_region_iterator, obtained with
+   *  region_begin() and region_end(), which walks the curve through the
+   *  region and uses the BIGMIN computation to jump over the parts of the
+   *  curve that leave it. Nearest neighbors are found by scanning boxes of
+   *  increasing sizes around the target.
+   *
+   *  Each coordinate is read with \c Accessor, converted to \c Code, and may
+   *  not exceed \ref max_coordinate(); an \ref invalid_coordinate exception
+   *  is thrown otherwise. Inserting a single value moves all the values that
+   *  follow it; insert values in batches whenever possible.
+   *
+   *  \tparam Rank The number of dimensions of the points, which may not
+   *  exceed the number of bits of \c Code.
+   *  \tparam Key The type of the points.
+   *  \tparam Accessor A functor called as <tt>accessor(dim, key)</tt> to
+   *  return the coordinate of \c key on \c dim.
+   *  \tparam Code An unsigned integral type that holds the Morton codes.
+   *  \tparam Alloc The allocator of the values.
+   */
+  template<dimension_type Rank, typename Key,
+           typename Accessor = bracket_accessor<Key, std::size_t>,
+           typename Code = std::size_t,
+           typename Alloc = std::allocator<Key> >
+  class morton_point_multiset
+  {
+  private:
+    typedef std::vector<Key, Alloc> storage_type;
+
+    //! Fails to compile if \c Rank is 0 or exceeds the bits of \c Code.
+    typedef char check_rank_type
+    [sizeof(details::Morton_rank_check
+            <(Rank > 0 && Rank <= static_cast<dimension_type>
+              (std::numeric_limits<Code>::digits))>)];
+
+    template <typename> friend class morton_region_iterator;
+
+  public:
+    typedef details::Static_rank<Rank>                    rank_type;
+    typedef Key                                           key_type;
+    typedef Key                                           value_type;
+    typedef Accessor                                      accessor_type;
+    typedef accessor_less<Accessor, Key>                  key_compare;
+    typedef Code                                          code_type;
+    typedef Alloc                                         allocator_type;
+    typedef typename storage_type::size_type              size_type;
+    typedef typename storage_type::difference_type        difference_type;
+    typedef const Key*                                    pointer;
+    typedef const Key*                                    const_pointer;
+    typedef const Key&                                    reference;
+    typedef const Key&                                    const_reference;
+    typedef typename storage_type::const_iterator         iterator;
+    typedef typename storage_type::const_iterator         const_iterator;
+    typedef std::reverse_iterator<const_iterator>         reverse_iterator;
+    typedef std::reverse_iterator<const_iterator>
+    const_reverse_iterator;
+    typedef details::Morton_region<Code, Rank>            region_type;
+
+    morton_point_multiset() { }
+
+    explicit morton_point_multiset(const Accessor& accessor_)
+      : _accessor(accessor_)
+    { }
+
+    morton_point_multiset(const Accessor& accessor_, const Alloc& alloc)
+      : _accessor(accessor_), _values(alloc)
+    { }
+
+    //! Returns the rank of the container.
+    rank_type rank() const { return rank_type(); }
+
+    //! Returns the number of dimensions of the container.
+    dimension_type dimension() const { return Rank; }
+
+    //! Returns the comparator of the coordinates read by the accessor.
+    key_compare key_comp() const { return key_compare(_accessor); }
+
+    //! Returns the accessor of the coordinates.
+    accessor_type accessor() const { return _accessor; }
+
+    allocator_type get_allocator() const { return _values.get_allocator(); }
+
+    //! Returns the largest coordinate that may be stored on any dimension.
+    static code_type max_coordinate()
+    {
+      const unsigned int bits = details::morton_bits<Code>(Rank);
+      return bits == static_cast<unsigned int>
+        (std::numeric_limits<Code>::digits)
+        ? (std::numeric_limits<Code>::max)()
+        : static_cast<Code>((Code(1) << bits) - 1u);
+    }
+
+    /**
+     *  Returns the Morton code of \c key.
+     *  \throws invalid_coordinate if a coordinate of \c key exceeds \ref
+     *  max_coordinate().
+     */
+    code_type code(const key_type& key) const
+    {
+      Code coord[Rank];
+      checked_coordinates(key, coord);
+      return details::morton_encode(coord, Rank);
+    }
+
+    ///@{
+    //! Iterates over the values in the order of their Morton codes.
+    const_iterator begin() const { return _values.begin(); }
+    const_iterator end() const { return _values.end(); }
+    const_iterator cbegin() const { return _values.begin(); }
+    const_iterator cend() const { return _values.end(); }
+    const_reverse_iterator rbegin() const
+    { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const
+    { return const_reverse_iterator(begin()); }
+    ///@}
+
+    bool empty() const { return _values.empty(); }
+    size_type size() const { return _values.size(); }
+    size_type max_size() const { return _values.max_size(); }
+
+    void clear() { _values.clear(); }
+
+    void swap(morton_point_multiset& other)
+    {
+      std::swap(_accessor, other._accessor);
+      _values.swap(other._values);
+    }
+
+    /**
+     *  Inserts a single value and returns an iterator to it. This moves all
+     *  the values that follow it in the array.
+     *  \throws invalid_coordinate if a coordinate exceeds \ref
+     *  max_coordinate().
+     */
+    iterator insert(const value_type& value)
+    {
+      Code coord[Rank];
+      checked_coordinates(value, coord);
+      difference_type offset = upper(begin(), end(), coord) - begin();
+      _values.insert(_values.begin() + offset, value);
+      return begin() + offset;
+    }
+
+    /**
+     *  Inserts the values of [\c first, \c last). The values are sorted
+     *  among themselves by a radix sort of their Morton codes, and then
+     *  merged with the values already in the container.
+     *  \throws invalid_coordinate if a coordinate exceeds \ref
+     *  max_coordinate(), in which case the container is left unchanged.
+     */
+    template <typename InputIterator>
+    void insert(InputIterator first, InputIterator last)
+    {
+      typedef std::pair<Code, std::size_t> entry_type;
+      storage_type batch(first, last, _values.get_allocator());
+      if (batch.empty()) return;
+      std::vector<entry_type> entries;
+      entries.reserve(batch.size());
+      for (std::size_t i = 0; i < batch.size(); ++i)
+        {
+          Code coord[Rank];
+          checked_coordinates(batch[i], coord);
+          entries.push_back
+            (entry_type(details::morton_encode(coord, Rank), i));
+        }
+      details::morton_radix_sort
+        (entries, Rank * details::morton_bits<Code>(Rank));
+      _values.reserve(_values.size() + batch.size());
+      difference_type middle = static_cast<difference_type>(size());
+      for (typename std::vector<entry_type>::const_iterator
+             i = entries.begin(); i != entries.end(); ++i)
+        { _values.push_back(batch[i->second]); }
+      std::inplace_merge(_values.begin(), _values.begin() + middle,
+                         _values.end(), Key_less(_accessor));
+    }
+
+    //! Erases the value pointed to by \c pos.
+    void erase(const_iterator pos)
+    {
+      _values.erase(_values.begin() + (pos - begin()));
+    }
+
+    //! Erases all the values that have the coordinates of \c key and returns
+    //! their number.
+    size_type erase(const key_type& key)
+    {
+      Code coord[Rank];
+      coordinates(key, coord);
+      const_iterator first = lower(begin(), end(), coord);
+      const_iterator last = upper(first, end(), coord);
+      typename storage_type::iterator i = _values.begin() + (first - begin());
+      _values.erase(i, i + (last - first));
+      return static_cast<size_type>(last - first);
+    }
+
+    //! Returns the first value that has the coordinates of \c key, or \ref
+    //! end() if there are none.
+    const_iterator find(const key_type& key) const
+    {
+      Code coord[Rank];
+      coordinates(key, coord);
+      const_iterator pos = lower(begin(), end(), coord);
+      if (pos == end()) return pos;
+      Code found[Rank];
+      coordinates(*pos, found);
+      for (dimension_type d = 0; d < Rank; ++d)
+        { if (found[d] != coord[d]) return end(); }
+      return pos;
+    }
+
+    //! Returns the number of values that have the coordinates of \c key.
+    size_type count(const key_type& key) const
+    {
+      Code coord[Rank];
+      coordinates(key, coord);
+      const_iterator first = lower(begin(), end(), coord);
+      return static_cast<size_type>(upper(first, end(), coord) - first);
+    }
+
+    /**
+     *  Writes in \c out the iterators to the \c k values that are the
+     *  closest to \c target, or to all values if there are fewer, by
+     *  increasing euclidian distance between their coordinates.
+     *
+     *  The values are searched in boxes centered on \c target whose sides
+     *  double at each step, until the box holds \c k values that are closer
+     *  to \c target than any value outside of the box.
+     *
+     *  \throws invalid_coordinate if a coordinate of \c target exceeds \ref
+     *  max_coordinate().
+     */
+    template <typename OutputIterator>
+    OutputIterator
+    nearest_neighbors(const key_type& target, size_type k,
+                      OutputIterator out) const
+    {
+      typedef std::pair<double, const_iterator> candidate_type;
+      Code center[Rank];
+      checked_coordinates(target, center);
+      if (k == 0 || empty()) return out;
+      const Code limit = max_coordinate();
+      std::vector<candidate_type> heap;
+      heap.reserve(k + 1);
+      for (Code radius = 1;; radius = radius > limit / 2u
+             ? limit : static_cast<Code>(radius * 2u))
+        {
+          region_type box;
+          bool whole = true;
+          for (dimension_type d = 0; d < Rank; ++d)
+            {
+              box.lower[d] = center[d] > radius
+                ? static_cast<Code>(center[d] - radius) : Code(0);
+              box.upper[d] = limit - center[d] > radius
+                ? static_cast<Code>(center[d] + radius) : limit;
+              whole = whole && box.lower[d] == 0 && box.upper[d] == limit;
+            }
+          encode_region(box);
+          heap.clear();
+          for (const_iterator pos = region_first(box);
+               pos != end(); pos = region_next(box, ++pos))
+            {
+              candidate_type candidate(distance(center, *pos), pos);
+              if (heap.size() < k)
+                {
+                  heap.push_back(candidate);
+                  std::push_heap(heap.begin(), heap.end(), Candidate_less());
+                }
+              else if (candidate.first < heap.front().first)
+                {
+                  std::pop_heap(heap.begin(), heap.end(), Candidate_less());
+                  heap.back() = candidate;
+                  std::push_heap(heap.begin(), heap.end(), Candidate_less());
+                }
+            }
+          // Values outside of the box are farther than 'radius'.
+          if (whole
+              || (heap.size() == k && heap.front().first
+                  <= static_cast<double>(radius)
+                  * static_cast<double>(radius)))
+            break;
+        }
+      std::sort_heap(heap.begin(), heap.end(), Candidate_less());
+      for (typename std::vector<candidate_type>::const_iterator
+             i = heap.begin(); i != heap.end(); ++i)
+        { *out++ = i->second; }
+      return out;
+    }
+
+    //! Returns the value that is the closest to \c target, or \ref end() if
+    //! the container is empty.
+    //! \see nearest_neighbors()
+    const_iterator nearest_neighbor(const key_type& target) const
+    {
+      const_iterator result = end();
+      nearest_neighbors(target, 1, &result);
+      return result;
+    }
+
+  private:
+    //! Compares two keys in Morton order.
+    struct Key_less
+    {
+      explicit Key_less(const Accessor& accessor_) : accessor(accessor_) { }
+      bool operator()(const Key& x, const Key& y) const
+      {
+        Code cx[Rank], cy[Rank];
+        for (dimension_type d = 0; d < Rank; ++d)
+          {
+            cx[d] = static_cast<Code>(accessor(d, x));
+            cy[d] = static_cast<Code>(accessor(d, y));
+          }
+        return details::morton_less(cx, cy, Rank);
+      }
+      Accessor accessor;
+    };
+
+    //! Orders the candidates of a nearest neighbor search by distance.
+    struct Candidate_less
+    {
+      template <typename Candidate>
+      bool operator()(const Candidate& x, const Candidate& y) const
+      { return x.first < y.first; }
+    };
+
+    void coordinates(const key_type& key, Code (&coord)[Rank]) const
+    {
+      for (dimension_type d = 0; d < Rank; ++d)
+        { coord[d] = static_cast<Code>(_accessor(d, key)); }
+    }
+
+    void checked_coordinates(const key_type& key, Code (&coord)[Rank]) const
+    {
+      coordinates(key, coord);
+      for (dimension_type d = 0; d < Rank; ++d)
+        { except::check_morton_coordinate(coord[d], max_coordinate()); }
+    }
+
+    double distance(const Code (&center)[Rank], const key_type& key) const
+    {
+      double sum = 0.0;
+      for (dimension_type d = 0; d < Rank; ++d)
+        {
+          double diff = static_cast<double>(_accessor(d, key))
+            - static_cast<double>(center[d]);
+          sum += diff * diff;
+        }
+      return sum;
+    }
+
+    //! Returns the first value in [\c first, \c last) that does not come
+    //! before \c coord in Morton order.
+    const_iterator lower(const_iterator first, const_iterator last,
+                         const Code (&coord)[Rank]) const
+    {
+      difference_type len = last - first;
+      while (len > 0)
+        {
+          difference_type half = len / 2;
+          const_iterator mid = first + half;
+          Code found[Rank];
+          coordinates(*mid, found);
+          if (details::morton_less(found, coord, Rank))
+            { first = mid + 1; len -= half + 1; }
+          else len = half;
+        }
+      return first;
+    }
+
+    //! Returns the first value in [\c first, \c last) that comes after \c
+    //! coord in Morton order.
+    const_iterator upper(const_iterator first, const_iterator last,
+                         const Code (&coord)[Rank]) const
+    {
+      difference_type len = last - first;
+      while (len > 0)
+        {
+          difference_type half = len / 2;
+          const_iterator mid = first + half;
+          Code found[Rank];
+          coordinates(*mid, found);
+          if (!details::morton_less(coord, found, Rank))
+            { first = mid + 1; len -= half + 1; }
+          else len = half;
+        }
+      return first;
+    }
+
+    //! Computes the codes of the corners of \c box, or marks it empty.
+    static void encode_region(region_type& box)
+    {
+      for (dimension_type d = 0; d < Rank; ++d)
+        {
+          if (box.lower[d] > box.upper[d])
+            { box.min_code = 1; box.max_code = 0; return; }
+        }
+      box.min_code = details::morton_encode(box.lower, Rank);
+      box.max_code = details::morton_encode(box.upper, Rank);
+    }
+
+    //! Returns the box of the points within [\c lower, \c upper).
+    region_type make_region(const key_type& lower,
+                            const key_type& upper) const
+    {
+      except::check_bounds(*this, lower, upper);
+      region_type box;
+      coordinates(lower, box.lower);
+      coordinates(upper, box.upper);
+      for (dimension_type d = 0; d < Rank; ++d)
+        {
+          --box.upper[d];
+          if (box.upper[d] > max_coordinate())
+            { box.upper[d] = max_coordinate(); }
+        }
+      encode_region(box);
+      return box;
+    }
+
+    //! Returns the first value within \c box.
+    const_iterator region_first(const region_type& box) const
+    {
+      if (box.min_code > box.max_code) return end();
+      return region_next(box, lower(begin(), end(), box.lower));
+    }
+
+    /**
+     *  Returns the first value within \c box from \c pos, which may not come
+     *  before the lowest corner of \c box. Each time a value lies out of the
+     *  box, the search jumps to the next code of the curve that re-enters
+     *  the box.
+     */
+    const_iterator region_next(const region_type& box,
+                               const_iterator pos) const
+    {
+      while (pos != end())
+        {
+          Code coord[Rank];
+          coordinates(*pos, coord);
+          bool inside = true;
+          for (dimension_type d = 0; d < Rank && inside; ++d)
+            {
+              inside = !(coord[d] < box.lower[d])
+                && !(box.upper[d] < coord[d]);
+            }
+          if (inside) return pos;
+          Code code = details::morton_encode(coord, Rank);
+          if (!(code < box.max_code)) return end();
+          Code next[Rank];
+          details::morton_decode(details::morton_bigmin
+                                 (code, box.min_code, box.max_code, Rank),
+                                 Rank, next);
+          pos = lower(pos + 1, end(), next);
+        }
+      return pos;
+    }
+
+    Accessor _accessor;
+    storage_type _values;
+  };
+
+  /**
+   *  An iterator over the values of a \ref morton_point_multiset that lie
+   *  within the region formed by 2 points, inclusive of lower values, but
+   *  exclusive of upper values, as with \ref bounds. The values are visited
+   *  in the order of their Morton codes.
+   *
+   *  \tparam Container The \ref morton_point_multiset being iterated.
+   */
+  template <typename Container>
+  class morton_region_iterator
+  {
+  public:
+    typedef std::forward_iterator_tag               iterator_category;
+    typedef typename Container::value_type          value_type;
+    typedef typename Container::difference_type     difference_type;
+    typedef typename Container::const_pointer       pointer;
+    typedef typename Container::const_reference     reference;
+    typedef typename Container::const_iterator      const_iterator;
+    typedef typename Container::key_type            key_type;
+    typedef typename Container::region_type         region_type;
+
+    //! Uninitialized iterator.
+    morton_region_iterator() : _container(0) { }
+
+    //! Builds an iterator to the first value of \c container within [\c
+    //! lower, \c upper).
+    //! \throws invalid_bounds if \c lower is not less than \c upper over
+    //! every dimension.
+    morton_region_iterator(const Container& container, const key_type& lower,
+                           const key_type& upper)
+      : _container(&container),
+        _region(container.make_region(lower, upper)),
+        _pos(container.region_first(_region))
+    { }
+
+    //! Builds a past-the-end iterator of \c container.
+    explicit morton_region_iterator(const Container& container)
+      : _container(&container), _region(), _pos(container.end())
+    { }
+
+    reference operator*() const { return *_pos; }
+    pointer operator->() const { return &*_pos; }
+
+    morton_region_iterator& operator++()
+    {
+      _pos = _container->region_next(_region, ++_pos);
+      return *this;
+    }
+
+    morton_region_iterator operator++(int)
+    {
+      morton_region_iterator x(*this);
+      ++*this;
+      return x;
+    }
+
+    bool operator==(const morton_region_iterator& other) const
+    { return _pos == other._pos; }
+
+    bool operator!=(const morton_region_iterator& other) const
+    { return _pos != other._pos; }
+
+    //! Returns the position of the iterator in the container.
+    const_iterator base() const { return _pos; }
+
+    //! Returns the region that is iterated.
+    const region_type& region() const { return _region; }
+
+  private:
+    const Container* _container;
+    region_type _region;
+    const_iterator _pos;
+  };
+
+  /**
+   *  The constant version of \ref morton_region_iterator, which is the same
+   *  iterator since the values of a \ref morton_point_multiset are always
+   *  constant.
+   */
+  template <typename Container>
+  class morton_region_iterator<const Container>
+    : public morton_region_iterator<Container>
+  {
+  private:
+    typedef morton_region_iterator<Container> Base;
+
+  public:
+    typedef typename Container::key_type key_type;
+
+    morton_region_iterator() { }
+
+    morton_region_iterator(const Container& container, const key_type& lower,
+                           const key_type& upper)
+      : Base(container, lower, upper) { }
+
+    explicit morton_region_iterator(const Container& container)
+      : Base(container) { }
+
+    morton_region_iterator(const Base& other) : Base(other) { }
+
+    morton_region_iterator& operator++()
+    { Base::operator++(); return *this; }
+
+    morton_region_iterator operator++(int)
+    {
+      morton_region_iterator x(*this);
+      Base::operator++();
+      return x;
+    }
+  };
+
+  /**
+   *  Returns the iterators that delimit the values of a \ref
+   *  morton_point_multiset within the region formed by \c lower and \c
+   *  upper, inclusive of lower values, but exclusive of upper values.
+   */
+  ///@{
+  template <dimension_type Rank, typename Key, typename Accessor,
+            typename Code, typename Alloc>
+  inline morton_region_iterator
+  <morton_point_multiset<Rank, Key, Accessor, Code, Alloc> >
+  region_begin(morton_point_multiset<Rank, Key, Accessor, Code, Alloc>&
+               container, const Key& lower, const Key& upper)
+  {
+    return morton_region_iterator
+      <morton_point_multiset<Rank, Key, Accessor, Code, Alloc> >
+      (container, lower, upper);
+  }
+
+  template <dimension_type Rank, typename Key, typename Accessor,
+            typename Code, typename Alloc>
+  inline morton_region_iterator
+  <morton_point_multiset<Rank, Key, Accessor, Code, Alloc> >
+  region_end(morton_point_multiset<Rank, Key, Accessor, Code, Alloc>&
+             container, const Key&, const Key&)
+  {
+    return morton_region_iterator
+      <morton_point_multiset<Rank, Key, Accessor, Code, Alloc> >(container);
+  }
+
+  template <dimension_type Rank, typename Key, typename Accessor,
+            typename Code, typename Alloc>
+  inline morton_region_iterator
+  <const morton_point_multiset<Rank, Key, Accessor, Code, Alloc> >
+  region_begin(const morton_point_multiset<Rank, Key, Accessor, Code, Alloc>&
+               container, const Key& lower, const Key& upper)
+  {
+    return morton_region_iterator
+      <const morton_point_multiset<Rank, Key, Accessor, Code, Alloc> >
+      (container, lower, upper);
+  }
+
+  template <dimension_type Rank, typename Key, typename Accessor,
+            typename Code, typename Alloc>
+  inline morton_region_iterator
+  <const morton_point_multiset<Rank, Key, Accessor, Code, Alloc> >
+  region_end(const morton_point_multiset<Rank, Key, Accessor, Code, Alloc>&
+             container, const Key&, const Key&)
+  {
+    return morton_region_iterator
+      <const morton_point_multiset<Rank, Key, Accessor, Code, Alloc> >
+      (container);
+  }
+
+  template <dimension_type Rank, typename Key, typename Accessor,
+            typename Code, typename Alloc>
+  inline morton_region_iterator
+  <const morton_point_multiset<Rank, Key, Accessor, Code, Alloc> >
+  region_cbegin(const morton_point_multiset<Rank, Key, Accessor, Code, Alloc>&
+                container, const Key& lower, const Key& upper)
+  { return region_begin(container, lower, upper); }
+
+  template <dimension_type Rank, typename Key, typename Accessor,
+            typename Code, typename Alloc>
+  inline morton_region_iterator
+  <const morton_point_multiset<Rank, Key, Accessor, Code, Alloc> >
+  region_cend(const morton_point_multiset<Rank, Key, Accessor, Code, Alloc>&
+              container, const Key& lower, const Key& upper)
+  { return region_end(container, lower, upper); }
+  ///@}
+
+} // namespace spatial
+
+#endif // SPATIAL_MORTON_POINT_MULTISET_HPP
@@ -252,7 +252,7 @@ namespace spatial
      *
      *  \tparam Container The type of container to iterate.
      *  \param node The node pointed to by the iterator
-     *  \param dth  The depth of the node pointed to by the iterator.
+     *  \param dth  The dimension of the node pointed to by the iterator.
      *  \param rank The rank of the container which node belongs to.
      *  \param cmp  The comparator used by the container which node belongs to.
      *  \param bound The lowest bound to the iterator position.
@@ -278,9 +278,9 @@ namespace spatial
       SPATIAL_ASSERT_CHECK(node != 0);
       NodePtr end = node->parent;
       while (node->left != 0
-             && (dth % rank() > 0
+             && (dth > 0
                  || !cmp(0, const_key(node), bound)))
-        { node = node->left; ++dth; }
+        { node = node->left; dth = incr_dim(rank, dth); }
       NodePtr best = 0;
       dimension_type best_dth = 0;
       if (!order_less(cmp, rank, const_key(node), bound))
@@ -288,23 +288,23 @@ namespace spatial
       for(;;)
         {
           if (node->right != 0
-              && (dth % rank() > 0 || best == 0
+              && (dth > 0 || best == 0
                   || !cmp(0, const_key(best), const_key(node))))
             {
-              node = node->right; ++dth;
+              node = node->right; dth = incr_dim(rank, dth);
               while (node->left != 0
-                     && (dth % rank() > 0
+                     && (dth > 0
                          || !cmp(0, const_key(node), bound)))
-                { node = node->left; ++dth; }
+                { node = node->left; dth = incr_dim(rank, dth); }
             }
           else
             {
               NodePtr prev_node = node;
-              node = node->parent; --dth;
+              node = node->parent; dth = decr_dim(rank, dth);
               while (node != end && prev_node == node->right)
                 {
                   prev_node = node;
-                  node = node->parent; --dth;
+                  node = node->parent; dth = decr_dim(rank, dth);
                 }
               if (node == end) break;
             }
@@ -324,7 +324,7 @@ namespace spatial
      *
      *  \tparam Container The type of container to iterate.
      *  \param node The node pointed to by the iterator
-     *  \param dth  The depth of the node pointed to by the iterator.
+     *  \param dth  The dimension of the node pointed to by the iterator.
      *  \param rank The rank of the container which node belongs to.
      *  \param cmp  The comparator used by the container which node belongs to.
      *  \param bound The lowest bound to the iterator position.
@@ -350,9 +350,9 @@ namespace spatial
       SPATIAL_ASSERT_CHECK(node != 0);
       NodePtr end = node->parent;
       while (node->left != 0
-             && (dth % rank() > 0
+             && (dth > 0
                  || !cmp(0, const_key(node), bound)))
-        { node = node->left; ++dth; }
+        { node = node->left; dth = incr_dim(rank, dth); }
       NodePtr best = 0;
       dimension_type best_dth = 0;
       if (order_less(cmp, rank, bound, const_key(node)))
@@ -360,23 +360,23 @@ namespace spatial
       for(;;)
         {
           if (node->right != 0
-              && (dth % rank() > 0 || best == 0
+              && (dth > 0 || best == 0
                   || !cmp(0, const_key(best), const_key(node))))
             {
-              node = node->right; ++dth;
+              node = node->right; dth = incr_dim(rank, dth);
               while (node->left != 0
-                     && (dth % rank() > 0
+                     && (dth > 0
                          || !cmp(0, const_key(node), bound)))
-                { node = node->left; ++dth; }
+                { node = node->left; dth = incr_dim(rank, dth); }
             }
           else
             {
               NodePtr prev_node = node;
-              node = node->parent; --dth;
+              node = node->parent; dth = decr_dim(rank, dth);
               while (node != end && prev_node == node->right)
                 {
                   prev_node = node;
-                  node = node->parent; --dth;
+                  node = node->parent; dth = decr_dim(rank, dth);
                 }
               if (node == end) break;
             }
@@ -0,0 +1,109 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   pmr.hpp
+ *  Defines, in the namespace \c spatial::pmr, the containers of the library
+ *  using \c std::pmr::polymorphic_allocator, after the containers of the
+ *  namespace \c std::pmr. It requires C++17.
+ *
+ *  All the memory of these containers, which is the memory of their nodes,
+ *  of the buffers used to insert a range or to rebalance them, and of the
+ *  values that use their allocator, comes from the \c
+ *  std::pmr::memory_resource given to their constructor:
+ *
+ *  \code
+ *    std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer));
+ *    spatial::pmr::point_multiset<3, point> points
+ *      (bracket_less<point>(), loose_balancing(), &arena);
+ *    points.reserve(10000); // no more allocation up to 10000 points
+ *  \endcode
+ *
+ *  Allocators of the same resource compare equal. Swapping two containers
+ *  that use different resources is not valid, as with the containers of \c
+ *  std::pmr, since their allocators do not propagate.
+ */
+
+#ifndef SPATIAL_PMR_HPP
+#define SPATIAL_PMR_HPP
+
+#if __cplusplus < 201703L
+#  error "spatial/pmr.hpp requires C++17 or later"
+#endif
+
+#include <memory_resource>
+#include <utility> // std::pair
+#include "point_multiset.hpp"
+#include "point_multimap.hpp"
+#include "box_multiset.hpp"
+#include "box_multimap.hpp"
+#include "idle_point_multiset.hpp"
+#include "idle_point_multimap.hpp"
+#include "idle_box_multiset.hpp"
+#include "idle_box_multimap.hpp"
+
+namespace spatial
+{
+  namespace pmr
+  {
+    template <dimension_type Rank, typename Key,
+              typename Compare = bracket_less<Key>,
+              typename BalancingPolicy = loose_balancing>
+    using point_multiset = spatial::point_multiset
+      <Rank, Key, Compare, BalancingPolicy,
+       std::pmr::polymorphic_allocator<Key> >;
+
+    template <dimension_type Rank, typename Key, typename Mapped,
+              typename Compare = bracket_less<Key>,
+              typename BalancingPolicy = loose_balancing,
+              typename StoragePolicy = inline_storage>
+    using point_multimap = spatial::point_multimap
+      <Rank, Key, Mapped, Compare, BalancingPolicy,
+       std::pmr::polymorphic_allocator<std::pair<const Key, Mapped> >,
+       StoragePolicy>;
+
+    template <dimension_type Rank, typename Key,
+              typename Compare = bracket_less<Key>,
+              typename BalancingPolicy = loose_balancing>
+    using box_multiset = spatial::box_multiset
+      <Rank, Key, Compare, BalancingPolicy,
+       std::pmr::polymorphic_allocator<Key> >;
+
+    template <dimension_type Rank, typename Key, typename Mapped,
+              typename Compare = bracket_less<Key>,
+              typename BalancingPolicy = loose_balancing,
+              typename StoragePolicy = inline_storage>
+    using box_multimap = spatial::box_multimap
+      <Rank, Key, Mapped, Compare, BalancingPolicy,
+       std::pmr::polymorphic_allocator<std::pair<const Key, Mapped> >,
+       StoragePolicy>;
+
+    template <dimension_type Rank, typename Key,
+              typename Compare = bracket_less<Key> >
+    using idle_point_multiset = spatial::idle_point_multiset
+      <Rank, Key, Compare, std::pmr::polymorphic_allocator<Key> >;
+
+    template <dimension_type Rank, typename Key, typename Mapped,
+              typename Compare = bracket_less<Key> >
+    using idle_point_multimap = spatial::idle_point_multimap
+      <Rank, Key, Mapped, Compare,
+       std::pmr::polymorphic_allocator<std::pair<const Key, Mapped> > >;
+
+    template <dimension_type Rank, typename Key,
+              typename Compare = bracket_less<Key> >
+    using idle_box_multiset = spatial::idle_box_multiset
+      <Rank, Key, Compare, std::pmr::polymorphic_allocator<Key> >;
+
+    template <dimension_type Rank, typename Key, typename Mapped,
+              typename Compare = bracket_less<Key> >
+    using idle_box_multimap = spatial::idle_box_multimap
+      <Rank, Key, Mapped, Compare,
+       std::pmr::polymorphic_allocator<std::pair<const Key, Mapped> > >;
+  } // namespace pmr
+} // namespace spatial
+
+#endif // SPATIAL_PMR_HPP
@@ -23,22 +23,27 @@ namespace spatial
   /**
    *  These containers are mapped containers and store values in space that can
    *  be represented as points.
+   *
+   *  With \ref cold_storage as \c StoragePolicy, the nodes only hold the keys
+   *  and the values are allocated separately, which speeds up the traversals
+   *  when the mapped type is large.
    */
   template<dimension_type Rank, typename Key, typename Mapped,
            typename Compare = bracket_less<Key>,
            typename BalancingPolicy = loose_balancing,
-           typename Alloc = std::allocator<std::pair<const Key, Mapped> > >
+           typename Alloc = std::allocator<std::pair<const Key, Mapped> >,
+           typename StoragePolicy = inline_storage>
   struct point_multimap
     : details::Relaxed_kdtree<details::Static_rank<Rank>, const Key,
                               std::pair<const Key, Mapped>, Compare,
-                              BalancingPolicy, Alloc>
+                              BalancingPolicy, Alloc, StoragePolicy>
   {
   private:
     typedef details::Relaxed_kdtree
     <details::Static_rank<Rank>, const Key, std::pair<const Key, Mapped>,
-     Compare, BalancingPolicy, Alloc>         base_type;
+     Compare, BalancingPolicy, Alloc, StoragePolicy> base_type;
     typedef point_multimap<Rank, Key, Mapped, Compare,
-                     BalancingPolicy, Alloc>  Self;
+                           BalancingPolicy, Alloc, StoragePolicy> Self;
 
   public:
     typedef Mapped                            mapped_type;
@@ -72,17 +77,19 @@ namespace spatial
    *  be determined at run time and does not need to be fixed at compile time.
    */
   template<typename Key, typename Mapped, typename Compare,
-           typename BalancingPolicy, typename Alloc>
-  struct point_multimap<0, Key, Mapped, Compare, BalancingPolicy, Alloc>
+           typename BalancingPolicy, typename Alloc, typename StoragePolicy>
+  struct point_multimap<0, Key, Mapped, Compare, BalancingPolicy, Alloc,
+                        StoragePolicy>
     : details::Relaxed_kdtree<details::Dynamic_rank, const Key,
                               std::pair<const Key, Mapped>, Compare,
-                              BalancingPolicy, Alloc>
+                              BalancingPolicy, Alloc, StoragePolicy>
   {
   private:
     typedef details::Relaxed_kdtree
     <details::Dynamic_rank, const Key, std::pair<const Key, Mapped>,
-     Compare, BalancingPolicy, Alloc>       base_type;
-    typedef point_multimap<0, Key, Mapped, Compare, BalancingPolicy, Alloc>
+     Compare, BalancingPolicy, Alloc, StoragePolicy> base_type;
+    typedef point_multimap<0, Key, Mapped, Compare, BalancingPolicy, Alloc,
+                           StoragePolicy>
     Self;
 
   public:
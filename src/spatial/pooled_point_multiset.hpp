@@ -0,0 +1,339 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   pooled_point_multiset.hpp
+ *  Contains the definition of \ref spatial::pooled_point_multiset, a
+ *  container with a rank set at run time that copies the coordinates of its
+ *  keys into contiguous storage that it owns, and of \ref
+ *  spatial::pooled_key, the key that refers to these coordinates.
+ */
+
+#ifndef SPATIAL_POOLED_POINT_MULTISET_HPP
+#define SPATIAL_POOLED_POINT_MULTISET_HPP
+
+#include <memory>  // std::allocator, std::allocator_traits
+#include <vector>
+#include <algorithm> // std::swap
+#include "function.hpp"
+#include "bits/spatial_except.hpp"
+#include "bits/spatial_relaxed_kdtree.hpp"
+
+namespace spatial
+{
+  /**
+   *  A key that refers to \c rank coordinates stored contiguously in the
+   *  pool of a \ref pooled_point_multiset. It is read with \c operator[], and
+   *  therefore works with \ref bracket_less and the metrics of the library,
+   *  which read the coordinates without any other indirection.
+   */
+  template <typename Tp>
+  struct pooled_key
+  {
+    typedef Tp value_type;
+
+    pooled_key() : coord(0) { }
+    explicit pooled_key(const Tp* coord_) : coord(coord_) { }
+
+    const Tp& operator[](dimension_type n) const { return coord[n]; }
+
+    const Tp* coord;
+  };
+
+  namespace details
+  {
+    /**
+     *  Storage for slices of \c rank coordinates, allocated by blocks so
+     *  that the slices never move, and recycled through a free list.
+     */
+    template <typename Tp, typename Alloc>
+    class Coordinate_pool
+    {
+      typedef typename std::allocator_traits<Alloc>
+      ::template rebind_alloc<Tp> allocator_type;
+      typedef typename std::allocator_traits<Alloc>
+      ::template rebind_alloc<Tp*> pointer_allocator;
+
+    public:
+      //! The number of slices in a block.
+      static const std::size_t block_slices = 256;
+
+      Coordinate_pool(dimension_type rank_, const Alloc& alloc)
+        : _rank(rank_), _used(block_slices), _alloc(alloc),
+          _blocks(pointer_allocator(alloc)), _free(pointer_allocator(alloc))
+      { }
+
+      ~Coordinate_pool() { clear(); }
+
+      dimension_type rank() const { return _rank; }
+
+      Alloc get_allocator() const { return Alloc(_alloc); }
+
+      //! Returns a slice that holds the \c rank first coordinates of \c key,
+      //! read with \c operator[].
+      template <typename Key>
+      Tp* allocate(const Key& key)
+      {
+        Tp* slice;
+        if (!_free.empty())
+          { slice = _free.back(); _free.pop_back(); }
+        else
+          {
+            if (_used == block_slices)
+              {
+                _blocks.reserve(_blocks.size() + 1);
+                _blocks.push_back(_alloc.allocate(block_slices * _rank));
+                _used = 0;
+              }
+            slice = _blocks.back() + _used * _rank;
+            ++_used;
+          }
+        for (dimension_type n = 0; n < _rank; ++n) { slice[n] = key[n]; }
+        return slice;
+      }
+
+      //! Returns \c slice to the pool.
+      void deallocate(const Tp* slice)
+      { _free.push_back(const_cast<Tp*>(slice)); }
+
+      //! Releases all the blocks of the pool.
+      void clear()
+      {
+        for (std::size_t i = 0; i < _blocks.size(); ++i)
+          { _alloc.deallocate(_blocks[i], block_slices * _rank); }
+        _blocks.clear();
+        _free.clear();
+        _used = block_slices;
+      }
+
+      void swap(Coordinate_pool& other)
+      {
+        std::swap(_rank, other._rank);
+        std::swap(_used, other._used);
+        std::swap(_alloc, other._alloc);
+        _blocks.swap(other._blocks);
+        _free.swap(other._free);
+      }
+
+    private:
+      Coordinate_pool(const Coordinate_pool&); // not implemented
+      Coordinate_pool& operator=(const Coordinate_pool&); // not implemented
+
+      dimension_type _rank;
+      std::size_t _used;
+      allocator_type _alloc;
+      std::vector<Tp*, pointer_allocator> _blocks;
+      std::vector<Tp*, pointer_allocator> _free;
+    };
+
+    /**
+     *  A copy of the coordinates of a query key, read with \c operator[],
+     *  that a \ref pooled_key can refer to during a search. The coordinates
+     *  are held on the stack, unless the rank exceeds \c local_rank.
+     */
+    template <typename Tp>
+    class Query_slice
+    {
+    public:
+      template <typename Key>
+      Query_slice(dimension_type rank, const Key& key)
+        : _heap(rank > local_rank ? rank : 0)
+      {
+        Tp* coord = _heap.empty() ? _local : &_heap[0];
+        for (dimension_type n = 0; n < rank; ++n) { coord[n] = key[n]; }
+      }
+
+      //! Returns a key that refers to the copied coordinates.
+      pooled_key<Tp> key() const
+      { return pooled_key<Tp>(_heap.empty() ? _local : &_heap[0]); }
+
+    private:
+      Query_slice(const Query_slice&); // not implemented
+      Query_slice& operator=(const Query_slice&); // not implemented
+
+      static const dimension_type local_rank = 32;
+
+      Tp _local[local_rank];
+      std::vector<Tp> _heap;
+    };
+  } // namespace details
+
+  /**
+   *  A multiset of points whose rank is set at run time, and whose
+   *  coordinates are copied into storage owned by the container.
+   *
+   *  With a \dynamic_rank, keys are usually \c std::vector or other types
+   *  that hold their coordinates in a separate allocation: each node visited
+   *  costs a second cache miss to read the key, and each value costs a
+   *  second allocation. In this container, the coordinates of all the keys
+   *  are stored contiguously, \c rank at a time, in blocks of \ref
+   *  details::Coordinate_pool::block_slices keys. The nodes store a \ref
+   *  pooled_key, which points to the coordinates of the value.
+   *
+   *  Values are inserted from any key read with \c operator[], such as a \c
+   *  std::vector, an array or a pointer to the coordinates, and are read back
+   *  as \ref pooled_key, which remain valid as long as their value is in the
+   *  container. All the iterators of the library apply to the container.
+   *
+   *  \tparam Tp The type of the coordinates.
+   *  \tparam BalancingPolicy The balancing policy of the tree.
+   *  \tparam Alloc The allocator, rebound for the nodes and the coordinates.
+   */
+  template <typename Tp, typename BalancingPolicy = loose_balancing,
+            typename Alloc = std::allocator<Tp> >
+  struct pooled_point_multiset
+    : details::Relaxed_kdtree<details::Dynamic_rank, const pooled_key<Tp>,
+                              const pooled_key<Tp>,
+                              bracket_less<pooled_key<Tp> >, BalancingPolicy,
+                              typename std::allocator_traits<Alloc>
+                              ::template rebind_alloc<pooled_key<Tp> > >
+  {
+  private:
+    typedef details::Relaxed_kdtree
+    <details::Dynamic_rank, const pooled_key<Tp>, const pooled_key<Tp>,
+     bracket_less<pooled_key<Tp> >, BalancingPolicy,
+     typename std::allocator_traits<Alloc>
+     ::template rebind_alloc<pooled_key<Tp> > >           base_type;
+    typedef details::Coordinate_pool<Tp, Alloc>           pool_type;
+
+  public:
+    typedef typename base_type::iterator                  iterator;
+    typedef typename base_type::const_iterator            const_iterator;
+    typedef typename base_type::size_type                 size_type;
+    typedef typename base_type::key_type                  key_type;
+
+    explicit pooled_point_multiset(dimension_type dim = 1)
+      : base_type(details::Dynamic_rank(dim)), _pool(dim, Alloc())
+    { except::check_rank(dim); }
+
+    pooled_point_multiset(dimension_type dim, const BalancingPolicy& policy,
+                          const Alloc& alloc = Alloc())
+      : base_type(details::Dynamic_rank(dim), bracket_less<pooled_key<Tp> >(),
+                  policy, typename base_type::allocator_type(alloc)),
+        _pool(dim, alloc)
+    { except::check_rank(dim); }
+
+    //! Copies the tree of \c other, with its coordinates into a new pool
+    //! that uses the allocator of \c other.
+    pooled_point_multiset(const pooled_point_multiset& other)
+      : base_type(other), _pool(other.dimension(), other._pool.get_allocator())
+    { repoint(); }
+
+    /**
+     *  Copies the tree of \c other, with its coordinates into a new pool.
+     *  The allocator of the container is not modified.
+     *
+     *  The copy is built aside, then swapped with the container: if it
+     *  throws, the container is left unchanged.
+     */
+    pooled_point_multiset& operator=(const pooled_point_multiset& other)
+    {
+      if (&other != this)
+        {
+          pooled_point_multiset copy(other.dimension(), other.balancing(),
+                                     _pool.get_allocator());
+          copy.base_type::operator=(other);
+          copy.repoint();
+          swap(copy);
+        }
+      return *this;
+    }
+
+    /**
+     *  Copies the \c dimension() first coordinates of \c key, read with \c
+     *  operator[], into the pool and inserts them in the tree.
+     */
+    template <typename Key>
+    iterator insert(const Key& key)
+    {
+      const Tp* slice = _pool.allocate(key);
+      try { return base_type::insert(key_type(slice)); }
+      catch (...) { _pool.deallocate(slice); throw; }
+    }
+
+    //! Inserts the keys of [\c first, \c last).
+    template <typename InputIterator>
+    void insert(InputIterator first, InputIterator last)
+    { for (; first != last; ++first) { insert(*first); } }
+
+    //! Erases the value pointed to by \c position, and recycles its
+    //! coordinates.
+    void erase(iterator position)
+    {
+      const Tp* slice = position->coord;
+      base_type::erase(position);
+      _pool.deallocate(slice);
+    }
+
+    //! Erases all the values equal to \c key, read with \c operator[], and
+    //! returns their number.
+    template <typename Key>
+    size_type erase(const Key& key)
+    {
+      details::Query_slice<Tp> query(this->dimension(), key);
+      size_type erased = 0;
+      for (iterator i = base_type::find(query.key());
+           i != this->end(); i = base_type::find(query.key()))
+        { erase(i); ++erased; }
+      return erased;
+    }
+
+    //! Returns a value equal to \c key, read with \c operator[], or \ref
+    //! end() if there are none.
+    ///@{
+    template <typename Key>
+    iterator find(const Key& key)
+    {
+      details::Query_slice<Tp> query(this->dimension(), key);
+      return base_type::find(query.key());
+    }
+
+    template <typename Key>
+    const_iterator find(const Key& key) const
+    {
+      details::Query_slice<Tp> query(this->dimension(), key);
+      return base_type::find(query.key());
+    }
+    ///@}
+
+    void clear()
+    {
+      base_type::clear();
+      _pool.clear();
+    }
+
+    void swap(pooled_point_multiset& other)
+    {
+      base_type::swap(other);
+      _pool.swap(other._pool);
+    }
+
+  private:
+    /**
+     *  Moves the coordinates of all keys, which still refer to the pool of
+     *  another container, into the pool of this one. The coordinates are
+     *  not modified, so the order of the tree is preserved.
+     *
+     *  All the slices are allocated before any key is modified: if an
+     *  allocation throws, every key still refers to the other pool.
+     */
+    void repoint()
+    {
+      std::vector<const Tp*> slices;
+      slices.reserve(this->size());
+      for (iterator i = this->begin(); i != this->end(); ++i)
+        { slices.push_back(_pool.allocate(*i)); }
+      typename std::vector<const Tp*>::const_iterator slice = slices.begin();
+      for (iterator i = this->begin(); i != this->end(); ++i, ++slice)
+        { const_cast<key_type&>(*i).coord = *slice; }
+    }
+
+    pool_type _pool;
+  };
+}
+
+#endif // SPATIAL_POOLED_POINT_MULTISET_HPP
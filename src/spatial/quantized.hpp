@@ -0,0 +1,267 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   quantized.hpp
+ *  Contains the definition of \ref spatial::quantized_point, a key that
+ *  stores its coordinates as small integers, of \ref spatial::quantizer,
+ *  which converts full-precision points into such keys, and of \ref
+ *  spatial::quantized_nearest_neighbors(), which refines a nearest neighbor
+ *  search among quantized keys with the full-precision points.
+ */
+
+#ifndef SPATIAL_QUANTIZED_HPP
+#define SPATIAL_QUANTIZED_HPP
+
+#include <sstream>
+#include <vector>
+#include <utility> // std::pair
+#include <limits>
+#include <cmath> // std::floor, std::sqrt
+#include <algorithm> // std::push_heap, std::pop_heap, std::sort_heap
+#include "exception.hpp"
+#include "metric.hpp"
+#include "neighbor_iterator.hpp"
+
+namespace spatial
+{
+  namespace except
+  {
+    /**
+     *  Checks that the coordinate \c value, expressed in steps of a \ref
+     *  quantizer, is within [\c low, \c high], the range of its integers.
+     *  \exception invalid_coordinate is thrown if the check fails.
+     */
+    template <typename Real>
+    inline void check_quantized_coordinate(Real value, Real low, Real high)
+    {
+      if (!(low <= value && value <= high))
+        {
+          std::stringstream out;
+          out << value << " is not within [" << low << ", " << high << "]";
+          throw invalid_coordinate(out.str());
+        }
+    }
+  }
+
+  /**
+   *  A point whose coordinates are stored as integers of type \c Int, in
+   *  steps of a \ref quantizer from its origin. With \c short coordinates, a
+   *  3-dimensional key takes 6 bytes instead of the 24 bytes of 3 \c double,
+   *  and is compared with integer instructions.
+   *
+   *  The key is read with \c operator[], and therefore works with \ref
+   *  bracket_less and the other built-in functors of the library.
+   *
+   *  \tparam Rank The number of coordinates.
+   *  \tparam Int A signed integral type, such as \c short or \c int.
+   */
+  template <dimension_type Rank, typename Int>
+  struct quantized_point
+  {
+    typedef Int value_type;
+
+    Int operator[](dimension_type n) const { return coord[n]; }
+    Int& operator[](dimension_type n) { return coord[n]; }
+
+    Int coord[Rank];
+  };
+
+  template <dimension_type Rank, typename Int>
+  inline bool operator==(const quantized_point<Rank, Int>& x,
+                         const quantized_point<Rank, Int>& y)
+  {
+    for (dimension_type n = 0; n < Rank; ++n)
+      { if (x[n] != y[n]) return false; }
+    return true;
+  }
+
+  template <dimension_type Rank, typename Int>
+  inline bool operator!=(const quantized_point<Rank, Int>& x,
+                         const quantized_point<Rank, Int>& y)
+  { return !(x == y); }
+
+  /**
+   *  The difference between two \ref quantized_point along the dimension \c
+   *  n, computed in \c Unit so that it cannot overflow \c Int.
+   */
+  template <typename Tp, typename Unit>
+  struct quantized_minus
+  {
+    Unit operator()(dimension_type n, const Tp& x, const Tp& y) const
+    { return static_cast<Unit>(x[n]) - static_cast<Unit>(y[n]); }
+  };
+
+  /**
+   *  Converts points with full-precision coordinates into \ref
+   *  quantized_point, relative to an origin and in steps of a fixed scale,
+   *  and back.
+   *
+   *  Each coordinate is rounded to the closest step, so a point and its
+   *  quantized key are at most \ref max_error() apart. For instance, a scale
+   *  of 1 cm with \c short coordinates covers 655 m around the origin, and
+   *  with \c int coordinates covers 42,000 km.
+   *
+   *  \tparam Rank The number of coordinates.
+   *  \tparam Int A signed integral type, such as \c short or \c int.
+   *  \tparam Real The type of the full-precision coordinates.
+   */
+  template <dimension_type Rank, typename Int, typename Real = double>
+  class quantizer
+  {
+  public:
+    typedef quantized_point<Rank, Int> key_type;
+    typedef Int integer_type;
+    typedef Real real_type;
+
+    //! Builds a quantizer with its origin at 0 and a scale of 1.
+    quantizer() : _scale(1)
+    { for (dimension_type n = 0; n < Rank; ++n) { _origin[n] = Real(); } }
+
+    /**
+     *  Builds a quantizer with the given \c origin, read with \c operator[],
+     *  and \c scale, the size of a step.
+     *  \throws invalid_distance if \c scale is not strictly positive.
+     */
+    template <typename Point>
+    quantizer(const Point& origin_, Real scale_) : _scale(scale_)
+    {
+      except::check_positive_distance(scale_);
+      if (!(Real() < scale_)) throw invalid_distance("scale is 0");
+      for (dimension_type n = 0; n < Rank; ++n)
+        { _origin[n] = static_cast<Real>(origin_[n]); }
+    }
+
+    //! Returns the coordinate of the origin on the dimension \c n.
+    Real origin(dimension_type n) const { return _origin[n]; }
+
+    //! Returns the size of a step.
+    Real scale() const { return _scale; }
+
+    //! Returns the largest distance between a point and its quantized key.
+    Real max_error() const
+    { return _scale * std::sqrt(static_cast<Real>(Rank)) / Real(2); }
+
+    /**
+     *  Returns the quantized key of \c point, read with \c operator[].
+     *  \throws invalid_coordinate if a coordinate is too far from the origin
+     *  to be represented by \c Int.
+     */
+    template <typename Point>
+    key_type quantize(const Point& point) const
+    {
+      key_type key;
+      for (dimension_type n = 0; n < Rank; ++n)
+        {
+          Real step = std::floor((static_cast<Real>(point[n]) - _origin[n])
+                                 / _scale + Real(0.5));
+          except::check_quantized_coordinate
+            (step, static_cast<Real>((std::numeric_limits<Int>::min)()),
+             static_cast<Real>((std::numeric_limits<Int>::max)()));
+          key[n] = static_cast<Int>(step);
+        }
+      return key;
+    }
+
+    //! Returns the full-precision coordinate of \c key on the dimension \c n.
+    Real dequantize(dimension_type n, const key_type& key) const
+    { return _origin[n] + static_cast<Real>(key[n]) * _scale; }
+
+  private:
+    Real _origin[Rank];
+    Real _scale;
+  };
+
+  namespace details
+  {
+    //! Orders the candidates of a refined search by exact distance.
+    struct Refined_less
+    {
+      template <typename Candidate>
+      bool operator()(const Candidate& x, const Candidate& y) const
+      { return x.first < y.first; }
+    };
+  }
+
+  /**
+   *  Writes iterators to the \c k values of \c container that are the
+   *  closest to \c target, or to all values if there are fewer, by
+   *  increasing euclidian distance between their full-precision points.
+   *
+   *  \c container is a mapped container whose keys are the \ref
+   *  quantized_point of \c quantizer, and whose mapped values are the
+   *  positions, from \c exact, of the full-precision points. The values are
+   *  visited by increasing distance between their quantized keys and the
+   *  quantized target, and the distance to their full-precision point is
+   *  computed. Since each quantized key is within \ref
+   *  quantizer::max_error() of its point, the search stops once the
+   *  quantized distance, less twice this error, exceeds the distance of the
+   *  k-th closest point found.
+   *
+   *  \throws invalid_coordinate if \c target cannot be quantized.
+   */
+  template <typename Container, dimension_type Rank, typename Int,
+            typename Real, typename RandomAccessIterator, typename Point,
+            typename OutputIterator>
+  inline OutputIterator
+  quantized_nearest_neighbors(Container& container,
+                              const quantizer<Rank, Int, Real>& quantizer_,
+                              RandomAccessIterator exact,
+                              const Point& target, std::size_t k,
+                              OutputIterator out)
+  {
+    typedef quantized_point<Rank, Int> key_type;
+    typedef euclidian<typename details::mutate<Container>::type, Real,
+                      quantized_minus<key_type, Real> > metric_type;
+    typedef neighbor_iterator<Container, metric_type> iterator;
+    typedef std::pair<Real, iterator> candidate_type;
+    key_type quantized_target = quantizer_.quantize(target);
+    if (k == 0) return out;
+    const Real slack = Real(2) * quantizer_.max_error();
+    std::vector<candidate_type> heap;
+    heap.reserve(k + 1);
+    metric_type metric;
+    for (iterator i = neighbor_begin(container, metric, quantized_target),
+           end = neighbor_end(container, metric, quantized_target);
+         i != end; ++i)
+      {
+        if (heap.size() == k
+            && heap.front().first < i.distance() * quantizer_.scale() - slack)
+          break;
+        const typename std::iterator_traits<RandomAccessIterator>
+          ::value_type& point = exact[static_cast<typename std::iterator_traits
+                                      <RandomAccessIterator>::difference_type>
+                                      (i->second)];
+        Real sum = Real();
+        for (dimension_type n = 0; n < Rank; ++n)
+          {
+            Real diff = static_cast<Real>(point[n])
+              - static_cast<Real>(target[n]);
+            sum += diff * diff;
+          }
+        candidate_type candidate(std::sqrt(sum), i);
+        if (heap.size() < k)
+          {
+            heap.push_back(candidate);
+            std::push_heap(heap.begin(), heap.end(), details::Refined_less());
+          }
+        else if (candidate.first < heap.front().first)
+          {
+            std::pop_heap(heap.begin(), heap.end(), details::Refined_less());
+            heap.back() = candidate;
+            std::push_heap(heap.begin(), heap.end(), details::Refined_less());
+          }
+      }
+    std::sort_heap(heap.begin(), heap.end(), details::Refined_less());
+    for (typename std::vector<candidate_type>::const_iterator
+           i = heap.begin(); i != heap.end(); ++i)
+      { *out++ = i->second; }
+    return out;
+  }
+}
+
+#endif // SPATIAL_QUANTIZED_HPP
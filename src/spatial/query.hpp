@@ -0,0 +1,414 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   query.hpp
+ *  Provides one-shot queries on the containers: visiting or counting the
+ *  values in a region, visiting the values within a radius, and finding the
+ *  k nearest neighbors of a point. Batches of exact searches, nearest
+ *  neighbor searches and region counts are also provided.
+ *
+ *  Unlike the iterators, which can be moved back and forth at any time and
+ *  must therefore find their way back up the tree from the current node,
+ *  these queries run to completion in a single call. They record the
+ *  subtrees that remain to be visited on an explicit stack, which avoids
+ *  climbing back through the parents of the nodes already visited and
+ *  evaluating the query on them again.
+ */
+
+#ifndef SPATIAL_QUERY_HPP
+#define SPATIAL_QUERY_HPP
+
+#include <vector>
+#include <iterator> // std::iterator_traits
+#include "spatial.hpp"
+#include "bits/spatial_region.hpp"
+#include "bits/spatial_traversal.hpp"
+#include "bits/spatial_batch.hpp"
+#include "bits/spatial_locality.hpp"
+
+namespace spatial
+{
+  namespace details
+  {
+    /**
+     *  The types of nodes and iterators reached by a query on a \c Container.
+     */
+    template <typename Container>
+    struct Query_types
+    {
+      typedef typename Container::mode_type::node_ptr   node_ptr;
+      typedef typename Container::iterator              iterator;
+    };
+
+    /**
+     *  On a constant \c Container, queries reach constant nodes and
+     *  iterators.
+     */
+    template <typename Container>
+    struct Query_types<const Container>
+    {
+      typedef typename Container::mode_type::const_node_ptr node_ptr;
+      typedef typename Container::const_iterator            iterator;
+    };
+
+    //! A visitor that counts the values it is called with.
+    struct Count_visitor
+    {
+      Count_visitor() : count(0) { }
+      template <typename Value>
+      void operator()(const Value&) { ++count; }
+      std::size_t count;
+    };
+
+    /**
+     *  Stores the node found by a batch query, as an \c Iterator, at the
+     *  position of the query in the output.
+     */
+    template <typename RandomAccessIterator, typename Iterator>
+    struct Store_iterator
+    {
+      explicit Store_iterator(RandomAccessIterator first_) : first(first_) { }
+      template <typename NodePtr>
+      void operator()(std::size_t pos, NodePtr node) const
+      {
+        first[static_cast<typename std::iterator_traits<RandomAccessIterator>
+                          ::difference_type>(pos)] = Iterator(node);
+      }
+      RandomAccessIterator first;
+    };
+
+    /**
+     *  Stores the result of a batch query at the position of the query in
+     *  the output.
+     */
+    template <typename RandomAccessIterator>
+    struct Store_value
+    {
+      explicit Store_value(RandomAccessIterator first_) : first(first_) { }
+      template <typename Result>
+      void operator()(std::size_t pos, const Result& result) const
+      {
+        first[static_cast<typename std::iterator_traits<RandomAccessIterator>
+                          ::difference_type>(pos)] = result;
+      }
+      RandomAccessIterator first;
+    };
+
+    /**
+     *  Passes the result of a batch query run on reordered queries to \c
+     *  Store, along with the original position of the query.
+     */
+    template <typename Store>
+    struct Store_reordered
+    {
+      Store_reordered(const Store& store_,
+                      const std::vector<std::size_t>& origin_)
+        : store(store_), origin(&origin_) { }
+      template <typename Result>
+      void operator()(std::size_t pos, const Result& result) const
+      { store((*origin)[pos], result); }
+      Store store;
+      const std::vector<std::size_t>* origin;
+    };
+
+    //! Returns \c first advanced by \c n.
+    template <typename RandomAccessIterator>
+    inline RandomAccessIterator
+    advance_by(RandomAccessIterator first, std::size_t n)
+    {
+      return first + static_cast<typename std::iterator_traits
+                                 <RandomAccessIterator>::difference_type>(n);
+    }
+  } // namespace details
+
+  /**
+   *  Calls \c visitor on each value of \c container that matches \c pred.
+   *
+   *  The values are visited in pre-order of the tree, which differs from
+   *  the order of a \region_iterator. The values of a constant container
+   *  are passed as constant references.
+   *
+   *  \tparam Container The type of \c container.
+   *  \tparam Predicate A model of \region_predicate.
+   *  \tparam Visitor A functor that is called with a reference to a value.
+   *  \param container The container being searched.
+   *  \param pred The predicate used for the search.
+   *  \param visitor The functor called on the matching values.
+   *  \return A copy of \c visitor, after it was called on all matching values.
+   */
+  template <typename Container, typename Predicate, typename Visitor>
+  inline Visitor
+  region_visit(Container& container, const Predicate& pred, Visitor visitor)
+  {
+    if (container.empty()) return visitor;
+    return details::visit_region
+      (container.end().node->parent, container.rank(),
+       details::traversal_depth_bound(container.size()), pred, visitor);
+  }
+
+  /**
+   *  Calls \c visitor on each value of \c container that is within the
+   *  boundaries defined by \c lower and \c upper, as with \ref bounds.
+   */
+  template <typename Container, typename Visitor>
+  inline Visitor
+  region_visit(Container& container,
+               const typename Container::key_type& lower,
+               const typename Container::key_type& upper, Visitor visitor)
+  {
+    return region_visit(container, make_bounds(container, lower, upper),
+                        visitor);
+  }
+
+  /**
+   *  Returns the number of values of \c container that match \c pred.
+   *
+   *  \tparam Container The type of \c container.
+   *  \tparam Predicate A model of \region_predicate.
+   *  \param container The container being searched.
+   *  \param pred The predicate used for the search.
+   */
+  template <typename Container, typename Predicate>
+  inline typename Container::size_type
+  region_count(const Container& container, const Predicate& pred)
+  { return region_visit(container, pred, details::Count_visitor()).count; }
+
+  /**
+   *  Returns the number of values of \c container that are within the
+   *  boundaries defined by \c lower and \c upper, as with \ref bounds.
+   */
+  template <typename Container>
+  inline typename Container::size_type
+  region_count(const Container& container,
+               const typename Container::key_type& lower,
+               const typename Container::key_type& upper)
+  { return region_count(container, make_bounds(container, lower, upper)); }
+
+  /**
+   *  Calls \c visitor on each value of \c container whose distance to \c
+   *  target, as computed by \c metric, is lower or equal to \c radius. The
+   *  values are not visited in any particular order.
+   *
+   *  \tparam Container The type of \c container.
+   *  \tparam Metric A model of \metric.
+   *  \tparam Visitor A functor that is called with a reference to a value.
+   *  \param container The container being searched.
+   *  \param metric The metric used to compute distances.
+   *  \param target The point from which distances are measured.
+   *  \param radius The largest distance at which values are visited.
+   *  \param visitor The functor called on the values found.
+   *  \return A copy of \c visitor, after it was called on all values found.
+   */
+  template <typename Container, typename Metric, typename Visitor>
+  inline Visitor
+  radius_visit(Container& container, const Metric& metric,
+               const typename Container::key_type& target,
+               typename Metric::distance_type radius, Visitor visitor)
+  {
+    if (container.empty()) return visitor;
+    return details::visit_radius
+      (container.end().node->parent, container.rank(),
+       details::traversal_depth_bound(container.size()),
+       container.key_comp(), metric, target, radius, visitor);
+  }
+
+  /**
+   *  Finds the \c k values of \c container that are the closest to \c target,
+   *  according to \c metric, and writes iterators to these values in \c out,
+   *  by increasing distance.
+   *
+   *  If \c container holds less than \c k values, all of them are written.
+   *  Values at equal distance from \c target are written in no particular
+   *  order. The iterators written are constant iterators if \c container is
+   *  constant.
+   *
+   *  \tparam Container The type of \c container.
+   *  \tparam Metric A model of \metric.
+   *  \tparam OutputIterator An output iterator that accepts iterators of \c
+   *  container.
+   *  \param container The container being searched.
+   *  \param metric The metric used to compute distances.
+   *  \param target The point from which distances are measured.
+   *  \param k The number of values to find.
+   *  \param out The output iterator where results are written.
+   *  \return The output iterator past the last result written.
+   */
+  template <typename Container, typename Metric, typename OutputIterator>
+  inline OutputIterator
+  nearest_neighbors(Container& container, const Metric& metric,
+                    const typename Container::key_type& target,
+                    typename Container::size_type k, OutputIterator out)
+  {
+    typedef typename details::Query_types<Container>::node_ptr node_ptr;
+    typedef typename details::Query_types<Container>::iterator iterator;
+    typedef std::pair<typename Metric::distance_type, node_ptr> result_type;
+    if (container.empty() || k == 0) return out;
+    std::vector<result_type> nearest;
+    details::nearest_k
+      (static_cast<node_ptr>(container.end().node->parent), container.rank(),
+       details::traversal_depth_bound(container.size()),
+       container.key_comp(), metric, target, k, nearest);
+    for (typename std::vector<result_type>::const_iterator
+           i = nearest.begin(); i != nearest.end(); ++i, ++out)
+      { *out = iterator(i->second); }
+    return out;
+  }
+
+  /**
+   *  Searches \c container for each of the keys in [\c first, \c last), and
+   *  writes in \c result, at the same position as the key, an iterator to
+   *  the first value found with a key equal to it, or <tt>container.end()</tt>
+   *  if there is none.
+   *
+   *  Up to \c width searches are advanced in turn, one node at a time, and
+   *  each search requests its next node to be loaded before the next search
+   *  takes over. On trees that do not fit in cache, this overlaps the memory
+   *  latency of the searches, which is otherwise paid one node at a time. On
+   *  small trees, it brings no benefit over calling \c find() in a loop.
+   *
+   *  The keys are first copied and sorted with \ref details::locality_sort(),
+   *  so that consecutive searches share most of their path in the tree. The
+   *  iterators are nonetheless written in the order of the keys.
+   *
+   *  \tparam Container The type of \c container.
+   *  \tparam InputIterator An iterator over keys of \c container.
+   *  \tparam RandomAccessIterator A mutable random access iterator to
+   *  iterators of \c container.
+   *  \param container The container being searched.
+   *  \param first The first key searched.
+   *  \param last The end of the keys searched.
+   *  \param result The beginning of the range where iterators are written.
+   *  \param width The number of searches advanced in turn.
+   *  \return The end of the range where iterators were written.
+   */
+  template <typename Container, typename InputIterator,
+            typename RandomAccessIterator>
+  inline RandomAccessIterator
+  batch_find(Container& container, InputIterator first, InputIterator last,
+             RandomAccessIterator result,
+             std::size_t width = SPATIAL_BATCH_WIDTH)
+  {
+    typedef typename details::Query_types<Container>::node_ptr node_ptr;
+    typedef typename details::Query_types<Container>::iterator iterator;
+    if (container.empty())
+      {
+        for (; first != last; ++first, ++result) { *result = container.end(); }
+        return result;
+      }
+    std::vector<typename Container::key_type> keys;
+    std::vector<std::size_t> origin;
+    details::locality_order(first, last, container.rank(),
+                            container.key_comp(), keys, origin);
+    return details::advance_by
+      (result, details::batch_find
+       (static_cast<node_ptr>(container.end().node->parent),
+        container.rank(), container.key_comp(),
+        details::traversal_depth_bound(container.size()), width,
+        keys.begin(), keys.end(),
+        details::Store_reordered
+        <details::Store_iterator<RandomAccessIterator, iterator> >
+        (details::Store_iterator<RandomAccessIterator, iterator>(result),
+         origin)));
+  }
+
+  /**
+   *  Searches \c container for the nearest neighbor of each of the targets in
+   *  [\c first, \c last) according to \c metric, and writes in \c result, at
+   *  the same position as the target, an iterator to the value found, or
+   *  <tt>container.end()</tt> if \c container is empty.
+   *
+   *  The targets are reordered and the searches are advanced in turn, as
+   *  with \ref batch_find().
+   *
+   *  \tparam Container The type of \c container.
+   *  \tparam Metric A model of \metric.
+   *  \tparam InputIterator An iterator over keys of \c container.
+   *  \tparam RandomAccessIterator A mutable random access iterator to
+   *  iterators of \c container.
+   *  \param container The container being searched.
+   *  \param metric The metric used to compute distances.
+   *  \param first The first target.
+   *  \param last The end of the targets.
+   *  \param result The beginning of the range where iterators are written.
+   *  \param width The number of searches advanced in turn.
+   *  \return The end of the range where iterators were written.
+   */
+  template <typename Container, typename Metric, typename InputIterator,
+            typename RandomAccessIterator>
+  inline RandomAccessIterator
+  batch_nearest_neighbor(Container& container, const Metric& metric,
+                         InputIterator first, InputIterator last,
+                         RandomAccessIterator result,
+                         std::size_t width = SPATIAL_BATCH_WIDTH)
+  {
+    typedef typename details::Query_types<Container>::node_ptr node_ptr;
+    typedef typename details::Query_types<Container>::iterator iterator;
+    if (container.empty())
+      {
+        for (; first != last; ++first, ++result) { *result = container.end(); }
+        return result;
+      }
+    std::vector<typename Container::key_type> keys;
+    std::vector<std::size_t> origin;
+    details::locality_order(first, last, container.rank(),
+                            container.key_comp(), keys, origin);
+    return details::advance_by
+      (result, details::batch_nearest
+       (static_cast<node_ptr>(container.end().node->parent),
+        container.rank(), container.key_comp(), metric,
+        details::traversal_depth_bound(container.size()), width,
+        keys.begin(), keys.end(),
+        details::Store_reordered
+        <details::Store_iterator<RandomAccessIterator, iterator> >
+        (details::Store_iterator<RandomAccessIterator, iterator>(result),
+         origin)));
+  }
+
+  /**
+   *  Counts the values of \c container that match each of the predicates in
+   *  [\c first, \c last), and writes in \c result, at the same position as
+   *  the predicate, the number of values that match it.
+   *
+   *  The counts are advanced in turn, as with \ref batch_find().
+   *
+   *  \tparam Container The type of \c container.
+   *  \tparam InputIterator An iterator over models of \region_predicate.
+   *  \tparam RandomAccessIterator A mutable random access iterator to
+   *  integers.
+   *  \param container The container being searched.
+   *  \param first The first predicate.
+   *  \param last The end of the predicates.
+   *  \param result The beginning of the range where counts are written.
+   *  \param width The number of counts advanced in turn.
+   *  \return The end of the range where counts were written.
+   */
+  template <typename Container, typename InputIterator,
+            typename RandomAccessIterator>
+  inline RandomAccessIterator
+  batch_region_count(const Container& container, InputIterator first,
+                     InputIterator last, RandomAccessIterator result,
+                     std::size_t width = SPATIAL_BATCH_WIDTH)
+  {
+    typedef typename details::Query_types<const Container>::node_ptr
+      node_ptr;
+    if (container.empty())
+      {
+        for (; first != last; ++first, ++result) { *result = 0; }
+        return result;
+      }
+    return details::advance_by
+      (result, details::batch_region_count
+       (static_cast<node_ptr>(container.end().node->parent),
+        container.rank(), details::traversal_depth_bound(container.size()),
+        width, first, last,
+        details::Store_value<RandomAccessIterator>(result)));
+  }
+
+} // namespace spatial
+
+#endif // SPATIAL_QUERY_HPP
@@ -0,0 +1,615 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   vp_multiset.hpp
+ *  Contains the definition of \ref spatial::vp_multiset, a vantage-point tree
+ *  that only relies on the distances between keys, and the specializations
+ *  of \ref spatial::neighbor_iterator that search it.
+ */
+
+#ifndef SPATIAL_VP_MULTISET_HPP
+#define SPATIAL_VP_MULTISET_HPP
+
+#include <memory>  // std::allocator
+#include <vector>
+#include <utility> // std::pair
+#include <iterator> // std::forward_iterator_tag
+#include <algorithm> // std::nth_element, std::push_heap, std::pop_heap
+#include "neighbor_iterator.hpp"
+#include "bits/spatial_indexed_array.hpp"
+
+namespace spatial
+{
+  template<dimension_type Rank, typename Key, typename Metric,
+           typename Alloc>
+  class vp_multiset;
+
+  namespace details
+  {
+    /**
+     *  An entry of the search queue of a \ref vp_multiset: either a single
+     *  value at \c pos, whose distance to the target is \c bound, or the
+     *  subtree stored in [\c pos, \c end), whose values are no closer to the
+     *  target than \c bound.
+     */
+    template <typename Distance>
+    struct Vp_entry
+    {
+      Vp_entry(Distance bound_, std::size_t pos_, std::size_t end_,
+               bool value_)
+        : bound(bound_), pos(pos_), end(end_), value(value_) { }
+      Distance bound;
+      std::size_t pos;
+      std::size_t end;
+      bool value;
+    };
+
+    //! Orders the entries of the search queue so that the closest comes out
+    //! first, and values come out before subtrees with the same bound.
+    struct Vp_entry_greater
+    {
+      template <typename Entry>
+      bool operator()(const Entry& x, const Entry& y) const
+      {
+        return y.bound < x.bound
+          || (!(x.bound < y.bound) && y.value && !x.value);
+      }
+    };
+
+    /**
+     *  The incremental nearest neighbor search of a \ref vp_multiset: a
+     *  best-first traversal that keeps the values and the subtrees that
+     *  remain to be visited in a priority queue ordered by their distance, or
+     *  the lower bound of their distance, to the target.
+     *
+     *  Each time a vantage point is visited at a distance \c d of the
+     *  target, the triangle inequality bounds the distance to the values of
+     *  its inner subtree, which are within \c mu of the vantage point, by \c
+     *  d - \c mu, and the distance to the values of its outer subtree by \c mu
+     *  - \c d.
+     */
+    template <typename Container, typename Metric>
+    class Vp_search
+    {
+    public:
+      typedef typename Metric::distance_type distance_type;
+      typedef typename Container::key_type key_type;
+      typedef Vp_entry<distance_type> entry_type;
+
+      Vp_search() : container(0), pos(0), distance() { }
+
+      Vp_search(const Container& container_, const Metric& metric_,
+                const key_type& target_)
+        : container(&container_), metric(metric_), target(target_),
+          pos(container_.slot_count()), distance()
+      {
+        if (container_.indexed_size() != 0)
+          {
+            heap.push_back(entry_type(distance_type(), 0,
+                                      container_.indexed_size(), false));
+          }
+        for (std::size_t i = container_.next_slot(container_.indexed_size());
+             i < container_.slot_count(); i = container_.next_slot(i + 1))
+          {
+            heap.push_back(entry_type(distance_to(i), i, i + 1, true));
+            std::push_heap(heap.begin(), heap.end(), Vp_entry_greater());
+          }
+        increment();
+      }
+
+      //! Moves to the next closest value, or past-the-end.
+      void increment()
+      {
+        while (!heap.empty())
+          {
+            std::pop_heap(heap.begin(), heap.end(), Vp_entry_greater());
+            entry_type entry = heap.back();
+            heap.pop_back();
+            if (entry.value)
+              { pos = entry.pos; distance = entry.bound; return; }
+            distance_type d = distance_to(entry.pos);
+            if (!container->is_erased(entry.pos))
+              { push(entry_type(d, entry.pos, entry.pos + 1, true)); }
+            std::size_t split = container->_split[entry.pos];
+            distance_type mu = container->_bound[entry.pos];
+            if (split > entry.pos + 1)
+              {
+                push(entry_type(mu < d && entry.bound < d - mu
+                                ? d - mu : entry.bound,
+                                entry.pos + 1, split, false));
+              }
+            if (entry.end > split)
+              {
+                push(entry_type(d < mu && entry.bound < mu - d
+                                ? mu - d : entry.bound,
+                                split, entry.end, false));
+              }
+          }
+        pos = container->slot_count();
+      }
+
+      distance_type distance_to(std::size_t i) const
+      {
+        return metric.distance_to_key(container->dimension(), target,
+                                      container->slot(i));
+      }
+
+      void push(const entry_type& entry)
+      {
+        heap.push_back(entry);
+        std::push_heap(heap.begin(), heap.end(), Vp_entry_greater());
+      }
+
+      const Container* container;
+      Metric metric;
+      key_type target;
+      std::vector<entry_type> heap;
+      std::size_t pos;
+      distance_type distance;
+    };
+  } // namespace details
+
+  /**
+   *  A multiset of keys indexed by a vantage-point tree, which relies only on
+   *  \c distance_to_key() of its \c Metric and on the triangle inequality.
+   *
+   *  The trees of the library prune their searches with \c
+   *  distance_to_plane(), which is loose or meaningless for metrics such as
+   *  the edit distance, the angular distance or the distance between
+   *  learned embeddings. Each node of a vantage-point tree instead splits
+   *  the values of its subtree around the median of their distances to the
+   *  node, which bounds the distance of the target to either side.
+   *
+   *  The tree is stored in a single array, in pre-order. It is built in \Onlogn
+   *  distance computations. Values inserted after the last build are kept
+   *  at the end of the array and searched exhaustively, and erased values
+   *  are skipped by the searches, until they amount to a quarter of the
+   *  tree, which is then rebuilt.
+   *
+   *  The values are searched with \ref neighbor_iterator, obtained with
+   *  neighbor_begin(), neighbor_end(), neighbor_lower_bound() and
+   *  neighbor_upper_bound(), which visit the values by increasing distance
+   *  to the target. The metric given to these functions must be the one that
+   *  built the container.
+   *
+   *  \tparam Rank The rank passed to the metric; for keys that are not
+   *  points, such as strings, any rank accepted by the metric.
+   *  \tparam Key The type of the keys.
+   *  \tparam Metric A type that provides \c distance_type and \c
+   *  distance_to_key(rank, x, y), which must satisfy the triangle
+   *  inequality.
+   *  \tparam Alloc The allocator of the values.
+   */
+  template<dimension_type Rank, typename Key, typename Metric,
+           typename Alloc = std::allocator<Key> >
+  class vp_multiset
+    : public details::Indexed_array<vp_multiset<Rank, Key, Metric, Alloc>,
+                                    Key, Alloc>
+  {
+  private:
+    typedef details::Indexed_array<vp_multiset<Rank, Key, Metric, Alloc>,
+                                   Key, Alloc> Base;
+
+    template <typename, typename> friend class details::Vp_search;
+    friend class details::Indexed_array<vp_multiset<Rank, Key, Metric, Alloc>,
+                                        Key, Alloc>;
+
+  public:
+    typedef details::Static_rank<Rank>                    rank_type;
+    typedef Key                                           key_type;
+    typedef Key                                           value_type;
+    typedef Metric                                        metric_type;
+    typedef typename Metric::distance_type                distance_type;
+    typedef Alloc                                         allocator_type;
+    typedef typename Base::size_type                      size_type;
+    typedef typename Base::difference_type                difference_type;
+    typedef const Key*                                    pointer;
+    typedef const Key*                                    const_pointer;
+    typedef const Key&                                    reference;
+    typedef const Key&                                    const_reference;
+    typedef typename Base::iterator                       iterator;
+    typedef typename Base::const_iterator                 const_iterator;
+
+    vp_multiset() : Base(Alloc()) { }
+
+    explicit vp_multiset(const Metric& metric_)
+      : Base(Alloc()), _metric(metric_) { }
+
+    vp_multiset(const Metric& metric_, const Alloc& alloc)
+      : Base(alloc), _metric(metric_) { }
+
+    //! Returns the rank of the container.
+    rank_type rank() const { return rank_type(); }
+
+    //! Returns the rank passed to the metric.
+    dimension_type dimension() const { return Rank; }
+
+    //! Returns the metric used to build the tree.
+    metric_type metric() const { return _metric; }
+
+    void swap(vp_multiset& other)
+    {
+      Base::swap(other);
+      _bound.swap(other._bound);
+      _split.swap(other._split);
+      std::swap(_metric, other._metric);
+    }
+
+    //! Returns a value at a distance of zero from \c key, or \ref end() if
+    //! there are none.
+    const_iterator find(const key_type& key) const
+    {
+      details::Vp_search<vp_multiset, Metric> search(*this, _metric, key);
+      if (search.pos != this->slot_count()
+          && !(distance_type() < search.distance))
+        return const_iterator(*this, search.pos);
+      return this->end();
+    }
+
+    //! Returns the number of values at a distance of zero from \c key.
+    size_type count(const key_type& key) const
+    {
+      size_type found = 0;
+      for (details::Vp_search<vp_multiset, Metric> search(*this, _metric, key);
+           search.pos != this->slot_count()
+             && !(distance_type() < search.distance);
+           search.increment())
+        { ++found; }
+      return found;
+    }
+
+  private:
+    //! Builds the tree over all the values of the array, whose positions
+    //! are reordered in \c order so that the tree is stored in pre-order.
+    void build_index(std::vector<std::size_t>& order)
+    {
+      std::vector<distance_type> bound(order.size());
+      std::vector<std::size_t> split(order.size());
+      if (!order.empty())
+        {
+          std::vector<std::pair<distance_type, std::size_t> >
+            work(order.size());
+          for (std::size_t i = 0; i < work.size(); ++i)
+            { work[i].second = order[i]; }
+          build(work, 0, work.size(), bound, split);
+          for (std::size_t i = 0; i < work.size(); ++i)
+            { order[i] = work[i].second; }
+        }
+      _bound.swap(bound);
+      _split.swap(split);
+    }
+
+    //! Returns true if \c value is at a distance of zero from \c key.
+    bool equal_value(const Key& value, const key_type& key) const
+    { return !(distance_type() < _metric.distance_to_key(Rank, key, value)); }
+
+    /**
+     *  Builds the subtree of the values whose positions are stored in [\c
+     *  first, \c last) of \c work. The first value is the vantage point. The
+     *  others are partitioned around the median of their distances to it,
+     *  the closest ones forming the inner subtree.
+     */
+    void build(std::vector<std::pair<distance_type, std::size_t> >& work,
+               std::size_t first, std::size_t last,
+               std::vector<distance_type>& bound,
+               std::vector<std::size_t>& split) const
+    {
+      while (last - first > 1)
+        {
+          const Key& vantage = this->slot(work[first].second);
+          for (std::size_t i = first + 1; i < last; ++i)
+            {
+              work[i].first = _metric.distance_to_key
+                (Rank, vantage, this->slot(work[i].second));
+            }
+          std::size_t mid = first + 1 + (last - first - 1) / 2;
+          std::nth_element(work.begin() + static_cast<difference_type>
+                           (first + 1),
+                           work.begin() + static_cast<difference_type>(mid),
+                           work.begin() + static_cast<difference_type>(last),
+                           Distance_less());
+          bound[first] = work[mid].first;
+          split[first] = mid + 1;
+          build(work, first + 1, mid + 1, bound, split);
+          first = mid + 1;
+        }
+      if (first < last)
+        { bound[first] = distance_type(); split[first] = last; }
+    }
+
+    //! Orders the entries of the build by distance to the vantage point.
+    struct Distance_less
+    {
+      template <typename Entry>
+      bool operator()(const Entry& x, const Entry& y) const
+      { return x.first < y.first; }
+    };
+
+    std::vector<distance_type> _bound;
+    std::vector<std::size_t> _split;
+    Metric _metric;
+  };
+
+  /**
+   *  Specialization of \ref neighbor_iterator for \ref vp_multiset. The
+   *  iterator visits the values of the container by increasing distance to
+   *  the target. It may only be incremented.
+   */
+  template <dimension_type Rank, typename Key, typename Metric,
+            typename Alloc, typename QueryMetric>
+  class neighbor_iterator<vp_multiset<Rank, Key, Metric, Alloc>, QueryMetric>
+  {
+  private:
+    typedef vp_multiset<Rank, Key, Metric, Alloc> container_type;
+
+  public:
+    typedef std::forward_iterator_tag                   iterator_category;
+    typedef Key                                         value_type;
+    typedef typename container_type::difference_type    difference_type;
+    typedef const Key*                                  pointer;
+    typedef const Key&                                  reference;
+    typedef QueryMetric                                 metric_type;
+    typedef typename QueryMetric::distance_type         distance_type;
+    typedef Key                                         key_type;
+
+    //! Uninitialized iterator.
+    neighbor_iterator() { }
+
+    //! Builds an iterator to the value of \c container that is the closest
+    //! to \c target.
+    neighbor_iterator(const container_type& container,
+                      const QueryMetric& metric, const key_type& target)
+      : _search(container, metric, target) { }
+
+    //! Builds a past-the-end iterator of \c container.
+    explicit neighbor_iterator(const container_type& container)
+    {
+      _search.container = &container;
+      _search.pos = container.slot_count();
+    }
+
+    reference operator*() const
+    { return _search.container->slot(_search.pos); }
+
+    pointer operator->() const { return &**this; }
+
+    neighbor_iterator& operator++()
+    { _search.increment(); return *this; }
+
+    neighbor_iterator operator++(int)
+    {
+      neighbor_iterator x(*this);
+      _search.increment();
+      return x;
+    }
+
+    bool operator==(const neighbor_iterator& other) const
+    { return _search.pos == other._search.pos; }
+
+    bool operator!=(const neighbor_iterator& other) const
+    { return _search.pos != other._search.pos; }
+
+    //! Returns the distance between the current value and the target.
+    distance_type distance() const { return _search.distance; }
+
+    //! Returns the metric used by the iterator.
+    const metric_type& metric() const { return _search.metric; }
+
+    //! Returns the target of the search.
+    const key_type& target_key() const { return _search.target; }
+
+  private:
+    details::Vp_search<container_type, QueryMetric> _search;
+  };
+
+  /**
+   *  Specialization of \ref neighbor_iterator for constant \ref
+   *  vp_multiset, which is the same iterator since the values of the
+   *  container are always constant.
+   */
+  template <dimension_type Rank, typename Key, typename Metric,
+            typename Alloc, typename QueryMetric>
+  class neighbor_iterator<const vp_multiset<Rank, Key, Metric, Alloc>,
+                          QueryMetric>
+    : public neighbor_iterator<vp_multiset<Rank, Key, Metric, Alloc>,
+                               QueryMetric>
+  {
+  private:
+    typedef vp_multiset<Rank, Key, Metric, Alloc> container_type;
+    typedef neighbor_iterator<container_type, QueryMetric> Base;
+
+  public:
+    neighbor_iterator() { }
+
+    neighbor_iterator(const container_type& container,
+                      const QueryMetric& metric, const Key& target)
+      : Base(container, metric, target) { }
+
+    explicit neighbor_iterator(const container_type& container)
+      : Base(container) { }
+
+    neighbor_iterator(const Base& other) : Base(other) { }
+
+    neighbor_iterator& operator++()
+    { Base::operator++(); return *this; }
+
+    neighbor_iterator operator++(int)
+    {
+      neighbor_iterator x(*this);
+      Base::operator++();
+      return x;
+    }
+  };
+
+  /**
+   *  Returns a \ref neighbor_iterator to the value of a \ref vp_multiset that
+   *  is the closest to \c target, or past-the-end.
+   */
+  ///@{
+  template <dimension_type Rank, typename Key, typename Metric,
+            typename Alloc, typename QueryMetric>
+  inline neighbor_iterator<vp_multiset<Rank, Key, Metric, Alloc>,
+                           QueryMetric>
+  neighbor_begin(vp_multiset<Rank, Key, Metric, Alloc>& container,
+                 const QueryMetric& metric, const Key& target)
+  {
+    return neighbor_iterator<vp_multiset<Rank, Key, Metric, Alloc>,
+                             QueryMetric>(container, metric, target);
+  }
+
+  template <dimension_type Rank, typename Key, typename Metric,
+            typename Alloc, typename QueryMetric>
+  inline neighbor_iterator<const vp_multiset<Rank, Key, Metric, Alloc>,
+                           QueryMetric>
+  neighbor_cbegin(const vp_multiset<Rank, Key, Metric, Alloc>& container,
+                  const QueryMetric& metric, const Key& target)
+  {
+    return neighbor_iterator<const vp_multiset<Rank, Key, Metric, Alloc>,
+                             QueryMetric>(container, metric, target);
+  }
+  ///@}
+
+  /**
+   *  Returns a past-the-end \ref neighbor_iterator of a \ref vp_multiset.
+   */
+  ///@{
+  template <dimension_type Rank, typename Key, typename Metric,
+            typename Alloc, typename QueryMetric>
+  inline neighbor_iterator<vp_multiset<Rank, Key, Metric, Alloc>,
+                           QueryMetric>
+  neighbor_end(vp_multiset<Rank, Key, Metric, Alloc>& container,
+               const QueryMetric&, const Key&)
+  {
+    return neighbor_iterator<vp_multiset<Rank, Key, Metric, Alloc>,
+                             QueryMetric>(container);
+  }
+
+  template <dimension_type Rank, typename Key, typename Metric,
+            typename Alloc, typename QueryMetric>
+  inline neighbor_iterator<const vp_multiset<Rank, Key, Metric, Alloc>,
+                           QueryMetric>
+  neighbor_cend(const vp_multiset<Rank, Key, Metric, Alloc>& container,
+                const QueryMetric&, const Key&)
+  {
+    return neighbor_iterator<const vp_multiset<Rank, Key, Metric, Alloc>,
+                             QueryMetric>(container);
+  }
+  ///@}
+
+  /**
+   *  Returns a \ref neighbor_iterator to the closest value of a \ref
+   *  vp_multiset whose distance to \c target is greater or equal to \c
+   *  bound, or past-the-end.
+   */
+  ///@{
+  template <dimension_type Rank, typename Key, typename Metric,
+            typename Alloc, typename QueryMetric>
+  inline neighbor_iterator<vp_multiset<Rank, Key, Metric, Alloc>,
+                           QueryMetric>
+  neighbor_lower_bound(vp_multiset<Rank, Key, Metric, Alloc>& container,
+                       const QueryMetric& metric, const Key& target,
+                       typename QueryMetric::distance_type bound)
+  {
+    except::check_positive_distance(bound);
+    neighbor_iterator<vp_multiset<Rank, Key, Metric, Alloc>, QueryMetric>
+      i(container, metric, target), end(container);
+    while (i != end && i.distance() < bound) { ++i; }
+    return i;
+  }
+
+  template <dimension_type Rank, typename Key, typename Metric,
+            typename Alloc, typename QueryMetric>
+  inline neighbor_iterator<const vp_multiset<Rank, Key, Metric, Alloc>,
+                           QueryMetric>
+  neighbor_clower_bound(const vp_multiset<Rank, Key, Metric, Alloc>&
+                        container, const QueryMetric& metric,
+                        const Key& target,
+                        typename QueryMetric::distance_type bound)
+  {
+    except::check_positive_distance(bound);
+    neighbor_iterator<const vp_multiset<Rank, Key, Metric, Alloc>,
+                      QueryMetric> i(container, metric, target), end(container);
+    while (i != end && i.distance() < bound) { ++i; }
+    return i;
+  }
+  ///@}
+
+  /**
+   *  Returns a \ref neighbor_iterator to the closest value of a \ref
+   *  vp_multiset whose distance to \c target is greater than \c bound, or
+   *  past-the-end. The values within a radius \c bound of \c target are in
+   *  [neighbor_begin(), neighbor_upper_bound()).
+   */
+  ///@{
+  template <dimension_type Rank, typename Key, typename Metric,
+            typename Alloc, typename QueryMetric>
+  inline neighbor_iterator<vp_multiset<Rank, Key, Metric, Alloc>,
+                           QueryMetric>
+  neighbor_upper_bound(vp_multiset<Rank, Key, Metric, Alloc>& container,
+                       const QueryMetric& metric, const Key& target,
+                       typename QueryMetric::distance_type bound)
+  {
+    except::check_positive_distance(bound);
+    neighbor_iterator<vp_multiset<Rank, Key, Metric, Alloc>, QueryMetric>
+      i(container, metric, target), end(container);
+    while (i != end && !(bound < i.distance())) { ++i; }
+    return i;
+  }
+
+  template <dimension_type Rank, typename Key, typename Metric,
+            typename Alloc, typename QueryMetric>
+  inline neighbor_iterator<const vp_multiset<Rank, Key, Metric, Alloc>,
+                           QueryMetric>
+  neighbor_cupper_bound(const vp_multiset<Rank, Key, Metric, Alloc>&
+                        container, const QueryMetric& metric,
+                        const Key& target,
+                        typename QueryMetric::distance_type bound)
+  {
+    except::check_positive_distance(bound);
+    neighbor_iterator<const vp_multiset<Rank, Key, Metric, Alloc>,
+                      QueryMetric> i(container, metric, target), end(container);
+    while (i != end && !(bound < i.distance())) { ++i; }
+    return i;
+  }
+  ///@}
+
+  /**
+   *  Returns a \ref neighbor_iterator_pair over all the values of a \ref
+   *  vp_multiset, by increasing distance to \c target.
+   */
+  ///@{
+  template <dimension_type Rank, typename Key, typename Metric,
+            typename Alloc, typename QueryMetric>
+  inline neighbor_iterator_pair<vp_multiset<Rank, Key, Metric, Alloc>,
+                                QueryMetric>
+  neighbor_range(vp_multiset<Rank, Key, Metric, Alloc>& container,
+                 const QueryMetric& metric, const Key& target)
+  {
+    return neighbor_iterator_pair<vp_multiset<Rank, Key, Metric, Alloc>,
+                                  QueryMetric>
+      (neighbor_begin(container, metric, target),
+       neighbor_end(container, metric, target));
+  }
+
+  template <dimension_type Rank, typename Key, typename Metric,
+            typename Alloc, typename QueryMetric>
+  inline neighbor_iterator_pair<const vp_multiset<Rank, Key, Metric, Alloc>,
+                                QueryMetric>
+  neighbor_crange(const vp_multiset<Rank, Key, Metric, Alloc>& container,
+                  const QueryMetric& metric, const Key& target)
+  {
+    return neighbor_iterator_pair<const vp_multiset<Rank, Key, Metric, Alloc>,
+                                  QueryMetric>
+      (neighbor_cbegin(container, metric, target),
+       neighbor_cend(container, metric, target));
+  }
+  ///@}
+
+} // namespace spatial
+
+#endif // SPATIAL_VP_MULTISET_HPP
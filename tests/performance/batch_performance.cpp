@@ -0,0 +1,121 @@
+// Compares the nearest neighbor searches and exact searches carried out one
+// at a time with the same searches carried out in batches, where several of
+// them are advanced in turn. The batches pay off with sample sizes for which
+// the tree does not fit in cache, e.g. 10000000 points.
+//
+// Batched searches are timed by chunks of targets: their latency is that of a
+// chunk, and their throughput is given in targets per second.
+
+#include <vector>
+#include <string>
+#include <sstream>
+
+#include "../../src/idle_point_multiset.hpp"
+#include "../../src/neighbor_iterator.hpp"
+#include "../../src/query.hpp"
+
+#include "benchmark.hpp"
+#include "random.hpp"
+#include "workload.hpp"
+#include "point_type.hpp"
+
+// The number of targets given to each call of a batched search.
+const std::size_t chunk = 256;
+
+inline std::string with_width(const char* operation, std::size_t width)
+{
+  std::ostringstream name;
+  name << operation << " (" << width << ")";
+  return name.str();
+}
+
+template <typename Container, typename Point, typename Metric>
+void time_neighbors
+(utils::benchmark& bench, const char* name, Container& cobaye,
+ const std::vector<Point>& targets,
+ std::vector<typename Container::iterator>& results, const Metric& metric)
+{
+  bench.run(name, "neighbor_begin", targets.size(),
+            [&](std::size_t i)
+            { results[i] = neighbor_begin(cobaye, targets[i]); });
+  for (std::size_t width = 4; width <= 16; width *= 2)
+    bench.run(name, with_width("batch_nearest_neighbor", width),
+              targets.size() / chunk,
+              utils::no_setup(),
+              [&](std::size_t i)
+              {
+                spatial::batch_nearest_neighbor
+                  (cobaye, metric, targets.begin() + i * chunk,
+                   targets.begin() + (i + 1) * chunk,
+                   results.begin() + i * chunk, width);
+              }, chunk);
+}
+
+template <spatial::dimension_type N, typename Point, typename Distribution>
+void compare_batches
+(utils::benchmark& bench, const char* distribution_name,
+ Distribution& distribution)
+{
+  bench.dataset(distribution_name, N);
+  typedef spatial::idle_point_multiset<N, Point> container_type;
+  std::vector<Point> data;
+  std::vector<Point> targets;
+  data.reserve(bench.size());
+  targets.reserve(bench.size());
+  for (std::size_t i = 0; i < bench.size(); ++i)
+    {
+      data.push_back(utils::draw<Point>(distribution, N));
+      targets.push_back(utils::draw_target<Point>(distribution, N));
+    }
+  container_type cobaye;
+  cobaye.insert_rebalance(data.begin(), data.end());
+  std::vector<typename container_type::iterator> results(data.size());
+  typename spatial::neighbor_iterator<container_type>::metric_type metric;
+  bench.run("idle_point_multiset", "find", data.size(),
+            [&](std::size_t i)
+            { results[i] = cobaye.find(data[data.size() - i - 1]); });
+  for (std::size_t width = 4; width <= 16; width *= 2)
+    bench.run("idle_point_multiset", with_width("batch_find", width),
+              data.size() / chunk,
+              utils::no_setup(),
+              [&](std::size_t i)
+              {
+                spatial::batch_find
+                  (cobaye, data.rbegin() + i * chunk,
+                   data.rbegin() + (i + 1) * chunk,
+                   results.begin() + i * chunk, width);
+              }, chunk);
+  time_neighbors(bench, "idle_point_multiset", cobaye, targets, results,
+                 metric);
+  // Targets that come in groups of close points, as in a scan
+  for (std::size_t i = 0; i < data.size(); ++i)
+    {
+      targets[i] = targets[i - i % 8];
+      for (std::size_t d = 0; d < N; ++d)
+        targets[i][d] += 0.001 * static_cast<double>(i % 8);
+    }
+  time_neighbors(bench, "idle_point_multiset (scan)", cobaye, targets,
+                 results, metric);
+}
+
+// Runs compare_batches() on the points of 3 and of 9 dimensions
+struct all_dimensions
+{
+  explicit all_dimensions(utils::benchmark& bench_) : bench(bench_) { }
+
+  template <typename Distribution>
+  void operator()(const char* name, Distribution& distribution) const
+  {
+    compare_batches<3, point3_type>(bench, name, distribution);
+    compare_batches<9, point9_type>(bench, name, distribution);
+  }
+
+  utils::benchmark& bench;
+};
+
+int main (int argc, char **argv)
+{
+  utils::benchmark bench("batch", argc, argv);
+  utils::run_workloads(52617839, all_dimensions(bench));
+  return bench.report();
+}
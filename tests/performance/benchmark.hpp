@@ -0,0 +1,392 @@
+// -*- C++ -*-
+#ifndef SPATIAL_EXAMPLE_UTILS_BENCHMARK_HPP
+#define SPATIAL_EXAMPLE_UTILS_BENCHMARK_HPP
+
+#include <chrono>
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <iterator>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+
+namespace utils
+{
+  /// The clock of the benchmarks: monotonic, with a resolution of about a
+  /// nanosecond on common platforms.
+  typedef std::chrono::steady_clock benchmark_clock;
+
+  /// Keeps the compiler from discarding the computation of \c value.
+  template <typename Tp>
+  inline void do_not_optimize(const Tp& value)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+  }
+
+  /// The options common to all benchmark programs, read from the command
+  /// line.
+  struct benchmark_options
+  {
+    benchmark_options()
+      : size(100000), warmup(1), repetitions(5), format("text") { }
+
+    /// The number of objects in the containers.
+    std::size_t size;
+    /// The number of untimed passes run before the measures.
+    std::size_t warmup;
+    /// The number of timed passes of each measure.
+    std::size_t repetitions;
+    /// One of "text", "csv" or "json".
+    std::string format;
+    /// The file where results are written, or empty for the standard output.
+    std::string output;
+    /// Only the measures whose operation or container contains this string
+    /// are run, if it is not empty.
+    std::string filter;
+  };
+
+  /// The statistics of one operation on one container.
+  struct benchmark_result
+  {
+    std::string operation;
+    std::string container;
+    std::string distribution;
+    std::size_t dimension;
+    std::size_t size;
+    /// The number of operations in a pass.
+    std::size_t operations;
+    /// The number of objects processed by each operation.
+    std::size_t items;
+    /// Latency percentiles and mean of one operation, in nanoseconds.
+    double p50, p99, p999, mean;
+    /// Objects processed per second.
+    double throughput;
+  };
+
+  /// The setup of measures that need none.
+  struct no_setup { void operator()() const { } };
+
+  namespace details
+  {
+    inline std::uint64_t elapsed_ns(benchmark_clock::time_point start,
+                                    benchmark_clock::time_point stop)
+    {
+      return static_cast<std::uint64_t>
+        (std::chrono::duration_cast<std::chrono::nanoseconds>
+         (stop - start).count());
+    }
+
+    /// The smallest time measured between 2 consecutive readings of the
+    /// clock, which is subtracted from the latency of each operation.
+    inline std::uint64_t clock_overhead()
+    {
+      std::uint64_t overhead = ~std::uint64_t(0);
+      for (int i = 0; i < 1000; ++i)
+        {
+          benchmark_clock::time_point start = benchmark_clock::now();
+          benchmark_clock::time_point stop = benchmark_clock::now();
+          overhead = std::min(overhead, elapsed_ns(start, stop));
+        }
+      return overhead;
+    }
+
+    /// Returns the nearest-rank percentile \c p of the sorted \c samples.
+    inline double percentile(const std::vector<std::uint64_t>& samples,
+                             double p)
+    {
+      if (samples.empty()) return 0.0;
+      std::size_t rank = static_cast<std::size_t>
+        (std::ceil(p * static_cast<double>(samples.size())));
+      if (rank > 0) --rank;
+      return static_cast<double>(samples[std::min(rank, samples.size() - 1)]);
+    }
+
+    inline std::string json_string(const std::string& value)
+    {
+      std::string quoted("\"");
+      for (std::string::const_iterator i = value.begin();
+           i != value.end(); ++i)
+        {
+          if (*i == '"' || *i == '\\') quoted += '\\';
+          quoted += *i;
+        }
+      return quoted + "\"";
+    }
+
+    inline void usage(const char* program)
+    {
+      std::cerr << "Usage: " << program << " [<sample size>] [--size <n>]"
+        " [--warmup <n>] [--repetitions <n>] [--format text|csv|json]"
+        " [--output <file>] [--filter <string>]" << std::endl;
+      std::exit(1);
+    }
+
+    inline std::size_t parse_size(const char* program, const char* value)
+    {
+      std::istringstream argbuf(value);
+      std::size_t result;
+      if (!(argbuf >> result) || !argbuf.eof()) usage(program);
+      return result;
+    }
+  } // namespace details
+
+  /**
+   *  Runs the measures of a benchmark program and reports their results.
+   *
+   *  Each measure is a number of operations carried out on a container, after
+   *  a setup that is not timed. The operations are first run \c warmup times,
+   *  then each repetition runs them twice: once timed as a whole for the
+   *  throughput, and once timed one by one for the latency percentiles,
+   *  from which the overhead of the clock is subtracted.
+   *
+   *  The results are written as text, CSV or JSON to the standard output or
+   *  to a file when the benchmark is reported:
+   *
+   *  \code
+   *    utils::benchmark bench("find", argc, argv);
+   *    bench.dataset("uniform", 3);
+   *    bench.run("point_multiset", "find", data.size(),
+   *              [&](std::size_t i)
+   *              { utils::do_not_optimize(cobaye.find(data[i])); });
+   *    return bench.report();
+   *  \endcode
+   */
+  class benchmark
+  {
+  public:
+    benchmark(const std::string& scenario, int argc, char** argv)
+      : _scenario(scenario), _dimension(0),
+        _overhead(details::clock_overhead())
+    {
+      for (int i = 1; i < argc; ++i)
+        {
+          std::string arg(argv[i]);
+          if (arg[0] != '-')
+            {
+              _options.size = details::parse_size(argv[0], argv[i]);
+              continue;
+            }
+          if (i + 1 == argc) details::usage(argv[0]);
+          const char* value = argv[++i];
+          if (arg == "--size")
+            _options.size = details::parse_size(argv[0], value);
+          else if (arg == "--warmup")
+            _options.warmup = details::parse_size(argv[0], value);
+          else if (arg == "--repetitions")
+            _options.repetitions = details::parse_size(argv[0], value);
+          else if (arg == "--format") _options.format = value;
+          else if (arg == "--output") _options.output = value;
+          else if (arg == "--filter") _options.filter = value;
+          else details::usage(argv[0]);
+        }
+      if (_options.repetitions == 0
+          || (_options.format != "text" && _options.format != "csv"
+              && _options.format != "json"))
+        details::usage(argv[0]);
+    }
+
+    //! The number of objects to put in the containers.
+    std::size_t size() const { return _options.size; }
+
+    const benchmark_options& options() const { return _options; }
+
+    //! Sets the distribution and dimension of the following measures.
+    void dataset(const std::string& distribution, std::size_t dimension)
+    {
+      _distribution = distribution;
+      _dimension = dimension;
+    }
+
+    /**
+     *  Measures \c operations calls to \c op, called with the index of the
+     *  operation, each processing \c items objects. \c setup is called
+     *  before each pass, e.g. to empty a container before inserting in it.
+     */
+    template <typename Setup, typename Operation>
+    void run(const std::string& container, const std::string& operation,
+             std::size_t operations, Setup setup, Operation op,
+             std::size_t items = 1)
+    {
+      if (!selected(container, operation) || operations == 0) return;
+      for (std::size_t r = 0; r < _options.warmup; ++r)
+        {
+          setup();
+          for (std::size_t i = 0; i < operations; ++i) op(i);
+        }
+      std::vector<std::uint64_t> passes;
+      std::vector<std::uint64_t> samples;
+      passes.reserve(_options.repetitions);
+      samples.reserve(operations * _options.repetitions);
+      for (std::size_t r = 0; r < _options.repetitions; ++r)
+        {
+          setup();
+          benchmark_clock::time_point start = benchmark_clock::now();
+          for (std::size_t i = 0; i < operations; ++i) op(i);
+          benchmark_clock::time_point stop = benchmark_clock::now();
+          passes.push_back(details::elapsed_ns(start, stop));
+          setup();
+          for (std::size_t i = 0; i < operations; ++i)
+            {
+              start = benchmark_clock::now();
+              op(i);
+              stop = benchmark_clock::now();
+              std::uint64_t latency = details::elapsed_ns(start, stop);
+              samples.push_back(latency > _overhead ? latency - _overhead : 0);
+            }
+        }
+      std::sort(passes.begin(), passes.end());
+      std::sort(samples.begin(), samples.end());
+      benchmark_result result;
+      result.operation = operation;
+      result.container = container;
+      result.distribution = _distribution;
+      result.dimension = _dimension;
+      result.size = _options.size;
+      result.operations = operations;
+      result.items = items;
+      result.p50 = details::percentile(samples, 0.5);
+      result.p99 = details::percentile(samples, 0.99);
+      result.p999 = details::percentile(samples, 0.999);
+      double median = static_cast<double>(passes[passes.size() / 2]);
+      result.mean = median / static_cast<double>(operations);
+      result.throughput = median == 0.0 ? 0.0
+        : static_cast<double>(operations * items) * 1e9 / median;
+      if (_options.format == "text" && _options.output.empty())
+        print_text(std::cout, result);
+      _results.push_back(result);
+    }
+
+    //! Measures \c operations calls to \c op, without setup.
+    template <typename Operation>
+    void run(const std::string& container, const std::string& operation,
+             std::size_t operations, Operation op)
+    { run(container, operation, operations, no_setup(), op); }
+
+    /**
+     *  Measures the increments of an iterator from \c begin to \c end, then
+     *  its decrements from \c end to \c begin.
+     */
+    template <typename Iterator>
+    void run_traversal(const std::string& container, Iterator begin,
+                       Iterator end)
+    {
+      std::size_t count
+        = static_cast<std::size_t>(std::distance(begin, end));
+      Iterator i = begin;
+      run(container, "increment", count, [&]() { i = begin; },
+          [&](std::size_t) { ++i; });
+      run(container, "decrement", count, [&]() { i = end; },
+          [&](std::size_t) { --i; });
+      do_not_optimize(i);
+    }
+
+    /**
+     *  Writes the results in the chosen format and returns the exit status
+     *  of the program. Text written to the standard output is printed as
+     *  results are measured instead.
+     */
+    int report() const
+    {
+      if (_options.format == "text" && _options.output.empty()) return 0;
+      std::ofstream file;
+      if (!_options.output.empty())
+        {
+          file.open(_options.output.c_str());
+          if (!file)
+            {
+              std::cerr << "Cannot write " << _options.output << std::endl;
+              return 1;
+            }
+        }
+      std::ostream& out = _options.output.empty() ? std::cout : file;
+      out << std::fixed << std::setprecision(1);
+      if (_options.format == "csv") write_csv(out);
+      else if (_options.format == "json") write_json(out);
+      else
+        for (std::vector<benchmark_result>::const_iterator
+               i = _results.begin(); i != _results.end(); ++i)
+          print_text(out, *i);
+      return out ? 0 : 1;
+    }
+
+  private:
+    bool selected(const std::string& container,
+                  const std::string& operation) const
+    {
+      return _options.filter.empty()
+        || container.find(_options.filter) != std::string::npos
+        || operation.find(_options.filter) != std::string::npos;
+    }
+
+    void print_text(std::ostream& out, const benchmark_result& result) const
+    {
+      std::ios_base::fmtflags flags = out.flags();
+      out << std::fixed << std::setprecision(1)
+          << _scenario << "\t" << result.distribution << "\t"
+          << result.dimension << "D\t" << result.container << "\t"
+          << result.operation << ":\tp50 " << result.p50 << "ns\tp99 "
+          << result.p99 << "ns\tp999 " << result.p999 << "ns\t"
+          << std::setprecision(0) << result.throughput << "/s" << std::endl;
+      out.flags(flags);
+    }
+
+    void write_csv(std::ostream& out) const
+    {
+      out << "scenario,operation,container,distribution,dimension,size,"
+        "operations,items,repetitions,p50_ns,p99_ns,p999_ns,mean_ns,"
+        "throughput" << '\n';
+      for (std::vector<benchmark_result>::const_iterator
+             i = _results.begin(); i != _results.end(); ++i)
+        out << _scenario << ',' << i->operation << ',' << i->container << ','
+            << i->distribution << ',' << i->dimension << ',' << i->size << ','
+            << i->operations << ',' << i->items << ','
+            << _options.repetitions << ',' << i->p50 << ',' << i->p99 << ','
+            << i->p999 << ',' << i->mean << ',' << i->throughput << '\n';
+    }
+
+    void write_json(std::ostream& out) const
+    {
+      out << "{\n  \"scenario\": " << details::json_string(_scenario)
+          << ",\n  \"clock\": \"steady_clock\",\n  \"clock_overhead_ns\": "
+          << _overhead << ",\n  \"warmup\": " << _options.warmup
+          << ",\n  \"repetitions\": " << _options.repetitions
+          << ",\n  \"results\": [";
+      for (std::vector<benchmark_result>::const_iterator
+             i = _results.begin(); i != _results.end(); ++i)
+        {
+          out << (i == _results.begin() ? "\n" : ",\n")
+              << "    {\"operation\": " << details::json_string(i->operation)
+              << ", \"container\": " << details::json_string(i->container)
+              << ", \"distribution\": "
+              << details::json_string(i->distribution)
+              << ", \"dimension\": " << i->dimension
+              << ", \"size\": " << i->size
+              << ", \"operations\": " << i->operations
+              << ", \"items\": " << i->items
+              << ", \"p50_ns\": " << i->p50 << ", \"p99_ns\": " << i->p99
+              << ", \"p999_ns\": " << i->p999 << ", \"mean_ns\": " << i->mean
+              << ", \"throughput\": " << i->throughput << "}";
+        }
+      out << "\n  ]\n}\n";
+    }
+
+    std::string _scenario;
+    std::string _distribution;
+    std::size_t _dimension;
+    std::uint64_t _overhead;
+    benchmark_options _options;
+    std::vector<benchmark_result> _results;
+  };
+}
+
+#endif // SPATIAL_EXAMPLE_UTILS_BENCHMARK_HPP
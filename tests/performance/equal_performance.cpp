@@ -1,62 +1,63 @@
-#include <iostream>
+// Measures the iteration over keys that are all equal, and over the
+// duplicates of a key in a grid.
+
 #include <vector>
-#include <sstream>
 
 #include "../../src/point_multiset.hpp"
 #include "../../src/idle_point_multiset.hpp"
 #include "../../src/equal_iterator.hpp"
 
-#include "chrono.hpp"
+#include "benchmark.hpp"
+#include "workload.hpp"
 #include "point_type.hpp"
 
-double total = 0.;
-
 template <spatial::dimension_type N, typename Point>
-void compare_libraries(std::size_t data_size)
+void time_equal
+(utils::benchmark& bench, const std::vector<Point>& data, const Point& p)
 {
-  std::cout << "\t" << N << " dimensions, " << data_size << " objects:" << std::endl;
-  std::vector<Point> data;
-  data.reserve(data_size);
-  Point p(1.0);
-  for (std::size_t i = 0; i < data_size; ++i)
-    data.push_back(p);
   {
     spatial::point_multiset<N, Point> cobaye;
     cobaye.insert(data.begin(), data.end());
-    std::cout << "\t\tpoint_multiset:\t" << std::flush;
-    utils::time_point start = utils::process_timer_now();
-    for (spatial::equal_iterator<spatial::point_multiset<N, Point> >
-           i = equal_begin(cobaye, p); i != equal_end(cobaye, p); ++i);
-    utils::time_point stop = utils::process_timer_now();
-    std::cout << (stop - start) << "sec" << std::endl;
-    total += stop - start;
-    std::cout << "\t\tpoint_multiset (reverse):\t" << std::flush;
-    start = utils::process_timer_now();
-    spatial::equal_iterator<spatial::point_multiset<N, Point> >
-      i = equal_end(cobaye, p), end = equal_begin(cobaye, p);
-    for (; i != end; --i);
-    stop = utils::process_timer_now();
-    std::cout << (stop - start) << "sec" << std::endl;
-    total += stop - start;
+    bench.run_traversal("point_multiset", equal_begin(cobaye, p),
+                        equal_end(cobaye, p));
   }
+  {
+    spatial::idle_point_multiset<N, Point> cobaye;
+    cobaye.insert_rebalance(data.begin(), data.end());
+    bench.run_traversal("idle_point_multiset", equal_begin(cobaye, p),
+                        equal_end(cobaye, p));
+  }
+}
+
+template <spatial::dimension_type N, typename Point>
+void compare_containers(utils::benchmark& bench)
+{
+  bench.dataset("equal", N);
+  Point p(1.0);
+  std::vector<Point> data(bench.size(), p);
+  time_equal<N>(bench, data, p);
+}
+
+// Keys equal to a cell of a grid where most points have many duplicates
+template <spatial::dimension_type N, typename Point>
+void compare_containers(utils::benchmark& bench, utils::duplicate_grid& grid)
+{
+  bench.dataset("duplicates", N);
+  std::vector<Point> data;
+  data.reserve(bench.size());
+  for (std::size_t i = 0; i < bench.size(); ++i)
+    data.push_back(utils::draw<Point>(grid, N));
+  time_equal<N>(bench, data, utils::draw_target<Point>(grid, N));
 }
 
 int main (int argc, char **argv)
 {
-  if (argc != 2)
-    {
-      std::cerr << "Usage: " << argv[0] << " <sample size: integer>"
-                << std::endl;
-      return 1;
-    }
-
-  std::istringstream argbuf(argv[1]);
-  std::size_t data_size;
-  argbuf >> data_size;
-
-  std::cout << "All points equal:" << std::endl;
-  compare_libraries<3, point3_type>(data_size);
-  compare_libraries<9, point9_type>(data_size);
-
-  std::cout << "Total: " << total << std::endl;
+  utils::benchmark bench("equal", argc, argv);
+  compare_containers<3, point3_type>(bench);
+  compare_containers<9, point9_type>(bench);
+
+  utils::duplicate_grid duplicates(81726354);
+  compare_containers<3, point3_type>(bench, duplicates);
+  compare_containers<9, point9_type>(bench, duplicates);
+  return bench.report();
 }
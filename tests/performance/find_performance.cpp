@@ -1,96 +1,64 @@
-#include <iostream>
+// Measures exact searches of keys that are in the containers.
+
 #include <vector>
-#include <sstream>
 
 #include "../../src/point_multiset.hpp"
 #include "../../src/idle_point_multiset.hpp"
-#include <kdtree++/kdtree.hpp>
 
-#include "chrono.hpp"
+#include "benchmark.hpp"
 #include "random.hpp"
+#include "workload.hpp"
 #include "point_type.hpp"
 
+template <typename Container, typename Point>
+void time_find(utils::benchmark& bench, const char* name, Container& cobaye,
+               const std::vector<Point>& data)
+{
+  bench.run(name, "find", data.size(),
+            [&](std::size_t i)
+            { utils::do_not_optimize(cobaye.find(data[i])); });
+}
+
 template <spatial::dimension_type N, typename Point, typename Distribution>
-void compare_libraries
-(std::size_t data_size, const Distribution& distribution)
+void compare_containers
+(utils::benchmark& bench, const char* distribution_name,
+ Distribution& distribution)
 {
-  std::cout << "\t" << N << " dimensions, " << data_size << " objects:" << std::endl;
+  bench.dataset(distribution_name, N);
   std::vector<Point> data;
-  data.reserve(data_size);
-  for (std::size_t i = 0; i < data_size; ++i)
-    data.push_back(Point(distribution));
+  data.reserve(bench.size());
+  for (std::size_t i = 0; i < bench.size(); ++i)
+    data.push_back(utils::draw<Point>(distribution, N));
   {
-    // Find into a point_multiset
-    std::cout << "\t\tpoint_multiset:\t" << std::flush;
     spatial::point_multiset<N, Point> cobaye;
     cobaye.insert(data.begin(), data.end());
-    utils::time_point start = utils::process_timer_now();
-    for (typename std::vector<Point>::const_iterator i = data.begin();
-         i != data.end(); ++i)
-      cobaye.find(*i);
-    utils::time_point stop = utils::process_timer_now();
-    std::cout << (stop - start) << "sec" << std::endl;
+    time_find(bench, "point_multiset", cobaye, data);
   }
   {
-    // Find into an idle_point_multiset
-    std::cout << "\t\tidle_point_multiset:\t" << std::flush;
     spatial::idle_point_multiset<N, Point> cobaye;
     cobaye.insert_rebalance(data.begin(), data.end());
-    utils::time_point start = utils::process_timer_now();
-    for (typename std::vector<Point>::const_iterator i = data.begin();
-         i != data.end(); ++i)
-      cobaye.find(*i);
-    utils::time_point stop = utils::process_timer_now();
-    std::cout << (stop - start) << "sec" << std::endl;
-  }
-  {
-    // Find into an KDtree
-    std::cout << "\t\tKDtree:\t" << std::flush;
-    KDTree::KDTree<N, Point> cobaye;
-    cobaye.insert(data.begin(), data.end());
-    cobaye.optimise();
-    utils::time_point start = utils::process_timer_now();
-    for (typename std::vector<Point>::const_iterator i = data.begin();
-         i != data.end(); ++i)
-      cobaye.find(*i);
-    utils::time_point stop = utils::process_timer_now();
-    std::cout << (stop - start) << "sec" << std::endl;
+    time_find(bench, "idle_point_multiset", cobaye, data);
   }
 }
 
-int main (int argc, char **argv)
+// Runs compare_containers() on the points of 3 and of 9 dimensions
+struct all_dimensions
 {
-  if (argc != 2)
-    {
-      std::cerr << "Usage: " << argv[0] << " <sample size: integer>"
-                << std::endl;
-      return 1;
-    }
-
-  // Build initialization memory
-  std::istringstream argbuf(argv[1]);
-  std::size_t data_size;
-  argbuf >> data_size;
-  utils::random_engine engine(12384328);
+  explicit all_dimensions(utils::benchmark& bench_) : bench(bench_) { }
 
-  std::cout << "Uniform distribution:" << std::endl;
-  utils::uniform_double_distribution uniform(engine, -1.0, 1.0);
-  compare_libraries<3, point3_type, utils::uniform_double_distribution>
-    (data_size, uniform);
-  compare_libraries<9, point9_type, utils::uniform_double_distribution>
-    (data_size, uniform);
+  template <typename Distribution>
+  void operator()(const char* name, Distribution& distribution) const
+  {
+    compare_containers<3, point3_type>(bench, name, distribution);
+    compare_containers<9, point9_type>(bench, name, distribution);
+  }
 
-  std::cout << "Normal distribution:" << std::endl;
-  utils::normal_double_distribution normal(engine, -1.0, 1.0);
-  compare_libraries<3, point3_type, utils::normal_double_distribution>
-    (data_size, normal);
-  compare_libraries<9, point9_type, utils::normal_double_distribution>
-    (data_size, normal);
+  utils::benchmark& bench;
+};
 
-  std::cout << "Narrow normal distribution:" << std::endl;
-  utils::narrow_double_distribution narrow(engine, -1.0, 1.0);
-  compare_libraries<3, point3_type, utils::narrow_double_distribution>
-    (data_size, narrow);
-  compare_libraries<9, point9_type, utils::narrow_double_distribution>
-    (data_size, narrow);
+int main (int argc, char **argv)
+{
+  utils::benchmark bench("find", argc, argv);
+  utils::run_workloads(12384328, all_dimensions(bench));
+  return bench.report();
 }
@@ -1,105 +1,73 @@
-#include <iostream>
+// Measures the search of the minimum and the maximum of the containers in
+// each dimension.
+
 #include <vector>
-#include <sstream>
 
 #include "../../src/point_multiset.hpp"
 #include "../../src/idle_point_multiset.hpp"
 #include "../../src/mapping_iterator.hpp"
 
-#include "chrono.hpp"
+#include "benchmark.hpp"
 #include "random.hpp"
+#include "workload.hpp"
 #include "point_type.hpp"
 
+template <typename Container>
+void time_minmax(utils::benchmark& bench, const char* name,
+                 Container& cobaye)
+{
+  typedef spatial::mapping_iterator<Container> iterator;
+  bench.run(name, "mapping_begin", cobaye.dimension(),
+            [&](std::size_t j)
+            { utils::do_not_optimize(mapping_begin(cobaye, j)); });
+  bench.run(name, "mapping_end decrement", cobaye.dimension(),
+            [&](std::size_t j)
+            {
+              iterator last = mapping_end(cobaye, j);
+              utils::do_not_optimize(--last);
+            });
+}
+
 template <spatial::dimension_type N, typename Point, typename Distribution>
-void compare_libraries
-(std::size_t data_size, const Distribution& distribution)
+void compare_containers
+(utils::benchmark& bench, const char* distribution_name,
+ Distribution& distribution)
 {
-  std::cout << "\t" << N << " dimensions, " << data_size << " objects:" << std::endl;
+  bench.dataset(distribution_name, N);
   std::vector<Point> data;
-  data.reserve(data_size);
-  for (std::size_t i = 0; i < data_size; ++i)
-    data.push_back(Point(distribution));
+  data.reserve(bench.size());
+  for (std::size_t i = 0; i < bench.size(); ++i)
+    data.push_back(utils::draw<Point>(distribution, N));
   {
-    // Mapping begin into an idle_point_multiset
-    spatial::idle_point_multiset<N, Point> cobaye;
-    cobaye.insert_rebalance(data.begin(), data.end());
-    std::cout << "\t\tidle_point_multiset (maximum):\t" << std::flush;
-    utils::time_point start = utils::process_timer_now();
-    for (int j = 0; j != N; ++j)
-      {
-        spatial::mapping_iterator<spatial::idle_point_multiset<N, Point> >
-          i = mapping_end(cobaye, 0); --i;
-      }
-    utils::time_point stop = utils::process_timer_now();
-    std::cout << (stop - start) << "sec" << std::endl;
-    std::cout << "\t\tidle_point_multiset:\t" << std::flush;
-    start = utils::process_timer_now();
-    for (int j = 0; j != N; ++j)
-      {
-        spatial::mapping_iterator<spatial::idle_point_multiset<N, Point> >
-           i = mapping_begin(cobaye, 0); ++i;
-      }
-    stop = utils::process_timer_now();
-    std::cout << (stop - start) << "sec" << std::endl;
-  }
-  {
-    // Mapping begin into a point_multiset
     spatial::point_multiset<N, Point> cobaye;
     cobaye.insert(data.begin(), data.end());
-    std::cout << "\t\tpoint_multiset:\t" << std::flush;
-    utils::time_point start = utils::process_timer_now();
-    for (int j = 0; j != N; ++j)
-      {
-        spatial::mapping_iterator<spatial::point_multiset<N, Point> >
-           i = mapping_begin(cobaye, 0); ++i;
-      }
-    utils::time_point stop = utils::process_timer_now();
-    std::cout << (stop - start) << "sec" << std::endl;
-    std::cout << "\t\tpoint_multiset (reverse):\t" << std::flush;
-    start = utils::process_timer_now();
-    for (int j = 0; j != N; ++j)
-      {
-        spatial::mapping_iterator<spatial::point_multiset<N, Point> >
-          i = mapping_end(cobaye, 0); --i;
-      }
-    stop = utils::process_timer_now();
-    std::cout << (stop - start) << "sec" << std::endl;
+    time_minmax(bench, "point_multiset", cobaye);
+  }
+  {
+    spatial::idle_point_multiset<N, Point> cobaye;
+    cobaye.insert_rebalance(data.begin(), data.end());
+    time_minmax(bench, "idle_point_multiset", cobaye);
   }
 }
 
-int main (int argc, char **argv)
+// Runs compare_containers() on the points of 3 and of 9 dimensions
+struct all_dimensions
 {
-  if (argc != 2)
-    {
-      std::cerr << "Usage: " << argv[0] << " <sample size: integer>"
-                << std::endl;
-      return 1;
-    }
-
-  // Build initialization memory
-  std::istringstream argbuf(argv[1]);
-  std::size_t data_size;
-  argbuf >> data_size;
-  utils::random_engine engine(243287873);
+  explicit all_dimensions(utils::benchmark& bench_) : bench(bench_) { }
 
-  std::cout << "Uniform distribution:" << std::endl;
-  utils::uniform_double_distribution uniform(engine, -1.0, 1.0);
-  compare_libraries<3, point3_type, utils::uniform_double_distribution>
-    (data_size, uniform);
-  compare_libraries<9, point9_type, utils::uniform_double_distribution>
-    (data_size, uniform);
+  template <typename Distribution>
+  void operator()(const char* name, Distribution& distribution) const
+  {
+    compare_containers<3, point3_type>(bench, name, distribution);
+    compare_containers<9, point9_type>(bench, name, distribution);
+  }
 
-  std::cout << "Normal distribution:" << std::endl;
-  utils::normal_double_distribution normal(engine, -1.0, 1.0);
-  compare_libraries<3, point3_type, utils::normal_double_distribution>
-    (data_size, normal);
-  compare_libraries<9, point9_type, utils::normal_double_distribution>
-    (data_size, normal);
+  utils::benchmark& bench;
+};
 
-  std::cout << "Narrow normal distribution:" << std::endl;
-  utils::narrow_double_distribution narrow(engine, -1.0, 1.0);
-  compare_libraries<3, point3_type, utils::narrow_double_distribution>
-    (data_size, narrow);
-  compare_libraries<9, point9_type, utils::narrow_double_distribution>
-    (data_size, narrow);
+int main (int argc, char **argv)
+{
+  utils::benchmark bench("minmax_mapping", argc, argv);
+  utils::run_workloads(243287873, all_dimensions(bench));
+  return bench.report();
 }
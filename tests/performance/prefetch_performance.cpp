@@ -0,0 +1,102 @@
+// This program is built twice, with and without SPATIAL_ENABLE_PREFETCH, in
+// order to compare the descents of the trees with and without prefetching of
+// the child nodes. The effect is visible with sample sizes for which the tree
+// does not fit in cache, e.g. 10000000 points.
+
+#include <vector>
+#include <iterator>
+
+#include "../../src/point_multiset.hpp"
+#include "../../src/idle_point_multiset.hpp"
+#include "../../src/region_iterator.hpp"
+#include "../../src/neighbor_iterator.hpp"
+#include "../../src/query.hpp"
+
+#include "benchmark.hpp"
+#include "random.hpp"
+#include "workload.hpp"
+#include "point_type.hpp"
+
+template <typename Container, typename Point>
+void time_queries
+(utils::benchmark& bench, const char* name, Container& cobaye,
+ const std::vector<Point>& targets)
+{
+  bench.run(name, "nearest neighbor", targets.size(),
+            [&](std::size_t i)
+            { utils::do_not_optimize(neighbor_begin(cobaye, targets[i])); });
+  std::vector<typename Container::iterator> nearest;
+  nearest.reserve(8);
+  typename spatial::neighbor_iterator<Container>::metric_type metric;
+  bench.run(name, "8 nearest neighbors", targets.size(),
+            [&](std::size_t i)
+            {
+              nearest.clear();
+              spatial::nearest_neighbors(cobaye, metric, targets[i], 8,
+                                         std::back_inserter(nearest));
+            });
+  bench.run(name, "first in small region", targets.size(),
+            [&](std::size_t i)
+            {
+              Point low(targets[i]), high(targets[i]);
+              for (std::size_t d = 0; d < cobaye.dimension(); ++d)
+                { low[d] -= 0.01; high[d] += 0.01; }
+              utils::do_not_optimize(region_begin(cobaye, low, high));
+            });
+}
+
+template <spatial::dimension_type N, typename Point, typename Distribution>
+void time_descents
+(utils::benchmark& bench, const char* distribution_name,
+ Distribution& distribution)
+{
+  bench.dataset(distribution_name, N);
+  std::vector<Point> data;
+  std::vector<Point> targets;
+  data.reserve(bench.size());
+  targets.reserve(bench.size());
+  for (std::size_t i = 0; i < bench.size(); ++i)
+    {
+      data.push_back(utils::draw<Point>(distribution, N));
+      targets.push_back(utils::draw_target<Point>(distribution, N));
+    }
+  {
+    spatial::idle_point_multiset<N, Point> cobaye;
+    cobaye.insert_rebalance(data.begin(), data.end());
+    time_queries(bench, "idle_point_multiset", cobaye, targets);
+  }
+  {
+    spatial::point_multiset<N, Point> cobaye;
+    bench.run("point_multiset", "insert range", 1,
+              [&]() { cobaye.clear(); },
+              [&](std::size_t)
+              { cobaye.insert(data.begin(), data.end()); }, data.size());
+    time_queries(bench, "point_multiset", cobaye, targets);
+  }
+}
+
+// Runs time_descents() on the points of 3 and of 9 dimensions
+struct all_dimensions
+{
+  explicit all_dimensions(utils::benchmark& bench_) : bench(bench_) { }
+
+  template <typename Distribution>
+  void operator()(const char* name, Distribution& distribution) const
+  {
+    time_descents<3, point3_type>(bench, name, distribution);
+    time_descents<9, point9_type>(bench, name, distribution);
+  }
+
+  utils::benchmark& bench;
+};
+
+int main (int argc, char **argv)
+{
+#ifdef SPATIAL_ENABLE_PREFETCH
+  utils::benchmark bench("prefetch_enabled", argc, argv);
+#else
+  utils::benchmark bench("prefetch", argc, argv);
+#endif
+  utils::run_workloads(87235172, all_dimensions(bench));
+  return bench.report();
+}
@@ -0,0 +1,93 @@
+// This program is built twice, with and without SPATIAL_ENABLE_RANK_DISPATCH,
+// in order to compare the traversals of containers whose rank is set at run
+// time, when they use the generic algorithms and when they are dispatched to
+// the algorithms instantiated with a static rank.
+
+#include <vector>
+#include <iterator>
+
+// The keys hold 3 coordinates, so no other rank should be dispatched
+#ifdef SPATIAL_ENABLE_RANK_DISPATCH
+#  define SPATIAL_DISPATCH_RANKS(CASE) CASE(3)
+#endif
+
+#include "../../src/point_multiset.hpp"
+#include "../../src/idle_point_multiset.hpp"
+#include "../../src/region_iterator.hpp"
+#include "../../src/neighbor_iterator.hpp"
+
+#include "benchmark.hpp"
+#include "random.hpp"
+#include "workload.hpp"
+#include "point_type.hpp"
+
+template <typename Container, typename Point>
+void time_queries
+(utils::benchmark& bench, const char* name, Container& cobaye,
+ const std::vector<Point>& data, const std::vector<Point>& targets)
+{
+  bench.run(name, "find", data.size(),
+            [&](std::size_t i)
+            { utils::do_not_optimize(cobaye.find(data[i])); });
+  bench.run(name, "nearest neighbor", targets.size(),
+            [&](std::size_t i)
+            { utils::do_not_optimize(neighbor_begin(cobaye, targets[i])); });
+  bench.run(name, "small region", targets.size(),
+            [&](std::size_t i)
+            {
+              Point low(targets[i]), high(targets[i]);
+              for (std::size_t d = 0; d < cobaye.dimension(); ++d)
+                { low[d] -= 0.01; high[d] += 0.01; }
+              utils::do_not_optimize
+                (std::distance(region_begin(cobaye, low, high),
+                               region_end(cobaye, low, high)));
+            });
+}
+
+template <spatial::dimension_type N, typename Point, typename Distribution>
+void time_runtime_rank
+(utils::benchmark& bench, const char* distribution_name,
+ Distribution& distribution)
+{
+  bench.dataset(distribution_name, N);
+  std::vector<Point> data;
+  std::vector<Point> targets;
+  data.reserve(bench.size());
+  targets.reserve(bench.size());
+  for (std::size_t i = 0; i < bench.size(); ++i)
+    {
+      data.push_back(utils::draw<Point>(distribution, N));
+      targets.push_back(utils::draw_target<Point>(distribution, N));
+    }
+  {
+    spatial::point_multiset<0, Point> cobaye(N);
+    cobaye.insert(data.begin(), data.end());
+    time_queries(bench, "point_multiset", cobaye, data, targets);
+  }
+  {
+    spatial::idle_point_multiset<0, Point> cobaye(N);
+    cobaye.insert_rebalance(data.begin(), data.end());
+    time_queries(bench, "idle_point_multiset", cobaye, data, targets);
+  }
+}
+
+int main (int argc, char **argv)
+{
+#ifdef SPATIAL_ENABLE_RANK_DISPATCH
+  utils::benchmark bench("rank_dispatch_enabled", argc, argv);
+#else
+  utils::benchmark bench("rank_dispatch", argc, argv);
+#endif
+  const unsigned int seed = 52871093;
+  utils::random_engine engine(seed);
+
+  utils::uniform_double_distribution uniform(engine, -1.0, 1.0);
+  time_runtime_rank<3, point3_type>(bench, "uniform", uniform);
+
+  utils::gaussian_clusters clusters(seed);
+  time_runtime_rank<3, point3_type>(bench, "clusters", clusters);
+
+  utils::lidar_scan lidar(seed);
+  time_runtime_rank<3, point3_type>(bench, "lidar", lidar);
+  return bench.report();
+}
@@ -1,86 +1,102 @@
-#include <iostream>
+// Measures the search of the nearest neighbor of targets close to the center
+// of a sphere, when all the keys are on the surface of that sphere: the
+// worst case of the search, where all keys are at about the same distance.
+// The keys are spread uniformly on the sphere, or follow the directions of
+// the points of a workload, which leaves some areas of the sphere crowded
+// and others empty.
+
 #include <vector>
-#include <sstream>
+#include <cmath>
 
 #include "../../src/point_multiset.hpp"
 #include "../../src/idle_point_multiset.hpp"
 #include "../../src/neighbor_iterator.hpp"
-#include <kdtree++/kdtree.hpp>
 
-#include "chrono.hpp"
+#include "benchmark.hpp"
 #include "random.hpp"
+#include "workload.hpp"
 #include "point_type.hpp"
 
+template <typename Container, typename Point>
+void time_nearest(utils::benchmark& bench, const char* name,
+                  Container& cobaye, const std::vector<Point>& targets)
+{
+  bench.run(name, "neighbor_begin", targets.size(),
+            [&](std::size_t i)
+            { utils::do_not_optimize(neighbor_begin(cobaye, targets[i])); });
+}
+
 template <spatial::dimension_type N, typename Point, typename Distribution>
-void compare_libraries
-(std::size_t data_size, const Distribution& distribution)
+void compare_containers
+(utils::benchmark& bench, const char* distribution_name,
+ const Distribution& distribution)
 {
-  std::cout << "\t" << N << " dimensions, " << data_size << " objects:" << std::endl;
+  bench.dataset(distribution_name, N);
   std::vector<Point> data;
   std::vector<Point> targets;
-  data.reserve(data_size);
-  targets.reserve(data_size);
-  for (std::size_t i = 0; i < data_size; ++i)
+  data.reserve(bench.size());
+  targets.reserve(bench.size());
+  for (std::size_t i = 0; i < bench.size(); ++i)
     {
       data.push_back(distribution());
       targets.push_back(distribution(0.01));
     }
   {
-    // Nearest neighbor begin into an idle_point_multiset
-    spatial::idle_point_multiset<N, Point> cobaye;
-    cobaye.insert_rebalance(data.begin(), data.end());
-    std::cout << "\t\tidle_point_multiset:\t" << std::flush;
-    utils::time_point start = utils::process_timer_now();
-    for (typename std::vector<Point>::const_iterator
-           i = targets.begin(); i != targets.end(); ++i)
-      neighbor_begin(cobaye, *i);
-    utils::time_point stop = utils::process_timer_now();
-    std::cout << (stop - start) << "sec" << std::endl;
-  }
-  {
-    // Nearest neighbor begin into an idle_point_multiset
     spatial::point_multiset<N, Point> cobaye;
     cobaye.insert(data.begin(), data.end());
-    std::cout << "\t\tpoint_multiset:\t" << std::flush;
-    utils::time_point start = utils::process_timer_now();
-    for (typename std::vector<Point>::const_iterator
-           i = targets.begin(); i != targets.end(); ++i)
-      neighbor_begin(cobaye, *i);
-    utils::time_point stop = utils::process_timer_now();
-    std::cout << (stop - start) << "sec" << std::endl;
+    time_nearest(bench, "point_multiset", cobaye, targets);
   }
   {
-    // Nearest neighbor into an KDtree
-    KDTree::KDTree<N, Point> cobaye;
-    cobaye.insert(data.begin(), data.end());
-    cobaye.optimise();
-    std::cout << "\t\tKDtree:\t" << std::flush;
-    utils::time_point start = utils::process_timer_now();
-    for (typename std::vector<Point>::const_iterator
-           i = targets.begin(); i != targets.end(); ++i)
-      cobaye.find_nearest(*i);
-    utils::time_point stop = utils::process_timer_now();
-    std::cout << (stop - start) << "sec" << std::endl;
+    spatial::idle_point_multiset<N, Point> cobaye;
+    cobaye.insert_rebalance(data.begin(), data.end());
+    time_nearest(bench, "idle_point_multiset", cobaye, targets);
   }
 }
 
+/**
+ *  Projects the points of a workload on the unit sphere to make the keys,
+ *  while targets are drawn uniformly on a sphere of the given scale, as with
+ *  \c uniform_sphere_distribution.
+ */
+template <typename Point, typename Workload>
+class projected_workload
+{
+public:
+  projected_workload(utils::random_engine engine, Workload& workload)
+    : _sphere(engine), _workload(workload) { }
+
+  Point operator()() const
+  {
+    Point p = utils::draw<Point>(_workload, 3);
+    double norm = std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+    if (norm == 0.0) return _sphere();
+    p[0] /= norm; p[1] /= norm; p[2] /= norm;
+    return p;
+  }
+
+  Point operator()(double scale) const { return _sphere(scale); }
+
+private:
+  utils::uniform_sphere_distribution<Point> _sphere;
+  Workload& _workload;
+};
+
 int main (int argc, char **argv)
 {
-  if (argc != 2)
-    {
-      std::cerr << "Usage: " << argv[0] << " <sample size: integer>"
-                << std::endl;
-      return 1;
-    }
+  utils::benchmark bench("spheric_nearest", argc, argv);
+  utils::random_engine engine(91736428);
+
+  utils::uniform_sphere_distribution<point3_type> sphere(engine);
+  compare_containers<3, point3_type>(bench, "sphere", sphere);
 
-  // Build initialization memory
-  std::istringstream argbuf(argv[1]);
-  std::size_t data_size;
-  argbuf >> data_size;
-  utils::random_engine engine;
+  utils::gaussian_clusters clusters(91736428);
+  projected_workload<point3_type, utils::gaussian_clusters>
+    clustered_sphere(engine, clusters);
+  compare_containers<3, point3_type>(bench, "clusters", clustered_sphere);
 
-  std::cout << "Uniform sphere distribution:" << std::endl;
-  utils::uniform_sphere_distribution<point3_type> uniform(engine);
-  compare_libraries<3, point3_type, utils::uniform_sphere_distribution<point3_type> >
-    (data_size, uniform);
+  utils::lidar_scan lidar(91736428);
+  projected_workload<point3_type, utils::lidar_scan>
+    lidar_sphere(engine, lidar);
+  compare_containers<3, point3_type>(bench, "lidar", lidar_sphere);
+  return bench.report();
 }
@@ -3,6 +3,8 @@
 #include <iostream>
 #include <sstream>
 #include "random.hpp"
+#include "workload.hpp"
+#include "point_type.hpp"
 
 template <typename Distrib>
 void run_distribution(int size, const Distrib& distrib)
@@ -22,6 +24,23 @@ void run_distribution(int size, const Distrib& distrib)
   std::cout << "\tDeviation: " << deviation / size << std::endl;
 }
 
+template <typename Workload>
+void run_workload(int size, Workload& workload)
+{
+  double mean[3] = { 0, 0, 0 };
+  std::cout << "(" << std::flush;
+  for (int i = 0; i < size; ++i, std::cout << ", " << std::flush)
+    {
+      point3_type sample = utils::draw<point3_type>(workload, 3);
+      std::cout << "(" << sample[0] << ", " << sample[1] << ", "
+                << sample[2] << ")" << std::flush;
+      for (std::size_t d = 0; d < 3; ++d) mean[d] += sample[d];
+    }
+  std::cout << ")" << std::endl;
+  std::cout << "\tMean: (" << mean[0] / size << ", " << mean[1] / size
+            << ", " << mean[2] / size << ")" << std::endl;
+}
+
 int main (int argc, char **argv)
 {
     if (argc != 2)
@@ -48,4 +67,24 @@ int main (int argc, char **argv)
   std::cout << "Narrow normal distribution (-1.0, 1.0):" << std::endl;
   utils::narrow_double_distribution narrow(engine, -1.0, 1.0);
   run_distribution(data_size, narrow);
+
+  std::cout << "Gaussian clusters:" << std::endl;
+  utils::gaussian_clusters clusters(46728843);
+  run_workload(data_size, clusters);
+
+  std::cout << "Lidar scan:" << std::endl;
+  utils::lidar_scan lidar(46728843);
+  run_workload(data_size, lidar);
+
+  std::cout << "Vehicle trajectories:" << std::endl;
+  utils::vehicle_trajectories trajectories(46728843);
+  run_workload(data_size, trajectories);
+
+  std::cout << "Power law density:" << std::endl;
+  utils::power_law_density power_law(46728843);
+  run_workload(data_size, power_law);
+
+  std::cout << "Duplicate grid:" << std::endl;
+  utils::duplicate_grid duplicates(46728843);
+  run_workload(data_size, duplicates);
 }
@@ -0,0 +1,522 @@
+// -*- C++ -*-
+#ifndef SPATIAL_EXAMPLE_UTILS_WORKLOAD_HPP
+#define SPATIAL_EXAMPLE_UTILS_WORKLOAD_HPP
+
+#include <cstddef>
+#include <cmath>
+#include <vector>
+#include <random>
+
+#include "random.hpp"
+
+namespace utils
+{
+  /**
+   *  The base of the workloads: generators that draw all the coordinates of
+   *  a point together, unlike the distributions of random.hpp, so that the
+   *  points can follow the shape of real data. Each workload owns an engine
+   *  seeded at construction, and always generates the same points for the
+   *  same seed.
+   *
+   *  A workload provides the points stored in the containers and the
+   *  targets of the queries, in at least 3 dimensions, within [-1, 1]:
+   *  \code
+   *    template <typename Point> void point(Point& p, std::size_t dims);
+   *    template <typename Point> void target(Point& p, std::size_t dims);
+   *  \endcode
+   *  Benchmarks call them through draw() and draw_target(), which also
+   *  accept the distributions of random.hpp.
+   */
+  class workload
+  {
+  public:
+    /// Seeds the engine
+    explicit workload(unsigned int seed) : _engine(seed) { }
+
+  protected:
+    /// Uniformly pick a number in [min, max)
+    double uniform(double min, double max)
+    { return std::uniform_real_distribution<double>(min, max)(_engine); }
+
+    /// Pick a number of a normal distribution
+    double normal(double mean, double sigma)
+    { return std::normal_distribution<double>(mean, sigma)(_engine); }
+
+    /// Uniformly pick an index in [0, n)
+    std::size_t index(std::size_t n)
+    { return std::uniform_int_distribution<std::size_t>(0, n - 1)(_engine); }
+
+    /// Returns the weights 1/k^s, k from 1 to n, of a Zipf distribution
+    static std::vector<double> zipf_weights(std::size_t n, double s)
+    {
+      std::vector<double> weights(n);
+      for (std::size_t k = 0; k < n; ++k)
+        weights[k] = 1.0 / std::pow(static_cast<double>(k + 1), s);
+      return weights;
+    }
+
+    /// The engine of the workload
+    std::mt19937 _engine;
+  };
+
+  /**
+   *  Points grouped in clusters of different sizes and spreads, with a
+   *  normal distribution around the center of each cluster, e.g. objects
+   *  detected around points of interest. Targets are drawn from the same
+   *  clusters.
+   */
+  class gaussian_clusters : public workload
+  {
+  public:
+    gaussian_clusters
+    (unsigned int seed, std::size_t clusters = 32, double sigma = 0.02)
+      : workload(seed), _clusters(clusters), _sigma(sigma), _dims(0) { }
+
+    template <typename Point>
+    void point(Point& p, std::size_t dims)
+    {
+      if (dims != _dims) build(dims);
+      std::size_t c = _pick(_engine);
+      for (std::size_t d = 0; d < dims; ++d)
+        p[d] = clamp(normal(_centers[c][d], _sigmas[c]));
+    }
+
+    template <typename Point>
+    void target(Point& p, std::size_t dims) { point(p, dims); }
+
+  private:
+    static double clamp(double x)
+    { return x < -1.0 ? -1.0 : (x > 1.0 ? 1.0 : x); }
+
+    void build(std::size_t dims)
+    {
+      _dims = dims;
+      _centers.assign(_clusters, std::vector<double>(dims));
+      _sigmas.resize(_clusters);
+      std::vector<double> weights(_clusters);
+      for (std::size_t c = 0; c < _clusters; ++c)
+        {
+          for (std::size_t d = 0; d < dims; ++d)
+            _centers[c][d] = uniform(-0.9, 0.9);
+          _sigmas[c] = _sigma * uniform(0.25, 2.0);
+          weights[c] = uniform(0.1, 1.0);
+        }
+      _pick = std::discrete_distribution<std::size_t>
+        (weights.begin(), weights.end());
+    }
+
+    std::size_t _clusters;
+    double _sigma;
+    std::size_t _dims;
+    std::vector<std::vector<double> > _centers;
+    std::vector<double> _sigmas;
+    std::discrete_distribution<std::size_t> _pick;
+  };
+
+  /**
+   *  The returns of a rotating lidar with several rings of beams, mounted on
+   *  a vehicle over a flat ground, in a scene where obstacles hide the
+   *  facades behind them. Points lie on thin surfaces: the ground seen as
+   *  concentric rings, the obstacles and the facades; beams that reach
+   *  nothing in range return no point. Coordinates past the third hold the
+   *  reflectivity of the surface, the elevation of the ring, and noise.
+   *  Targets are returns of the same scene.
+   */
+  class lidar_scan : public workload
+  {
+  public:
+    lidar_scan
+    (unsigned int seed, std::size_t rings = 32, std::size_t sectors = 720)
+      : workload(seed), _rings(rings), _obstacle(sectors),
+        _height(sectors), _facade(sectors), _facade_height(sectors),
+        _reflectivity(sectors)
+    {
+      // Obstacles span runs of consecutive sectors
+      std::size_t s = 0;
+      while (s < sectors)
+        {
+          std::size_t run = 1 + index(sectors / 24);
+          bool occluded = uniform(0.0, 1.0) < 0.4;
+          double range = uniform(3.0, 20.0), height = uniform(0.5, 4.0);
+          double reflectivity = uniform(-0.8, 0.8);
+          for (; run != 0 && s < sectors; --run, ++s)
+            {
+              _obstacle[s] = occluded ? range : max_range();
+              _height[s] = height;
+              _reflectivity[s] = reflectivity;
+            }
+        }
+      // Facades vary smoothly around the vehicle, and beams that pass over
+      // them reach nothing
+      double facade = uniform(25.0, 45.0), height = uniform(5.0, 20.0);
+      for (s = 0; s < sectors; ++s)
+        {
+          facade += normal(0.0, 0.3);
+          if (facade < 25.0) facade = 25.0;
+          if (facade > 45.0) facade = 45.0;
+          height += normal(0.0, 0.2);
+          if (height < 5.0) height = 5.0;
+          if (height > 20.0) height = 20.0;
+          _facade[s] = facade;
+          _facade_height[s] = height;
+        }
+    }
+
+    template <typename Point>
+    void point(Point& p, std::size_t dims)
+    {
+      const double pi = 3.14159265358979323846;
+      std::size_t ring;
+      double azimuth, elevation, range, reflectivity;
+      do
+        {
+          ring = index(_rings);
+          // Rings from -25 to +15 degrees of elevation
+          elevation = (-25.0 + 40.0 * static_cast<double>(ring)
+                       / static_cast<double>(_rings - 1)) * pi / 180.0;
+          azimuth = uniform(0.0, 2.0 * pi);
+          std::size_t s = static_cast<std::size_t>
+            (azimuth / (2.0 * pi) * static_cast<double>(_obstacle.size()));
+          if (s >= _obstacle.size()) s = _obstacle.size() - 1;
+          double slope = std::tan(elevation);
+          // Horizontal distance of the first surface hit by the beam
+          double horizontal = max_range();
+          reflectivity = 0.0;
+          if (elevation < 0.0)
+            {
+              horizontal = sensor_height() / -slope;
+              reflectivity = -0.5;
+            }
+          if (_obstacle[s] < horizontal
+              && sensor_height() + slope * _obstacle[s] < _height[s])
+            {
+              horizontal = _obstacle[s];
+              reflectivity = _reflectivity[s];
+            }
+          if (_facade[s] < horizontal
+              && sensor_height() + slope * _facade[s] < _facade_height[s])
+            {
+              horizontal = _facade[s];
+              reflectivity = 0.5;
+            }
+          range = horizontal / std::cos(elevation) + normal(0.0, 0.02);
+        }
+      while (range >= max_range() || range <= 0.0);
+      double horizontal = range * std::cos(elevation);
+      p[0] = horizontal * std::cos(azimuth) / max_range();
+      p[1] = horizontal * std::sin(azimuth) / max_range();
+      p[2] = range * std::sin(elevation) / max_range();
+      for (std::size_t d = 3; d < dims; ++d)
+        {
+          if (d == 3) p[d] = reflectivity + normal(0.0, 0.05);
+          else if (d == 4) p[d] = elevation;
+          else p[d] = normal(0.0, 0.05);
+        }
+    }
+
+    template <typename Point>
+    void target(Point& p, std::size_t dims) { point(p, dims); }
+
+  private:
+    /// The range of the lidar, in meters
+    static double max_range() { return 50.0; }
+    /// The height of the lidar above the ground, in meters
+    static double sensor_height() { return 1.8; }
+
+    std::size_t _rings;
+    std::vector<double> _obstacle;
+    std::vector<double> _height;
+    std::vector<double> _facade;
+    std::vector<double> _facade_height;
+    std::vector<double> _reflectivity;
+  };
+
+  /**
+   *  The positions of a fleet of vehicles sampled along their trajectories,
+   *  in turn, as x, y and time, followed by slowly varying state variables
+   *  in further coordinates. Targets are the successive positions of one
+   *  more vehicle: each query is close to the previous one, as when
+   *  tracking a moving object.
+   */
+  class vehicle_trajectories : public workload
+  {
+  public:
+    vehicle_trajectories(unsigned int seed, std::size_t vehicles = 64)
+      : workload(seed), _fleet(vehicles), _next(0), _dims(0) { }
+
+    template <typename Point>
+    void point(Point& p, std::size_t dims)
+    {
+      if (dims != _dims) build(dims);
+      vehicle& v = _fleet[_next];
+      _next = (_next + 1) % _fleet.size();
+      advance(v);
+      write(p, v);
+    }
+
+    template <typename Point>
+    void target(Point& p, std::size_t dims)
+    {
+      if (dims != _dims) build(dims);
+      advance(_query);
+      write(p, _query);
+    }
+
+  private:
+    struct vehicle
+    {
+      double x, y, heading, speed;
+      std::size_t steps;
+      std::vector<double> state;
+    };
+
+    void build(std::size_t dims)
+    {
+      _dims = dims;
+      _next = 0;
+      for (std::size_t i = 0; i < _fleet.size(); ++i) start(_fleet[i]);
+      start(_query);
+    }
+
+    void start(vehicle& v)
+    {
+      v.x = uniform(-1.0, 1.0);
+      v.y = uniform(-1.0, 1.0);
+      v.heading = uniform(0.0, 6.283185307179586);
+      v.speed = uniform(0.001, 0.005);
+      v.steps = 0;
+      v.state.resize(_dims > 3 ? _dims - 3 : 0);
+      for (std::size_t k = 0; k < v.state.size(); ++k)
+        v.state[k] = uniform(-0.5, 0.5);
+    }
+
+    /// Moves the vehicle by one step, bouncing on the edges of the map
+    void advance(vehicle& v)
+    {
+      v.heading += normal(0.0, 0.05);
+      v.speed += normal(0.0, 0.0002);
+      if (v.speed < 0.0005) v.speed = 0.0005;
+      if (v.speed > 0.01) v.speed = 0.01;
+      v.x += v.speed * std::cos(v.heading);
+      v.y += v.speed * std::sin(v.heading);
+      if (v.x < -1.0 || v.x > 1.0)
+        {
+          v.x = v.x < -1.0 ? -2.0 - v.x : 2.0 - v.x;
+          v.heading = 3.141592653589793 - v.heading;
+        }
+      if (v.y < -1.0 || v.y > 1.0)
+        {
+          v.y = v.y < -1.0 ? -2.0 - v.y : 2.0 - v.y;
+          v.heading = -v.heading;
+        }
+      for (std::size_t k = 0; k < v.state.size(); ++k)
+        {
+          v.state[k] += normal(0.0, 0.01);
+          if (v.state[k] < -1.0) v.state[k] = -1.0;
+          if (v.state[k] > 1.0) v.state[k] = 1.0;
+        }
+      ++v.steps;
+    }
+
+    template <typename Point>
+    void write(Point& p, const vehicle& v) const
+    {
+      // Time goes from -1 to 1 over 2000 steps, then starts over
+      double time = -1.0 + static_cast<double>(v.steps % 2000) * 0.001;
+      for (std::size_t d = 0; d < _dims; ++d)
+        p[d] = d == 0 ? v.x : d == 1 ? v.y : d == 2 ? time : v.state[d - 3];
+    }
+
+    std::vector<vehicle> _fleet;
+    vehicle _query;
+    std::size_t _next;
+    std::size_t _dims;
+  };
+
+  /**
+   *  Points around a few hubs of Zipf-distributed popularity, at a distance
+   *  from their hub that follows a power law, e.g. a population around
+   *  cities: the density is very high at the hubs and decreases slowly away
+   *  from them. Targets are drawn from the same distribution.
+   */
+  class power_law_density : public workload
+  {
+  public:
+    power_law_density
+    (unsigned int seed, double exponent = 1.2, std::size_t hubs = 16)
+      : workload(seed), _exponent(exponent), _hubs(hubs), _dims(0)
+    {
+      std::vector<double> weights = zipf_weights(hubs, 1.0);
+      _pick = std::discrete_distribution<std::size_t>
+        (weights.begin(), weights.end());
+    }
+
+    template <typename Point>
+    void point(Point& p, std::size_t dims)
+    {
+      if (dims != _dims) build(dims);
+      const std::vector<double>& hub = _centers[_pick(_engine)];
+      std::vector<double> direction(dims);
+      bool inside;
+      do
+        {
+          double norm = 0.0;
+          for (std::size_t d = 0; d < dims; ++d)
+            {
+              direction[d] = normal(0.0, 1.0);
+              norm += direction[d] * direction[d];
+            }
+          // Pareto distributed radius, from 0.0001 without bound
+          double radius = 0.0001
+            * std::pow(1.0 - uniform(0.0, 1.0), -1.0 / _exponent);
+          radius /= std::sqrt(norm);
+          inside = true;
+          for (std::size_t d = 0; d < dims && inside; ++d)
+            {
+              p[d] = hub[d] + radius * direction[d];
+              inside = p[d] >= -1.0 && p[d] <= 1.0;
+            }
+        }
+      while (!inside);
+    }
+
+    template <typename Point>
+    void target(Point& p, std::size_t dims) { point(p, dims); }
+
+  private:
+    void build(std::size_t dims)
+    {
+      _dims = dims;
+      _centers.assign(_hubs, std::vector<double>(dims));
+      for (std::size_t h = 0; h < _hubs; ++h)
+        for (std::size_t d = 0; d < dims; ++d)
+          _centers[h][d] = uniform(-0.8, 0.8);
+    }
+
+    double _exponent;
+    std::size_t _hubs;
+    std::size_t _dims;
+    std::vector<std::vector<double> > _centers;
+    std::discrete_distribution<std::size_t> _pick;
+  };
+
+  /**
+   *  Points snapped to a coarse grid, drawn among a limited number of
+   *  distinct cells with a Zipf distribution, so that most points have many
+   *  duplicates, e.g. quantized sensor readings. Targets are cells of the
+   *  same grid and thus always have exact matches.
+   */
+  class duplicate_grid : public workload
+  {
+  public:
+    duplicate_grid
+    (unsigned int seed, std::size_t cells = 1024, std::size_t steps = 16)
+      : workload(seed), _cells(cells), _steps(steps), _dims(0)
+    {
+      std::vector<double> weights = zipf_weights(cells, 0.8);
+      _pick = std::discrete_distribution<std::size_t>
+        (weights.begin(), weights.end());
+    }
+
+    template <typename Point>
+    void point(Point& p, std::size_t dims)
+    {
+      if (dims != _dims) build(dims);
+      const std::vector<double>& cell = _grid[_pick(_engine)];
+      for (std::size_t d = 0; d < dims; ++d) p[d] = cell[d];
+    }
+
+    template <typename Point>
+    void target(Point& p, std::size_t dims) { point(p, dims); }
+
+  private:
+    void build(std::size_t dims)
+    {
+      _dims = dims;
+      _grid.assign(_cells, std::vector<double>(dims));
+      double step = 2.0 / static_cast<double>(_steps);
+      for (std::size_t c = 0; c < _cells; ++c)
+        for (std::size_t d = 0; d < dims; ++d)
+          _grid[c][d] = -1.0 + step * static_cast<double>(index(_steps + 1));
+    }
+
+    std::size_t _cells;
+    std::size_t _steps;
+    std::size_t _dims;
+    std::vector<std::vector<double> > _grid;
+    std::discrete_distribution<std::size_t> _pick;
+  };
+
+  namespace details
+  {
+    /// Draws each coordinate independently from a distribution of random.hpp
+    template <typename Point, typename Distribution>
+    inline Point draw(Distribution& distribution, std::size_t, const void*)
+    { return Point(distribution); }
+
+    /// Draws a point of a workload
+    template <typename Point, typename Workload>
+    inline Point draw(Workload& w, std::size_t dims, const workload*)
+    {
+      Point p;
+      w.point(p, dims);
+      return p;
+    }
+
+    template <typename Point, typename Distribution>
+    inline Point draw_target(Distribution& distribution, std::size_t,
+                             const void*)
+    { return Point(distribution); }
+
+    template <typename Point, typename Workload>
+    inline Point draw_target(Workload& w, std::size_t dims, const workload*)
+    {
+      Point p;
+      w.target(p, dims);
+      return p;
+    }
+  } // namespace details
+
+  /// Returns the next point of a distribution or of a workload.
+  template <typename Point, typename Distribution>
+  inline Point draw(Distribution& distribution, std::size_t dims)
+  { return details::draw<Point>(distribution, dims, &distribution); }
+
+  /// Returns the next query target of a distribution or of a workload.
+  template <typename Point, typename Distribution>
+  inline Point draw_target(Distribution& distribution, std::size_t dims)
+  { return details::draw_target<Point>(distribution, dims, &distribution); }
+
+  /**
+   *  Runs \c scenario over each distribution of random.hpp and each
+   *  workload, all seeded with \c seed, by calling:
+   *  \code
+   *    scenario(name, distribution);
+   *  \endcode
+   *  where \c name identifies the distribution or the workload in the
+   *  reports, and \c distribution is passed to draw() and draw_target().
+   */
+  template <typename Scenario>
+  inline void run_workloads(unsigned int seed, const Scenario& scenario)
+  {
+    random_engine engine(seed);
+    uniform_double_distribution uniform(engine, -1.0, 1.0);
+    scenario("uniform", uniform);
+    normal_double_distribution normal(engine, -1.0, 1.0);
+    scenario("normal", normal);
+    narrow_double_distribution narrow(engine, -1.0, 1.0);
+    scenario("narrow", narrow);
+    gaussian_clusters clusters(seed);
+    scenario("clusters", clusters);
+    lidar_scan lidar(seed);
+    scenario("lidar", lidar);
+    vehicle_trajectories trajectories(seed);
+    scenario("trajectories", trajectories);
+    power_law_density power_law(seed);
+    scenario("power_law", power_law);
+    duplicate_grid duplicates(seed);
+    scenario("duplicates", duplicates);
+  }
+} // namespace utils
+
+#endif // SPATIAL_EXAMPLE_UTILS_WORKLOAD_HPP
@@ -0,0 +1,163 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   verify_adaptive_point_multiset.cpp
+ *  Contains the tests for the \ref adaptive_point_multiset, which are checked
+ *  against an exhaustive search of the values.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define SPATIAL_ENABLE_ASSERT // detect interal issues that should not occur
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <boost/test/unit_test.hpp>
+#include "../../src/adaptive_point_multiset.hpp"
+#include "spatial_test_fixtures.hpp"
+
+typedef adaptive_point_multiset<2, int2> adaptive_int2;
+typedef adaptive_point_multiset<0, int2, bracket_less<int2>,
+                                sliding_midpoint_split> sliding_int2;
+
+BOOST_AUTO_TEST_CASE( test_adaptive_insert_find_erase )
+{
+  BOOST_CHECK_THROW(sliding_int2(0), invalid_rank);
+  sliding_int2 container(2);
+  BOOST_CHECK(container.find(ones) == container.end());
+  std::vector<int2> keys;
+  int2 key;
+  for (int i = 0; i < 300; ++i)
+    {
+      // Elongated along the first dimension.
+      keys.push_back(randomize(0, 20)(key, 0, 0));
+      keys.back()[0] *= 100;
+    }
+  container.insert(keys.begin(), keys.begin() + 200);
+  for (std::vector<int2>::const_iterator i = keys.begin() + 200;
+       i != keys.end(); ++i)
+    { container.insert(*i); }
+  BOOST_CHECK_EQUAL(container.size(), keys.size());
+  BOOST_CHECK_EQUAL(container.node_dimension(0), 0u);
+  sliding_int2::size_type expected = static_cast<sliding_int2::size_type>
+    (std::count(keys.begin(), keys.end(), keys[0]));
+  BOOST_CHECK(*container.find(keys[0]) == keys[0]);
+  BOOST_CHECK_EQUAL(container.count(keys[0]), expected);
+  BOOST_CHECK_EQUAL(container.erase(keys[0]), expected);
+  BOOST_CHECK(container.find(keys[0]) == container.end());
+  BOOST_CHECK_EQUAL(container.size(), keys.size() - expected);
+  sliding_int2::size_type before = container.count(keys[1]);
+  container.erase(container.find(keys[1]));
+  BOOST_CHECK_EQUAL(container.count(keys[1]), before - 1);
+}
+
+BOOST_AUTO_TEST_CASE( test_adaptive_erase_search )
+{
+  adaptive_int2 container;
+  std::vector<int2> keys;
+  int2 key;
+  for (int i = 0; i < 400; ++i)
+    { keys.push_back(randomize(0, 1000)(key, 0, 0)); }
+  container.insert(keys.begin(), keys.end());
+  // Erase one value out of three, so that the tree is rebuilt once in
+  // between, and check that the searches only visit the remaining values.
+  std::size_t kept = 0;
+  for (std::size_t i = 0; i < keys.size(); ++i)
+    {
+      if (i % 3 == 0) container.erase(container.find(keys[i]));
+      else ++kept;
+    }
+  BOOST_CHECK_EQUAL(container.size(), kept);
+  BOOST_CHECK_EQUAL(static_cast<std::size_t>
+                    (std::distance(container.begin(), container.end())),
+                    kept);
+  int2 low(0, 0), high(1001, 1001);
+  BOOST_CHECK_EQUAL(static_cast<std::size_t>
+                    (std::distance(region_begin(container, low, high),
+                                   region_end(container, low, high))),
+                    kept);
+  BOOST_CHECK_EQUAL(static_cast<std::size_t>
+                    (std::distance(neighbor_begin(container, low),
+                                   neighbor_end(container, low))),
+                    kept);
+}
+
+BOOST_AUTO_TEST_CASE( test_adaptive_sliding_ulp_spread )
+{
+  // The values are one ulp apart on the first dimension, so the middle of
+  // their spread rounds to the lowest one, and the split must fall back to
+  // the median instead of leaving the lower side empty.
+  typedef adaptive_point_multiset<6, double6, bracket_less<double6>,
+                                  sliding_midpoint_split> sliding_double6;
+  sliding_double6 container;
+  double6 low = make_double6(1.0), high = make_double6(1.0);
+  high[0] = 1.0 + std::numeric_limits<double>::epsilon(); // next after 1.0
+  for (int i = 0; i < 40; ++i) { container.insert(i % 2 ? high : low); }
+  container.rebalance();
+  BOOST_CHECK_EQUAL(container.size(), 40u);
+  BOOST_CHECK_EQUAL(container.count(low), 20u);
+  BOOST_CHECK_EQUAL(container.count(high), 20u);
+}
+
+BOOST_AUTO_TEST_CASE( test_adaptive_region_and_neighbor )
+{
+  adaptive_int2 container;
+  std::vector<int2> keys;
+  int2 key;
+  for (int i = 0; i < 500; ++i)
+    {
+      keys.push_back(randomize(0, 1000)(key, 0, 0));
+      keys.back()[1] /= 50;
+      container.insert(keys.back());
+    }
+  for (int i = 0; i < 20; ++i)
+    {
+      int2 l(i * 40, i / 2), h(i * 40 + 200, 10 + i / 2);
+      std::size_t count = 0;
+      for (region_iterator<adaptive_int2> j = region_begin(container, l, h);
+           j != region_end(container, l, h); ++j)
+        {
+          BOOST_CHECK((*j)[0] >= l[0] && (*j)[0] < h[0]
+                      && (*j)[1] >= l[1] && (*j)[1] < h[1]);
+          ++count;
+        }
+      std::size_t expected = 0;
+      for (std::vector<int2>::const_iterator j = keys.begin();
+           j != keys.end(); ++j)
+        {
+          if ((*j)[0] >= l[0] && (*j)[0] < h[0]
+              && (*j)[1] >= l[1] && (*j)[1] < h[1]) ++expected;
+        }
+      BOOST_CHECK_EQUAL(count, expected);
+      int2 target;
+      randomize(0, 1000)(target, 0, 0);
+      std::vector<double> distances;
+      for (std::vector<int2>::const_iterator j = keys.begin();
+           j != keys.end(); ++j)
+        {
+          double dx = (*j)[0] - target[0], dy = (*j)[1] - target[1];
+          distances.push_back(std::sqrt(dx * dx + dy * dy));
+        }
+      std::sort(distances.begin(), distances.end());
+      const adaptive_int2& ccontainer = container;
+      neighbor_iterator_pair<const adaptive_int2> range
+        = neighbor_crange(ccontainer, target);
+      for (std::size_t j = 0; j < 10; ++j, ++range.first)
+        { BOOST_CHECK_CLOSE(distance(range.first), distances[j], .0000001); }
+      count = 0;
+      double radius = 20.0 + i * 5.0;
+      for (neighbor_iterator<adaptive_int2> j
+             = neighbor_begin(container, target);
+           j != neighbor_upper_bound(container, target, radius); ++j)
+        { ++count; }
+      BOOST_CHECK_EQUAL(count, static_cast<std::size_t>
+                        (std::upper_bound(distances.begin(), distances.end(),
+                                          radius) - distances.begin()));
+    }
+  BOOST_CHECK_THROW(region_begin(container, twos, ones), invalid_bounds);
+}
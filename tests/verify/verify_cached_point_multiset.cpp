@@ -0,0 +1,153 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   verify_cached_point_multiset.cpp
+ *  Contains the tests for the \ref cached_point_multiset, which are checked
+ *  against an exhaustive search of the values.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define SPATIAL_ENABLE_ASSERT // detect interal issues that should not occur
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <boost/test/unit_test.hpp>
+#include "../../src/cached_point_multiset.hpp"
+#include "../../src/region_iterator.hpp"
+#include "../../src/neighbor_iterator.hpp"
+
+using namespace spatial;
+
+namespace spatial
+{
+  template <dimension_type Rank, typename Tp>
+  std::ostream& operator<<(std::ostream& o,
+                           const cached_coordinates<Rank, Tp>& key)
+  { return o << "(" << key[0] << ", " << key[1] << ")"; }
+}
+
+namespace
+{
+  std::size_t calls = 0;
+
+  struct shape
+  {
+    virtual ~shape() { }
+    virtual int coordinate(dimension_type n) const = 0;
+  };
+
+  struct dot : shape
+  {
+    dot(int x_, int y_, int id_) : x(x_), y(y_), id(id_) { }
+    int coordinate(dimension_type n) const { ++calls; return n ? y : x; }
+    int x, y, id;
+  };
+
+  struct shape_accessor
+  {
+    int operator()(dimension_type n, const dot& d) const
+    { return d.coordinate(n); }
+  };
+
+  typedef cached_point_multiset<2, dot, shape_accessor, int> cached_dots;
+
+  // The number of instances of counted that are alive.
+  int alive = 0;
+
+  struct counted
+  {
+    counted(int x_, int y_) : x(x_), y(y_) { ++alive; }
+    counted(const counted& other) : x(other.x), y(other.y) { ++alive; }
+    ~counted() { --alive; }
+    int x, y;
+  };
+
+  // Fails to read the coordinates of values with a negative abscissa.
+  struct throwing_accessor
+  {
+    int operator()(dimension_type n, const counted& c) const
+    {
+      if (c.x < 0) throw std::runtime_error("unreadable coordinate");
+      return n ? c.y : c.x;
+    }
+  };
+
+  typedef cached_point_multiset<2, counted, throwing_accessor, int>
+  cached_counted;
+}
+
+BOOST_AUTO_TEST_CASE( test_cached_insert_find_erase )
+{
+  cached_dots container;
+  std::vector<dot> dots;
+  for (int i = 0; i < 300; ++i)
+    { dots.push_back(dot(std::rand() % 20, std::rand() % 20, i)); }
+  container.insert(dots.begin(), dots.begin() + 150);
+  for (std::vector<dot>::const_iterator i = dots.begin() + 150;
+       i != dots.end(); ++i)
+    { container.insert(*i); }
+  BOOST_CHECK_EQUAL(container.size(), dots.size());
+  cached_dots::key_type key = container.key_of(dots[0]);
+  BOOST_CHECK_EQUAL(key[0], dots[0].x);
+  BOOST_CHECK_EQUAL(key[1], dots[0].y);
+  BOOST_CHECK_EQUAL(container.find(key)->x, dots[0].x);
+  std::size_t expected = 0;
+  for (std::vector<dot>::const_iterator i = dots.begin(); i != dots.end(); ++i)
+    { if (i->x == dots[0].x && i->y == dots[0].y) ++expected; }
+  cached_dots copy(container);
+  BOOST_CHECK_EQUAL(container.erase(key), expected);
+  BOOST_CHECK(container.find(key) == container.end());
+  BOOST_CHECK(copy.find(key) != copy.end());
+  container.erase(container.begin());
+  BOOST_CHECK_EQUAL(container.size(), dots.size() - expected - 1);
+}
+
+BOOST_AUTO_TEST_CASE( test_cached_search_does_not_call_accessor )
+{
+  cached_dots container;
+  std::vector<dot> dots;
+  for (int i = 0; i < 500; ++i)
+    {
+      dots.push_back(dot(std::rand() % 100, std::rand() % 100, i));
+      container.insert(dots.back());
+    }
+  calls = 0;
+  cached_coordinates<2, int> low = {{ 20, 30 }}, high = {{ 60, 50 }};
+  std::size_t count = 0;
+  for (region_iterator<cached_dots> i = region_begin(container, low, high);
+       i != region_end(container, low, high); ++i)
+    { ++count; }
+  cached_coordinates<2, int> target = {{ 50, 50 }};
+  double nearest = distance(neighbor_begin(container, target));
+  BOOST_CHECK_EQUAL(calls, 0u);
+  std::size_t expected = 0;
+  double best = 1000;
+  for (std::vector<dot>::const_iterator i = dots.begin(); i != dots.end(); ++i)
+    {
+      if (i->x >= 20 && i->x < 60 && i->y >= 30 && i->y < 50) ++expected;
+      double dx = i->x - 50, dy = i->y - 50;
+      best = (std::min)(best, std::sqrt(dx * dx + dy * dy));
+    }
+  BOOST_CHECK_EQUAL(count, expected);
+  BOOST_CHECK_CLOSE(nearest, best, .0000001);
+}
+
+BOOST_AUTO_TEST_CASE( test_cached_insert_throwing_accessor )
+{
+  cached_counted container;
+  counted good(1, 2), bad(-1, 2);
+  int before = alive;
+  container.insert(good);
+  BOOST_CHECK_THROW(container.insert(bad), std::runtime_error);
+  BOOST_CHECK_EQUAL(container.size(), 1u);
+  // The value whose coordinates could not be read was not left behind.
+  BOOST_CHECK_EQUAL(alive, before + 1);
+}
@@ -0,0 +1,165 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   verify_collapsed.cpp
+ *  Contains the tests for the \collapsed_point_multiset and the
+ *  \collapsed_point_multimap containers.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define SPATIAL_ENABLE_ASSERT // detect interal issues that should not occur
+
+#include <boost/test/unit_test.hpp>
+#include "../../src/collapsed_point_multiset.hpp"
+#include "../../src/collapsed_point_multimap.hpp"
+#include "../../src/region_iterator.hpp"
+#include "../../src/neighbor_iterator.hpp"
+#include "spatial_test_fixtures.hpp"
+
+BOOST_AUTO_TEST_CASE( test_collapsed_constructors )
+{
+  collapsed_point_multiset<2, int2> points;
+  collapsed_point_multiset<0, int2> runtime_points(2);
+  collapsed_point_multimap<2, int2, std::string> map;
+  collapsed_point_multimap<0, int2, std::string> runtime_map(2);
+  BOOST_CHECK(points.empty());
+  BOOST_CHECK(runtime_points.empty());
+  BOOST_CHECK(map.begin() == map.end());
+  BOOST_CHECK_EQUAL(runtime_map.dimension(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE( test_collapsed_insert_erase )
+{
+  collapsed_point_multiset<2, int2> points;
+  points.insert(ones);
+  points.insert(zeros);
+  points.insert(ones);
+  points.insert(ones);
+  BOOST_CHECK_EQUAL(points.size(), 4u);
+  BOOST_CHECK_EQUAL(points.key_count(), 2u);
+  BOOST_CHECK_EQUAL(points.count(ones), 3u);
+  BOOST_CHECK_EQUAL(points.count(twos), 0u);
+  BOOST_CHECK_EQUAL(std::distance(points.begin(), points.end()), 4);
+  BOOST_CHECK_EQUAL(std::distance(points.equal_range(ones).first,
+                                  points.equal_range(ones).second), 3);
+  BOOST_CHECK(points.equal_range(twos).first == points.end());
+  BOOST_CHECK(*points.find(zeros) == zeros);
+  points.erase(points.find(ones));
+  BOOST_CHECK_EQUAL(points.count(ones), 2u);
+  BOOST_CHECK_EQUAL(points.erase(ones), 2u);
+  BOOST_CHECK_EQUAL(points.size(), 1u);
+  BOOST_CHECK_EQUAL(points.key_count(), 1u);
+  points.erase(points.begin());
+  BOOST_CHECK(points.empty());
+  BOOST_CHECK_EQUAL(points.key_count(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE( test_collapsed_multimap_values )
+{
+  // 50 keys, each duplicated several times with a distinct mapped value
+  collapsed_point_multimap<0, int2, int> map(2);
+  std::size_t n = 0;
+  for (int i = 0; i < 300; ++i)
+    {
+      int2 p; randomize(0, 7)(p, i, 300);
+      map.insert(std::make_pair(p, i));
+      ++n;
+      BOOST_CHECK_EQUAL(map.size(), n);
+    }
+  BOOST_CHECK(map.key_count() <= 49u);
+  BOOST_CHECK_EQUAL(map.tree().size(), map.key_count());
+  // Iterating enumerates each mapped value once
+  std::vector<int> seen(300, 0);
+  for (collapsed_point_multimap<0, int2, int>::iterator i = map.begin();
+       i != map.end(); ++i)
+    { ++seen[static_cast<std::size_t>(i->second)]; i->second += 0; }
+  BOOST_CHECK(std::count(seen.begin(), seen.end(), 1) == 300);
+  // Iterating backward gives the same count
+  std::ptrdiff_t backward = 0;
+  for (collapsed_point_multimap<0, int2, int>::iterator i = map.end();
+       i != map.begin(); --i) ++backward;
+  BOOST_CHECK_EQUAL(backward, 300);
+  // Erasing in the middle of a node preserves the other values
+  while (!map.empty())
+    {
+      collapsed_point_multimap<0, int2, int>::iterator pick = map.begin();
+      std::advance(pick, (std::ptrdiff_t)
+                   (static_cast<std::size_t>(std::rand()) % map.size()));
+      int2 key = pick->first;
+      int value = pick->second;
+      std::size_t count = map.count(key);
+      map.erase(pick);
+      --n;
+      BOOST_CHECK_EQUAL(map.size(), n);
+      BOOST_CHECK_EQUAL(map.count(key), count - 1);
+      for (collapsed_point_multimap<0, int2, int>::const_iterator
+             i = map.equal_range(key).first;
+           i != map.equal_range(key).second; ++i)
+        { BOOST_CHECK(i->first == key); BOOST_CHECK(i->second != value); }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( test_collapsed_region )
+{
+  typedef collapsed_point_multiset<2, int2> set_type;
+  set_type points;
+  for (int i = 0; i < 100; ++i)
+    { int2 p; points.insert(randomize(0, 10)(p, i, 100)); }
+  int2 low(2, 2), high(6, 6);
+  std::ptrdiff_t expected = 0;
+  for (set_type::const_iterator i = points.begin(); i != points.end(); ++i)
+    if ((*i)[0] >= 2 && (*i)[0] < 6 && (*i)[1] >= 2 && (*i)[1] < 6)
+      ++expected;
+  BOOST_CHECK_EQUAL(std::distance(region_begin(points, low, high),
+                                  region_end(points, low, high)), expected);
+  BOOST_CHECK_EQUAL(std::distance(region_cbegin(points, low, high),
+                                  region_cend(points, low, high)), expected);
+  set_type copy(points);
+  points.clear();
+  BOOST_CHECK_EQUAL(copy.size(), 100u);
+  swap(points, copy);
+  BOOST_CHECK(copy.empty());
+  BOOST_CHECK_EQUAL(points.size(), 100u);
+}
+
+BOOST_AUTO_TEST_CASE( test_collapsed_neighbor )
+{
+  typedef collapsed_point_multiset<2, int2> set_type;
+  set_type points;
+  for (int i = 0; i < 100; ++i)
+    { int2 p; points.insert(randomize(0, 10)(p, i, 100)); }
+  int2 target(5, 5);
+  double last = 0.0;
+  std::size_t count = 0;
+  for (neighbor_iterator<set_type> i = neighbor_begin(points, target);
+       i != neighbor_end(points, target); ++i, ++count)
+    {
+      BOOST_CHECK_GE(distance(i), last);
+      last = distance(i);
+    }
+  BOOST_CHECK_EQUAL(count, points.size());
+  // Every value equal to the target is found before any other value
+  points.insert(target);
+  points.insert(target);
+  neighbor_iterator<const set_type> near = neighbor_cbegin(points, target);
+  for (std::size_t n = 0; n < points.count(target); ++n, ++near)
+    { BOOST_CHECK(*near == target); BOOST_CHECK_EQUAL(distance(near), 0.0); }
+  // The mapped values of a multimap can be modified through its iterators
+  collapsed_point_multimap<2, int2, int> map;
+  map.insert(std::make_pair(target, 1));
+  map.insert(std::make_pair(target, 2));
+  map.insert(std::make_pair(ones, 3));
+  for (region_iterator<collapsed_point_multimap<2, int2, int> >
+         i = region_begin(map, target, int2(7, 7));
+       i != region_end(map, target, int2(7, 7)); ++i)
+    i->second += 10;
+  neighbor_begin(map, ones)->second = 0;
+  BOOST_CHECK_EQUAL(map.find(ones)->second, 0);
+  BOOST_CHECK_EQUAL(map.equal_range(target).first->second, 11);
+  BOOST_CHECK_EQUAL((++map.equal_range(target).first)->second, 12);
+}
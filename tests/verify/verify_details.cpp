@@ -12,6 +12,8 @@
 #include "../../src/bits/spatial_condition.hpp"
 #include "../../src/bits/spatial_rank.hpp"
 #include "../../src/bits/spatial_template_member_swap.hpp"
+#include "../../src/bits/spatial_locality.hpp"
+#include "../../src/function.hpp"
 #include "spatial_test_types.hpp"
 
 using namespace spatial;
@@ -77,3 +79,45 @@ BOOST_AUTO_TEST_CASE( test_details_match )
   BOOST_CHECK(closed_test_range()(0, 2, _x) == below);
   BOOST_CHECK(closed_test_range()(1, 2, x_) == above);
 }
+
+/**
+ *  Check that the first element produced by \c locality_sort is a median of
+ *  the range on the first dimension.
+ */
+template <typename Iter>
+void check_locality(Iter first, Iter last)
+{
+  std::ptrdiff_t lower = 0, upper = 0;
+  for (Iter i = first + 1; i != last; ++i)
+    {
+      if ((*i)[0] < (*first)[0]) ++lower;
+      if ((*first)[0] < (*i)[0]) ++upper;
+    }
+  BOOST_CHECK_LE(lower, (last - first) / 2);
+  BOOST_CHECK_LE(upper, (last - first) / 2);
+}
+
+BOOST_AUTO_TEST_CASE( test_details_locality_sort )
+{
+  std::vector<int2> points;
+  for (int i = 0; i < 100; ++i)
+    { points.push_back(int2(std::rand() % 10, std::rand() % 10)); }
+  std::vector<int2> sorted(points);
+  details::locality_sort(sorted.begin(), sorted.end(), 0,
+                         details::Static_rank<2>(), bracket_less<int2>());
+  check_locality(sorted.begin(), sorted.end());
+  std::vector<int2> keys;
+  std::vector<std::size_t> origin;
+  details::locality_order(points.begin(), points.end(),
+                          details::Dynamic_rank(2), bracket_less<int2>(),
+                          keys, origin);
+  BOOST_REQUIRE_EQUAL(keys.size(), points.size());
+  check_locality(keys.begin(), keys.end());
+  std::vector<bool> seen(points.size(), false);
+  for (std::size_t i = 0; i < keys.size(); ++i)
+    {
+      BOOST_CHECK(keys[i] == points[origin[i]]);
+      BOOST_CHECK(!seen[origin[i]]);
+      seen[origin[i]] = true;
+    }
+}
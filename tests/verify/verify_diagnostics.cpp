@@ -0,0 +1,111 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   verify_diagnostics.cpp
+ *  Contains the tests for the reports on the shape of the trees, in
+ *  algorithm.hpp and diagnostics.hpp.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define SPATIAL_ENABLE_ASSERT // detect interal issues that should not occur
+
+#include <boost/test/unit_test.hpp>
+#include "../../src/point_multiset.hpp"
+#include "../../src/point_multimap.hpp"
+#include "../../src/idle_point_multiset.hpp"
+#include "../../src/algorithm.hpp"
+#include "../../src/diagnostics.hpp"
+#include "spatial_test_fixtures.hpp"
+
+template <typename Container>
+void check_consistent(const Container& container,
+                      const tree_diagnostics<Container>& diag)
+{
+  BOOST_CHECK_EQUAL(diag.size, container.size());
+  std::pair<std::size_t, std::size_t> minmax = minmax_depth(container);
+  BOOST_CHECK_EQUAL(diag.min_depth, minmax.first);
+  BOOST_CHECK_EQUAL(diag.max_depth, minmax.second);
+  BOOST_CHECK_EQUAL(diag.levels.size(), diag.max_depth + 1);
+  std::size_t nodes = 0, leaves = 0;
+  for (std::size_t i = 0; i < diag.levels.size(); ++i)
+    {
+      nodes += diag.levels[i].nodes;
+      leaves += diag.depth_histogram[i];
+      BOOST_CHECK_EQUAL(diag.levels[i].leaves, diag.depth_histogram[i]);
+      BOOST_CHECK_LE(diag.levels[i].mean_imbalance,
+                     diag.levels[i].max_imbalance);
+      BOOST_CHECK_LT(diag.levels[i].max_imbalance, 1.0);
+    }
+  BOOST_CHECK_EQUAL(nodes, diag.size);
+  BOOST_CHECK_EQUAL(leaves, diag.leaves);
+  BOOST_CHECK_EQUAL(diag.levels[1].nodes, 1u);
+  BOOST_CHECK_GE(diag.mean_depth, static_cast<double>(diag.min_depth));
+  BOOST_CHECK_LE(diag.mean_depth, static_cast<double>(diag.max_depth));
+  BOOST_CHECK_EQUAL(depth(diag.worst), diag.worst_depth);
+  BOOST_CHECK_GE(diag.memory(0),
+                 diag.size * diag.node_size + sizeof(Container));
+}
+
+BOOST_AUTO_TEST_CASE( test_diagnose_idle_degenerate )
+{
+  idle_point_multiset<2, int2> container;
+  tree_diagnostics<idle_point_multiset<2, int2> > empty = diagnose(container);
+  BOOST_CHECK(empty.worst == container.end());
+  BOOST_CHECK_EQUAL(empty.max_depth, 0u);
+  BOOST_CHECK_EQUAL(empty.depth_ratio(), 1.0);
+  BOOST_CHECK_EQUAL(minmax_depth(container).second, 0u);
+  // Sorted insertions without rebalancing build a list.
+  for (int i = 0; i < 100; ++i) { container.insert(int2(i, i)); }
+  tree_diagnostics<idle_point_multiset<2, int2> > list = diagnose(container);
+  check_consistent(container, list);
+  BOOST_CHECK_EQUAL(list.leaves, 1u);
+  BOOST_CHECK_EQUAL(list.max_depth, 100u);
+  BOOST_CHECK_EQUAL(list.optimal_depth(), 7u);
+  BOOST_CHECK_GT(list.depth_ratio(), 10.0);
+  BOOST_CHECK(list.worst == container.begin());
+  BOOST_CHECK_EQUAL(list.worst_depth, 1u);
+  BOOST_CHECK_EQUAL(list.worst_left, 0u);
+  BOOST_CHECK_EQUAL(list.worst_right, 99u);
+  container.rebalance();
+  tree_diagnostics<idle_point_multiset<2, int2> > balanced
+    = diagnose(container);
+  check_consistent(container, balanced);
+  BOOST_CHECK_LE(balanced.max_depth, balanced.optimal_depth() + 1);
+  BOOST_CHECK_LE(balanced.max_depth - balanced.min_depth, 1u);
+  BOOST_CHECK_LT(balanced.levels[1].max_imbalance, 0.1);
+  BOOST_CHECK_EQUAL(balanced.value_size, 0u);
+}
+
+BOOST_AUTO_TEST_CASE( test_diagnose_relaxed )
+{
+  pointset_fix<int2> fix(1000, randomize(0, 100));
+  typedef point_multiset<2, int2> set_type;
+  tree_diagnostics<set_type> diag = diagnose(fix.container);
+  check_consistent(fix.container, diag);
+  // Loose balancing keeps the tree within twice the optimal depth.
+  BOOST_CHECK_LE(diag.max_depth, 2 * diag.optimal_depth());
+  BOOST_CHECK_EQUAL(diag.worst_left + diag.worst_right + 1,
+                    static_cast<std::size_t>
+                    (const_link(diag.worst.node)->weight));
+  fix.container.reserve(1500);
+  BOOST_CHECK_EQUAL(diagnose(fix.container).capacity, 1500u);
+  // Values allocated apart from the nodes count in the memory.
+  typedef point_multimap<2, int2, double, bracket_less<int2>, loose_balancing,
+                         std::allocator<std::pair<const int2, double> >,
+                         cold_storage> cold_map;
+  cold_map cold;
+  for (int i = 0; i < 100; ++i)
+    { cold.insert(std::make_pair(int2(i % 10, i / 10), 0.5)); }
+  tree_diagnostics<cold_map> cold_diag = diagnose(cold);
+  check_consistent(cold, cold_diag);
+  BOOST_CHECK_EQUAL(cold_diag.value_size,
+                    sizeof(std::pair<const int2, double>));
+  BOOST_CHECK_EQUAL(cold_diag.memory(0),
+                    sizeof(cold_map) + 100 * cold_diag.node_size
+                    + 100 * cold_diag.value_size);
+}
@@ -0,0 +1,131 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   verify_grid_multimap.cpp
+ *  Contains the tests for the \ref grid_multimap, which are checked against
+ *  an exhaustive search of the values.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define SPATIAL_ENABLE_ASSERT // detect interal issues that should not occur
+
+#include <vector>
+#include <limits>
+#include <boost/test/unit_test.hpp>
+#include "../../src/grid_multimap.hpp"
+#include "spatial_test_fixtures.hpp"
+
+typedef grid_multimap<2, int2, int> grid_int2;
+typedef grid_multimap<4, quad, int, accessor_less<quad_access, quad> >
+grid_quad;
+
+BOOST_AUTO_TEST_CASE( test_grid_insert_find_erase )
+{
+  grid_int2 grid(4.0);
+  BOOST_CHECK_THROW(grid_int2(0.0), invalid_distance);
+  std::vector<int2> keys;
+  int2 key;
+  for (int i = 0; i < 300; ++i)
+    {
+      keys.push_back(randomize(-20, 20)(key, 0, 0));
+      grid.insert(std::make_pair(keys.back(), i));
+    }
+  BOOST_CHECK_EQUAL(grid.size(), keys.size());
+  BOOST_CHECK(grid.cell_count() <= 100u);
+  grid_int2::size_type expected = static_cast<grid_int2::size_type>
+    (std::count(keys.begin(), keys.end(), keys[0]));
+  BOOST_CHECK(grid.find(keys[0])->first == keys[0]);
+  BOOST_CHECK_EQUAL(grid.count(keys[0]), expected);
+  BOOST_CHECK_EQUAL(grid.erase(keys[0]), expected);
+  BOOST_CHECK(grid.find(keys[0]) == grid.end());
+  BOOST_CHECK_EQUAL(grid.size(), keys.size() - expected);
+  grid_int2 copy(grid);
+  BOOST_CHECK_EQUAL(copy.size(), grid.size());
+  BOOST_CHECK_EQUAL(copy.cell_count(), grid.cell_count());
+  while (!grid.empty()) { grid.erase(grid.begin()); }
+  BOOST_CHECK_EQUAL(grid.cell_count(), 0u);
+  BOOST_CHECK_EQUAL(copy.count(keys[1]), static_cast<grid_int2::size_type>
+                    (std::count(keys.begin(), keys.end(), keys[1])));
+}
+
+BOOST_AUTO_TEST_CASE( test_grid_region_and_radius )
+{
+  grid_int2 grid(8.0);
+  grid_quad quads(3.0);
+  std::vector<int2> keys;
+  std::vector<quad> quad_keys;
+  for (int i = 0; i < 500; ++i)
+    {
+      int2 key; quad q;
+      keys.push_back(randomize(-50, 50)(key, 0, 0));
+      quad_keys.push_back(randomize(0, 10)(q, 0, 0));
+      grid.insert(std::make_pair(keys.back(), i));
+      quads.insert(std::make_pair(quad_keys.back(), i));
+    }
+  for (int i = 0; i < 20; ++i)
+    {
+      // Small regions look up cells, the largest ones scan the values.
+      int2 l(i * 4 - 50, -i), h(i * 4 - 40 + i * i, 10 + i * i);
+      std::size_t count = 0;
+      typedef grid_iterator_pair<grid_int2, details::Grid_region
+                                 <2, int2, bracket_less<int2> > > range_type;
+      range_type range = region_range(grid, l, h);
+      for (; range.first != range.second; ++range.first)
+        {
+          BOOST_CHECK(range.first->first[0] >= l[0]
+                      && range.first->first[0] < h[0]
+                      && range.first->first[1] >= l[1]
+                      && range.first->first[1] < h[1]);
+          ++count;
+        }
+      std::size_t expected = 0;
+      for (std::vector<int2>::const_iterator j = keys.begin();
+           j != keys.end(); ++j)
+        {
+          if ((*j)[0] >= l[0] && (*j)[0] < h[0]
+              && (*j)[1] >= l[1] && (*j)[1] < h[1]) ++expected;
+        }
+      BOOST_CHECK_EQUAL(count, expected);
+      const grid_quad& cquads = quads;
+      quad target(i % 10, 5, i / 2, 3);
+      double radius = 1.0 + i / 4.0;
+      count = 0;
+      for (grid_iterator_pair<const grid_quad, details::Grid_ball
+             <4, quad, accessor_less<quad_access, quad> > >
+             r = radius_crange(cquads, target, radius);
+           r.first != r.second; ++r.first)
+        { ++count; }
+      expected = 0;
+      for (std::vector<quad>::const_iterator j = quad_keys.begin();
+           j != quad_keys.end(); ++j)
+        {
+          double dx = j->x - target.x, dy = j->y - target.y,
+            dz = j->z - target.z, dw = j->w - target.w;
+          if (dx * dx + dy * dy + dz * dz + dw * dw <= radius * radius)
+            ++expected;
+        }
+      BOOST_CHECK_EQUAL(count, expected);
+    }
+  BOOST_CHECK_THROW(region_range(grid, twos, ones), invalid_bounds);
+  BOOST_CHECK_THROW(radius_range(grid, ones, -1.0), invalid_distance);
+}
+
+BOOST_AUTO_TEST_CASE( test_grid_invalid_coordinate )
+{
+  grid_multimap<6, double6, int> grid(0.5);
+  double6 key = make_double6(1.);
+  grid.insert(std::make_pair(key, 0));
+  key[2] = std::numeric_limits<double>::quiet_NaN();
+  BOOST_CHECK_THROW(grid.insert(std::make_pair(key, 1)), invalid_coordinate);
+  key[2] = std::numeric_limits<double>::infinity();
+  BOOST_CHECK_THROW(grid.find(key), invalid_coordinate);
+  key[2] = -1e300;
+  BOOST_CHECK_THROW(grid.count(key), invalid_coordinate);
+  BOOST_CHECK_EQUAL(grid.size(), 1u);
+  BOOST_CHECK_EQUAL(grid.cell_of(-0.25), -1);
+}
@@ -0,0 +1,166 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   verify_hash_indexed.cpp
+ *  Contains the tests for the \ref hash_indexed adaptor and its index.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define SPATIAL_ENABLE_ASSERT // detect interal issues that should not occur
+
+#include <boost/test/unit_test.hpp>
+#include "../../src/hash_indexed.hpp"
+#include "spatial_test_fixtures.hpp"
+
+typedef bracket_hash<int2, int> int2_hash;
+
+//! A hash that sends every key in the same slot, to test collisions.
+struct constant_hash
+{
+  std::size_t operator()(dimension_type, const int2&) const { return 7; }
+};
+
+BOOST_AUTO_TEST_CASE( test_hash_index_collisions )
+{
+  typedef details::Hash_index<int*, std::allocator<int> > index_type;
+  int values[40];
+  index_type index;
+  BOOST_CHECK(index.empty());
+  BOOST_CHECK(index.first(3) == index.bucket_count());
+  for (int i = 0; i < 40; ++i) index.insert(static_cast<std::size_t>(i % 3),
+                                            &values[i]);
+  BOOST_CHECK_EQUAL(index.size(), 40u);
+  BOOST_CHECK(index.bucket_count() >= 80u);
+  // Erase every other value, then count the remaining ones for each hash
+  for (int i = 0; i < 40; i += 2)
+    index.erase(static_cast<std::size_t>(i % 3), &values[i]);
+  BOOST_CHECK_EQUAL(index.size(), 20u);
+  for (std::size_t hash = 0; hash < 3; ++hash)
+    {
+      int found = 0;
+      for (index_type::size_type slot = index.first(hash);
+           slot != index.bucket_count(); slot = index.next(slot, hash))
+        {
+          std::ptrdiff_t i = index.node(slot) - values;
+          BOOST_CHECK_EQUAL(i % 2, 1);
+          BOOST_CHECK_EQUAL(static_cast<std::size_t>(i % 3), hash);
+          ++found;
+        }
+      BOOST_CHECK_EQUAL(found, (hash == 2 ? 6 : 7));
+    }
+  index.clear();
+  BOOST_CHECK(index.empty());
+  BOOST_CHECK_EQUAL(index.bucket_count(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE( test_hash_indexed_find )
+{
+  hash_indexed<point_multiset<2, int2>, int2_hash> points;
+  BOOST_CHECK(points.index_enabled());
+  BOOST_CHECK(points.find(ones) == points.end());
+  BOOST_CHECK_EQUAL(points.count(ones), 0u);
+  points.insert(zeros);
+  points.insert(ones);
+  points.insert(ones);
+  points.insert(twos);
+  BOOST_CHECK_EQUAL(points.size(), 4u);
+  BOOST_CHECK_EQUAL(points.count(), 4u);
+  BOOST_CHECK_EQUAL(points.index().size(), 4u);
+  BOOST_CHECK(*points.find(ones) == ones);
+  BOOST_CHECK(points.find(threes) == points.end());
+  BOOST_CHECK_EQUAL(points.count(ones), 2u);
+  BOOST_CHECK_EQUAL(points.count(threes), 0u);
+  points.disable_index();
+  BOOST_CHECK(!points.index_enabled());
+  BOOST_CHECK(points.index().empty());
+  BOOST_CHECK(*points.find(ones) == ones);
+  BOOST_CHECK_EQUAL(points.count(ones), 2u);
+  points.insert(ones);
+  points.enable_index();
+  BOOST_CHECK_EQUAL(points.index().size(), 5u);
+  BOOST_CHECK_EQUAL(points.count(ones), 3u);
+}
+
+BOOST_AUTO_TEST_CASE( test_hash_indexed_collisions )
+{
+  hash_indexed<point_multiset<2, int2>, constant_hash> points;
+  points.insert(zeros);
+  points.insert(ones);
+  points.insert(twos);
+  points.insert(ones);
+  BOOST_CHECK_EQUAL(points.count(ones), 2u);
+  BOOST_CHECK_EQUAL(points.count(zeros), 1u);
+  BOOST_CHECK_EQUAL(points.count(threes), 0u);
+  BOOST_CHECK_EQUAL(points.erase(ones), 2u);
+  BOOST_CHECK_EQUAL(points.index().size(), 2u);
+  BOOST_CHECK(points.find(ones) == points.end());
+  BOOST_CHECK(*points.find(twos) == twos);
+}
+
+BOOST_AUTO_TEST_CASE( test_hash_indexed_erase_rebalancing )
+{
+  // Many duplicates and many erasures, so that nodes are relinked often
+  hash_indexed<point_multiset<2, int2, bracket_less<int2>, perfect_balancing>,
+               int2_hash> points;
+  for (int i = 0; i < 200; ++i)
+    { int2 p; points.insert(randomize(-3, 3)(p, i, 200)); }
+  BOOST_CHECK_EQUAL(points.index().size(), 200u);
+  while (!points.empty())
+    {
+      point_multiset<2, int2>::iterator pick = points.begin();
+      std::advance(pick, (std::ptrdiff_t)
+                   (static_cast<std::size_t>(std::rand()) % points.size()));
+      int2 key = *pick;
+      std::size_t expected = static_cast<std::size_t>
+        (std::distance(equal_begin(points, key), equal_end(points, key)));
+      BOOST_CHECK_EQUAL(points.count(key), expected);
+      std::size_t found = 0;
+      for (hash_indexed<point_multiset<2, int2, bracket_less<int2>,
+                                       perfect_balancing>,
+                        int2_hash>::equal_iterator
+             i = points.equal_range(key).first;
+           i != points.equal_range(key).second; ++i)
+        { BOOST_CHECK(*i == key); ++found; }
+      BOOST_CHECK_EQUAL(found, expected);
+      if (std::rand() % 2) points.erase(pick);
+      else BOOST_CHECK_EQUAL(points.erase(key), expected);
+      BOOST_CHECK_EQUAL(points.index().size(), points.size());
+      BOOST_CHECK(points.count(key) == 0 || points.count(key) == expected - 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE( test_hash_indexed_idle_runtime_map )
+{
+  std::vector<int2> values;
+  for (int i = 0; i < 100; ++i)
+    { int2 p; values.push_back(randomize(-5, 5)(p, i, 100)); }
+  hash_indexed<idle_point_multiset<2, int2>, int2_hash> idle;
+  idle.insert_rebalance(values.begin(), values.end());
+  BOOST_CHECK_EQUAL(idle.index().size(), 100u);
+  idle.rebalance();
+  hash_indexed<point_multimap<0, int2, std::string>, int2_hash>
+    runtime(2u), copy(2u);
+  for (std::vector<int2>::const_iterator i = values.begin();
+       i != values.end(); ++i)
+    runtime.insert(std::make_pair(*i, std::string("value")));
+  BOOST_CHECK_EQUAL(runtime.dimension(), 2u);
+  copy = runtime;
+  runtime.clear();
+  BOOST_CHECK(runtime.index().empty());
+  swap(runtime, copy);
+  BOOST_CHECK(copy.empty());
+  BOOST_CHECK_EQUAL(runtime.index().size(), 100u);
+  for (std::vector<int2>::const_iterator i = values.begin();
+       i != values.end(); ++i)
+    {
+      BOOST_CHECK_EQUAL(idle.count(*i), runtime.count(*i));
+      BOOST_CHECK(idle.find(*i) != idle.end());
+      runtime.find(*i)->second = "found";
+    }
+  BOOST_CHECK(runtime.begin()->second == "found");
+}
@@ -0,0 +1,156 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   verify_kd_forest_multiset.cpp
+ *  Contains the tests for the \ref kd_forest_multiset, which are checked
+ *  against an exhaustive search of the values.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define SPATIAL_ENABLE_ASSERT // detect interal issues that should not occur
+
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <boost/test/unit_test.hpp>
+#include "../../src/kd_forest_multiset.hpp"
+#include "../../src/query.hpp"
+#include "spatial_test_fixtures.hpp"
+
+typedef std::vector<int> descriptor;
+typedef kd_forest_multiset<0, descriptor> forest_descriptor;
+typedef kd_forest_multiset<2, int2> forest_int2;
+
+inline double
+quadrance_to(const descriptor& x, const descriptor& y)
+{
+  double sum = 0.0;
+  for (std::size_t d = 0; d < x.size(); ++d)
+    { sum += static_cast<double>((x[d] - y[d]) * (x[d] - y[d])); }
+  return sum;
+}
+
+inline descriptor
+random_descriptor(std::size_t rank)
+{
+  descriptor key(rank);
+  for (std::size_t d = 0; d < rank; ++d) { key[d] = std::rand() % 256; }
+  return key;
+}
+
+BOOST_AUTO_TEST_CASE( test_kd_forest_insert_erase )
+{
+  BOOST_CHECK_THROW(forest_descriptor(0), invalid_rank);
+  forest_int2 container(bracket_less<int2>(), 3);
+  BOOST_CHECK_EQUAL(container.tree_count(), 3u);
+  BOOST_CHECK(container.nearest_neighbor(ones) == container.end());
+  std::vector<int2> keys;
+  int2 key;
+  for (int i = 0; i < 300; ++i)
+    { keys.push_back(randomize(0, 20)(key, 0, 0)); }
+  container.insert(keys.begin(), keys.begin() + 200);
+  for (std::vector<int2>::const_iterator i = keys.begin() + 200;
+       i != keys.end(); ++i)
+    { container.insert(*i); }
+  BOOST_CHECK_EQUAL(container.size(), keys.size());
+  forest_int2::size_type expected = static_cast<forest_int2::size_type>
+    (std::count(keys.begin(), keys.end(), keys[0]));
+  BOOST_CHECK_EQUAL(container.erase(keys[0]), expected);
+  BOOST_CHECK_EQUAL(container.size(), keys.size() - expected);
+  container.erase(container.begin());
+  BOOST_CHECK_EQUAL(container.size(), keys.size() - expected - 1);
+  std::vector<forest_int2::const_iterator> all;
+  container.set_max_checks(container.size() * container.tree_count());
+  container.nearest_neighbors(zeros, 1000, std::back_inserter(all));
+  BOOST_CHECK_EQUAL(all.size(), container.size());
+  std::sort(all.begin(), all.end());
+  BOOST_CHECK(std::unique(all.begin(), all.end()) == all.end());
+}
+
+BOOST_AUTO_TEST_CASE( test_kd_forest_nearest )
+{
+  const std::size_t rank = 32;
+  std::srand(1);
+  forest_descriptor container(rank);
+  std::vector<descriptor> keys;
+  for (int i = 0; i < 2000; ++i)
+    { keys.push_back(random_descriptor(rank)); }
+  container.insert(keys.begin(), keys.end());
+  // A value is found at a distance of zero from itself.
+  container.set_max_checks(64);
+  for (std::size_t i = 0; i < keys.size(); i += 97)
+    {
+      BOOST_CHECK_EQUAL(quadrance_to(*container.nearest_neighbor(keys[i]),
+                                     keys[i]), 0.0);
+    }
+  // With a large budget, most searches are exact.
+  container.set_max_checks(1000);
+  int exact = 0;
+  for (int i = 0; i < 20; ++i)
+    {
+      descriptor target = random_descriptor(rank);
+      std::vector<double> expected;
+      for (std::vector<descriptor>::const_iterator j = keys.begin();
+           j != keys.end(); ++j)
+        { expected.push_back(quadrance_to(target, *j)); }
+      std::sort(expected.begin(), expected.end());
+      std::vector<forest_descriptor::const_iterator> found;
+      container.nearest_neighbors(target, 5, std::back_inserter(found));
+      BOOST_REQUIRE_EQUAL(found.size(), 5u);
+      for (std::size_t j = 1; j < found.size(); ++j)
+        {
+          BOOST_CHECK(quadrance_to(target, *found[j - 1])
+                      <= quadrance_to(target, *found[j]));
+        }
+      if (quadrance_to(target, *found[0]) == expected[0]) ++exact;
+    }
+  BOOST_CHECK(exact >= 15);
+}
+
+BOOST_AUTO_TEST_CASE( test_kd_forest_erase_search )
+{
+  forest_int2 container;
+  std::vector<int2> keys;
+  int2 key;
+  for (int i = 0; i < 400; ++i)
+    { keys.push_back(randomize(0, 1000)(key, 0, 0)); }
+  container.insert(keys.begin(), keys.end());
+  container.set_max_checks(container.size() * container.tree_count());
+  // Erase one value out of three, so that the forest is rebuilt once in
+  // between, and check that the searches only find the remaining values.
+  std::vector<int2> kept;
+  for (std::size_t i = 0; i < keys.size(); ++i)
+    {
+      if (i % 3 != 0) { kept.push_back(keys[i]); continue; }
+      forest_int2::const_iterator found = container.nearest_neighbor(keys[i]);
+      BOOST_REQUIRE(*found == keys[i]);
+      container.erase(found);
+    }
+  BOOST_CHECK_EQUAL(container.size(), kept.size());
+  BOOST_CHECK_EQUAL(static_cast<std::size_t>
+                    (std::distance(container.begin(), container.end())),
+                    kept.size());
+  std::vector<forest_int2::const_iterator> all;
+  container.nearest_neighbors(zeros, 1000, std::back_inserter(all));
+  BOOST_REQUIRE_EQUAL(all.size(), kept.size());
+  std::vector<int2> found;
+  for (std::size_t i = 0; i < all.size(); ++i) { found.push_back(*all[i]); }
+  for (std::vector<int2>::const_iterator i = kept.begin();
+       i != kept.end(); ++i)
+    {
+      BOOST_CHECK_EQUAL(std::count(found.begin(), found.end(), *i),
+                        std::count(kept.begin(), kept.end(), *i));
+    }
+  // The metric overload gives the same results as the member function.
+  std::vector<forest_int2::const_iterator> nearest, with_metric;
+  container.nearest_neighbors(keys[1], 5, std::back_inserter(nearest));
+  quadrance<forest_int2, int, bracket_minus<int2, int> > metric;
+  nearest_neighbors(container, metric, keys[1], 5,
+                    std::back_inserter(with_metric));
+  BOOST_CHECK(nearest == with_metric);
+}
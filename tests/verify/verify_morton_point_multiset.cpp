@@ -0,0 +1,161 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   verify_morton_point_multiset.cpp
+ *  Contains the tests for the \ref morton_point_multiset, which are checked
+ *  against an exhaustive search of the values.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define SPATIAL_ENABLE_ASSERT // detect interal issues that should not occur
+
+#include <vector>
+#include <algorithm>
+#include <boost/test/unit_test.hpp>
+#include "../../src/morton_point_multiset.hpp"
+#include "spatial_test_fixtures.hpp"
+
+typedef morton_point_multiset<2, int2> morton_int2;
+typedef morton_point_multiset<4, quad, quad_access, unsigned int> morton_quad;
+
+template <typename Container>
+inline bool
+within(const Container& container, const typename Container::key_type& key,
+       const typename Container::key_type& lower,
+       const typename Container::key_type& upper)
+{
+  typename Container::accessor_type access = container.accessor();
+  for (dimension_type d = 0; d < container.dimension(); ++d)
+    {
+      if (access(d, key) < access(d, lower)
+          || !(access(d, key) < access(d, upper)))
+        return false;
+    }
+  return true;
+}
+
+template <typename Container>
+inline double
+quadrance_to(const Container& container,
+             const typename Container::key_type& x,
+             const typename Container::key_type& y)
+{
+  typename Container::accessor_type access = container.accessor();
+  double sum = 0.0;
+  for (dimension_type d = 0; d < container.dimension(); ++d)
+    {
+      double diff = static_cast<double>(access(d, x))
+        - static_cast<double>(access(d, y));
+      sum += diff * diff;
+    }
+  return sum;
+}
+
+BOOST_AUTO_TEST_CASE( test_morton_insert_find_erase )
+{
+  std::vector<int2> keys;
+  int2 key;
+  for (int i = 0; i < 300; ++i)
+    { keys.push_back(randomize(0, 30)(key, 0, 0)); }
+  morton_int2 container;
+  container.insert(keys.begin(), keys.begin() + 200);
+  for (std::vector<int2>::const_iterator i = keys.begin() + 200;
+       i != keys.end(); ++i)
+    { container.insert(*i); }
+  BOOST_CHECK_EQUAL(container.size(), keys.size());
+  for (morton_int2::const_iterator i = container.begin();
+       i + 1 < container.end(); ++i)
+    { BOOST_CHECK(container.code(*i) <= container.code(*(i + 1))); }
+  morton_int2::size_type expected = static_cast<morton_int2::size_type>
+    (std::count(keys.begin(), keys.end(), keys[0]));
+  BOOST_CHECK(*container.find(keys[0]) == keys[0]);
+  BOOST_CHECK_EQUAL(container.count(keys[0]), expected);
+  BOOST_CHECK_EQUAL(container.erase(keys[0]), expected);
+  BOOST_CHECK(container.find(keys[0]) == container.end());
+  BOOST_CHECK_EQUAL(container.size(), keys.size() - expected);
+  BOOST_CHECK_THROW(container.insert(int2(-1, 0)), invalid_coordinate);
+  BOOST_CHECK_EQUAL(container.size(), keys.size() - expected);
+}
+
+BOOST_AUTO_TEST_CASE( test_morton_region )
+{
+  morton_int2 points;
+  morton_quad quads;
+  std::vector<int2> keys;
+  std::vector<quad> quad_keys;
+  for (int i = 0; i < 500; ++i)
+    {
+      int2 key; quad q;
+      keys.push_back(randomize(0, 100)(key, 0, 0));
+      quad_keys.push_back(randomize(0, 20)(q, 0, 0));
+    }
+  points.insert(keys.begin(), keys.end());
+  quads.insert(quad_keys.begin(), quad_keys.end());
+  for (int i = 0; i < 20; ++i)
+    {
+      int2 l(i * 3, 50 - i), h(i * 3 + 20, 90);
+      std::size_t count = 0;
+      for (morton_region_iterator<morton_int2>
+             j = region_begin(points, l, h);
+           j != region_end(points, l, h); ++j)
+        { BOOST_CHECK(within(points, *j, l, h)); ++count; }
+      std::size_t expected = 0;
+      for (std::vector<int2>::const_iterator j = keys.begin();
+           j != keys.end(); ++j)
+        { if (within(points, *j, l, h)) ++expected; }
+      BOOST_CHECK_EQUAL(count, expected);
+      quad ql(i / 2, 2, i / 4, 5), qh(i / 2 + 8, 15, i / 4 + 10, 12);
+      const morton_quad& cquads = quads;
+      count = 0;
+      for (morton_region_iterator<const morton_quad>
+             j = region_cbegin(cquads, ql, qh);
+           j != region_cend(cquads, ql, qh); ++j)
+        { BOOST_CHECK(within(quads, *j, ql, qh)); ++count; }
+      expected = 0;
+      for (std::vector<quad>::const_iterator j = quad_keys.begin();
+           j != quad_keys.end(); ++j)
+        { if (within(quads, *j, ql, qh)) ++expected; }
+      BOOST_CHECK_EQUAL(count, expected);
+    }
+  BOOST_CHECK_THROW(region_begin(points, twos, ones), invalid_bounds);
+}
+
+BOOST_AUTO_TEST_CASE( test_morton_nearest )
+{
+  morton_int2 points;
+  BOOST_CHECK(points.nearest_neighbor(ones) == points.end());
+  std::vector<int2> keys;
+  int2 key;
+  for (int i = 0; i < 300; ++i)
+    { keys.push_back(randomize(0, 1000)(key, 0, 0)); }
+  points.insert(keys.begin(), keys.end());
+  for (int i = 0; i < 20; ++i)
+    {
+      int2 target;
+      randomize(0, 1000)(target, 0, 0);
+      std::vector<double> expected;
+      for (std::vector<int2>::const_iterator j = keys.begin();
+           j != keys.end(); ++j)
+        { expected.push_back(quadrance_to(points, target, *j)); }
+      std::sort(expected.begin(), expected.end());
+      std::vector<morton_int2::const_iterator> found;
+      points.nearest_neighbors(target, 5, std::back_inserter(found));
+      BOOST_REQUIRE_EQUAL(found.size(), 5u);
+      for (std::size_t j = 0; j < found.size(); ++j)
+        {
+          BOOST_CHECK_EQUAL(quadrance_to(points, target, *found[j]),
+                            expected[j]);
+        }
+      BOOST_CHECK_EQUAL
+        (quadrance_to(points, target, *points.nearest_neighbor(target)),
+         expected[0]);
+    }
+  std::vector<morton_int2::const_iterator> all;
+  points.nearest_neighbors(zeros, 400, std::back_inserter(all));
+  BOOST_CHECK_EQUAL(all.size(), keys.size());
+}
@@ -505,3 +505,29 @@ BOOST_AUTO_TEST_CASE_TEMPLATE
     BOOST_CHECK(pair2.second == ordered_cend(fix.container));
   }
 }
+
+BOOST_AUTO_TEST_CASE( test_ordered_carried_dimension )
+{
+  // The dimension carried by the iterator from node to node must match the
+  // dimension computed from the depth of each node, for ranks that are
+  // dispatched (4) and for ranks that are not (5).
+  typedef runtime_pointset_fix<quad> fix_type;
+  fix_type fix(100, randomize(-4, 4));
+  point_multiset<0, double6> dbl(5u);
+  for (int i = 0; i < 100; ++i)
+    { double6 d; dbl.insert(randomize(-4, 4)(d, i, 100)); }
+  int count_it = 0;
+  for (ordered_iterator<fix_type::container_type>
+         i = ordered_begin(fix.container);
+       i != ordered_end(fix.container); ++i, ++count_it)
+    BOOST_CHECK_EQUAL(i.node_dim, details::modulo(i.node, i.rank()));
+  BOOST_CHECK_EQUAL(count_it, 100);
+  count_it = 0;
+  for (ordered_iterator<point_multiset<0, double6> > i = ordered_end(dbl);
+       i != ordered_begin(dbl); ++count_it)
+    {
+      --i;
+      BOOST_CHECK_EQUAL(i.node_dim, details::modulo(i.node, i.rank()));
+    }
+  BOOST_CHECK_EQUAL(count_it, 100);
+}
@@ -10,7 +10,10 @@
 
 #include <boost/test/unit_test.hpp>
 #include <utility> // std::make_pair
+#include <cstdlib> // std::rand
 #include "../../src/point_multimap.hpp"
+#include "../../src/region_iterator.hpp"
+#include "../../src/neighbor_iterator.hpp"
 #include "spatial_test_types.hpp"
 
 using namespace spatial;
@@ -48,3 +51,61 @@ BOOST_AUTO_TEST_CASE( test_zero_point_map_copy_assignment )
   BOOST_CHECK_EQUAL(points.size(), copy.size());
   BOOST_CHECK(*points.begin() == *copy.begin());
 }
+
+BOOST_AUTO_TEST_CASE( test_cold_point_map_insert_erase )
+{
+  typedef point_multimap<2, int2, int, bracket_less<int2>, loose_balancing,
+                         std::allocator<std::pair<const int2, int> >,
+                         cold_storage> cold_map;
+  cold_map points;
+  for (int i = 0; i < 200; ++i)
+    { points.insert(std::make_pair(int2(std::rand() % 20, 2 + i % 20), i)); }
+  points.insert(std::make_pair(ones, -1));
+  cold_map::iterator one = points.find(ones);
+  BOOST_REQUIRE(one != points.end());
+  const std::pair<const int2, int>* address = &*one;
+  // Erasing other values rebalances the tree but does not move the values.
+  for (int i = 0; i < 100; ++i)
+    {
+      cold_map::iterator first = points.begin();
+      if (first == one) ++first;
+      points.erase(first);
+    }
+  BOOST_CHECK_EQUAL(points.size(), 101u);
+  BOOST_CHECK(&*points.find(ones) == address);
+  BOOST_CHECK_EQUAL(points.find(ones)->second, -1);
+  points.find(ones)->second = 1;
+  cold_map copy(points);
+  BOOST_CHECK(&*copy.find(ones) != address);
+  BOOST_CHECK_EQUAL(copy.find(ones)->second, 1);
+  BOOST_CHECK(copy == points);
+  points.clear();
+  BOOST_CHECK(points.empty());
+}
+
+BOOST_AUTO_TEST_CASE( test_cold_point_map_region_and_neighbor )
+{
+  point_multimap<0, int2, int, bracket_less<int2>, loose_balancing,
+                 std::allocator<std::pair<const int2, int> >, cold_storage>
+    cold(2);
+  point_multimap<0, int2, int> hot(2);
+  for (int i = 0; i < 300; ++i)
+    {
+      std::pair<int2, int> value(int2(std::rand() % 50, std::rand() % 50), i);
+      cold.insert(value);
+      hot.insert(value);
+    }
+  int2 l(10, 10), h(30, 40);
+  int cold_sum = 0, hot_sum = 0;
+  for (region_iterator<point_multimap<0, int2, int, bracket_less<int2>,
+         loose_balancing, std::allocator<std::pair<const int2, int> >,
+         cold_storage> > i = region_begin(cold, l, h);
+       i != region_end(cold, l, h); ++i)
+    { cold_sum += i->second; }
+  for (region_iterator<point_multimap<0, int2, int> >
+         i = region_begin(hot, l, h); i != region_end(hot, l, h); ++i)
+    { hot_sum += i->second; }
+  BOOST_CHECK_EQUAL(cold_sum, hot_sum);
+  BOOST_CHECK_EQUAL(distance(neighbor_begin(cold, twos)),
+                    distance(neighbor_begin(hot, twos)));
+}
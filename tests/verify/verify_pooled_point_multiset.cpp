@@ -0,0 +1,256 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   verify_pooled_point_multiset.cpp
+ *  Contains the tests for the \ref pooled_point_multiset, which are checked
+ *  against an exhaustive search of the values.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define SPATIAL_ENABLE_ASSERT // detect interal issues that should not occur
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include <boost/test/unit_test.hpp>
+#include "../../src/pooled_point_multiset.hpp"
+#include "../../src/region_iterator.hpp"
+#include "../../src/neighbor_iterator.hpp"
+#include "spatial_test_fixtures.hpp"
+
+namespace spatial
+{
+  template <typename Tp>
+  std::ostream& operator<<(std::ostream& o, const pooled_key<Tp>& key)
+  { return o << "(" << key[0] << ", " << key[1] << ", " << key[2] << ")"; }
+}
+
+typedef pooled_point_multiset<double> pooled_double;
+
+namespace
+{
+  std::vector<double> random_point(int low, int high)
+  {
+    std::vector<double> point(3);
+    for (std::size_t n = 0; n < 3; ++n)
+      { point[n] = static_cast<double>(low + std::rand() % (high - low)); }
+    return point;
+  }
+
+  bool same_point(const pooled_key<double>& x, const std::vector<double>& y)
+  { return x[0] == y[0] && x[1] == y[1] && x[2] == y[2]; }
+
+  // The number of calls to allocate() made by the tagged_allocator of each
+  // tag.
+  std::size_t tagged_allocations[3];
+
+  // The number of calls to allocate() after which the tagged_allocator of
+  // each tag throws, or 0 if it never throws.
+  std::size_t tagged_limits[3];
+
+  // An allocator with a state: the tag that counts its allocations.
+  template <typename Tp>
+  struct tagged_allocator
+  {
+    typedef Tp value_type;
+    template <typename Up> struct rebind
+    { typedef tagged_allocator<Up> other; };
+
+    tagged_allocator() : tag(0) { }
+    explicit tagged_allocator(int tag_) : tag(tag_) { }
+    template <typename Up>
+    tagged_allocator(const tagged_allocator<Up>& other) : tag(other.tag) { }
+
+    Tp* allocate(std::size_t n)
+    {
+      if (tagged_limits[tag] != 0
+          && tagged_allocations[tag] == tagged_limits[tag])
+        { throw std::bad_alloc(); }
+      ++tagged_allocations[tag];
+      return std::allocator<Tp>().allocate(n);
+    }
+
+    void deallocate(Tp* p, std::size_t n)
+    { std::allocator<Tp>().deallocate(p, n); }
+
+    int tag;
+  };
+
+  template <typename Tp, typename Up>
+  bool operator==(const tagged_allocator<Tp>& x,
+                  const tagged_allocator<Up>& y)
+  { return x.tag == y.tag; }
+
+  template <typename Tp, typename Up>
+  bool operator!=(const tagged_allocator<Tp>& x,
+                  const tagged_allocator<Up>& y)
+  { return x.tag != y.tag; }
+}
+
+BOOST_AUTO_TEST_CASE( test_pooled_insert_find_erase )
+{
+  BOOST_CHECK_THROW(pooled_double(0), invalid_rank);
+  pooled_double container(3);
+  std::vector<std::vector<double> > keys;
+  for (int i = 0; i < 600; ++i) { keys.push_back(random_point(0, 8)); }
+  container.insert(keys.begin(), keys.end());
+  BOOST_CHECK_EQUAL(container.size(), keys.size());
+  BOOST_CHECK(same_point(*container.find(keys[0]), keys[0]));
+  std::size_t expected = static_cast<std::size_t>
+    (std::count(keys.begin(), keys.end(), keys[0]));
+  pooled_double copy(container);
+  BOOST_CHECK_EQUAL(container.erase(keys[0]), expected);
+  BOOST_CHECK(container.find(keys[0]) == container.end());
+  BOOST_CHECK(copy.find(keys[0]) != copy.end());
+  // The slices freed by erase are reused by the next insertions.
+  container.erase(container.find(keys[1]));
+  container.insert(keys[1]);
+  BOOST_CHECK_EQUAL(container.size(), copy.size() - expected);
+  for (pooled_double::iterator i = container.begin(); i != container.end(); ++i)
+    { BOOST_CHECK(copy.find(*i) != copy.end()); }
+  container = copy;
+  copy.clear();
+  BOOST_CHECK_EQUAL(container.size(), keys.size());
+  for (std::vector<std::vector<double> >::const_iterator i = keys.begin();
+       i != keys.end(); ++i)
+    { BOOST_CHECK(same_point(*container.find(*i), *i)); }
+}
+
+BOOST_AUTO_TEST_CASE( test_pooled_region_and_neighbor )
+{
+  pooled_double container(3);
+  std::vector<std::vector<double> > keys;
+  for (int i = 0; i < 500; ++i)
+    {
+      keys.push_back(random_point(0, 100));
+      container.insert(keys.back());
+    }
+  for (int i = 0; i < 10; ++i)
+    {
+      std::vector<double> l = random_point(0, 50), h = random_point(50, 100);
+      std::vector<double> target = random_point(0, 100);
+      std::size_t count = 0;
+      for (region_iterator<pooled_double> j
+             = region_begin(container, pooled_key<double>(&l[0]),
+                            pooled_key<double>(&h[0]));
+           j != region_end(container, pooled_key<double>(&l[0]),
+                           pooled_key<double>(&h[0])); ++j)
+        { ++count; }
+      std::size_t expected = 0;
+      std::vector<double> distances;
+      for (std::vector<std::vector<double> >::const_iterator j = keys.begin();
+           j != keys.end(); ++j)
+        {
+          if ((*j)[0] >= l[0] && (*j)[0] < h[0] && (*j)[1] >= l[1]
+              && (*j)[1] < h[1] && (*j)[2] >= l[2] && (*j)[2] < h[2])
+            ++expected;
+          double d = 0;
+          for (std::size_t n = 0; n < 3; ++n)
+            { d += ((*j)[n] - target[n]) * ((*j)[n] - target[n]); }
+          distances.push_back(std::sqrt(d));
+        }
+      BOOST_CHECK_EQUAL(count, expected);
+      std::sort(distances.begin(), distances.end());
+      neighbor_iterator<pooled_double> j
+        = neighbor_begin(container, pooled_key<double>(&target[0]));
+      for (std::size_t k = 0; k < 10; ++k, ++j)
+        { BOOST_CHECK_CLOSE(distance(j), distances[k], .0000001); }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( test_pooled_allocator )
+{
+  typedef pooled_point_multiset<double, loose_balancing,
+                                tagged_allocator<double> > tagged_double;
+  tagged_double first(3, loose_balancing(), tagged_allocator<double>(1));
+  tagged_double second(3, loose_balancing(), tagged_allocator<double>(2));
+  for (int i = 0; i < 100; ++i)
+    {
+      first.insert(random_point(0, 100));
+      second.insert(random_point(0, 100));
+    }
+  std::fill(tagged_allocations, tagged_allocations + 3, 0u);
+  // A copy allocates with the allocator of its source, an assignment with
+  // the allocator of its target, and never with a default allocator.
+  tagged_double copy(first);
+  BOOST_CHECK(tagged_allocations[1] != 0);
+  std::size_t before = tagged_allocations[1];
+  second = first;
+  BOOST_CHECK(tagged_allocations[2] != 0);
+  BOOST_CHECK_EQUAL(tagged_allocations[1], before);
+  // After a swap, each pool releases its blocks with the allocator that
+  // allocated them and keeps allocating with it.
+  first.swap(second);
+  before = tagged_allocations[1];
+  for (int i = 0; i < 300; ++i) { second.insert(random_point(0, 100)); }
+  BOOST_CHECK(tagged_allocations[1] != before);
+  BOOST_CHECK_EQUAL(tagged_allocations[0], 0u);
+}
+
+BOOST_AUTO_TEST_CASE( test_pooled_assign_throwing_allocator )
+{
+  typedef pooled_point_multiset<double, loose_balancing,
+                                tagged_allocator<double> > tagged_double;
+  tagged_double first(3, loose_balancing(), tagged_allocator<double>(1));
+  tagged_double second(3, loose_balancing(), tagged_allocator<double>(2));
+  // More values than a block of the pool holds, so that the assignment
+  // allocates several blocks.
+  for (int i = 0; i < 300; ++i) { first.insert(random_point(0, 100)); }
+  for (int i = 0; i < 10; ++i) { second.insert(random_point(0, 100)); }
+  std::vector<std::vector<double> > expected;
+  for (tagged_double::const_iterator i = second.begin(); i != second.end();
+       ++i)
+    { expected.push_back(std::vector<double>(&(*i)[0], &(*i)[0] + 3)); }
+  std::sort(expected.begin(), expected.end());
+  // Fail each allocation of the assignment in turn, until it succeeds: the
+  // target must be left unchanged by each failure.
+  bool assigned = false;
+  for (std::size_t fail = 0; !assigned; ++fail)
+    {
+      tagged_limits[2] = tagged_allocations[2] + fail;
+      try { second = first; assigned = true; }
+      catch (const std::bad_alloc&)
+        {
+          std::vector<std::vector<double> > values;
+          for (tagged_double::const_iterator i = second.begin();
+               i != second.end(); ++i)
+            { values.push_back(std::vector<double>(&(*i)[0], &(*i)[0] + 3)); }
+          std::sort(values.begin(), values.end());
+          BOOST_CHECK(values == expected);
+        }
+      tagged_limits[2] = 0;
+    }
+  BOOST_CHECK_EQUAL(second.size(), first.size());
+  for (tagged_double::const_iterator i = first.begin(); i != first.end();
+       ++i)
+    { BOOST_CHECK(second.find(*i) != second.end()); }
+}
+
+BOOST_AUTO_TEST_CASE( test_pooled_high_rank_find )
+{
+  // The coordinates of the queries exceed the buffer kept on the stack.
+  const dimension_type rank = 40;
+  pooled_double container(rank);
+  std::vector<std::vector<double> > keys;
+  for (int i = 0; i < 50; ++i)
+    {
+      keys.push_back(std::vector<double>(rank));
+      for (dimension_type n = 0; n < rank; ++n)
+        { keys.back()[n] = static_cast<double>(std::rand() % 4); }
+      container.insert(keys.back());
+    }
+  for (std::vector<std::vector<double> >::const_iterator i = keys.begin();
+       i != keys.end(); ++i)
+    { BOOST_CHECK(container.find(*i) != container.end()); }
+  std::size_t expected = static_cast<std::size_t>
+    (std::count(keys.begin(), keys.end(), keys[0]));
+  BOOST_CHECK_EQUAL(container.erase(keys[0]), expected);
+  BOOST_CHECK(container.find(keys[0]) == container.end());
+}
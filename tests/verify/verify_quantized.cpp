@@ -0,0 +1,105 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   verify_quantized.cpp
+ *  Contains the tests for the \ref quantizer and the refined nearest neighbor
+ *  search among quantized keys.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define SPATIAL_ENABLE_ASSERT // detect interal issues that should not occur
+
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <ostream>
+#include <boost/test/unit_test.hpp>
+#include "../../src/point_multimap.hpp"
+#include "../../src/quantized.hpp"
+#include "spatial_test_fixtures.hpp"
+
+namespace spatial
+{
+  // Prints the keys in the messages of the assertions.
+  inline std::ostream&
+  operator<<(std::ostream& out, const quantized_point<2, short>& key)
+  { return out << "(" << key[0] << ", " << key[1] << ")"; }
+}
+
+typedef quantizer<2, short> quantizer_type;
+typedef point_multimap<2, quantizer_type::key_type, std::size_t>
+quantized_map;
+
+inline std::vector<double>
+random_position()
+{
+  std::vector<double> point(2);
+  point[0] = -300.0 + 600.0 * std::rand() / RAND_MAX;
+  point[1] = -300.0 + 600.0 * std::rand() / RAND_MAX;
+  return point;
+}
+
+inline double
+distance_between(const std::vector<double>& x, const std::vector<double>& y)
+{
+  return std::sqrt((x[0] - y[0]) * (x[0] - y[0])
+                   + (x[1] - y[1]) * (x[1] - y[1]));
+}
+
+BOOST_AUTO_TEST_CASE( test_quantizer )
+{
+  std::vector<double> origin(2, 100.0);
+  BOOST_CHECK_THROW(quantizer_type(origin, 0.0), invalid_distance);
+  quantizer_type quantizer_(origin, 0.01);
+  std::vector<double> point(2);
+  point[0] = 100.004; point[1] = 99.996;
+  quantizer_type::key_type key = quantizer_.quantize(point);
+  BOOST_CHECK_EQUAL(key[0], 0);
+  BOOST_CHECK_EQUAL(key[1], 0);
+  point[0] = 427.67; point[1] = -227.67;
+  key = quantizer_.quantize(point);
+  BOOST_CHECK_EQUAL(key[0], 32767);
+  BOOST_CHECK_EQUAL(key[1], -32767);
+  BOOST_CHECK_CLOSE(quantizer_.dequantize(0, key), 427.67, .0000001);
+  point[0] = 427.68;
+  BOOST_CHECK_THROW(quantizer_.quantize(point), invalid_coordinate);
+}
+
+BOOST_AUTO_TEST_CASE( test_quantized_nearest_neighbors )
+{
+  std::srand(1);
+  // A coarse scale, so that quantization changes the order of neighbors.
+  quantizer_type quantizer_(zeros, 2.0);
+  std::vector<std::vector<double> > exact;
+  quantized_map container;
+  for (std::size_t i = 0; i < 1000; ++i)
+    {
+      exact.push_back(random_position());
+      container.insert(std::make_pair(quantizer_.quantize(exact.back()), i));
+    }
+  for (int i = 0; i < 20; ++i)
+    {
+      std::vector<double> target = random_position();
+      std::vector<double> expected;
+      for (std::size_t j = 0; j < exact.size(); ++j)
+        { expected.push_back(distance_between(target, exact[j])); }
+      std::sort(expected.begin(), expected.end());
+      typedef neighbor_iterator<quantized_map, euclidian
+        <quantized_map, double, quantized_minus
+         <quantizer_type::key_type, double> > > iterator;
+      std::vector<iterator> found;
+      quantized_nearest_neighbors(container, quantizer_, exact.begin(),
+                                  target, 8, std::back_inserter(found));
+      BOOST_REQUIRE_EQUAL(found.size(), 8u);
+      for (std::size_t j = 0; j < found.size(); ++j)
+        {
+          BOOST_CHECK_CLOSE(distance_between(target, exact[found[j]->second]),
+                            expected[j], .0000001);
+        }
+    }
+}
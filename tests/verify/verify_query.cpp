@@ -0,0 +1,167 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   verify_query.cpp
+ *  Contains the tests for the one-shot queries, which are checked against the
+ *  iterators and against an exhaustive search of the containers.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define SPATIAL_ENABLE_ASSERT // detect interal issues that should not occur
+
+#include <algorithm>
+#include <boost/test/unit_test.hpp>
+#include "../../src/query.hpp"
+#include "../../src/region_iterator.hpp"
+#include "../../src/neighbor_iterator.hpp"
+#include "spatial_test_fixtures.hpp"
+
+BOOST_AUTO_TEST_CASE_TEMPLATE
+( test_query_region_count, Tp, double6_sets )
+{
+  Tp fix(100, randomize(-1, 1));
+  double6 l; std::fill(l.begin(), l.end(), -0.5);
+  double6 h; std::fill(h.begin(), h.end(), 0.5);
+  typename Tp::container_type::size_type count = 0;
+  for (region_iterator<typename Tp::container_type>
+         i = region_begin(fix.container, l, h);
+       i != region_end(fix.container, l, h); ++i)
+    { ++count; }
+  BOOST_CHECK_EQUAL(region_count(fix.container, l, h), count);
+  const typename Tp::container_type& cref = fix.container;
+  BOOST_CHECK_EQUAL(region_count(cref, make_bounds(cref, l, h)), count);
+  typename Tp::container_type empty(fix.container);
+  empty.clear();
+  BOOST_CHECK_EQUAL(region_count(empty, l, h), 0u);
+}
+
+struct sum_first
+{
+  sum_first() : sum(0) { }
+  void operator()(const double6& value) { sum += value[0]; }
+  double sum;
+};
+
+BOOST_AUTO_TEST_CASE( test_query_region_visit )
+{
+  runtime_pointset_fix<double6> fix(100, randomize(-1, 1));
+  double6 l; std::fill(l.begin(), l.end(), -0.5);
+  double6 h; std::fill(h.begin(), h.end(), 0.5);
+  double sum = 0;
+  for (region_iterator<runtime_pointset_fix<double6>::container_type>
+         i = region_begin(fix.container, l, h);
+       i != region_end(fix.container, l, h); ++i)
+    { sum += (*i)[0]; }
+  BOOST_CHECK_CLOSE(region_visit(fix.container, l, h, sum_first()).sum,
+                    sum, 0.000000001);
+}
+
+struct count_within
+{
+  count_within() : count(0) { }
+  template <typename Value> void operator()(const Value&) { ++count; }
+  std::size_t count;
+};
+
+BOOST_AUTO_TEST_CASE_TEMPLATE
+( test_query_radius_and_nearest, Tp, double6_maps )
+{
+  typedef typename Tp::container_type container_type;
+  typedef typename neighbor_iterator<container_type>::metric_type metric_type;
+  typedef typename metric_type::distance_type distance_type;
+  Tp fix(100, randomize(0, 20));
+  metric_type metric;
+  double6 target;
+  for (int n = 0; n < 10; ++n)
+    {
+      randomize(0, 20)(target, 0, 0);
+      std::vector<distance_type> all;
+      for (typename container_type::const_iterator
+             i = fix.container.cbegin(); i != fix.container.cend(); ++i)
+        {
+          all.push_back(metric.distance_to_key
+                        (fix.container.rank()(), target, i->first));
+        }
+      std::sort(all.begin(), all.end());
+      // Every value up to the 10th closest is within the radius
+      distance_type radius = all[9];
+      std::size_t within = static_cast<std::size_t>
+        (std::upper_bound(all.begin(), all.end(), radius) - all.begin());
+      BOOST_CHECK_EQUAL(radius_visit(fix.container, metric, target, radius,
+                                     count_within()).count, within);
+      std::vector<typename container_type::const_iterator> nearest;
+      const container_type& cref = fix.container;
+      nearest_neighbors(cref, metric, target, 10, std::back_inserter(nearest));
+      BOOST_REQUIRE_EQUAL(nearest.size(), 10u);
+      for (std::size_t i = 0; i < nearest.size(); ++i)
+        {
+          BOOST_CHECK_CLOSE(metric.distance_to_key
+                            (fix.container.rank()(), target,
+                             nearest[i]->first), all[i], 0.000000001);
+        }
+      std::vector<typename container_type::iterator> every;
+      nearest_neighbors(fix.container, metric, target, 1000,
+                        std::back_inserter(every));
+      BOOST_CHECK_EQUAL(every.size(), fix.container.size());
+    }
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE
+( test_query_batch_find, Tp, double6_sets )
+{
+  Tp fix(100, randomize(0, 3));
+  std::vector<double6> keys;
+  for (int n = 0; n < 40; ++n)
+    {
+      double6 key;
+      keys.push_back(randomize(0, 3)(key, 0, 0));
+    }
+  typedef typename Tp::container_type::iterator iterator;
+  std::vector<iterator> found(keys.size());
+  BOOST_CHECK(batch_find(fix.container, keys.begin(), keys.end(),
+                         found.begin(), 3) == found.end());
+  for (std::size_t i = 0; i < keys.size(); ++i)
+    { BOOST_CHECK(found[i] == fix.container.find(keys[i])); }
+}
+
+typedef boost::mpl::list<pointset_fix<double6>,
+                         runtime_pointset_fix<double6> > batch_sets;
+
+BOOST_AUTO_TEST_CASE_TEMPLATE
+( test_query_batch_nearest_and_count, Tp, batch_sets )
+{
+  typedef typename Tp::container_type container_type;
+  typedef typename neighbor_iterator<container_type>::metric_type metric_type;
+  Tp fix(100, randomize(0, 20));
+  std::vector<double6> targets;
+  std::vector<bounds<double6, typename container_type::key_compare> > preds;
+  for (int n = 0; n < 25; ++n)
+    {
+      double6 target;
+      targets.push_back(randomize(0, 20)(target, 0, 0));
+      double6 high(target);
+      for (std::size_t d = 0; d < 6; ++d) { high[d] += 10.0; }
+      preds.push_back(make_bounds(fix.container, target, high));
+    }
+  std::vector<typename container_type::const_iterator>
+    nearest(targets.size());
+  const container_type& cref = fix.container;
+  batch_nearest_neighbor(cref, metric_type(), targets.begin(), targets.end(),
+                         nearest.begin(), 4);
+  std::vector<std::size_t> counts(preds.size());
+  batch_region_count(fix.container, preds.begin(), preds.end(),
+                     counts.begin(), 4);
+  for (std::size_t i = 0; i < targets.size(); ++i)
+    {
+      BOOST_CHECK_CLOSE(distance(neighbor_begin(fix.container, targets[i])),
+                        metric_type().distance_to_key
+                        (fix.container.rank()(), targets[i], *nearest[i]),
+                        0.000000001);
+      BOOST_CHECK_EQUAL(counts[i], region_count(fix.container, preds[i]));
+    }
+}
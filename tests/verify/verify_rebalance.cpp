@@ -0,0 +1,98 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   verify_rebalance.cpp
+ *  Contains the tests for the reports of the rebalancing in the relaxed
+ *  trees.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define SPATIAL_ENABLE_ASSERT // detect interal issues that should not occur
+
+#include <vector>
+#include <iterator>
+#include <boost/test/unit_test.hpp>
+#include "../../src/point_multiset.hpp"
+#include "spatial_test_fixtures.hpp"
+
+// Records all the events in a vector shared by its copies.
+struct event_recorder
+{
+  event_recorder() : events(0) { }
+  explicit event_recorder(std::vector<rebalance_event>* e) : events(e) { }
+  void operator()(const rebalance_event& event)
+  { events->push_back(event); }
+  std::vector<rebalance_event>* events;
+};
+
+template <typename Balancing>
+rebalance_counters
+sorted_insert_counters(int count)
+{
+  point_multiset<2, int2, bracket_less<int2>,
+                 observed_balancing<Balancing> > container;
+  for (int i = 0; i < count; ++i) { container.insert(int2(i, i)); }
+  BOOST_CHECK_EQUAL(container.size(), static_cast<std::size_t>(count));
+  BOOST_CHECK_EQUAL(static_cast<int>(std::distance(container.begin(),
+                                                   container.end())),
+                    count);
+  return container.balancing().observer();
+}
+
+BOOST_AUTO_TEST_CASE( test_rebalance_counters )
+{
+  rebalance_counters loose = sorted_insert_counters<loose_balancing>(500);
+  BOOST_CHECK_GT(loose.events, 0u);
+  // Each rebalancing, nested or not, erases and inserts one node.
+  BOOST_CHECK_EQUAL(loose.erase_nodes, loose.events);
+  BOOST_CHECK_EQUAL(loose.insert_nodes, loose.events);
+  BOOST_CHECK_GE(loose.max_weight, 3u);
+  BOOST_CHECK_GE(loose.total_weight, loose.events * 3);
+  BOOST_CHECK(loose.max_elapsed <= loose.elapsed);
+  rebalance_counters perfect = sorted_insert_counters<perfect_balancing>(500);
+  BOOST_CHECK_GT(perfect.events, loose.events);
+  BOOST_CHECK_EQUAL(perfect.erase_nodes, perfect.events);
+  loose.clear();
+  BOOST_CHECK_EQUAL(loose.events, 0u);
+  BOOST_CHECK(loose.elapsed == rebalance_counters().elapsed);
+}
+
+BOOST_AUTO_TEST_CASE( test_rebalance_events )
+{
+  std::vector<rebalance_event> events;
+  typedef observed_balancing<tight_balancing, event_recorder> balancing;
+  balancing policy((event_recorder(&events)));
+  point_multiset<2, int2, bracket_less<int2>, balancing>
+    container(bracket_less<int2>(), policy);
+  for (int i = 0; i < 200; ++i) { container.insert(int2(i, 200 - i)); }
+  std::size_t inserted = events.size();
+  BOOST_REQUIRE_GT(inserted, 0u);
+  // Erasing the leftmost values unbalances the tree too.
+  for (int i = 0; i < 150; ++i) { container.erase(container.begin()); }
+  BOOST_CHECK_GT(events.size(), inserted);
+  BOOST_CHECK_EQUAL(container.size(), 50u);
+  for (std::vector<rebalance_event>::const_iterator i = events.begin();
+       i != events.end(); ++i)
+    {
+      BOOST_CHECK_GE(i->weight, 2u);
+      BOOST_CHECK_LT(i->depth, 200u);
+      BOOST_CHECK_GE(i->erase_nodes, 1u);
+      BOOST_CHECK_EQUAL(i->erase_nodes, i->insert_nodes);
+      // A nested rebalancing is reported before the one containing it,
+      // which counts its nodes as well.
+      if (i->nesting != 0)
+        {
+          std::vector<rebalance_event>::const_iterator j = i + 1;
+          while (j != events.end() && j->nesting >= i->nesting) { ++j; }
+          BOOST_REQUIRE(j != events.end());
+          BOOST_CHECK_EQUAL(j->nesting, i->nesting - 1);
+          BOOST_CHECK_GT(j->erase_nodes, i->erase_nodes);
+          BOOST_CHECK(j->elapsed >= i->elapsed);
+        }
+    }
+}
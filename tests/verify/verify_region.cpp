@@ -753,3 +753,40 @@ BOOST_AUTO_TEST_CASE_TEMPLATE( test_region_decrement, Tp, double6_sets )
       }
   }
 }
+
+BOOST_AUTO_TEST_CASE( test_region_rank_dispatch )
+{
+  // A runtime rank of 6 is dispatched to Static_rank<6>: both paths must
+  // visit the same nodes, in the same order.
+  typedef runtime_pointset_fix<double6> fix_type;
+  typedef fix_type::container_type::iterator::node_ptr node_ptr;
+  fix_type fix(100, randomize(-2, 2));
+  bounds<double6, bracket_less<double6> > pred
+    = make_bounds(fix.container, make_double6(-1.), make_double6(1.));
+  details::Dynamic_rank rank(6);
+  node_ptr root = fix.container.end().node->parent;
+  std::pair<node_ptr, dimension_type> dispatched
+    = details::first_region(root, 0, rank, pred);
+  std::pair<node_ptr, dimension_type> generic
+    = details::first_region<node_ptr, details::Dynamic_rank>
+    (root, 0, rank, pred);
+  std::ptrdiff_t count_it = 0;
+  while (!details::header(dispatched.first))
+    {
+      BOOST_CHECK(dispatched == generic);
+      BOOST_CHECK(match_all(fix.container.rank(),
+                            details::const_key(dispatched.first), pred));
+      ++count_it;
+      dispatched = details::increment_region
+        (dispatched.first, dispatched.second, rank, pred);
+      generic = details::increment_region<node_ptr, details::Dynamic_rank>
+        (generic.first, generic.second, rank, pred);
+    }
+  BOOST_CHECK(dispatched == generic);
+  BOOST_CHECK_EQUAL(count_it, std::distance(region_begin(fix.container,
+                                                         make_double6(-1.),
+                                                         make_double6(1.)),
+                                            region_end(fix.container,
+                                                       make_double6(-1.),
+                                                       make_double6(1.))));
+}
@@ -0,0 +1,125 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   verify_reserve.cpp
+ *  Contains the tests for the nodes reserved in advance by the containers,
+ *  which are checked by counting the calls to their allocator.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define SPATIAL_ENABLE_ASSERT // detect interal issues that should not occur
+
+#include <memory>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include "../../src/point_multiset.hpp"
+#include "../../src/idle_point_multiset.hpp"
+#include "spatial_test_fixtures.hpp"
+
+// The number of calls to allocate() of all counting_allocator.
+static std::size_t allocations = 0;
+
+template <typename Tp>
+struct counting_allocator
+{
+  typedef Tp value_type;
+
+  counting_allocator() { }
+
+  template <typename Up>
+  counting_allocator(const counting_allocator<Up>&) { }
+
+  Tp* allocate(std::size_t n)
+  {
+    ++allocations;
+    return std::allocator<Tp>().allocate(n);
+  }
+
+  void deallocate(Tp* p, std::size_t n)
+  { std::allocator<Tp>().deallocate(p, n); }
+};
+
+template <typename Tp, typename Up>
+inline bool operator==(const counting_allocator<Tp>&,
+                       const counting_allocator<Up>&)
+{ return true; }
+
+template <typename Tp, typename Up>
+inline bool operator!=(const counting_allocator<Tp>&,
+                       const counting_allocator<Up>&)
+{ return false; }
+
+BOOST_AUTO_TEST_CASE( test_reserve_relaxed_no_allocation )
+{
+  typedef point_multiset<2, int2, bracket_less<int2>, loose_balancing,
+                         counting_allocator<int2> > set_type;
+  set_type container;
+  BOOST_CHECK_EQUAL(container.capacity(), 0u);
+  container.reserve(300);
+  BOOST_CHECK_EQUAL(container.capacity(), 300u);
+  std::size_t reserved = allocations;
+  int2 key;
+  for (int i = 0; i < 300; ++i)
+    { container.insert(randomize(0, 100)(key, 0, 0)); }
+  for (int i = 0; i < 150; ++i) { container.erase(container.begin()); }
+  for (int i = 0; i < 150; ++i)
+    { container.insert(randomize(0, 100)(key, 0, 0)); }
+  container.clear();
+  for (int i = 0; i < 100; ++i)
+    { container.insert(randomize(0, 100)(key, 0, 0)); }
+  BOOST_CHECK_EQUAL(allocations, reserved);
+  BOOST_CHECK_EQUAL(container.size(), 100u);
+  BOOST_CHECK_EQUAL(container.capacity(), 300u);
+  // Copies start without reserve, and the reserve follows swaps.
+  set_type copy(container);
+  BOOST_CHECK_EQUAL(copy.capacity(), 100u);
+  copy.swap(container);
+  BOOST_CHECK_EQUAL(copy.capacity(), 300u);
+  copy.shrink_to_fit();
+  BOOST_CHECK_EQUAL(copy.capacity(), 100u);
+  reserved = allocations;
+  copy.erase(copy.begin());
+  copy.insert(key);
+  BOOST_CHECK_EQUAL(allocations, reserved + 1);
+}
+
+BOOST_AUTO_TEST_CASE( test_reserve_idle_no_allocation )
+{
+  typedef idle_point_multiset<2, int2, bracket_less<int2>,
+                              counting_allocator<int2> > set_type;
+  set_type container;
+  int2 key;
+  for (int i = 0; i < 50; ++i)
+    { container.insert(randomize(0, 100)(key, 0, 0)); }
+  container.reserve(400);
+  BOOST_CHECK_EQUAL(container.capacity(), 400u);
+  std::size_t reserved = allocations;
+  for (int i = 0; i < 250; ++i)
+    { container.insert(randomize(0, 100)(key, 0, 0)); }
+  container.rebalance();
+  for (int i = 0; i < 100; ++i) { container.erase(container.begin()); }
+  std::vector<int2> batch(200);
+  for (std::vector<int2>::iterator i = batch.begin(); i != batch.end(); ++i)
+    { randomize(0, 100)(*i, 0, 0); }
+  std::size_t before_batch = allocations;
+  container.insert_rebalance(batch.begin(), batch.end());
+  BOOST_CHECK_EQUAL(before_batch, reserved);
+  BOOST_CHECK_EQUAL(allocations, reserved);
+  BOOST_CHECK_EQUAL(container.size(), 400u);
+  container.clear();
+  BOOST_CHECK_EQUAL(container.capacity(), 400u);
+  BOOST_CHECK_EQUAL(allocations, reserved);
+  // Without reserve, rebalancing allocates its buffer again.
+  container.shrink_to_fit();
+  BOOST_CHECK_EQUAL(container.capacity(), 0u);
+  container.insert(key);
+  container.insert(key);
+  reserved = allocations;
+  container.rebalance();
+  BOOST_CHECK_EQUAL(allocations, reserved + 1);
+}
@@ -0,0 +1,101 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   verify_stats.cpp
+ *  Contains the tests for the counts of the traversals. This file is built
+ *  in its own executable, with SPATIAL_ENABLE_STATS defined, since the
+ *  counts change the layout of the iterators.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define SPATIAL_ENABLE_ASSERT // detect interal issues that should not occur
+
+#include <boost/test/unit_test.hpp>
+#include "../../src/point_multiset.hpp"
+#include "../../src/neighbor_iterator.hpp"
+#include "../../src/region_iterator.hpp"
+#include "../../src/equal_iterator.hpp"
+#include "../../src/mapping_iterator.hpp"
+#include "spatial_test_fixtures.hpp"
+
+BOOST_AUTO_TEST_CASE( test_stats_neighbor )
+{
+  pointset_fix<int2> fix(1000, randomize(0, 1000));
+  int2 target(500, 500);
+  thread_traversal_stats().clear();
+  neighbor_iterator<point_multiset<2, int2> > i
+    = neighbor_begin(fix.container, target);
+  traversal_stats begin = i.stats();
+  BOOST_CHECK(begin == thread_traversal_stats());
+  BOOST_CHECK_GE(begin.nodes_visited, 1u);
+  BOOST_CHECK_GE(begin.distances_to_key, 1u);
+  BOOST_CHECK_GE(begin.distances_to_plane, 1u);
+  // A nearest neighbor search in a large tree must skip most of it.
+  BOOST_CHECK_GT(begin.pruned_subtrees, 0u);
+  BOOST_CHECK_LT(begin.distances_to_key, 1000u);
+  BOOST_CHECK_EQUAL(begin.predicate_evaluations, 0u);
+  for (int n = 0; n < 20; ++n) { ++i; }
+  traversal_stats after = i.stats();
+  BOOST_CHECK(after == thread_traversal_stats());
+  BOOST_CHECK_GT(after.distances_to_key, begin.distances_to_key);
+  BOOST_CHECK_GT(after.climbs, 0u);
+  // The counts follow the iterator, not the thread.
+  neighbor_iterator<const point_multiset<2, int2> > j = i;
+  BOOST_CHECK(j.stats() == after);
+  j.clear_stats();
+  BOOST_CHECK(j.stats() == traversal_stats());
+  --j;
+  BOOST_CHECK_GE(j.stats().distances_to_key, 1u);
+  BOOST_CHECK(after + j.stats() == thread_traversal_stats());
+}
+
+BOOST_AUTO_TEST_CASE( test_stats_region_equal )
+{
+  pointset_fix<int2> fix(1000, randomize(0, 1000));
+  thread_traversal_stats().clear();
+  int2 lower(100, 100), upper(200, 200);
+  region_iterator<point_multiset<2, int2> > i
+    = region_begin(fix.container, lower, upper);
+  traversal_stats found = i.stats();
+  BOOST_CHECK_GE(found.nodes_visited, 1u);
+  BOOST_CHECK_GE(found.predicate_evaluations, 1u);
+  BOOST_CHECK_EQUAL(found.distances_to_key, 0u);
+  std::size_t count = 0;
+  for (; i != region_end(fix.container, lower, upper); ++i) { ++count; }
+  BOOST_CHECK_GT(i.stats().pruned_subtrees, 0u);
+  BOOST_CHECK_LT(i.stats().nodes_visited, 2000u);
+  BOOST_CHECK(i.stats() == thread_traversal_stats());
+  thread_traversal_stats().clear();
+  int2 model = *fix.container.begin();
+  equal_iterator<point_multiset<2, int2> > e
+    = equal_begin(fix.container, model);
+  BOOST_REQUIRE(e != equal_end(fix.container, model));
+  BOOST_CHECK_GE(e.stats().predicate_evaluations, 2u);
+  BOOST_CHECK_GT(e.stats().pruned_subtrees, 0u);
+  for (; e != equal_end(fix.container, model); ++e) { }
+  BOOST_CHECK(e.stats() == thread_traversal_stats());
+}
+
+BOOST_AUTO_TEST_CASE( test_stats_mapping )
+{
+  pointset_fix<int2> fix(1000, randomize(0, 1000));
+  thread_traversal_stats().clear();
+  mapping_iterator<point_multiset<2, int2> > i
+    = mapping_begin(fix.container, 1);
+  BOOST_CHECK_GE(i.stats().nodes_visited, 1u);
+  BOOST_CHECK_GE(i.stats().predicate_evaluations, 1u);
+  BOOST_CHECK_GT(i.stats().pruned_subtrees, 0u);
+  traversal_stats begin = i.stats();
+  for (int n = 0; n < 10; ++n) { ++i; }
+  BOOST_CHECK_GT(i.stats().climbs, begin.climbs);
+  BOOST_CHECK(i.stats() == thread_traversal_stats());
+  // Iterators that do not search start without counts.
+  mapping_iterator<point_multiset<2, int2> > end
+    = mapping_end(fix.container, 1);
+  BOOST_CHECK(end.stats() == traversal_stats());
+}
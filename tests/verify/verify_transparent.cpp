@@ -0,0 +1,198 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   verify_transparent.cpp
+ *  Contains the tests for the lookups of containers using the transparent
+ *  \ref bracket_less<void> with query keys of another type than their own.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define SPATIAL_ENABLE_ASSERT // detect interal issues that should not occur
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+#include <ostream>
+#include <boost/test/unit_test.hpp>
+#include "../../src/point_multiset.hpp"
+#include "../../src/idle_point_multiset.hpp"
+#include "../../src/region_iterator.hpp"
+#include "../../src/neighbor_iterator.hpp"
+#include "../../src/equal_iterator.hpp"
+#include "spatial_test_fixtures.hpp"
+
+// A heavy key, queried with a light array of coordinates.
+struct heavy_point
+{
+  double coord[3];
+  std::string label;
+  double operator[](dimension_type n) const { return coord[n]; }
+};
+
+struct light_point
+{
+  double coord[3];
+  double operator[](dimension_type n) const { return coord[n]; }
+};
+
+// Prints the keys in the messages of the assertions.
+inline std::ostream&
+operator<<(std::ostream& out, const heavy_point& key)
+{ return out << "(" << key[0] << ", " << key[1] << ", " << key[2] << ")"; }
+
+typedef point_multiset<3, heavy_point, bracket_less<void> > heavy_set;
+typedef idle_point_multiset<3, heavy_point, bracket_less<void> >
+heavy_idle_set;
+typedef target_metric
+<euclidian<heavy_set, double, bracket_minus<void, double> >, light_point>
+light_metric;
+
+inline light_point
+make_light(double x, double y, double z)
+{
+  light_point p;
+  p.coord[0] = x; p.coord[1] = y; p.coord[2] = z;
+  return p;
+}
+
+inline std::vector<heavy_point>
+random_heavy_points(std::size_t count)
+{
+  std::vector<heavy_point> points(count);
+  for (std::size_t i = 0; i < count; ++i)
+    {
+      for (dimension_type n = 0; n < 3; ++n)
+        { points[i].coord[n] = static_cast<double>(std::rand() % 50); }
+      points[i].label = "a label too long for the small string buffer";
+    }
+  return points;
+}
+
+BOOST_AUTO_TEST_CASE( test_transparent_find_and_bounds )
+{
+  std::vector<heavy_point> points = random_heavy_points(300);
+  heavy_set container;
+  heavy_idle_set idle;
+  container.insert(points.begin(), points.end());
+  idle.insert(points.begin(), points.end());
+  idle.rebalance();
+  const heavy_set& ccontainer = container;
+  for (std::size_t i = 0; i < 20; ++i)
+    {
+      light_point query = make_light(points[i][0], points[i][1],
+                                     points[i][2]);
+      heavy_set::iterator found = container.find(query);
+      BOOST_REQUIRE(found != container.end());
+      BOOST_CHECK(found->coord[0] == query[0] && found->coord[1] == query[1]
+                  && found->coord[2] == query[2]);
+      BOOST_CHECK(ccontainer.find(query) != ccontainer.end());
+      BOOST_CHECK(idle.find(query) != idle.end());
+    }
+  light_point missing = make_light(0.5, 0.5, 0.5);
+  BOOST_CHECK(container.find(missing) == container.end());
+  BOOST_CHECK(idle.find(missing) == idle.end());
+  // The regular overload is still used for the key type.
+  BOOST_CHECK(container.find(points[0]) != container.end());
+  light_point lower = make_light(10, 5, 20), upper = make_light(30, 40, 35);
+  std::size_t count = 0;
+  for (region_iterator<heavy_set, bounds<light_point, bracket_less<void> > >
+         i = region_begin(container, make_bounds(container, lower, upper));
+       i != region_end(container, make_bounds(container, lower, upper)); ++i)
+    {
+      BOOST_CHECK((*i)[0] >= lower[0] && (*i)[0] < upper[0]
+                  && (*i)[1] >= lower[1] && (*i)[1] < upper[1]
+                  && (*i)[2] >= lower[2] && (*i)[2] < upper[2]);
+      ++count;
+    }
+  std::size_t expected = 0;
+  for (std::vector<heavy_point>::const_iterator i = points.begin();
+       i != points.end(); ++i)
+    {
+      if ((*i)[0] >= lower[0] && (*i)[0] < upper[0]
+          && (*i)[1] >= lower[1] && (*i)[1] < upper[1]
+          && (*i)[2] >= lower[2] && (*i)[2] < upper[2]) ++expected;
+    }
+  BOOST_CHECK_EQUAL(count, expected);
+  BOOST_CHECK_THROW(make_bounds(container, upper, lower), invalid_bounds);
+}
+
+BOOST_AUTO_TEST_CASE( test_transparent_neighbor )
+{
+  std::vector<heavy_point> points = random_heavy_points(300);
+  heavy_set container;
+  container.insert(points.begin(), points.end());
+  for (std::size_t i = 0; i < 10; ++i)
+    {
+      light_point target = make_light(std::rand() % 50, std::rand() % 50,
+                                      std::rand() % 50);
+      std::vector<double> distances;
+      for (std::vector<heavy_point>::const_iterator j = points.begin();
+           j != points.end(); ++j)
+        {
+          double dx = (*j)[0] - target[0], dy = (*j)[1] - target[1],
+            dz = (*j)[2] - target[2];
+          distances.push_back(std::sqrt(dx * dx + dy * dy + dz * dz));
+        }
+      std::sort(distances.begin(), distances.end());
+      light_metric metric;
+      neighbor_iterator<heavy_set, light_metric> j
+        = neighbor_begin(container, metric, target);
+      BOOST_CHECK(target_key(j)[0] == target[0]);
+      for (std::size_t k = 0; k < 20; ++k, ++j)
+        { BOOST_CHECK_CLOSE(distance(j), distances[k], .0000001); }
+      const heavy_set& ccontainer = container;
+      neighbor_iterator<const heavy_set, light_metric> l
+        = neighbor_lower_bound(ccontainer, metric, target, 10.0);
+      BOOST_CHECK(l == neighbor_cend(ccontainer, metric, target)
+                  || distance(l) >= 10.0);
+      // The default metric still works with heavy targets.
+      heavy_point heavy = points[i];
+      BOOST_CHECK_CLOSE(distance(neighbor_begin(container, heavy)), .0,
+                        .0000001);
+    }
+}
+
+BOOST_AUTO_TEST_CASE( test_transparent_equal )
+{
+  std::vector<heavy_point> points = random_heavy_points(300);
+  heavy_set container;
+  container.insert(points.begin(), points.end());
+  const heavy_set& ccontainer = container;
+  for (std::size_t i = 0; i < 20; ++i)
+    {
+      light_point query = make_light(points[i][0], points[i][1],
+                                     points[i][2]);
+      std::size_t expected = 0;
+      for (std::vector<heavy_point>::const_iterator j = points.begin();
+           j != points.end(); ++j)
+        {
+          if ((*j)[0] == query[0] && (*j)[1] == query[1]
+              && (*j)[2] == query[2]) ++expected;
+        }
+      std::size_t count = 0;
+      for (equal_iterator<heavy_set, light_point>
+             j = equal_begin(container, query);
+           j != equal_end(container, query); ++j)
+        {
+          BOOST_CHECK((*j)[0] == query[0] && (*j)[1] == query[1]
+                      && (*j)[2] == query[2]);
+          ++count;
+        }
+      BOOST_CHECK_EQUAL(count, expected);
+      equal_iterator<const heavy_set, light_point>
+        last = equal_cend(ccontainer, query);
+      --last;
+      BOOST_CHECK((*last)[0] == query[0]);
+      BOOST_CHECK(equal_cbegin(ccontainer, query)
+                  != equal_cend(ccontainer, query));
+    }
+  light_point missing = make_light(0.5, 0.5, 0.5);
+  BOOST_CHECK(equal_begin(container, missing) == equal_end(container, missing));
+}
@@ -0,0 +1,160 @@
+// -*- C++ -*-
+//
+// Copyright Sylvain Bougerel 2009 - 2013.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file COPYING or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ *  \file   verify_vp_multiset.cpp
+ *  Contains the tests for the \ref vp_multiset, which are checked against an
+ *  exhaustive search of the values.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define SPATIAL_ENABLE_ASSERT // detect interal issues that should not occur
+
+#include <vector>
+#include <algorithm>
+#include <boost/test/unit_test.hpp>
+#include "../../src/vp_multiset.hpp"
+#include "spatial_test_fixtures.hpp"
+
+/**
+ *  A metric that only provides the distance between keys: the Chebyshev
+ *  distance between two points.
+ */
+template <typename Key>
+struct chebyshev_metric
+{
+  typedef int distance_type;
+
+  int distance_to_key(dimension_type rank, const Key& x, const Key& y) const
+  {
+    int d = 0;
+    for (dimension_type i = 0; i < rank; ++i)
+      {
+        int diff = x[i] < y[i] ? y[i] - x[i] : x[i] - y[i];
+        if (d < diff) d = diff;
+      }
+    return d;
+  }
+};
+
+typedef vp_multiset<2, int2, chebyshev_metric<int2> > vp_int2;
+
+BOOST_AUTO_TEST_CASE( test_vp_insert_find_erase )
+{
+  vp_int2 container;
+  BOOST_CHECK(container.find(ones) == container.end());
+  std::vector<int2> keys;
+  int2 key;
+  for (int i = 0; i < 300; ++i)
+    { keys.push_back(randomize(0, 20)(key, 0, 0)); }
+  container.insert(keys.begin(), keys.begin() + 200);
+  for (std::vector<int2>::const_iterator i = keys.begin() + 200;
+       i != keys.end(); ++i)
+    { container.insert(*i); }
+  BOOST_CHECK_EQUAL(container.size(), keys.size());
+  vp_int2::size_type expected = static_cast<vp_int2::size_type>
+    (std::count(keys.begin(), keys.end(), keys[0]));
+  BOOST_CHECK(*container.find(keys[0]) == keys[0]);
+  BOOST_CHECK_EQUAL(container.count(keys[0]), expected);
+  BOOST_CHECK_EQUAL(container.erase(keys[0]), expected);
+  BOOST_CHECK(container.find(keys[0]) == container.end());
+  BOOST_CHECK_EQUAL(container.size(), keys.size() - expected);
+  vp_int2::size_type before = container.count(keys[1]);
+  container.erase(container.find(keys[1]));
+  BOOST_CHECK_EQUAL(container.count(keys[1]), before - 1);
+}
+
+BOOST_AUTO_TEST_CASE( test_vp_neighbor )
+{
+  chebyshev_metric<int2> metric;
+  vp_int2 container(metric);
+  std::vector<int2> keys;
+  int2 key;
+  for (int i = 0; i < 500; ++i)
+    {
+      keys.push_back(randomize(0, 1000)(key, 0, 0));
+      container.insert(keys.back());
+    }
+  for (int i = 0; i < 20; ++i)
+    {
+      int2 target;
+      randomize(0, 1000)(target, 0, 0);
+      std::vector<int> expected;
+      for (std::vector<int2>::const_iterator j = keys.begin();
+           j != keys.end(); ++j)
+        { expected.push_back(metric.distance_to_key(2, target, *j)); }
+      std::sort(expected.begin(), expected.end());
+      std::vector<int> found;
+      typedef neighbor_iterator<vp_int2, chebyshev_metric<int2> > iterator;
+      for (iterator j = neighbor_begin(container, metric, target);
+           j != neighbor_end(container, metric, target); ++j)
+        {
+          BOOST_CHECK_EQUAL(distance(j),
+                            metric.distance_to_key(2, target, *j));
+          found.push_back(distance(j));
+        }
+      BOOST_CHECK(found == expected);
+      int radius = 20 + i * 10;
+      const vp_int2& ccontainer = container;
+      std::size_t count = 0;
+      for (neighbor_iterator<const vp_int2, chebyshev_metric<int2> >
+             j = neighbor_cbegin(ccontainer, metric, target);
+           j != neighbor_cupper_bound(ccontainer, metric, target, radius);
+           ++j)
+        { BOOST_CHECK(j.distance() <= radius); ++count; }
+      BOOST_CHECK_EQUAL(count, static_cast<std::size_t>
+                        (std::upper_bound(expected.begin(), expected.end(),
+                                          radius) - expected.begin()));
+      iterator lower = neighbor_lower_bound(container, metric, target, radius);
+      BOOST_CHECK(lower == neighbor_end(container, metric, target)
+                  || lower.distance() >= radius);
+    }
+  BOOST_CHECK_THROW(neighbor_upper_bound(container, metric, ones, -1),
+                    invalid_distance);
+}
+
+BOOST_AUTO_TEST_CASE( test_vp_erase_search )
+{
+  chebyshev_metric<int2> metric;
+  vp_int2 container(metric);
+  std::vector<int2> keys;
+  int2 key;
+  for (int i = 0; i < 400; ++i)
+    { keys.push_back(randomize(0, 1000)(key, 0, 0)); }
+  container.insert(keys.begin(), keys.end());
+  // Erase one value out of three, so that the tree is rebuilt once in
+  // between, and check the searches against the remaining values.
+  std::vector<int2> kept;
+  for (std::size_t i = 0; i < keys.size(); ++i)
+    {
+      if (i % 3 == 0) container.erase(container.find(keys[i]));
+      else kept.push_back(keys[i]);
+    }
+  BOOST_CHECK_EQUAL(container.size(), kept.size());
+  BOOST_CHECK_EQUAL(static_cast<std::size_t>
+                    (std::distance(container.begin(), container.end())),
+                    kept.size());
+  for (std::vector<int2>::const_iterator i = kept.begin();
+       i != kept.end(); ++i)
+    { BOOST_CHECK(container.find(*i) != container.end()); }
+  int2 target;
+  randomize(0, 1000)(target, 0, 0);
+  std::vector<int> expected;
+  for (std::vector<int2>::const_iterator j = kept.begin();
+       j != kept.end(); ++j)
+    { expected.push_back(metric.distance_to_key(2, target, *j)); }
+  std::sort(expected.begin(), expected.end());
+  std::vector<int> found;
+  for (neighbor_iterator<vp_int2, chebyshev_metric<int2> >
+         j = neighbor_begin(container, metric, target);
+       j != neighbor_end(container, metric, target); ++j)
+    { found.push_back(distance(j)); }
+  BOOST_CHECK(found == expected);
+  container.clear();
+  BOOST_CHECK(container.empty());
+  BOOST_CHECK(container.begin() == container.end());
+}